@@ -37,6 +37,43 @@ boolean DT_containsPath(char* path);
 */
 int DT_rmPath(char* path);
 
+/*
+  Counters of the work done by the DT implementation since the last
+  DT_resetStats, summed over every thread that has used it. They are
+  only collected when the implementation is built with -DCOLLECT_STATS
+  ("make STATS=1"); otherwise every counter stays 0.
+*/
+struct DT_Stats {
+   /* path traversals, and nodes visited by them */
+   unsigned long traversals;
+   unsigned long nodesVisited;
+   /* node and path comparisons, and bytes examined by them */
+   unsigned long compares;
+   unsigned long bytesCompared;
+   /* heap blocks allocated and freed */
+   unsigned long mallocs;
+   unsigned long frees;
+   /* DynArray reallocations on growth, and elements shifted by
+      DynArray_addAt and DynArray_removeAt */
+   unsigned long grows;
+   unsigned long shifts;
+   /* invariant checks run, and seconds spent in them */
+   unsigned long checks;
+   double checkerSeconds;
+};
+
+/*
+  Stores the current counters in *pStats.
+  Returns TRUE if the counters are collected in this build,
+  and FALSE (having stored all zeros) otherwise.
+*/
+boolean DT_getStats(struct DT_Stats* pStats);
+
+/*
+  Sets every counter back to 0.
+*/
+void DT_resetStats(void);
+
 /*
   Sets the data structure to initialized status.
   The data structure is initially empty.
@@ -13,6 +13,7 @@
 #include "dt.h"
 #include "node.h"
 #include "checker.h"
+#include "stats.h"
 
 /* A Directory Tree is an AO with 3 state variables: */
 /* a flag for if it is in an initialized state (TRUE) or not (FALSE) */
@@ -40,10 +41,13 @@ static Node DT_traversePathFrom(char* path, Node curr) {
    if(curr == NULL)
       return NULL;
 
-   else if(!strcmp(path,Node_getPath(curr)))
+   STATS_ADD(nodesVisited, 1);
+   STATS_COMPARE(path, Node_getPath(curr), (size_t)-1);
+   if(!strcmp(path,Node_getPath(curr)))
       return curr;
 
-   else if(!strncmp(path, Node_getPath(curr), strlen(Node_getPath(curr)))) {
+   STATS_COMPARE(path, Node_getPath(curr), strlen(Node_getPath(curr)));
+   if(!strncmp(path, Node_getPath(curr), strlen(Node_getPath(curr)))) {
       for(i = 0; i < Node_getNumChildren(curr); i++) {
          found = DT_traversePathFrom(path,
                                 Node_getChild(curr, i));
@@ -62,6 +66,7 @@ static Node DT_traversePathFrom(char* path, Node curr) {
 */
 static Node DT_traversePath(char* path) {
    assert(path != NULL);
+   STATS_ADD(traversals, 1);
    return DT_traversePathFrom(path, root);
 }
 
@@ -127,6 +132,7 @@ static int DT_insertRestOfPath(char* path, Node parent) {
       }
    }
    else {
+      STATS_COMPARE(path, Node_getPath(curr), (size_t)-1);
       if(!strcmp(path, Node_getPath(curr)))
          return ALREADY_IN_TREE;
 
@@ -136,6 +142,7 @@ static int DT_insertRestOfPath(char* path, Node parent) {
    copyPath = malloc(strlen(restPath)+1);
    if(copyPath == NULL)
       return MEMORY_ERROR;
+   STATS_ADD(mallocs, 1);
    strcpy(copyPath, restPath);
    dirToken = strtok(copyPath, "/");
 
@@ -151,6 +158,7 @@ static int DT_insertRestOfPath(char* path, Node parent) {
             (void) Node_destroy(new);
             (void) Node_destroy(firstNew);
             free(copyPath);
+            STATS_ADD(frees, 1);
             return result;
          }
       }
@@ -158,6 +166,7 @@ static int DT_insertRestOfPath(char* path, Node parent) {
       if(new == NULL) {
          (void) Node_destroy(firstNew);
          free(copyPath);
+         STATS_ADD(frees, 1);
          return MEMORY_ERROR;
       }
 
@@ -166,6 +175,7 @@ static int DT_insertRestOfPath(char* path, Node parent) {
    }
 
    free(copyPath);
+   STATS_ADD(frees, 1);
 
    if(parent == NULL) {
       root = firstNew;
@@ -216,10 +226,10 @@ boolean DT_containsPath(char* path) {
 
    if(curr == NULL)
       result = FALSE;
-   else if(strcmp(path, Node_getPath(curr)))
-      result = FALSE;
-   else
-      result = TRUE;
+   else {
+      STATS_COMPARE(path, Node_getPath(curr), (size_t)-1);
+      result = strcmp(path, Node_getPath(curr)) ? FALSE : TRUE;
+   }
 
    assert(Checker_DT_isValid(isInitialized,root,count));
    return result;
@@ -241,6 +251,7 @@ static int DT_rmPathAt(char* path, Node curr) {
 
    parent = Node_getParent(curr);
 
+   STATS_COMPARE(path, Node_getPath(curr), (size_t)-1);
    if(!strcmp(path,Node_getPath(curr))) {
       if(parent == NULL)
          root = NULL;
@@ -346,6 +357,35 @@ static void DT_strcatAccumulate(char* str, char* acc) {
       strcat(acc, str); strcat(acc, "\n");
 }
 
+/* see dt.h for specification */
+boolean DT_getStats(struct DT_Stats* pStats) {
+   struct Stats total;
+
+   assert(pStats != NULL);
+
+   Stats_sum(&total);
+   pStats->traversals = total.traversals;
+   pStats->nodesVisited = total.nodesVisited;
+   pStats->compares = total.compares;
+   pStats->bytesCompared = total.bytesCompared;
+   pStats->mallocs = total.mallocs;
+   pStats->frees = total.frees;
+   pStats->grows = total.grows;
+   pStats->shifts = total.shifts;
+   pStats->checks = total.checks;
+   pStats->checkerSeconds = total.checkerSeconds;
+#ifdef COLLECT_STATS
+   return TRUE;
+#else
+   return FALSE;
+#endif
+}
+
+/* see dt.h for specification */
+void DT_resetStats(void) {
+   Stats_reset();
+}
+
 /* see dt.h for specification */
 char* DT_toString(void) {
    DynArray_T nodes;
@@ -368,6 +408,7 @@ char* DT_toString(void) {
       assert(Checker_DT_isValid(isInitialized,root,count));
       return NULL;
    }
+   STATS_ADD(mallocs, 1);
    *result = '\0';
 
    DynArray_map(nodes, (void (*)(void *, void*)) DT_strcatAccumulate, (void *) result);
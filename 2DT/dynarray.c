@@ -4,6 +4,7 @@
 /*--------------------------------------------------------------------*/
 
 #include "dynarray.h"
+#include "stats.h"
 #include <assert.h>
 #include <stdlib.h>
 
@@ -69,6 +70,7 @@ static int DynArray_grow(DynArray_T oDynArray)
       realloc(oDynArray->ppvArray, sizeof(void*) * uNewLength);
    if (ppvNewArray == NULL)
       return 0;
+   STATS_ADD(grows, 1);
 
    oDynArray->uPhysLength = uNewLength;
    oDynArray->ppvArray = ppvNewArray;
@@ -84,6 +86,7 @@ DynArray_T DynArray_new(size_t uLength)
    oDynArray = (struct DynArray*)malloc(sizeof(struct DynArray));
    if (oDynArray == NULL)
       return NULL;
+   STATS_ADD(mallocs, 1);
 
    oDynArray->uLength = uLength;
    if (uLength > MIN_PHYS_LENGTH)
@@ -96,8 +99,10 @@ DynArray_T DynArray_new(size_t uLength)
    if (oDynArray->ppvArray == NULL)
    {
       free(oDynArray);
+      STATS_ADD(frees, 1);
       return NULL;
    }
+   STATS_ADD(mallocs, 1);
 
    return oDynArray;
 }
@@ -111,6 +116,7 @@ void DynArray_free(DynArray_T oDynArray)
 
    free(oDynArray->ppvArray);
    free(oDynArray);
+   STATS_ADD(frees, 2);
 }
 
 /*--------------------------------------------------------------------*/
@@ -189,6 +195,7 @@ int DynArray_addAt(DynArray_T oDynArray, size_t uIndex,
 
    for (u = oDynArray->uLength; u > uIndex; u--)
       oDynArray->ppvArray[u] = oDynArray->ppvArray[u-1];
+   STATS_ADD(shifts, oDynArray->uLength - uIndex);
 
    oDynArray->ppvArray[uIndex] = pvElement;
    oDynArray->uLength++;
@@ -215,6 +222,7 @@ void *DynArray_removeAt(DynArray_T oDynArray, size_t uIndex)
 
    for (u = uIndex; u < oDynArray->uLength; u++)
       oDynArray->ppvArray[u] = oDynArray->ppvArray[u+1];
+   STATS_ADD(shifts, oDynArray->uLength - uIndex);
 
    assert(DynArray_isValid(oDynArray));
 
@@ -10,6 +10,7 @@
 
 #include "dynarray.h"
 #include "node.h"
+#include "stats.h"
 
 /*
    A node structure represents a directory in the directory tree
@@ -48,6 +49,7 @@ static char* Node_buildPath(Node n, const char* dir) {
 
    if(path == NULL)
       return NULL;
+   STATS_ADD(mallocs, 1);
    *path = '\0';
 
    if(n != NULL) {
@@ -69,11 +71,13 @@ Node Node_create(const char* dir, Node parent){
    new = malloc(sizeof(struct node));
    if(new == NULL)
       return NULL;
+   STATS_ADD(mallocs, 1);
 
    new->path = Node_buildPath(parent, dir);
 
    if(new->path == NULL) {
       free(new);
+      STATS_ADD(frees, 1);
       return NULL;
    }
 
@@ -82,6 +86,7 @@ Node Node_create(const char* dir, Node parent){
    if(new->children == NULL) {
       free(new->path);
       free(new);
+      STATS_ADD(frees, 2);
       return NULL;
    }
 
@@ -105,6 +110,7 @@ size_t Node_destroy(Node n) {
 
    free(n->path);
    free(n);
+   STATS_ADD(frees, 2);
    count++;
 
    return count;
@@ -134,6 +140,7 @@ int Node_compare(Node node1, Node node2) {
    assert(node1 != NULL);
    assert(node2 != NULL);
 
+   STATS_COMPARE(node1->path, node2->path, (size_t)-1);
    return strcmp(node1->path, node2->path);
 }
 
@@ -195,6 +202,7 @@ int Node_linkChild(Node parent, Node child) {
    if(Node_hasChild(parent, child->path, NULL))
       return ALREADY_IN_TREE;
    i = strlen(parent->path);
+   STATS_COMPARE(child->path, parent->path, i);
    if(strncmp(child->path, parent->path, i))
       return PARENT_CHILD_ERROR;
    rest = child->path + i;
@@ -261,6 +269,6 @@ char* Node_toString(Node n) {
    copyPath = malloc(strlen(n->path)+1);
    if(copyPath == NULL)
       return NULL;
-   else
-      return strcpy(copyPath, n->path);
+   STATS_ADD(mallocs, 1);
+   return strcpy(copyPath, n->path);
 }
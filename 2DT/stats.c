@@ -0,0 +1,193 @@
+/*--------------------------------------------------------------------*/
+/* stats.c                                                            */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "stats.h"
+#include <string.h>
+
+#ifdef COLLECT_STATS
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*--------------------------------------------------------------------*/
+
+/* A StatsBlock holds one thread's counters, linked into the list of
+   all live threads' blocks. */
+
+struct StatsBlock
+{
+   /* The counters; first, so that a block is its counters. */
+   struct Stats sCounts;
+
+   /* The neighbouring blocks in the list. */
+   struct StatsBlock *psPrev;
+   struct StatsBlock *psNext;
+};
+
+__thread struct Stats *Stats_psLocal = NULL;
+
+/* Where a thread whose block could not be allocated counts instead:
+   its increments are dropped rather than summed. */
+
+static __thread struct Stats sDropped;
+
+/* The blocks of live threads, the sum of the counters of exited
+   threads, and the mutex that guards both. */
+
+static struct StatsBlock *psBlocks = NULL;
+static struct Stats sRetired;
+static pthread_mutex_t oMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* The key whose destructor retires a thread's block when it exits. */
+
+static pthread_key_t oKey;
+static pthread_once_t oKeyOnce = PTHREAD_ONCE_INIT;
+
+/*--------------------------------------------------------------------*/
+
+/* Add the counters in *psFrom to those in *psTo. */
+
+static void Stats_add(struct Stats *psTo, const struct Stats *psFrom)
+{
+   psTo->traversals += psFrom->traversals;
+   psTo->nodesVisited += psFrom->nodesVisited;
+   psTo->compares += psFrom->compares;
+   psTo->bytesCompared += psFrom->bytesCompared;
+   psTo->mallocs += psFrom->mallocs;
+   psTo->frees += psFrom->frees;
+   psTo->grows += psFrom->grows;
+   psTo->shifts += psFrom->shifts;
+   psTo->checks += psFrom->checks;
+   psTo->checkerSeconds += psFrom->checkerSeconds;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Fold the exiting thread's block pvBlock into the retired counters
+   and free it. */
+
+static void Stats_retire(void *pvBlock)
+{
+   struct StatsBlock *psBlock = (struct StatsBlock*)pvBlock;
+
+   pthread_mutex_lock(&oMutex);
+   Stats_add(&sRetired, &psBlock->sCounts);
+   if (psBlock->psPrev != NULL)
+      psBlock->psPrev->psNext = psBlock->psNext;
+   else
+      psBlocks = psBlock->psNext;
+   if (psBlock->psNext != NULL)
+      psBlock->psNext->psPrev = psBlock->psPrev;
+   pthread_mutex_unlock(&oMutex);
+
+   free(psBlock);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Create the key that retires blocks. */
+
+static void Stats_createKey(void)
+{
+   pthread_key_create(&oKey, Stats_retire);
+}
+
+/*--------------------------------------------------------------------*/
+
+struct Stats *Stats_register(void)
+{
+   struct StatsBlock *psBlock;
+
+   /* Not counted: this is the counters' own memory. */
+   psBlock = (struct StatsBlock*)calloc(1, sizeof(struct StatsBlock));
+   if (psBlock == NULL)
+   {
+      Stats_psLocal = &sDropped;
+      return Stats_psLocal;
+   }
+
+   pthread_once(&oKeyOnce, Stats_createKey);
+   pthread_mutex_lock(&oMutex);
+   psBlock->psNext = psBlocks;
+   if (psBlocks != NULL)
+      psBlocks->psPrev = psBlock;
+   psBlocks = psBlock;
+   pthread_mutex_unlock(&oMutex);
+   pthread_setspecific(oKey, psBlock);
+
+   Stats_psLocal = &psBlock->sCounts;
+   return Stats_psLocal;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Stats_compare(const char *pcS1, const char *pcS2, size_t uMax)
+{
+   size_t u = 0;
+
+   while (u < uMax && pcS1[u] == pcS2[u] && pcS1[u] != '\0')
+      u++;
+   if (u < uMax)
+      u++;
+
+   STATS_ADD(compares, 1);
+   STATS_ADD(bytesCompared, u);
+}
+
+/*--------------------------------------------------------------------*/
+
+double Stats_now(void)
+{
+   struct timespec sTime;
+
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (double)sTime.tv_sec + (double)sTime.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Stats_sum(struct Stats *psTotal)
+{
+   struct StatsBlock *psBlock;
+
+   pthread_mutex_lock(&oMutex);
+   *psTotal = sRetired;
+   for (psBlock = psBlocks; psBlock != NULL; psBlock = psBlock->psNext)
+      Stats_add(psTotal, &psBlock->sCounts);
+   pthread_mutex_unlock(&oMutex);
+}
+
+/*--------------------------------------------------------------------*/
+
+void Stats_reset(void)
+{
+   struct StatsBlock *psBlock;
+
+   pthread_mutex_lock(&oMutex);
+   memset(&sRetired, 0, sizeof(sRetired));
+   for (psBlock = psBlocks; psBlock != NULL; psBlock = psBlock->psNext)
+      memset(&psBlock->sCounts, 0, sizeof(psBlock->sCounts));
+   pthread_mutex_unlock(&oMutex);
+}
+
+#else
+
+/*--------------------------------------------------------------------*/
+
+void Stats_sum(struct Stats *psTotal)
+{
+   memset(psTotal, 0, sizeof(*psTotal));
+}
+
+/*--------------------------------------------------------------------*/
+
+void Stats_reset(void)
+{
+}
+
+#endif
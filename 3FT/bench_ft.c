@@ -0,0 +1,844 @@
+/*--------------------------------------------------------------------*/
+/* bench_ft.c                                                         */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "ft.h"
+#include "dynarray.h"
+#include "segarray.h"
+
+/*
+   Benchmarks the FT implementation on parameterized synthetic trees:
+
+     wide       one directory with --wide files
+     deep       one chain of --deep nested directories
+     realistic  --nodes nodes whose fanout and depth follow the
+                heavy-tailed shape of real source trees
+     mixed      --ops random operations on a realistic tree, of which
+                a fraction --read-ratio are reads
+     sort       --sort pointers to keys sorted by DynArray_sort and
+                DynArray_sortParallel, in random, ascending,
+                descending, few-distinct and rising-then-falling order,
+                each reported as a workload of its own
+     append     --appends pointers added one at a time to an empty
+                DynArray and to an empty SegArray, so that the tail
+                latencies show the DynArray's copies as it doubles
+
+   For every function each workload times, reports the number of
+   calls, throughput, and p50/p99/p999 latency, along with the
+   process's peak RSS, as a text table (--format=text), CSV
+   (--format=csv) or JSON (--format=json). FT_toString is quadratic in
+   the size of the tree, so it is only timed on trees of at most
+   --to-string-limit nodes. With --trace=FILE the run is also recorded
+   to FILE, for replay with ft_replay.
+
+   Build with "make bench_ft", which compiles with -DNDEBUG so that
+   the per-operation checker does not dominate the measurements.
+*/
+
+/* The public FT functions that are timed */
+enum { OP_INSERT_DIR, OP_INSERT_FILE, OP_CONTAINS_DIR, OP_CONTAINS_FILE,
+       OP_STAT, OP_GET_CONTENTS, OP_REPLACE_CONTENTS, OP_RM_FILE,
+       OP_RM_DIR, OP_TO_STRING, OP_SORT, OP_SORT_PARALLEL, OP_DYN_ADD,
+       OP_SEG_ADD, NUM_OPS };
+
+static const char* opNames[NUM_OPS] = {
+   "FT_insertDir", "FT_insertFile", "FT_containsDir", "FT_containsFile",
+   "FT_stat", "FT_getFileContents", "FT_replaceFileContents",
+   "FT_rmFile", "FT_rmDir", "FT_toString", "DynArray_sort",
+   "DynArray_sortParallel", "DynArray_add", "SegArray_add"
+};
+
+/* The latencies, in nanoseconds, of every timed call to one function
+   during the current workload */
+struct Samples {
+   double* ns;
+   size_t n;
+   size_t cap;
+};
+
+static struct Samples samples[NUM_OPS];
+
+/* One line of the report: one function's figures in one workload */
+struct Result {
+   const char* workload;
+   int op;
+   size_t count;
+   double opsPerSec;
+   double p50;
+   double p99;
+   double p999;
+   long peakRssKB;
+};
+
+static struct Result* results;
+static size_t numResults;
+static size_t capResults;
+
+/* Benchmark parameters, settable from the command line */
+static size_t wideFiles = 1000000;
+static size_t deepLevels = 10000;
+static size_t realisticNodes = 1000000;
+static size_t mixedOps = 1000000;
+static double readRatio = 0.9;
+static size_t toStringLimit = 20000;
+static size_t sortLength = 1000000;
+static size_t appendLength = 10000000;
+static unsigned long seed = 217;
+
+/* State of the xorshift64* generator, so runs are reproducible
+   across platforms */
+static unsigned long rngState;
+
+/*--------------------------------------------------------------------*/
+
+/* Exits with a message if p is NULL; returns p otherwise. */
+static void* Bench_check(void* p) {
+   if(p == NULL) {
+      fprintf(stderr, "bench_ft: out of memory\n");
+      exit(EXIT_FAILURE);
+   }
+   return p;
+}
+
+/* Returns the next pseudo-random 64-bit value. */
+static unsigned long Bench_random(void) {
+   rngState ^= rngState >> 12;
+   rngState ^= rngState << 25;
+   rngState ^= rngState >> 27;
+   return rngState * 2685821657736338717UL;
+}
+
+/* Returns a pseudo-random index in [0, n). n must be positive. */
+static size_t Bench_below(size_t n) {
+   assert(n > 0);
+   return (size_t)(Bench_random() % n);
+}
+
+/* Returns a pseudo-random double in [0, 1). */
+static double Bench_uniform(void) {
+   return (double)(Bench_random() >> 11) / 9007199254740992.0;
+}
+
+/* Returns a pseudo-random sample from the normal distribution with
+   mean mu and standard deviation sigma. */
+static double Bench_normal(double mu, double sigma) {
+   double u1 = Bench_uniform();
+   double u2 = Bench_uniform();
+
+   if(u1 < 1e-300)
+      u1 = 1e-300;
+   return mu + sigma * sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+/* Returns the current time in nanoseconds. */
+static double Bench_now(void) {
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/* Records a call to function op that began at time start. */
+static void Bench_record(int op, double start) {
+   double elapsed = Bench_now() - start;
+   struct Samples* s = &samples[op];
+
+   if(s->n == s->cap) {
+      s->cap = (s->cap == 0) ? 1024 : 2 * s->cap;
+      s->ns = Bench_check(realloc(s->ns, s->cap * sizeof(double)));
+   }
+   s->ns[s->n++] = elapsed;
+}
+
+/* Orders doubles for qsort. */
+static int Bench_compareDoubles(const void* a, const void* b) {
+   double x = *(const double*)a;
+   double y = *(const double*)b;
+   return (x < y) ? -1 : (x > y);
+}
+
+/* Returns the q'th quantile of the n sorted values in v. */
+static double Bench_quantile(const double* v, size_t n, double q) {
+   assert(n > 0);
+   return v[(size_t)(q * (double)(n - 1) + 0.5)];
+}
+
+/* Returns the peak resident set size of the process so far, in KB. */
+static long Bench_peakRssKB(void) {
+   struct rusage ru;
+
+   if(getrusage(RUSAGE_SELF, &ru) != 0)
+      return -1;
+   return ru.ru_maxrss;
+}
+
+/* Turns the samples gathered during workload into report lines, and
+   clears them for the next workload. */
+static void Bench_finishWorkload(const char* workload) {
+   struct Samples* s;
+   struct Result* r;
+   double total;
+   size_t i;
+   int op;
+
+   for(op = 0; op < NUM_OPS; op++) {
+      s = &samples[op];
+      if(s->n == 0)
+         continue;
+
+      if(numResults == capResults) {
+         capResults = (capResults == 0) ? 16 : 2 * capResults;
+         results = Bench_check(realloc(results,
+                                       capResults * sizeof(*results)));
+      }
+      qsort(s->ns, s->n, sizeof(double), Bench_compareDoubles);
+      total = 0;
+      for(i = 0; i < s->n; i++)
+         total += s->ns[i];
+
+      r = &results[numResults++];
+      r->workload = workload;
+      r->op = op;
+      r->count = s->n;
+      r->opsPerSec = (total > 0) ? (double)s->n * 1e9 / total : 0;
+      r->p50 = Bench_quantile(s->ns, s->n, 0.50);
+      r->p99 = Bench_quantile(s->ns, s->n, 0.99);
+      r->p999 = Bench_quantile(s->ns, s->n, 0.999);
+      r->peakRssKB = Bench_peakRssKB();
+      s->n = 0;
+   }
+}
+
+/* Returns a newly allocated copy of str. */
+static char* Bench_strdup(const char* str) {
+   return strcpy(Bench_check(malloc(strlen(str) + 1)), str);
+}
+
+/* Shuffles the n pointers in v. */
+static void Bench_shuffle(char** v, size_t n) {
+   size_t i;
+   size_t j;
+   char* t;
+
+   for(i = n; i > 1; i--) {
+      j = Bench_below(i);
+      t = v[i - 1];
+      v[i - 1] = v[j];
+      v[j] = t;
+   }
+}
+
+/* Frees the n strings in v, and v itself. */
+static void Bench_freeAll(char** v, size_t n) {
+   size_t i;
+
+   for(i = 0; i < n; i++)
+      free(v[i]);
+   free(v);
+}
+
+/* Times one FT_toString call, if the tree has at most toStringLimit
+   nodes. */
+static void Bench_toString(size_t nodes) {
+   double start;
+   char* listing;
+
+   if(nodes > toStringLimit)
+      return;
+   start = Bench_now();
+   listing = FT_toString();
+   Bench_record(OP_TO_STRING, start);
+   free(listing);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* One directory holding wideFiles files: insert them all, look each
+   up, replace its contents, and remove them all in random order. */
+static void Bench_wide(void) {
+   char** paths;
+   char buf[64];
+   boolean type;
+   size_t length;
+   size_t i;
+   double start;
+
+   paths = Bench_check(calloc(wideFiles, sizeof(char*)));
+   for(i = 0; i < wideFiles; i++) {
+      sprintf(buf, "w/f%09lu", (unsigned long)Bench_random() % 1000000000UL);
+      paths[i] = Bench_strdup(buf);
+   }
+
+   (void) FT_init();
+   for(i = 0; i < wideFiles; i++) {
+      start = Bench_now();
+      (void) FT_insertFile(paths[i], NULL, i);
+      Bench_record(OP_INSERT_FILE, start);
+   }
+   Bench_toString(wideFiles + 1);
+
+   Bench_shuffle(paths, wideFiles);
+   for(i = 0; i < wideFiles; i++) {
+      start = Bench_now();
+      (void) FT_containsFile(paths[i]);
+      Bench_record(OP_CONTAINS_FILE, start);
+      start = Bench_now();
+      (void) FT_stat(paths[i], &type, &length);
+      Bench_record(OP_STAT, start);
+      start = Bench_now();
+      (void) FT_getFileContents(paths[i]);
+      Bench_record(OP_GET_CONTENTS, start);
+      start = Bench_now();
+      (void) FT_replaceFileContents(paths[i], NULL, 0);
+      Bench_record(OP_REPLACE_CONTENTS, start);
+   }
+
+   Bench_shuffle(paths, wideFiles);
+   for(i = 0; i < wideFiles; i++) {
+      start = Bench_now();
+      (void) FT_rmFile(paths[i]);
+      Bench_record(OP_RM_FILE, start);
+   }
+   (void) FT_destroy();
+
+   Bench_freeAll(paths, wideFiles);
+   Bench_finishWorkload("wide");
+}
+
+/* One chain of deepLevels directories: insert it a level at a time,
+   look up random levels, then remove it from the bottom up. */
+static void Bench_deep(void) {
+   char* path;
+   char saved;
+   boolean type;
+   size_t length;
+   size_t i;
+   size_t level;
+   double start;
+
+   /* level k (from 1) is the prefix "d/d/.../d" of length 2k-1 */
+   path = Bench_check(malloc(2 * deepLevels + 1));
+   for(i = 0; i < deepLevels; i++) {
+      path[2 * i] = 'd';
+      path[2 * i + 1] = '/';
+   }
+   path[2 * deepLevels - 1] = '\0';
+
+   (void) FT_init();
+   for(level = 1; level <= deepLevels; level++) {
+      saved = path[2 * level - 1];
+      path[2 * level - 1] = '\0';
+      start = Bench_now();
+      (void) FT_insertDir(path);
+      Bench_record(OP_INSERT_DIR, start);
+      path[2 * level - 1] = saved;
+   }
+
+   for(i = 0; i < deepLevels; i++) {
+      level = 1 + Bench_below(deepLevels);
+      saved = path[2 * level - 1];
+      path[2 * level - 1] = '\0';
+      start = Bench_now();
+      (void) FT_containsDir(path);
+      Bench_record(OP_CONTAINS_DIR, start);
+      start = Bench_now();
+      (void) FT_stat(path, &type, &length);
+      Bench_record(OP_STAT, start);
+      path[2 * level - 1] = saved;
+   }
+
+   for(level = deepLevels; level >= 1; level--) {
+      path[2 * level - 1] = '\0';
+      start = Bench_now();
+      (void) FT_rmDir(path);
+      Bench_record(OP_RM_DIR, start);
+   }
+   (void) FT_destroy();
+
+   free(path);
+   Bench_finishWorkload("deep");
+}
+
+/* The paths of a generated tree, directories and files separately */
+struct Tree {
+   char** dirs;
+   size_t numDirs;
+   char** files;
+   size_t numFiles;
+};
+
+/* Generates the paths of a tree of about n nodes shaped like a real
+   source tree: per-directory file and subdirectory counts are
+   log-normally distributed (most directories are small, a few are
+   very large), and subdirectories thin out with depth. The paths are
+   listed in the pre-order a checkout would create them in. */
+static void Bench_generateTree(struct Tree* t, size_t n) {
+   size_t* depths;
+   size_t* perDirNext;
+   size_t capDirs = 1024;
+   size_t capFiles = 1024;
+   size_t nodes = 1;
+   size_t dir;
+   size_t k;
+   size_t numSub;
+   size_t numFile;
+   size_t depth;
+   char buf[4096];
+
+   t->dirs = Bench_check(malloc(capDirs * sizeof(char*)));
+   t->files = Bench_check(malloc(capFiles * sizeof(char*)));
+   depths = Bench_check(malloc(capDirs * sizeof(size_t)));
+   perDirNext = Bench_check(calloc(capDirs, sizeof(size_t)));
+   t->dirs[0] = Bench_strdup("src");
+   depths[0] = 0;
+   t->numDirs = 1;
+   t->numFiles = 0;
+
+   /* expand directories breadth-first; if the tree runs out of
+      directories before reaching n nodes, grow the root again */
+   for(dir = 0; nodes < n; dir = (dir + 1 < t->numDirs) ? dir + 1 : 0) {
+      depth = depths[dir];
+      numFile = (size_t)exp(Bench_normal(1.6, 1.1));
+      numSub = (size_t)exp(Bench_normal(1.0 - 0.12 * (double)depth,
+                                        0.9));
+      if(strlen(t->dirs[dir]) > sizeof(buf) - 64)
+         numSub = 0;
+
+      for(k = 0; k < numFile && nodes < n; k++, nodes++) {
+         if(t->numFiles == capFiles) {
+            capFiles *= 2;
+            t->files = Bench_check(realloc(t->files,
+                                           capFiles * sizeof(char*)));
+         }
+         sprintf(buf, "%s/file%lu.c", t->dirs[dir],
+                 (unsigned long)perDirNext[dir]++);
+         t->files[t->numFiles++] = Bench_strdup(buf);
+      }
+      for(k = 0; k < numSub && nodes < n; k++, nodes++) {
+         if(t->numDirs == capDirs) {
+            capDirs *= 2;
+            t->dirs = Bench_check(realloc(t->dirs,
+                                          capDirs * sizeof(char*)));
+            depths = Bench_check(realloc(depths,
+                                         capDirs * sizeof(size_t)));
+            perDirNext = Bench_check(realloc(perDirNext,
+                                             capDirs * sizeof(size_t)));
+         }
+         sprintf(buf, "%s/dir%lu", t->dirs[dir],
+                 (unsigned long)perDirNext[dir]++);
+         depths[t->numDirs] = depth + 1;
+         perDirNext[t->numDirs] = 0;
+         t->dirs[t->numDirs++] = Bench_strdup(buf);
+      }
+   }
+
+   free(depths);
+   free(perDirNext);
+}
+
+/* Inserts every path of tree t into the (initialized) FT, timing
+   each insertion: directories first, in creation order, then
+   files. */
+static void Bench_buildTree(struct Tree* t) {
+   size_t i;
+   double start;
+
+   for(i = 0; i < t->numDirs; i++) {
+      start = Bench_now();
+      (void) FT_insertDir(t->dirs[i]);
+      Bench_record(OP_INSERT_DIR, start);
+   }
+   for(i = 0; i < t->numFiles; i++) {
+      start = Bench_now();
+      (void) FT_insertFile(t->files[i], NULL, i);
+      Bench_record(OP_INSERT_FILE, start);
+   }
+}
+
+/* A realistic tree of realisticNodes nodes: build it, look up every
+   node in random order, list it, and remove it subtree by subtree. */
+static void Bench_realistic(void) {
+   struct Tree t;
+   boolean type;
+   size_t length;
+   size_t i;
+   double start;
+
+   Bench_generateTree(&t, realisticNodes);
+
+   (void) FT_init();
+   Bench_buildTree(&t);
+   Bench_toString(t.numDirs + t.numFiles);
+
+   Bench_shuffle(t.files, t.numFiles);
+   for(i = 0; i < t.numFiles; i++) {
+      start = Bench_now();
+      (void) FT_containsFile(t.files[i]);
+      Bench_record(OP_CONTAINS_FILE, start);
+      start = Bench_now();
+      (void) FT_stat(t.files[i], &type, &length);
+      Bench_record(OP_STAT, start);
+   }
+   Bench_shuffle(t.dirs, t.numDirs);
+   for(i = 0; i < t.numDirs; i++) {
+      start = Bench_now();
+      (void) FT_containsDir(t.dirs[i]);
+      Bench_record(OP_CONTAINS_DIR, start);
+   }
+
+   /* directories in random order: most are already gone with an
+      ancestor by the time they come up, as in a real cleanup */
+   for(i = 0; i < t.numDirs; i++) {
+      start = Bench_now();
+      (void) FT_rmDir(t.dirs[i]);
+      Bench_record(OP_RM_DIR, start);
+   }
+   (void) FT_destroy();
+
+   Bench_freeAll(t.dirs, t.numDirs);
+   Bench_freeAll(t.files, t.numFiles);
+   Bench_finishWorkload("realistic");
+}
+
+/* mixedOps random operations on a realistic tree of realisticNodes
+   nodes, a fraction readRatio of them reads (contains, stat, get
+   contents) and the rest writes (insert, replace contents, remove). */
+static void Bench_mixed(void) {
+   struct Tree t;
+   char buf[4200];
+   boolean type;
+   size_t length;
+   size_t i;
+   size_t j;
+   size_t capFiles;
+   size_t nextNew = 0;
+   double start;
+
+   Bench_generateTree(&t, realisticNodes);
+   capFiles = t.numFiles;
+
+   (void) FT_init();
+   Bench_buildTree(&t);
+   /* only the mixed phase is reported */
+   samples[OP_INSERT_DIR].n = 0;
+   samples[OP_INSERT_FILE].n = 0;
+
+   for(i = 0; i < mixedOps; i++) {
+      if(Bench_uniform() < readRatio && t.numFiles > 0) {
+         j = Bench_below(t.numFiles);
+         switch(Bench_below(4)) {
+            case 0:
+               start = Bench_now();
+               (void) FT_containsFile(t.files[j]);
+               Bench_record(OP_CONTAINS_FILE, start);
+               break;
+            case 1:
+               start = Bench_now();
+               (void) FT_stat(t.files[j], &type, &length);
+               Bench_record(OP_STAT, start);
+               break;
+            case 2:
+               start = Bench_now();
+               (void) FT_getFileContents(t.files[j]);
+               Bench_record(OP_GET_CONTENTS, start);
+               break;
+            default:
+               start = Bench_now();
+               (void) FT_containsDir(t.dirs[Bench_below(t.numDirs)]);
+               Bench_record(OP_CONTAINS_DIR, start);
+               break;
+         }
+      }
+      else if(t.numFiles == 0 || Bench_below(3) == 0) {
+         sprintf(buf, "%s/new%lu", t.dirs[Bench_below(t.numDirs)],
+                 (unsigned long)nextNew++);
+         start = Bench_now();
+         (void) FT_insertFile(buf, NULL, 0);
+         Bench_record(OP_INSERT_FILE, start);
+         if(t.numFiles == capFiles) {
+            capFiles = 2 * capFiles + 1;
+            t.files = Bench_check(realloc(t.files,
+                                          capFiles * sizeof(char*)));
+         }
+         t.files[t.numFiles++] = Bench_strdup(buf);
+      }
+      else if(Bench_below(2) == 0) {
+         j = Bench_below(t.numFiles);
+         start = Bench_now();
+         (void) FT_replaceFileContents(t.files[j], NULL, i);
+         Bench_record(OP_REPLACE_CONTENTS, start);
+      }
+      else {
+         j = Bench_below(t.numFiles);
+         start = Bench_now();
+         (void) FT_rmFile(t.files[j]);
+         Bench_record(OP_RM_FILE, start);
+         free(t.files[j]);
+         t.files[j] = t.files[--t.numFiles];
+      }
+   }
+   (void) FT_destroy();
+
+   Bench_freeAll(t.dirs, t.numDirs);
+   Bench_freeAll(t.files, t.numFiles);
+   Bench_finishWorkload("mixed");
+}
+
+/* The number of times each order is sorted by each sort */
+enum { SORT_ROUNDS = 5 };
+
+/* Orders the size_t values at pvKey1 and pvKey2. */
+static int Bench_compareKeys(const void* pvKey1, const void* pvKey2) {
+   size_t key1 = *(const size_t*)pvKey1;
+   size_t key2 = *(const size_t*)pvKey2;
+
+   return (key1 > key2) - (key1 < key2);
+}
+
+/* Sorts sortLength keys in each of the orders named in orders,
+   SORT_ROUNDS times by DynArray_sort and as many by
+   DynArray_sortParallel with a thread per processor, checking each
+   result. */
+static void Bench_sort(void) {
+   static const char* orders[] = {
+      "sort-rand", "sort-asc", "sort-desc", "sort-dups", "sort-pipe"
+   };
+   DynArray_T array;
+   size_t* keys;
+   size_t i;
+   int order;
+   int round;
+   double start;
+
+   keys = Bench_check(malloc(sortLength * sizeof(size_t)));
+   array = Bench_check(DynArray_new(sortLength));
+
+   for(order = 0; order < 5; order++) {
+      for(round = 0; round < 2 * SORT_ROUNDS; round++) {
+         for(i = 0; i < sortLength; i++) {
+            switch(order) {
+               case 0: keys[i] = (size_t)Bench_random(); break;
+               case 1: keys[i] = i; break;
+               case 2: keys[i] = sortLength - i; break;
+               case 3: keys[i] = Bench_below(16); break;
+               default:
+                  keys[i] = (i < sortLength / 2) ? i : sortLength - i;
+                  break;
+            }
+            (void) DynArray_set(array, i, &keys[i]);
+         }
+
+         start = Bench_now();
+         if(round < SORT_ROUNDS) {
+            DynArray_sort(array, Bench_compareKeys);
+            Bench_record(OP_SORT, start);
+         }
+         else {
+            DynArray_sortParallel(array, Bench_compareKeys, 0);
+            Bench_record(OP_SORT_PARALLEL, start);
+         }
+
+         for(i = 1; i < sortLength; i++)
+            if(Bench_compareKeys(DynArray_get(array, i - 1),
+                                 DynArray_get(array, i)) > 0) {
+               fprintf(stderr, "bench_ft: %s is not sorted\n",
+                       orders[order]);
+               exit(EXIT_FAILURE);
+            }
+      }
+      Bench_finishWorkload(orders[order]);
+   }
+
+   DynArray_free(array);
+   free(keys);
+}
+
+/* Adds appendLength pointers one at a time to an empty DynArray and
+   then to an empty SegArray, timing each call, and checks that both
+   hold them in order. */
+static void Bench_append(void) {
+   DynArray_T array;
+   SegArray_T segments;
+   size_t* keys;
+   size_t i;
+   double start;
+
+   keys = Bench_check(malloc(appendLength * sizeof(size_t)));
+   array = Bench_check(DynArray_new(0));
+   segments = Bench_check(SegArray_new(0));
+
+   for(i = 0; i < appendLength; i++) {
+      keys[i] = i;
+      start = Bench_now();
+      if(!DynArray_add(array, &keys[i]))
+         Bench_check(NULL);
+      Bench_record(OP_DYN_ADD, start);
+   }
+   for(i = 0; i < appendLength; i++) {
+      start = Bench_now();
+      if(!SegArray_add(segments, &keys[i]))
+         Bench_check(NULL);
+      Bench_record(OP_SEG_ADD, start);
+   }
+
+   for(i = 0; i < appendLength; i++)
+      if(DynArray_get(array, i) != &keys[i] ||
+         SegArray_get(segments, i) != &keys[i]) {
+         fprintf(stderr, "bench_ft: append lost element %lu\n",
+                 (unsigned long)i);
+         exit(EXIT_FAILURE);
+      }
+   Bench_finishWorkload("append");
+
+   DynArray_free(array);
+   SegArray_free(segments);
+   free(keys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Prints the report in the given format: "text", "csv" or "json". */
+static void Bench_report(const char* format) {
+   struct Result* r;
+   size_t i;
+
+   if(!strcmp(format, "csv")) {
+      printf("workload,operation,count,ops_per_sec,"
+             "p50_ns,p99_ns,p999_ns,peak_rss_kb\n");
+      for(i = 0; i < numResults; i++) {
+         r = &results[i];
+         printf("%s,%s,%lu,%.0f,%.0f,%.0f,%.0f,%ld\n", r->workload,
+                opNames[r->op], (unsigned long)r->count, r->opsPerSec,
+                r->p50, r->p99, r->p999, r->peakRssKB);
+      }
+   }
+   else if(!strcmp(format, "json")) {
+      printf("{\n  \"results\": [\n");
+      for(i = 0; i < numResults; i++) {
+         r = &results[i];
+         printf("    {\"workload\": \"%s\", \"operation\": \"%s\", "
+                "\"count\": %lu, \"ops_per_sec\": %.0f, "
+                "\"p50_ns\": %.0f, \"p99_ns\": %.0f, "
+                "\"p999_ns\": %.0f, \"peak_rss_kb\": %ld}%s\n",
+                r->workload, opNames[r->op], (unsigned long)r->count,
+                r->opsPerSec, r->p50, r->p99, r->p999, r->peakRssKB,
+                (i + 1 < numResults) ? "," : "");
+      }
+      printf("  ],\n  \"peak_rss_kb\": %ld\n}\n", Bench_peakRssKB());
+   }
+   else {
+      printf("%-10s %-24s %10s %12s %10s %10s %10s\n", "workload",
+             "operation", "count", "ops/s", "p50 ns", "p99 ns",
+             "p999 ns");
+      for(i = 0; i < numResults; i++) {
+         r = &results[i];
+         printf("%-10s %-24s %10lu %12.0f %10.0f %10.0f %10.0f\n",
+                r->workload, opNames[r->op], (unsigned long)r->count,
+                r->opsPerSec, r->p50, r->p99, r->p999);
+      }
+      printf("peak RSS: %ld KB\n", Bench_peakRssKB());
+   }
+}
+
+/* Prints usage information to stderr. */
+static void Bench_usage(void) {
+   fprintf(stderr,
+      "usage: bench_ft [--workload=all|wide|deep|realistic|mixed|sort|"
+      "append]\n"
+      "                [--wide=N] [--deep=N] [--nodes=N] [--ops=N]\n"
+      "                [--sort=N] [--appends=N]\n"
+      "                [--read-ratio=R] [--seed=S]\n"
+      "                [--to-string-limit=N] [--trace=FILE]\n"
+      "                [--format=text|csv|json]\n");
+}
+
+/* Runs the benchmarks selected on the command line and prints the
+   report. Returns 0, or 1 if the arguments are invalid or the trace
+   cannot be written. */
+int main(int argc, char* argv[]) {
+   const char* workload = "all";
+   const char* format = "text";
+   const char* traceFile = NULL;
+   const char* value;
+   int i;
+
+   for(i = 1; i < argc; i++) {
+      value = strchr(argv[i], '=');
+      if(value == NULL) {
+         Bench_usage();
+         return 1;
+      }
+      value++;
+      if(!strncmp(argv[i], "--workload=", 11))
+         workload = value;
+      else if(!strncmp(argv[i], "--format=", 9))
+         format = value;
+      else if(!strncmp(argv[i], "--wide=", 7))
+         wideFiles = (size_t)strtoul(value, NULL, 10);
+      else if(!strncmp(argv[i], "--deep=", 7))
+         deepLevels = (size_t)strtoul(value, NULL, 10);
+      else if(!strncmp(argv[i], "--nodes=", 8))
+         realisticNodes = (size_t)strtoul(value, NULL, 10);
+      else if(!strncmp(argv[i], "--sort=", 7))
+         sortLength = (size_t)strtoul(value, NULL, 10);
+      else if(!strncmp(argv[i], "--appends=", 10))
+         appendLength = (size_t)strtoul(value, NULL, 10);
+      else if(!strncmp(argv[i], "--ops=", 6))
+         mixedOps = (size_t)strtoul(value, NULL, 10);
+      else if(!strncmp(argv[i], "--read-ratio=", 13))
+         readRatio = strtod(value, NULL);
+      else if(!strncmp(argv[i], "--trace=", 8))
+         traceFile = value;
+      else if(!strncmp(argv[i], "--to-string-limit=", 18))
+         toStringLimit = (size_t)strtoul(value, NULL, 10);
+      else if(!strncmp(argv[i], "--seed=", 7))
+         seed = strtoul(value, NULL, 10);
+      else {
+         Bench_usage();
+         return 1;
+      }
+   }
+   if(wideFiles == 0 || deepLevels == 0 || realisticNodes == 0 ||
+      sortLength == 0 || appendLength == 0) {
+      Bench_usage();
+      return 1;
+   }
+
+   if(traceFile != NULL && !FT_startTrace(traceFile)) {
+      fprintf(stderr, "bench_ft: cannot create %s\n", traceFile);
+      return 1;
+   }
+
+   rngState = seed * 2 + 1;
+   if(!strcmp(workload, "all") || !strcmp(workload, "wide"))
+      Bench_wide();
+   if(!strcmp(workload, "all") || !strcmp(workload, "deep"))
+      Bench_deep();
+   if(!strcmp(workload, "all") || !strcmp(workload, "realistic"))
+      Bench_realistic();
+   if(!strcmp(workload, "all") || !strcmp(workload, "mixed"))
+      Bench_mixed();
+   if(!strcmp(workload, "all") || !strcmp(workload, "sort"))
+      Bench_sort();
+   if(!strcmp(workload, "all") || !strcmp(workload, "append"))
+      Bench_append();
+
+   if(traceFile != NULL && !FT_stopTrace()) {
+      fprintf(stderr, "bench_ft: error writing %s\n", traceFile);
+      return 1;
+   }
+
+   Bench_report(format);
+   return 0;
+}
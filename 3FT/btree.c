@@ -0,0 +1,776 @@
+/*--------------------------------------------------------------------*/
+/* btree.c                                                            */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#include "btree.h"
+#include "stats.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The maximum number of entries (elements in a leaf, children in an
+   inner node) in any node of a BTree.  Nodes other than the root
+   never have fewer than half as many. */
+
+#ifndef BTREE_ORDER
+#define BTREE_ORDER 64
+#endif
+
+enum { MAX_ENTRIES = BTREE_ORDER, MIN_ENTRIES = BTREE_ORDER / 2 };
+
+/*--------------------------------------------------------------------*/
+
+/* Every node of a BTree begins with a BTreeNode header giving the
+   number of entries in use and whether it is a leaf.  Each array
+   below has one slot more than MAX_ENTRIES so that a node can
+   overflow briefly before it is split. */
+
+struct BTreeNode
+{
+   /* The number of entries in use. */
+   size_t uCount;
+
+   /* 1 (TRUE) if this is a BTreeLeaf, 0 (FALSE) if a BTreeInner. */
+   int iIsLeaf;
+};
+
+/* A leaf holds the elements themselves. */
+
+struct BTreeLeaf
+{
+   struct BTreeNode oHeader;
+
+   /* The elements, in sequence order. */
+   const void *apvElements[MAX_ENTRIES + 1];
+};
+
+/* An inner node holds its children, with the number of elements
+   beneath each and the first of them, so that both indexing and
+   searching can choose a child without visiting the others. */
+
+struct BTreeInner
+{
+   struct BTreeNode oHeader;
+
+   /* The number of elements beneath each child. */
+   size_t auSizes[MAX_ENTRIES + 1];
+
+   /* The first element beneath each child. */
+   const void *apvFirst[MAX_ENTRIES + 1];
+
+   /* The children, in sequence order. */
+   struct BTreeNode *apoChildren[MAX_ENTRIES + 1];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A BTree consists of its root node and length, along with spare
+   nodes set aside before each insertion, so that an insertion never
+   fails half way through splitting nodes. */
+
+struct BTree
+{
+   /* The number of elements in the BTree. */
+   size_t uLength;
+
+   /* The number of levels of inner nodes above the leaves. */
+   size_t uHeight;
+
+   /* The root node, which is an empty leaf when uLength is 0. */
+   struct BTreeNode *poRoot;
+
+   /* A spare leaf, or NULL. */
+   struct BTreeLeaf *poSpareLeaf;
+
+   /* Spare inner nodes, chained through apoChildren[0]. */
+   struct BTreeInner *poSpareInners;
+
+   /* The number of spare inner nodes. */
+   size_t uSpareInners;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of elements beneath poNode. */
+
+static size_t BTree_nodeSize(struct BTreeNode *poNode)
+{
+   struct BTreeInner *poInner;
+   size_t uSize = 0;
+   size_t u;
+
+   assert(poNode != NULL);
+
+   if (poNode->iIsLeaf)
+      return poNode->uCount;
+
+   poInner = (struct BTreeInner*)poNode;
+   for (u = 0; u < poNode->uCount; u++)
+      uSize += poInner->auSizes[u];
+   return uSize;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the first element beneath poNode, which must not be
+   empty. */
+
+static const void *BTree_nodeFirst(struct BTreeNode *poNode)
+{
+   assert(poNode != NULL);
+   assert(poNode->uCount > 0);
+
+   if (poNode->iIsLeaf)
+      return ((struct BTreeLeaf*)poNode)->apvElements[0];
+   return ((struct BTreeInner*)poNode)->apvFirst[0];
+}
+
+/*--------------------------------------------------------------------*/
+
+#ifndef NDEBUG
+
+/* Check the invariants of oBTree.  Return 1 (TRUE) iff oBTree
+   is in a valid state. */
+
+static int BTree_isValid(BTree_T oBTree)
+{
+   if (oBTree->poRoot == NULL) return 0;
+   if (oBTree->uHeight == 0 && ! oBTree->poRoot->iIsLeaf) return 0;
+   if (oBTree->uHeight > 0 && oBTree->poRoot->iIsLeaf) return 0;
+   if (BTree_nodeSize(oBTree->poRoot) != oBTree->uLength) return 0;
+   return 1;
+}
+
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* Set aside enough spare nodes in oBTree for one insertion to split
+   a node at every level and grow a new root.  Return 1 (TRUE) if
+   successful and 0 (FALSE) if insufficient memory is available. */
+
+static int BTree_reserveSpares(BTree_T oBTree)
+{
+   struct BTreeInner *poInner;
+
+   assert(oBTree != NULL);
+
+   if (oBTree->poSpareLeaf == NULL)
+   {
+      oBTree->poSpareLeaf =
+         (struct BTreeLeaf*)malloc(sizeof(struct BTreeLeaf));
+      if (oBTree->poSpareLeaf == NULL)
+         return 0;
+      STATS_ADD(mallocs, 1);
+   }
+
+   while (oBTree->uSpareInners < oBTree->uHeight + 1)
+   {
+      poInner = (struct BTreeInner*)malloc(sizeof(struct BTreeInner));
+      if (poInner == NULL)
+         return 0;
+      STATS_ADD(mallocs, 1);
+      poInner->apoChildren[0] = (struct BTreeNode*)oBTree->poSpareInners;
+      oBTree->poSpareInners = poInner;
+      oBTree->uSpareInners++;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Take a spare leaf from oBTree and return it, empty. */
+
+static struct BTreeLeaf *BTree_takeLeaf(BTree_T oBTree)
+{
+   struct BTreeLeaf *poLeaf;
+
+   assert(oBTree != NULL);
+   assert(oBTree->poSpareLeaf != NULL);
+
+   poLeaf = oBTree->poSpareLeaf;
+   oBTree->poSpareLeaf = NULL;
+   poLeaf->oHeader.uCount = 0;
+   poLeaf->oHeader.iIsLeaf = 1;
+   return poLeaf;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Take a spare inner node from oBTree and return it, empty. */
+
+static struct BTreeInner *BTree_takeInner(BTree_T oBTree)
+{
+   struct BTreeInner *poInner;
+
+   assert(oBTree != NULL);
+   assert(oBTree->uSpareInners > 0);
+
+   poInner = oBTree->poSpareInners;
+   oBTree->poSpareInners = (struct BTreeInner*)poInner->apoChildren[0];
+   oBTree->uSpareInners--;
+   poInner->oHeader.uCount = 0;
+   poInner->oHeader.iIsLeaf = 0;
+   return poInner;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free poNode and every node beneath it. */
+
+static void BTree_freeNode(struct BTreeNode *poNode)
+{
+   struct BTreeInner *poInner;
+   size_t u;
+
+   assert(poNode != NULL);
+
+   if (! poNode->iIsLeaf)
+   {
+      poInner = (struct BTreeInner*)poNode;
+      for (u = 0; u < poNode->uCount; u++)
+         BTree_freeNode(poInner->apoChildren[u]);
+   }
+   free(poNode);
+   STATS_ADD(frees, 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+BTree_T BTree_new(void)
+{
+   BTree_T oBTree;
+   struct BTreeLeaf *poLeaf;
+
+   oBTree = (struct BTree*)malloc(sizeof(struct BTree));
+   if (oBTree == NULL)
+      return NULL;
+
+   poLeaf = (struct BTreeLeaf*)malloc(sizeof(struct BTreeLeaf));
+   if (poLeaf == NULL)
+   {
+      free(oBTree);
+      STATS_ADD(frees, 1);
+      return NULL;
+   }
+   STATS_ADD(mallocs, 2);
+   poLeaf->oHeader.uCount = 0;
+   poLeaf->oHeader.iIsLeaf = 1;
+
+   oBTree->uLength = 0;
+   oBTree->uHeight = 0;
+   oBTree->poRoot = (struct BTreeNode*)poLeaf;
+   oBTree->poSpareLeaf = NULL;
+   oBTree->poSpareInners = NULL;
+   oBTree->uSpareInners = 0;
+
+   return oBTree;
+}
+
+/*--------------------------------------------------------------------*/
+
+void BTree_free(BTree_T oBTree)
+{
+   struct BTreeInner *poInner;
+
+   assert(oBTree != NULL);
+   assert(BTree_isValid(oBTree));
+
+   BTree_freeNode(oBTree->poRoot);
+   if (oBTree->poSpareLeaf != NULL)
+   {
+      free(oBTree->poSpareLeaf);
+      STATS_ADD(frees, 1);
+   }
+   while (oBTree->poSpareInners != NULL)
+   {
+      poInner = oBTree->poSpareInners;
+      oBTree->poSpareInners =
+         (struct BTreeInner*)poInner->apoChildren[0];
+      free(poInner);
+      STATS_ADD(frees, 1);
+   }
+   free(oBTree);
+   STATS_ADD(frees, 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t BTree_getLength(BTree_T oBTree)
+{
+   assert(oBTree != NULL);
+   assert(BTree_isValid(oBTree));
+
+   return oBTree->uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *BTree_get(BTree_T oBTree, size_t uIndex)
+{
+   struct BTreeNode *poNode;
+   struct BTreeInner *poInner;
+   size_t u;
+
+   assert(oBTree != NULL);
+   assert(uIndex < oBTree->uLength);
+
+   poNode = oBTree->poRoot;
+   while (! poNode->iIsLeaf)
+   {
+      poInner = (struct BTreeInner*)poNode;
+      for (u = 0; uIndex >= poInner->auSizes[u]; u++)
+         uIndex -= poInner->auSizes[u];
+      poNode = poInner->apoChildren[u];
+   }
+
+   return (void*)((struct BTreeLeaf*)poNode)->apvElements[uIndex];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Insert pvElement as the uIndex'th element beneath poNode, splitting
+   poNode if it overflows.  Return the new right half of poNode if it
+   was split, or NULL otherwise.  Any nodes needed must already be
+   set aside in oBTree. */
+
+static struct BTreeNode *BTree_insertHelp(BTree_T oBTree,
+                                          struct BTreeNode *poNode,
+                                          size_t uIndex,
+                                          const void *pvElement)
+{
+   struct BTreeLeaf *poLeaf;
+   struct BTreeLeaf *poLeafRight;
+   struct BTreeInner *poInner;
+   struct BTreeInner *poInnerRight;
+   struct BTreeNode *poSplit;
+   size_t uKeep;
+   size_t u;
+
+   assert(poNode != NULL);
+
+   if (poNode->iIsLeaf)
+   {
+      poLeaf = (struct BTreeLeaf*)poNode;
+      memmove(&poLeaf->apvElements[uIndex + 1],
+              &poLeaf->apvElements[uIndex],
+              (poNode->uCount - uIndex) * sizeof(void*));
+      poLeaf->apvElements[uIndex] = pvElement;
+      poNode->uCount++;
+      if (poNode->uCount <= MAX_ENTRIES)
+         return NULL;
+
+      poLeafRight = BTree_takeLeaf(oBTree);
+      uKeep = poNode->uCount / 2;
+      poLeafRight->oHeader.uCount = poNode->uCount - uKeep;
+      memcpy(poLeafRight->apvElements, &poLeaf->apvElements[uKeep],
+             poLeafRight->oHeader.uCount * sizeof(void*));
+      poNode->uCount = uKeep;
+      return (struct BTreeNode*)poLeafRight;
+   }
+
+   poInner = (struct BTreeInner*)poNode;
+   for (u = 0; u < poNode->uCount - 1 && uIndex > poInner->auSizes[u];
+        u++)
+      uIndex -= poInner->auSizes[u];
+
+   poSplit = BTree_insertHelp(oBTree, poInner->apoChildren[u], uIndex,
+                              pvElement);
+   poInner->auSizes[u]++;
+   poInner->apvFirst[u] = BTree_nodeFirst(poInner->apoChildren[u]);
+   if (poSplit == NULL)
+      return NULL;
+
+   /* Link the new right half in just after the child it split from. */
+   memmove(&poInner->auSizes[u + 2], &poInner->auSizes[u + 1],
+           (poNode->uCount - u - 1) * sizeof(size_t));
+   memmove(&poInner->apvFirst[u + 2], &poInner->apvFirst[u + 1],
+           (poNode->uCount - u - 1) * sizeof(void*));
+   memmove(&poInner->apoChildren[u + 2], &poInner->apoChildren[u + 1],
+           (poNode->uCount - u - 1) * sizeof(struct BTreeNode*));
+   poInner->auSizes[u + 1] = BTree_nodeSize(poSplit);
+   poInner->auSizes[u] -= poInner->auSizes[u + 1];
+   poInner->apvFirst[u + 1] = BTree_nodeFirst(poSplit);
+   poInner->apoChildren[u + 1] = poSplit;
+   poNode->uCount++;
+   if (poNode->uCount <= MAX_ENTRIES)
+      return NULL;
+
+   poInnerRight = BTree_takeInner(oBTree);
+   uKeep = poNode->uCount / 2;
+   poInnerRight->oHeader.uCount = poNode->uCount - uKeep;
+   memcpy(poInnerRight->auSizes, &poInner->auSizes[uKeep],
+          poInnerRight->oHeader.uCount * sizeof(size_t));
+   memcpy(poInnerRight->apvFirst, &poInner->apvFirst[uKeep],
+          poInnerRight->oHeader.uCount * sizeof(void*));
+   memcpy(poInnerRight->apoChildren, &poInner->apoChildren[uKeep],
+          poInnerRight->oHeader.uCount * sizeof(struct BTreeNode*));
+   poNode->uCount = uKeep;
+   return (struct BTreeNode*)poInnerRight;
+}
+
+/*--------------------------------------------------------------------*/
+
+int BTree_addAt(BTree_T oBTree, size_t uIndex, const void *pvElement)
+{
+   struct BTreeNode *poSplit;
+   struct BTreeInner *poNewRoot;
+
+   assert(oBTree != NULL);
+   assert(uIndex <= oBTree->uLength);
+   assert(BTree_isValid(oBTree));
+
+   if (! BTree_reserveSpares(oBTree))
+      return 0;
+
+   poSplit = BTree_insertHelp(oBTree, oBTree->poRoot, uIndex,
+                              pvElement);
+   if (poSplit != NULL)
+   {
+      poNewRoot = BTree_takeInner(oBTree);
+      poNewRoot->oHeader.uCount = 2;
+      poNewRoot->apoChildren[0] = oBTree->poRoot;
+      poNewRoot->apoChildren[1] = poSplit;
+      poNewRoot->auSizes[1] = BTree_nodeSize(poSplit);
+      poNewRoot->auSizes[0] =
+         oBTree->uLength + 1 - poNewRoot->auSizes[1];
+      poNewRoot->apvFirst[0] = BTree_nodeFirst(oBTree->poRoot);
+      poNewRoot->apvFirst[1] = BTree_nodeFirst(poSplit);
+      oBTree->poRoot = (struct BTreeNode*)poNewRoot;
+      oBTree->uHeight++;
+   }
+   oBTree->uLength++;
+
+   assert(BTree_isValid(oBTree));
+
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move one entry into poInner's uIndex'th child, which has too few,
+   from a sibling that can spare one, or else merge the child with a
+   sibling. */
+
+static void BTree_rebalance(struct BTreeInner *poInner, size_t uIndex)
+{
+   struct BTreeNode *poChild;
+   struct BTreeNode *poLeft;
+   struct BTreeNode *poRight;
+   struct BTreeInner *poL;
+   struct BTreeInner *poR;
+   size_t uL;
+   size_t uR;
+
+   assert(poInner != NULL);
+
+   poChild = poInner->apoChildren[uIndex];
+
+   if (uIndex > 0 &&
+       poInner->apoChildren[uIndex - 1]->uCount > MIN_ENTRIES)
+   {
+      /* Borrow the last entry of the left sibling. */
+      uL = uIndex - 1;
+      uR = uIndex;
+   }
+   else if (uIndex + 1 < poInner->oHeader.uCount &&
+            poInner->apoChildren[uIndex + 1]->uCount > MIN_ENTRIES)
+   {
+      /* Borrow the first entry of the right sibling. */
+      uL = uIndex;
+      uR = uIndex + 1;
+   }
+   else
+   {
+      /* Merge with a sibling: the right one of the pair into the
+         left one. */
+      uL = (uIndex > 0) ? uIndex - 1 : uIndex;
+      uR = uL + 1;
+      poLeft = poInner->apoChildren[uL];
+      poRight = poInner->apoChildren[uR];
+      if (poLeft->iIsLeaf)
+         memcpy(&((struct BTreeLeaf*)poLeft)->
+                   apvElements[poLeft->uCount],
+                ((struct BTreeLeaf*)poRight)->apvElements,
+                poRight->uCount * sizeof(void*));
+      else
+      {
+         poL = (struct BTreeInner*)poLeft;
+         poR = (struct BTreeInner*)poRight;
+         memcpy(&poL->auSizes[poLeft->uCount], poR->auSizes,
+                poRight->uCount * sizeof(size_t));
+         memcpy(&poL->apvFirst[poLeft->uCount], poR->apvFirst,
+                poRight->uCount * sizeof(void*));
+         memcpy(&poL->apoChildren[poLeft->uCount], poR->apoChildren,
+                poRight->uCount * sizeof(struct BTreeNode*));
+      }
+      poLeft->uCount += poRight->uCount;
+      poInner->auSizes[uL] += poInner->auSizes[uR];
+      poInner->apvFirst[uL] = BTree_nodeFirst(poLeft);
+      free(poRight);
+      STATS_ADD(frees, 1);
+
+      memmove(&poInner->auSizes[uR], &poInner->auSizes[uR + 1],
+              (poInner->oHeader.uCount - uR - 1) * sizeof(size_t));
+      memmove(&poInner->apvFirst[uR], &poInner->apvFirst[uR + 1],
+              (poInner->oHeader.uCount - uR - 1) * sizeof(void*));
+      memmove(&poInner->apoChildren[uR], &poInner->apoChildren[uR + 1],
+              (poInner->oHeader.uCount - uR - 1)
+              * sizeof(struct BTreeNode*));
+      poInner->oHeader.uCount--;
+      return;
+   }
+
+   poLeft = poInner->apoChildren[uL];
+   poRight = poInner->apoChildren[uR];
+
+   if (poChild->iIsLeaf)
+   {
+      if (poChild == poRight)
+      {
+         memmove(&((struct BTreeLeaf*)poRight)->apvElements[1],
+                 ((struct BTreeLeaf*)poRight)->apvElements,
+                 poRight->uCount * sizeof(void*));
+         ((struct BTreeLeaf*)poRight)->apvElements[0] =
+            ((struct BTreeLeaf*)poLeft)->apvElements[poLeft->uCount-1];
+         poLeft->uCount--;
+         poRight->uCount++;
+         poInner->auSizes[uL]--;
+         poInner->auSizes[uR]++;
+      }
+      else
+      {
+         ((struct BTreeLeaf*)poLeft)->apvElements[poLeft->uCount] =
+            ((struct BTreeLeaf*)poRight)->apvElements[0];
+         memmove(((struct BTreeLeaf*)poRight)->apvElements,
+                 &((struct BTreeLeaf*)poRight)->apvElements[1],
+                 (poRight->uCount - 1) * sizeof(void*));
+         poLeft->uCount++;
+         poRight->uCount--;
+         poInner->auSizes[uL]++;
+         poInner->auSizes[uR]--;
+      }
+   }
+   else
+   {
+      poL = (struct BTreeInner*)poLeft;
+      poR = (struct BTreeInner*)poRight;
+      if (poChild == poRight)
+      {
+         memmove(&poR->auSizes[1], poR->auSizes,
+                 poRight->uCount * sizeof(size_t));
+         memmove(&poR->apvFirst[1], poR->apvFirst,
+                 poRight->uCount * sizeof(void*));
+         memmove(&poR->apoChildren[1], poR->apoChildren,
+                 poRight->uCount * sizeof(struct BTreeNode*));
+         poR->auSizes[0] = poL->auSizes[poLeft->uCount - 1];
+         poR->apvFirst[0] = poL->apvFirst[poLeft->uCount - 1];
+         poR->apoChildren[0] = poL->apoChildren[poLeft->uCount - 1];
+         poLeft->uCount--;
+         poRight->uCount++;
+         poInner->auSizes[uL] -= poR->auSizes[0];
+         poInner->auSizes[uR] += poR->auSizes[0];
+      }
+      else
+      {
+         poL->auSizes[poLeft->uCount] = poR->auSizes[0];
+         poL->apvFirst[poLeft->uCount] = poR->apvFirst[0];
+         poL->apoChildren[poLeft->uCount] = poR->apoChildren[0];
+         poInner->auSizes[uL] += poR->auSizes[0];
+         poInner->auSizes[uR] -= poR->auSizes[0];
+         memmove(poR->auSizes, &poR->auSizes[1],
+                 (poRight->uCount - 1) * sizeof(size_t));
+         memmove(poR->apvFirst, &poR->apvFirst[1],
+                 (poRight->uCount - 1) * sizeof(void*));
+         memmove(poR->apoChildren, &poR->apoChildren[1],
+                 (poRight->uCount - 1) * sizeof(struct BTreeNode*));
+         poLeft->uCount++;
+         poRight->uCount--;
+      }
+   }
+
+   poInner->apvFirst[uL] = BTree_nodeFirst(poLeft);
+   poInner->apvFirst[uR] = BTree_nodeFirst(poRight);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remove and return the uIndex'th element beneath poNode, leaving
+   poNode with too few entries only if it is a leaf or the root. */
+
+static const void *BTree_removeHelp(struct BTreeNode *poNode,
+                                    size_t uIndex)
+{
+   struct BTreeLeaf *poLeaf;
+   struct BTreeInner *poInner;
+   const void *pvOldElement;
+   size_t u;
+
+   assert(poNode != NULL);
+
+   if (poNode->iIsLeaf)
+   {
+      poLeaf = (struct BTreeLeaf*)poNode;
+      pvOldElement = poLeaf->apvElements[uIndex];
+      memmove(&poLeaf->apvElements[uIndex],
+              &poLeaf->apvElements[uIndex + 1],
+              (poNode->uCount - uIndex - 1) * sizeof(void*));
+      poNode->uCount--;
+      return pvOldElement;
+   }
+
+   poInner = (struct BTreeInner*)poNode;
+   for (u = 0; uIndex >= poInner->auSizes[u]; u++)
+      uIndex -= poInner->auSizes[u];
+
+   pvOldElement = BTree_removeHelp(poInner->apoChildren[u], uIndex);
+   poInner->auSizes[u]--;
+   if (poInner->apoChildren[u]->uCount < MIN_ENTRIES)
+      BTree_rebalance(poInner, u);
+   else
+      poInner->apvFirst[u] = BTree_nodeFirst(poInner->apoChildren[u]);
+
+   return pvOldElement;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *BTree_removeAt(BTree_T oBTree, size_t uIndex)
+{
+   const void *pvOldElement;
+   struct BTreeNode *poOldRoot;
+
+   assert(oBTree != NULL);
+   assert(uIndex < oBTree->uLength);
+   assert(BTree_isValid(oBTree));
+
+   pvOldElement = BTree_removeHelp(oBTree->poRoot, uIndex);
+   oBTree->uLength--;
+
+   /* An inner root left with one child gives way to that child. */
+   if (! oBTree->poRoot->iIsLeaf && oBTree->poRoot->uCount == 1)
+   {
+      poOldRoot = oBTree->poRoot;
+      oBTree->poRoot =
+         ((struct BTreeInner*)poOldRoot)->apoChildren[0];
+      free(poOldRoot);
+      STATS_ADD(frees, 1);
+      oBTree->uHeight--;
+   }
+
+   assert(BTree_isValid(oBTree));
+
+   return (void*)pvOldElement;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Apply *pfApply to each element beneath poNode, in order. */
+
+static void BTree_mapHelp(struct BTreeNode *poNode,
+                          void (*pfApply)(void *pvElement,
+                                          void *pvExtra),
+                          const void *pvExtra)
+{
+   size_t u;
+
+   assert(poNode != NULL);
+
+   if (poNode->iIsLeaf)
+      for (u = 0; u < poNode->uCount; u++)
+         (*pfApply)(
+            (void*)((struct BTreeLeaf*)poNode)->apvElements[u],
+            (void*)pvExtra);
+   else
+      for (u = 0; u < poNode->uCount; u++)
+         BTree_mapHelp(((struct BTreeInner*)poNode)->apoChildren[u],
+                       pfApply, pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+void BTree_map(BTree_T oBTree,
+               void (*pfApply)(void *pvElement, void *pvExtra),
+               const void *pvExtra)
+{
+   assert(oBTree != NULL);
+   assert(pfApply != NULL);
+   assert(BTree_isValid(oBTree));
+
+   BTree_mapHelp(oBTree->poRoot, pfApply, pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+int BTree_bsearch(BTree_T oBTree,
+                  void *pvSoughtElement,
+                  size_t *puIndex,
+                  int (*pfCompare)(const void *pvElement1,
+                                   const void *pvElement2))
+{
+   struct BTreeNode *poNode;
+   struct BTreeInner *poInner;
+   struct BTreeLeaf *poLeaf;
+   size_t uOffset = 0;
+   size_t uLo;
+   size_t uHi;
+   size_t uMid;
+   size_t uChild;
+   size_t u;
+   int iCompare;
+
+   assert(oBTree != NULL);
+   assert(puIndex != NULL);
+   assert(pfCompare != NULL);
+   assert(BTree_isValid(oBTree));
+
+   poNode = oBTree->poRoot;
+   while (! poNode->iIsLeaf)
+   {
+      /* Descend into the last child whose first element is not
+         greater than the sought one (or the first child if none). */
+      poInner = (struct BTreeInner*)poNode;
+      uChild = 0;
+      uLo = 1;
+      uHi = poNode->uCount;
+      while (uLo < uHi)
+      {
+         uMid = uLo + (uHi - uLo) / 2;
+         if ((*pfCompare)(pvSoughtElement, poInner->apvFirst[uMid]) < 0)
+            uHi = uMid;
+         else
+         {
+            uChild = uMid;
+            uLo = uMid + 1;
+         }
+      }
+      for (u = 0; u < uChild; u++)
+         uOffset += poInner->auSizes[u];
+      poNode = poInner->apoChildren[uChild];
+   }
+
+   poLeaf = (struct BTreeLeaf*)poNode;
+   uLo = 0;
+   uHi = poNode->uCount;
+   while (uLo < uHi)
+   {
+      uMid = uLo + (uHi - uLo) / 2;
+      iCompare = (*pfCompare)(pvSoughtElement,
+                              poLeaf->apvElements[uMid]);
+      if (iCompare == 0)
+      {
+         *puIndex = uOffset + uMid;
+         return 1;
+      }
+      if (iCompare < 0)
+         uHi = uMid;
+      else
+         uLo = uMid + 1;
+   }
+
+   *puIndex = uOffset + uLo;
+   return 0;
+}
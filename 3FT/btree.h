@@ -0,0 +1,85 @@
+/*--------------------------------------------------------------------*/
+/* btree.h                                                            */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#ifndef BTREE_INCLUDED
+#define BTREE_INCLUDED
+
+#include <stddef.h>
+
+/* A BTree_T object is a sequence of elements, like a DynArray_T, but
+   stored in a B-tree whose nodes count the elements beneath them, so
+   that getting, adding or removing the uIndex'th element costs
+   O(log n) rather than shifting the elements after it. When the
+   client keeps the sequence sorted, BTree_bsearch finds elements in
+   O(log n) as well. */
+
+typedef struct BTree *BTree_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty BTree_T object, or NULL if insufficient memory
+   is available. */
+
+BTree_T BTree_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oBTree. */
+
+void BTree_free(BTree_T oBTree);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the length of oBTree. */
+
+size_t BTree_getLength(BTree_T oBTree);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the uIndex'th element of oBTree. */
+
+void *BTree_get(BTree_T oBTree, size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Add pvElement to oBTree such that it is the uIndex'th element.
+   Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory
+   is available, in which case oBTree is unchanged. */
+
+int BTree_addAt(BTree_T oBTree, size_t uIndex, const void *pvElement);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove and return the uIndex'th element of oBTree. */
+
+void *BTree_removeAt(BTree_T oBTree, size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Apply function *pfApply to each element of oBTree in order, passing
+   pvExtra as an extra argument.  That is, for each element pvElement
+   of oBTree, call (*pfApply)(pvElement, pvExtra). */
+
+void BTree_map(BTree_T oBTree,
+               void (*pfApply)(void *pvElement, void *pvExtra),
+               const void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Binary search oBTree for *pvSoughtElement using *pfCompare to
+   determine equality.  If the element is found, then assign its
+   index to *puIndex and return 1.  If the element is not found, then
+   assign the index where it would belong to *puIndex and return 0.
+   *pfCompare must return <0, 0, or >0 if *pvElement1 is less than,
+   equal to, or greater than *pvElement2.
+   oBTree must be sorted as determined by *pfCompare. */
+
+int BTree_bsearch(BTree_T oBTree,
+                  void *pvSoughtElement,
+                  size_t *puIndex,
+                  int (*pfCompare)(const void *pvElement1,
+                                   const void *pvElement2));
+
+#endif
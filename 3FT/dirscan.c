@@ -0,0 +1,661 @@
+/*--------------------------------------------------------------------*/
+/* dirscan.c                                                          */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "dirscan.h"
+#include "stats.h"
+#include <assert.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The most threads DirScan_run starts. */
+
+enum { MAX_SCAN_THREADS = 64 };
+
+/* The size of each chunk of memory that holds paths. */
+
+enum { CHUNK_BYTES = 65536 };
+
+/* The number of entries a listing has room for at first. */
+
+enum { MIN_ENTRIES = 16 };
+
+/*--------------------------------------------------------------------*/
+
+/* A Chunk is a block of memory from which the paths of one thread are
+   allocated, consecutively, and freed all at once.  Its bytes follow
+   it. */
+
+struct Chunk
+{
+   struct Chunk *psNext;
+   size_t uUsed;
+   size_t uSize;
+};
+
+/* A Task is a directory waiting to be listed: its path on disk, and
+   its path in the FT. */
+
+struct Task
+{
+   char *pcFsPath;
+   const char *pcFtPath;
+   struct Task *psNext;
+};
+
+/* A Listing holds the entries of one directory, sorted by name. */
+
+struct Listing
+{
+   struct FT_BatchEntry *psEntries;
+   size_t uCount;
+   struct Listing *psNext;
+};
+
+/* A Worker is one thread of DirScan_run, with the Chunks that hold
+   the paths it made. */
+
+struct Worker
+{
+   DirScan_T oScan;
+   struct Chunk *psChunks;
+   pthread_t thread;
+   int iStarted;
+};
+
+/* A DirScan consists of the state its threads share, guarded by a
+   mutex, and the entries they found. */
+
+struct DirScan
+{
+   /* Guards the fields from psTasks to uReads. */
+   pthread_mutex_t oMutex;
+
+   /* Signalled when a task is added or finished, or a read ends. */
+   pthread_cond_t oChanged;
+
+   /* The directories waiting to be listed, and the number being
+      listed. */
+   struct Task *psTasks;
+   size_t uBusy;
+
+   /* The directories listed, each after its parent. */
+   struct Listing *psFirst;
+   struct Listing **ppsLast;
+
+   /* SUCCESS, or the status of the first failure. */
+   int iResult;
+
+   /* The number of reads of contents under way. */
+   size_t uReads;
+
+   /* What to read, and how many reads may be under way at once. */
+   int iReadContents;
+   size_t uMaxReads;
+
+   /* The Chunks of every thread, once the scan is done. */
+   struct Chunk *psChunks;
+
+   /* The entries, once the scan is done. */
+   struct FT_BatchEntry *psEntries;
+   size_t uCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return uSize bytes from the Chunks at *ppsChunks, adding one if
+   they have too little room left, or NULL if insufficient memory is
+   available. */
+
+static char *DirScan_alloc(struct Chunk **ppsChunks, size_t uSize)
+{
+   struct Chunk *psChunk = *ppsChunks;
+   size_t uChunkSize;
+   char *pcBytes;
+
+   assert(ppsChunks != NULL);
+
+   if (psChunk == NULL || psChunk->uSize - psChunk->uUsed < uSize)
+   {
+      uChunkSize = uSize > CHUNK_BYTES ? uSize : CHUNK_BYTES;
+      psChunk = malloc(sizeof(struct Chunk) + uChunkSize);
+      if (psChunk == NULL)
+         return NULL;
+      STATS_ADD(mallocs, 1);
+      psChunk->uUsed = 0;
+      psChunk->uSize = uChunkSize;
+      psChunk->psNext = *ppsChunks;
+      *ppsChunks = psChunk;
+   }
+   pcBytes = (char*)(psChunk + 1) + psChunk->uUsed;
+   psChunk->uUsed += uSize;
+   return pcBytes;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return pcDir, '/' and pcName joined, allocated from the Chunks at
+   *ppsChunks, or NULL if insufficient memory is available. */
+
+static char *DirScan_join(struct Chunk **ppsChunks, const char *pcDir,
+                          const char *pcName)
+{
+   size_t uDirLength = strlen(pcDir);
+   size_t uNameLength = strlen(pcName);
+   char *pcPath;
+
+   pcPath = DirScan_alloc(ppsChunks, uDirLength + uNameLength + 2);
+   if (pcPath == NULL)
+      return NULL;
+   memcpy(pcPath, pcDir, uDirLength);
+   pcPath[uDirLength] = '/';
+   memcpy(pcPath + uDirLength + 1, pcName, uNameLength + 1);
+   return pcPath;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the Chunks at psChunks. */
+
+static void DirScan_freeChunks(struct Chunk *psChunks)
+{
+   struct Chunk *psNext;
+
+   for (; psChunks != NULL; psChunks = psNext)
+   {
+      psNext = psChunks->psNext;
+      free(psChunks);
+      STATS_ADD(frees, 1);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return <0, 0, or >0 as the path of the FT_BatchEntry at pvEntry1 is
+   less than, equal to, or greater than that at pvEntry2.  Entries of
+   one directory share all but their names, so this sorts them by
+   name, as the FT does. */
+
+static int DirScan_compareEntries(const void *pvEntry1,
+                                  const void *pvEntry2)
+{
+   const struct FT_BatchEntry *psEntry1 = pvEntry1;
+   const struct FT_BatchEntry *psEntry2 = pvEntry2;
+
+   return strcmp(psEntry1->path, psEntry2->path);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read the uLength bytes of the file named pcName in the directory
+   open as iDirFd, if it can be opened, waiting for one of oScan's
+   reads to end first if as many as it allows are under way.  Store
+   a new buffer holding them in *ppvContents, or NULL if there are
+   none or the file cannot be read, and the number read in *puLength.
+   Return SUCCESS, or MEMORY_ERROR if insufficient memory is
+   available. */
+
+static int DirScan_readFile(DirScan_T oScan, int iDirFd,
+                            const char *pcName, size_t uLength,
+                            void **ppvContents, size_t *puLength)
+{
+   char *pcContents;
+   size_t uRead = 0;
+   ssize_t iBytes;
+   int iFd;
+
+   *ppvContents = NULL;
+   if (uLength == 0)
+      return SUCCESS;
+   pcContents = malloc(uLength);
+   if (pcContents == NULL)
+      return MEMORY_ERROR;
+   STATS_ADD(mallocs, 1);
+
+   pthread_mutex_lock(&oScan->oMutex);
+   while (oScan->uMaxReads != 0 && oScan->uReads >= oScan->uMaxReads)
+      pthread_cond_wait(&oScan->oChanged, &oScan->oMutex);
+   oScan->uReads++;
+   pthread_mutex_unlock(&oScan->oMutex);
+
+   iFd = openat(iDirFd, pcName, O_RDONLY);
+   if (iFd >= 0)
+   {
+      while (uRead < uLength)
+      {
+         iBytes = read(iFd, pcContents + uRead, uLength - uRead);
+         if (iBytes <= 0)
+            break;
+         uRead += (size_t)iBytes;
+      }
+      (void)close(iFd);
+   }
+
+   pthread_mutex_lock(&oScan->oMutex);
+   oScan->uReads--;
+   pthread_cond_broadcast(&oScan->oChanged);
+   pthread_mutex_unlock(&oScan->oMutex);
+
+   if (iFd < 0)
+   {
+      free(pcContents);
+      STATS_ADD(frees, 1);
+      return SUCCESS;
+   }
+   *ppvContents = pcContents;
+   *puLength = uRead;
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add an entry for the file or directory named pcName, described by
+   *psStat, in the directory open as iDirFd, to *psListing, which has
+   room for *puCapacity entries; if it is a directory, then push a
+   Task for it onto *ppsSubdirs.  psTask is the directory's Task.
+   Return SUCCESS, or MEMORY_ERROR if insufficient memory is
+   available. */
+
+static int DirScan_addEntry(struct Worker *psWorker, struct Task *psTask,
+                            int iDirFd, const char *pcName,
+                            const struct stat *psStat,
+                            struct Listing *psListing,
+                            size_t *puCapacity, struct Task **ppsSubdirs)
+{
+   struct FT_BatchEntry *psEntry;
+   struct FT_BatchEntry *psNew;
+   struct Task *psSubdir;
+   char *pcPath;
+
+   if (psListing->uCount == *puCapacity)
+   {
+      psNew = realloc(psListing->psEntries,
+                      2 * *puCapacity * sizeof(struct FT_BatchEntry));
+      if (psNew == NULL)
+         return MEMORY_ERROR;
+      STATS_ADD(grows, 1);
+      psListing->psEntries = psNew;
+      *puCapacity *= 2;
+   }
+
+   pcPath = DirScan_join(&psWorker->psChunks, psTask->pcFtPath, pcName);
+   if (pcPath == NULL)
+      return MEMORY_ERROR;
+   psEntry = &psListing->psEntries[psListing->uCount];
+   psEntry->path = pcPath;
+   psEntry->contents = NULL;
+   psEntry->length = 0;
+
+   if (S_ISDIR(psStat->st_mode))
+   {
+      psEntry->isFile = FALSE;
+      psSubdir = malloc(sizeof(struct Task));
+      if (psSubdir == NULL)
+         return MEMORY_ERROR;
+      STATS_ADD(mallocs, 1);
+      psSubdir->pcFtPath = pcPath;
+      psSubdir->pcFsPath = DirScan_join(&psWorker->psChunks,
+                                        psTask->pcFsPath, pcName);
+      if (psSubdir->pcFsPath == NULL)
+      {
+         free(psSubdir);
+         STATS_ADD(frees, 1);
+         return MEMORY_ERROR;
+      }
+      psSubdir->psNext = *ppsSubdirs;
+      *ppsSubdirs = psSubdir;
+   }
+   else
+   {
+      psEntry->isFile = TRUE;
+      psEntry->length = (size_t)psStat->st_size;
+      if (psWorker->oScan->iReadContents &&
+          DirScan_readFile(psWorker->oScan, iDirFd, pcName,
+                           psEntry->length, &psEntry->contents,
+                           &psEntry->length) != SUCCESS)
+         return MEMORY_ERROR;
+   }
+
+   psListing->uCount++;
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the contents read for the uCount entries at psEntries. */
+
+static void DirScan_freeContents(struct FT_BatchEntry *psEntries,
+                                 size_t uCount)
+{
+   size_t u;
+
+   for (u = 0; u < uCount; u++)
+      if (psEntries[u].contents != NULL)
+      {
+         free(psEntries[u].contents);
+         STATS_ADD(frees, 1);
+      }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the Tasks at psTasks. */
+
+static void DirScan_freeTasks(struct Task *psTasks)
+{
+   struct Task *psNext;
+
+   for (; psTasks != NULL; psTasks = psNext)
+   {
+      psNext = psTasks->psNext;
+      free(psTasks);
+      STATS_ADD(frees, 1);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* List the directory of psTask: each entry is stat'ed relative to the
+   open directory, so the kernel resolves only its name.  Store the
+   sorted entries in a new Listing in *ppsListing, and push a Task for
+   each subdirectory onto *ppsSubdirs.  Return SUCCESS, or
+   MEMORY_ERROR, storing nothing, if insufficient memory is
+   available. */
+
+static int DirScan_list(struct Worker *psWorker, struct Task *psTask,
+                        struct Listing **ppsListing,
+                        struct Task **ppsSubdirs)
+{
+   struct Listing *psListing;
+   struct dirent *psDirent;
+   struct stat sStat;
+   DIR *psDir = NULL;
+   size_t uCapacity = MIN_ENTRIES;
+   int iFd;
+   int iResult = SUCCESS;
+
+   *ppsSubdirs = NULL;
+   psListing = malloc(sizeof(struct Listing));
+   if (psListing == NULL)
+      return MEMORY_ERROR;
+   psListing->psEntries = malloc(uCapacity * sizeof(struct FT_BatchEntry));
+   psListing->uCount = 0;
+   psListing->psNext = NULL;
+   STATS_ADD(mallocs, 2);
+   if (psListing->psEntries == NULL)
+      iResult = MEMORY_ERROR;
+
+   iFd = open(psTask->pcFsPath, O_RDONLY | O_DIRECTORY);
+   if (iFd >= 0)
+   {
+      psDir = fdopendir(iFd);
+      if (psDir == NULL)
+         (void)close(iFd);
+   }
+
+   while (psDir != NULL && iResult == SUCCESS &&
+          (psDirent = readdir(psDir)) != NULL)
+   {
+      if (strcmp(psDirent->d_name, ".") == 0 ||
+          strcmp(psDirent->d_name, "..") == 0)
+         continue;
+      if (fstatat(iFd, psDirent->d_name, &sStat, AT_SYMLINK_NOFOLLOW) != 0
+          || !(S_ISDIR(sStat.st_mode) || S_ISREG(sStat.st_mode)))
+         continue;
+      iResult = DirScan_addEntry(psWorker, psTask, iFd, psDirent->d_name,
+                                 &sStat, psListing, &uCapacity,
+                                 ppsSubdirs);
+   }
+   if (psDir != NULL)
+      (void)closedir(psDir);
+
+   if (iResult != SUCCESS)
+   {
+      if (psListing->psEntries != NULL)
+         DirScan_freeContents(psListing->psEntries, psListing->uCount);
+      DirScan_freeTasks(*ppsSubdirs);
+      *ppsSubdirs = NULL;
+      free(psListing->psEntries);
+      free(psListing);
+      STATS_ADD(frees, 2);
+      return iResult;
+   }
+
+   qsort(psListing->psEntries, psListing->uCount,
+         sizeof(struct FT_BatchEntry), DirScan_compareEntries);
+   *ppsListing = psListing;
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Take Tasks from the DirScan of the Worker pvWorker and list them
+   until none are left, or one fails.  A directory's listing is added
+   before its subdirectories' Tasks are, so each listing follows its
+   parent's.  Return NULL.  This is the start routine of DirScan_run's
+   threads. */
+
+static void *DirScan_work(void *pvWorker)
+{
+   struct Worker *psWorker = (struct Worker*)pvWorker;
+   DirScan_T oScan = psWorker->oScan;
+   struct Task *psTask;
+   struct Task *psSubdirs;
+   struct Task *psNext;
+   struct Listing *psListing = NULL;
+   int iResult;
+
+   pthread_mutex_lock(&oScan->oMutex);
+   for (;;)
+   {
+      while (oScan->psTasks == NULL && oScan->uBusy > 0 &&
+             oScan->iResult == SUCCESS)
+         pthread_cond_wait(&oScan->oChanged, &oScan->oMutex);
+      if (oScan->psTasks == NULL || oScan->iResult != SUCCESS)
+         break;
+      psTask = oScan->psTasks;
+      oScan->psTasks = psTask->psNext;
+      oScan->uBusy++;
+      pthread_mutex_unlock(&oScan->oMutex);
+
+      iResult = DirScan_list(psWorker, psTask, &psListing, &psSubdirs);
+      free(psTask);
+      STATS_ADD(frees, 1);
+
+      pthread_mutex_lock(&oScan->oMutex);
+      if (iResult != SUCCESS)
+         oScan->iResult = iResult;
+      else
+      {
+         *oScan->ppsLast = psListing;
+         oScan->ppsLast = &psListing->psNext;
+         for (; psSubdirs != NULL; psSubdirs = psNext)
+         {
+            psNext = psSubdirs->psNext;
+            psSubdirs->psNext = oScan->psTasks;
+            oScan->psTasks = psSubdirs;
+         }
+      }
+      oScan->uBusy--;
+      pthread_cond_broadcast(&oScan->oChanged);
+   }
+   pthread_mutex_unlock(&oScan->oMutex);
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move the entries of oScan's Listings into one array, in order, and
+   free the Listings.  Return SUCCESS, or MEMORY_ERROR if insufficient
+   memory is available, leaving the Listings. */
+
+static int DirScan_gather(DirScan_T oScan)
+{
+   struct Listing *psListing;
+   struct Listing *psNext;
+   size_t uCount = 0;
+
+   for (psListing = oScan->psFirst; psListing != NULL;
+        psListing = psListing->psNext)
+      uCount += psListing->uCount;
+   oScan->psEntries = malloc((uCount + 1) * sizeof(struct FT_BatchEntry));
+   if (oScan->psEntries == NULL)
+      return MEMORY_ERROR;
+   STATS_ADD(mallocs, 1);
+
+   for (psListing = oScan->psFirst; psListing != NULL; psListing = psNext)
+   {
+      psNext = psListing->psNext;
+      memcpy(oScan->psEntries + oScan->uCount, psListing->psEntries,
+             psListing->uCount * sizeof(struct FT_BatchEntry));
+      oScan->uCount += psListing->uCount;
+      free(psListing->psEntries);
+      free(psListing);
+      STATS_ADD(frees, 2);
+   }
+   oScan->psFirst = NULL;
+   oScan->ppsLast = &oScan->psFirst;
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+int DirScan_run(const char *pcFsPath, const char *pcPrefix,
+                size_t uThreads, int iReadContents, size_t uMaxReads,
+                DirScan_T *poScan)
+{
+   struct Worker asWorkers[MAX_SCAN_THREADS];
+   struct stat sStat;
+   DirScan_T oScan;
+   struct Task *psRoot;
+   struct Chunk *psChunk;
+   size_t u;
+   long lProcessors;
+   int iResult;
+
+   assert(pcFsPath != NULL);
+   assert(pcPrefix != NULL);
+   assert(poScan != NULL);
+
+   if (stat(pcFsPath, &sStat) != 0)
+      return NO_SUCH_PATH;
+   if (!S_ISDIR(sStat.st_mode))
+      return NOT_A_DIRECTORY;
+
+   if (uThreads == 0)
+   {
+      lProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+      uThreads = lProcessors > 0 ? (size_t)lProcessors : 1;
+   }
+   if (uThreads > MAX_SCAN_THREADS)
+      uThreads = MAX_SCAN_THREADS;
+
+   oScan = calloc(1, sizeof(struct DirScan));
+   psRoot = malloc(sizeof(struct Task));
+   STATS_ADD(mallocs, 2);
+   if (oScan == NULL || psRoot == NULL)
+   {
+      free(oScan);
+      free(psRoot);
+      STATS_ADD(frees, 2);
+      return MEMORY_ERROR;
+   }
+   pthread_mutex_init(&oScan->oMutex, NULL);
+   pthread_cond_init(&oScan->oChanged, NULL);
+   oScan->ppsLast = &oScan->psFirst;
+   oScan->iResult = SUCCESS;
+   oScan->iReadContents = iReadContents;
+   oScan->uMaxReads = uMaxReads;
+
+   /* The root Task's paths are the caller's, so it needs no Chunk. */
+   psRoot->pcFsPath = (char*)pcFsPath;
+   psRoot->pcFtPath = pcPrefix;
+   psRoot->psNext = NULL;
+   oScan->psTasks = psRoot;
+
+   /* The calling thread is the first Worker.  A Worker whose thread
+      cannot be created is simply left out. */
+   for (u = 0; u < uThreads; u++)
+   {
+      asWorkers[u].oScan = oScan;
+      asWorkers[u].psChunks = NULL;
+      asWorkers[u].iStarted = u > 0 &&
+         pthread_create(&asWorkers[u].thread, NULL, DirScan_work,
+                        &asWorkers[u]) == 0;
+   }
+   (void)DirScan_work(&asWorkers[0]);
+   for (u = 0; u < uThreads; u++)
+   {
+      if (asWorkers[u].iStarted)
+         (void)pthread_join(asWorkers[u].thread, NULL);
+      while (asWorkers[u].psChunks != NULL)
+      {
+         psChunk = asWorkers[u].psChunks;
+         asWorkers[u].psChunks = psChunk->psNext;
+         psChunk->psNext = oScan->psChunks;
+         oScan->psChunks = psChunk;
+      }
+   }
+
+   iResult = oScan->iResult;
+   if (iResult == SUCCESS)
+      iResult = DirScan_gather(oScan);
+   if (iResult != SUCCESS)
+   {
+      DirScan_free(oScan, 1);
+      return iResult;
+   }
+   *poScan = oScan;
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+const struct FT_BatchEntry *DirScan_getEntries(DirScan_T oScan,
+                                               size_t *puCount)
+{
+   assert(oScan != NULL);
+   assert(puCount != NULL);
+
+   *puCount = oScan->uCount;
+   return oScan->psEntries;
+}
+
+/*--------------------------------------------------------------------*/
+
+void DirScan_free(DirScan_T oScan, int iFreeContents)
+{
+   struct Listing *psListing;
+   struct Listing *psNext;
+
+   assert(oScan != NULL);
+
+   for (psListing = oScan->psFirst; psListing != NULL; psListing = psNext)
+   {
+      psNext = psListing->psNext;
+      DirScan_freeContents(psListing->psEntries, psListing->uCount);
+      free(psListing->psEntries);
+      free(psListing);
+      STATS_ADD(frees, 2);
+   }
+   if (oScan->psEntries != NULL && iFreeContents)
+      DirScan_freeContents(oScan->psEntries, oScan->uCount);
+   free(oScan->psEntries);
+   DirScan_freeTasks(oScan->psTasks);
+   DirScan_freeChunks(oScan->psChunks);
+   pthread_mutex_destroy(&oScan->oMutex);
+   pthread_cond_destroy(&oScan->oChanged);
+   free(oScan);
+   STATS_ADD(frees, 2);
+}
@@ -0,0 +1,55 @@
+/*--------------------------------------------------------------------*/
+/* dirscan.h                                                          */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#ifndef DIRSCAN_INCLUDED
+#define DIRSCAN_INCLUDED
+
+#include <stddef.h>
+#include "ft.h"
+
+/* A DirScan_T object holds the result of scanning a directory tree on
+   disk: one FT_BatchEntry for each regular file and directory beneath
+   it, named as in an FT.  The entries come a directory's children at
+   a time, each directory's after its parent's, and sorted by name, so
+   that FT_insertBatch links each directory's children in one pass.
+   Symbolic links and special files are skipped; a directory that
+   cannot be listed is left empty, and a file whose contents cannot be
+   read gets NULL contents. */
+
+typedef struct DirScan *DirScan_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Scan the directory tree at pcFsPath with uThreads threads (0 for one
+   per online processor), naming each entry pcPrefix, '/', and its
+   path below pcFsPath.  If iReadContents is 1 (TRUE), then read each
+   file's contents into memory, with at most uMaxReads reads under way
+   at once (0 for no limit), otherwise give each file NULL contents;
+   either way give it its length on disk.  If successful, then assign
+   the result to *poScan and return SUCCESS.  Otherwise return
+   NO_SUCH_PATH if pcFsPath cannot be opened, NOT_A_DIRECTORY if it is
+   not a directory, or MEMORY_ERROR if insufficient memory is
+   available. */
+
+int DirScan_run(const char *pcFsPath, const char *pcPrefix,
+                size_t uThreads, int iReadContents, size_t uMaxReads,
+                DirScan_T *poScan);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the entries of oScan, storing their number in *puCount.
+   They remain valid until oScan is freed. */
+
+const struct FT_BatchEntry *DirScan_getEntries(DirScan_T oScan,
+                                               size_t *puCount);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oScan, and, if iFreeContents is 1 (TRUE), the contents it
+   read; otherwise they belong to the caller. */
+
+void DirScan_free(DirScan_T oScan, int iFreeContents);
+
+#endif
@@ -3,9 +3,16 @@
 /* Author: Bob Dondero                                                */
 /*--------------------------------------------------------------------*/
 
+#define _POSIX_C_SOURCE 200112L
+
 #include "dynarray.h"
+#include "stats.h"
 #include <assert.h>
+#include <limits.h>
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 /*--------------------------------------------------------------------*/
 
@@ -13,6 +20,11 @@
 
 static const size_t MIN_PHYS_LENGTH = 2;
 
+/* The policy of a DynArray that has not been given one: double when
+   full, and shrink once less than a quarter full. */
+
+const struct DynArray_Policy DynArray_defaultPolicy = {100, 0, 25};
+
 /*--------------------------------------------------------------------*/
 
 /* A DynArray consists of an array, along with its logical and
@@ -30,6 +42,9 @@ struct DynArray
 
    /* The array that underlies the DynArray. */
    const void **ppvArray;
+
+   /* How the physical length changes. */
+   const struct DynArray_Policy *psPolicy;
 };
 
 /*--------------------------------------------------------------------*/
@@ -44,6 +59,7 @@ static int DynArray_isValid(DynArray_T oDynArray)
    if (oDynArray->uPhysLength < MIN_PHYS_LENGTH) return 0;
    if (oDynArray->uLength > oDynArray->uPhysLength) return 0;
    if (oDynArray->ppvArray == NULL) return 0;
+   if (oDynArray->psPolicy == NULL) return 0;
    return 1;
 }
 
@@ -51,24 +67,24 @@ static int DynArray_isValid(DynArray_T oDynArray)
 
 /*--------------------------------------------------------------------*/
 
-/* Increase the physical length of oDynArray.  Return 1 (TRUE) if
+/* Change the physical length of oDynArray to uNewLength, which must
+   be at least its length and MIN_PHYS_LENGTH.  Return 1 (TRUE) if
    successful and 0 (FALSE) if insufficient memory is available. */
 
-static int DynArray_grow(DynArray_T oDynArray)
+static int DynArray_resize(DynArray_T oDynArray, size_t uNewLength)
 {
-   const size_t GROWTH_FACTOR = 2;
-
-   size_t uNewLength;
    const void **ppvNewArray;
 
    assert(oDynArray != NULL);
-
-   uNewLength = GROWTH_FACTOR * oDynArray->uPhysLength;
+   assert(uNewLength >= oDynArray->uLength);
+   assert(uNewLength >= MIN_PHYS_LENGTH);
 
    ppvNewArray = (const void**)
       realloc(oDynArray->ppvArray, sizeof(void*) * uNewLength);
    if (ppvNewArray == NULL)
       return 0;
+   if (uNewLength > oDynArray->uPhysLength)
+      STATS_ADD(grows, 1);
 
    oDynArray->uPhysLength = uNewLength;
    oDynArray->ppvArray = ppvNewArray;
@@ -77,6 +93,72 @@ static int DynArray_grow(DynArray_T oDynArray)
 
 /*--------------------------------------------------------------------*/
 
+/* Return uPercent percent of u, rounded down, without overflow. */
+
+static size_t DynArray_percentOf(size_t u, size_t uPercent)
+{
+   return u / 100 * uPercent + u % 100 * uPercent / 100;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make room in oDynArray for uCount more elements: if they do not
+   fit, increase its physical length as its policy directs, or to
+   just enough if that is not enough.  Return 1 (TRUE) if successful
+   and 0 (FALSE) if insufficient memory is available. */
+
+static int DynArray_grow(DynArray_T oDynArray, size_t uCount)
+{
+   const struct DynArray_Policy *psPolicy;
+   size_t uGrowth;
+   size_t uNewLength;
+
+   assert(oDynArray != NULL);
+   assert(uCount <= (size_t)-1 - oDynArray->uLength);
+
+   if (uCount <= oDynArray->uPhysLength - oDynArray->uLength)
+      return 1;
+
+   psPolicy = oDynArray->psPolicy;
+   uGrowth = DynArray_percentOf(oDynArray->uPhysLength,
+                                psPolicy->uGrowthPercent);
+   if (psPolicy->uMaxGrowth != 0 && uGrowth > psPolicy->uMaxGrowth)
+      uGrowth = psPolicy->uMaxGrowth;
+   if (uGrowth == 0)
+      uGrowth = 1;
+
+   uNewLength = oDynArray->uPhysLength + uGrowth;
+   if (uNewLength < oDynArray->uLength + uCount)
+      uNewLength = oDynArray->uLength + uCount;
+   return DynArray_resize(oDynArray, uNewLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If oDynArray has fallen below its policy's shrink threshold, reduce
+   its physical length to twice its length.  Should the memory not be
+   released, oDynArray simply stays as it is. */
+
+static void DynArray_autoShrink(DynArray_T oDynArray)
+{
+   size_t uNewLength;
+
+   assert(oDynArray != NULL);
+
+   if (oDynArray->psPolicy->uShrinkPercent == 0
+       || oDynArray->uLength >= DynArray_percentOf(
+          oDynArray->uPhysLength, oDynArray->psPolicy->uShrinkPercent))
+      return;
+
+   uNewLength = 2 * oDynArray->uLength;
+   if (uNewLength < MIN_PHYS_LENGTH)
+      uNewLength = MIN_PHYS_LENGTH;
+   if (uNewLength < oDynArray->uPhysLength)
+      (void)DynArray_resize(oDynArray, uNewLength);
+}
+
+/*--------------------------------------------------------------------*/
+
 DynArray_T DynArray_new(size_t uLength)
 {
    DynArray_T oDynArray;
@@ -84,6 +166,7 @@ DynArray_T DynArray_new(size_t uLength)
    oDynArray = (struct DynArray*)malloc(sizeof(struct DynArray));
    if (oDynArray == NULL)
       return NULL;
+   STATS_ADD(mallocs, 1);
 
    oDynArray->uLength = uLength;
    if (uLength > MIN_PHYS_LENGTH)
@@ -91,13 +174,16 @@ DynArray_T DynArray_new(size_t uLength)
    else
       oDynArray->uPhysLength = MIN_PHYS_LENGTH;
 
+   oDynArray->psPolicy = &DynArray_defaultPolicy;
    oDynArray->ppvArray =
       (const void**)calloc(oDynArray->uPhysLength, sizeof(void*));
    if (oDynArray->ppvArray == NULL)
    {
       free(oDynArray);
+      STATS_ADD(frees, 1);
       return NULL;
    }
+   STATS_ADD(mallocs, 1);
 
    return oDynArray;
 }
@@ -111,6 +197,7 @@ void DynArray_free(DynArray_T oDynArray)
 
    free(oDynArray->ppvArray);
    free(oDynArray);
+   STATS_ADD(frees, 2);
 }
 
 /*--------------------------------------------------------------------*/
@@ -125,6 +212,60 @@ size_t DynArray_getLength(DynArray_T oDynArray)
 
 /*--------------------------------------------------------------------*/
 
+size_t DynArray_getCapacity(DynArray_T oDynArray)
+{
+   assert(oDynArray != NULL);
+   assert(DynArray_isValid(oDynArray));
+
+   return oDynArray->uPhysLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+void DynArray_setPolicy(DynArray_T oDynArray,
+                        const struct DynArray_Policy *psPolicy)
+{
+   assert(oDynArray != NULL);
+   assert(psPolicy == NULL || psPolicy->uShrinkPercent < 50);
+   assert(DynArray_isValid(oDynArray));
+
+   if (psPolicy == NULL)
+      psPolicy = &DynArray_defaultPolicy;
+   oDynArray->psPolicy = psPolicy;
+}
+
+/*--------------------------------------------------------------------*/
+
+int DynArray_reserve(DynArray_T oDynArray, size_t uCapacity)
+{
+   assert(oDynArray != NULL);
+   assert(DynArray_isValid(oDynArray));
+
+   if (uCapacity <= oDynArray->uPhysLength)
+      return 1;
+   return DynArray_resize(oDynArray, uCapacity);
+}
+
+/*--------------------------------------------------------------------*/
+
+void DynArray_shrinkToFit(DynArray_T oDynArray)
+{
+   size_t uNewLength;
+
+   assert(oDynArray != NULL);
+   assert(DynArray_isValid(oDynArray));
+
+   uNewLength = oDynArray->uLength;
+   if (uNewLength < MIN_PHYS_LENGTH)
+      uNewLength = MIN_PHYS_LENGTH;
+   if (uNewLength < oDynArray->uPhysLength)
+      (void)DynArray_resize(oDynArray, uNewLength);
+
+   assert(DynArray_isValid(oDynArray));
+}
+
+/*--------------------------------------------------------------------*/
+
 void *DynArray_get(DynArray_T oDynArray, size_t uIndex)
 {
    assert(oDynArray != NULL);
@@ -160,9 +301,8 @@ int DynArray_add(DynArray_T oDynArray, const void *pvElement)
    assert(oDynArray != NULL);
    assert(DynArray_isValid(oDynArray));
 
-   if (oDynArray->uLength == oDynArray->uPhysLength)
-      if (! DynArray_grow(oDynArray))
-         return 0;
+   if (! DynArray_grow(oDynArray, 1))
+      return 0;
 
    oDynArray->ppvArray[oDynArray->uLength] = pvElement;
    oDynArray->uLength++;
@@ -177,18 +317,16 @@ int DynArray_add(DynArray_T oDynArray, const void *pvElement)
 int DynArray_addAt(DynArray_T oDynArray, size_t uIndex,
                    const void *pvElement)
 {
-   size_t u;
-
    assert(oDynArray != NULL);
    assert(uIndex <= oDynArray->uLength);
    assert(DynArray_isValid(oDynArray));
 
-   if (oDynArray->uLength == oDynArray->uPhysLength)
-      if (! DynArray_grow(oDynArray))
-         return 0;
+   if (! DynArray_grow(oDynArray, 1))
+      return 0;
 
-   for (u = oDynArray->uLength; u > uIndex; u--)
-      oDynArray->ppvArray[u] = oDynArray->ppvArray[u-1];
+   memmove(&oDynArray->ppvArray[uIndex + 1], &oDynArray->ppvArray[uIndex],
+           (oDynArray->uLength - uIndex) * sizeof(void*));
+   STATS_ADD(shifts, oDynArray->uLength - uIndex);
 
    oDynArray->ppvArray[uIndex] = pvElement;
    oDynArray->uLength++;
@@ -203,7 +341,6 @@ int DynArray_addAt(DynArray_T oDynArray, size_t uIndex,
 void *DynArray_removeAt(DynArray_T oDynArray, size_t uIndex)
 {
    const void *pvOldElement;
-   size_t u;
 
    assert(oDynArray != NULL);
    assert(uIndex < oDynArray->uLength);
@@ -213,8 +350,11 @@ void *DynArray_removeAt(DynArray_T oDynArray, size_t uIndex)
 
    oDynArray->uLength--;
 
-   for (u = uIndex; u < oDynArray->uLength; u++)
-      oDynArray->ppvArray[u] = oDynArray->ppvArray[u+1];
+   memmove(&oDynArray->ppvArray[uIndex], &oDynArray->ppvArray[uIndex + 1],
+           (oDynArray->uLength - uIndex) * sizeof(void*));
+   STATS_ADD(shifts, oDynArray->uLength - uIndex);
+
+   DynArray_autoShrink(oDynArray);
 
    assert(DynArray_isValid(oDynArray));
 
@@ -223,6 +363,95 @@ void *DynArray_removeAt(DynArray_T oDynArray, size_t uIndex)
 
 /*--------------------------------------------------------------------*/
 
+int DynArray_addRangeAt(DynArray_T oDynArray, size_t uIndex,
+                        const void **ppvElements, size_t uCount)
+{
+   assert(oDynArray != NULL);
+   assert(uIndex <= oDynArray->uLength);
+   assert(ppvElements != NULL || uCount == 0);
+   assert(DynArray_isValid(oDynArray));
+
+   if (! DynArray_grow(oDynArray, uCount))
+      return 0;
+
+   memmove(&oDynArray->ppvArray[uIndex + uCount],
+           &oDynArray->ppvArray[uIndex],
+           (oDynArray->uLength - uIndex) * sizeof(void*));
+   STATS_ADD(shifts, oDynArray->uLength - uIndex);
+   if (uCount > 0)
+      memcpy(&oDynArray->ppvArray[uIndex], ppvElements,
+             uCount * sizeof(void*));
+   oDynArray->uLength += uCount;
+
+   assert(DynArray_isValid(oDynArray));
+
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void DynArray_removeRange(DynArray_T oDynArray, size_t uIndex,
+                          size_t uCount)
+{
+   assert(oDynArray != NULL);
+   assert(uIndex <= oDynArray->uLength);
+   assert(uCount <= oDynArray->uLength - uIndex);
+   assert(DynArray_isValid(oDynArray));
+
+   memmove(&oDynArray->ppvArray[uIndex],
+           &oDynArray->ppvArray[uIndex + uCount],
+           (oDynArray->uLength - uIndex - uCount) * sizeof(void*));
+   STATS_ADD(shifts, oDynArray->uLength - uIndex - uCount);
+   oDynArray->uLength -= uCount;
+
+   DynArray_autoShrink(oDynArray);
+
+   assert(DynArray_isValid(oDynArray));
+}
+
+/*--------------------------------------------------------------------*/
+
+int DynArray_mergeSorted(DynArray_T oDynArray,
+                         const void **ppvElements, size_t uCount,
+                         int (*pfCompare)(const void *pvElement1,
+                                          const void *pvElement2))
+{
+   size_t uOld;
+   size_t uNew;
+   size_t uTo;
+
+   assert(oDynArray != NULL);
+   assert(ppvElements != NULL || uCount == 0);
+   assert(pfCompare != NULL);
+   assert(DynArray_isValid(oDynArray));
+
+   if (! DynArray_grow(oDynArray, uCount))
+      return 0;
+
+   /* Merge from the back, into the space just made, so that no
+      element moves more than once and those that sort before every
+      new element do not move at all. */
+   uOld = oDynArray->uLength;
+   uNew = uCount;
+   uTo = uOld + uCount;
+   while (uNew > 0)
+   {
+      if (uOld > 0 && (*pfCompare)(oDynArray->ppvArray[uOld - 1],
+                                   ppvElements[uNew - 1]) > 0)
+         oDynArray->ppvArray[--uTo] = oDynArray->ppvArray[--uOld];
+      else
+         oDynArray->ppvArray[--uTo] = ppvElements[--uNew];
+   }
+   STATS_ADD(shifts, oDynArray->uLength - uOld);
+   oDynArray->uLength += uCount;
+
+   assert(DynArray_isValid(oDynArray));
+
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
 void DynArray_toArray(DynArray_T oDynArray, void **ppvArray)
 {
    size_t u;
@@ -253,6 +482,106 @@ void DynArray_map(DynArray_T oDynArray,
 
 /*--------------------------------------------------------------------*/
 
+/* Partitions of at most this many elements are insertion sorted. */
+
+static const size_t INSERTION_SORT_LENGTH = 16;
+
+/* DynArray_sortParallel sorts arrays shorter than this with
+   DynArray_sort. */
+
+static const size_t PARALLEL_SORT_LENGTH = 65536;
+
+/* DynArray_sortParallel never uses more threads than this. */
+
+enum {MAX_SORT_THREADS = 64};
+
+/*--------------------------------------------------------------------*/
+
+/* Sort the array of elements that resides in memory at addresses
+   ppvLo...ppvHi in ascending order, as determined by *pfCompare, by
+   insertion sort. */
+
+static void DynArray_insertionSort(
+   const void **ppvLo,
+   const void **ppvHi,
+   int (*pfCompare) (const void *pvElement1, const void *pvElement2))
+{
+   const void **ppvNext;
+   const void **ppvHole;
+   const void *pvElement;
+
+   assert(ppvLo != NULL);
+   assert(ppvHi != NULL);
+   assert(pfCompare != NULL);
+
+   for (ppvNext = ppvLo + 1; ppvNext <= ppvHi; ppvNext++)
+   {
+      pvElement = *ppvNext;
+      for (ppvHole = ppvNext;
+           ppvHole > ppvLo && (*pfCompare)(pvElement, *(ppvHole-1)) < 0;
+           ppvHole--)
+         *ppvHole = *(ppvHole-1);
+      *ppvHole = pvElement;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Sort the array of elements that resides in memory at addresses
+   ppvLo...ppvHi in ascending order, as determined by *pfCompare, by
+   heapsort. */
+
+static void DynArray_heapsort(
+   const void **ppvLo,
+   const void **ppvHi,
+   int (*pfCompare) (const void *pvElement1, const void *pvElement2))
+{
+   size_t uLength;
+   size_t uStart;
+   size_t uRoot;
+   size_t uChild;
+   const void *pvTemp;
+
+   assert(ppvLo != NULL);
+   assert(ppvHi != NULL);
+   assert(pfCompare != NULL);
+
+   uLength = (size_t)(ppvHi - ppvLo) + 1;
+
+   /* Build a max-heap, then repeatedly move its root to the end.  The
+      first pass sifts down each parent in turn; the second sifts down
+      the new root after each move. */
+   uStart = uLength / 2;
+   while (uLength > 1)
+   {
+      if (uStart > 0)
+         uStart--;
+      else
+      {
+         uLength--;
+         pvTemp = ppvLo[0];
+         ppvLo[0] = ppvLo[uLength];
+         ppvLo[uLength] = pvTemp;
+      }
+
+      uRoot = uStart;
+      while ((uChild = 2 * uRoot + 1) < uLength)
+      {
+         if (uChild + 1 < uLength
+             && (*pfCompare)(ppvLo[uChild], ppvLo[uChild+1]) < 0)
+            uChild++;
+         if ((*pfCompare)(ppvLo[uRoot], ppvLo[uChild]) >= 0)
+            break;
+         pvTemp = ppvLo[uRoot];
+         ppvLo[uRoot] = ppvLo[uChild];
+         ppvLo[uChild] = pvTemp;
+         uRoot = uChild;
+      }
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Sort the array of elements that resides in memory at
    addresses ppvLo...ppvHi in ascending order, as determined
    by *pfCompare.
@@ -260,53 +589,125 @@ void DynArray_map(DynArray_T oDynArray,
    *pvElement1 is less than, equal to, or greater than *pvElement2,
    respectively. */
 
-static void DynArray_qsort(
+static void DynArray_introsort(
    const void **ppvLo,
    const void **ppvHi,
    int (*pfCompare) (const void *pvElement1, const void *pvElement2))
 {
-   /* This function implements a variation of the quicksort algorithm
-      shown in the book "Algorithms + Data Structures = Programs" by
-      Niklaus Wirth. */
+   /* This function implements introsort: the quicksort of Wirth's
+      "Algorithms + Data Structures = Programs", with a median-of-three
+      pivot, that switches to heapsort for any partition that has been
+      split more than 2 log2(n) times, and to insertion sort for small
+      partitions, so that no input takes more than O(n log n) time.
+      It keeps the larger half of each split on an explicit stack and
+      goes on with the smaller, so the stack needs at most log2(n)
+      entries. */
 
    /* This function uses pointers instead of indices to avoid
       complications with using unsigned integers as array indices. */
 
+   struct
+   {
+      const void **ppvLo;
+      const void **ppvHi;
+      size_t uDepth;
+   } asStack[sizeof(size_t) * CHAR_BIT];
+   size_t uTop = 0;
+
    const void **ppvRight;
    const void **ppvLeft;
+   const void **ppvMid;
    const void *pvPivot;
    const void *pvTemp;
+   size_t uDepth = 0;
+   size_t u;
 
    assert(ppvLo != NULL);
    assert(ppvHi != NULL);
    assert(pfCompare != NULL);
 
-   ppvRight = ppvLo;
-   ppvLeft = ppvHi;
-   pvPivot = *(ppvLo + ((ppvHi - ppvLo) / 2));
+   for (u = (size_t)(ppvHi - ppvLo) + 1; u > 1; u /= 2)
+      uDepth += 2;
 
-   while (ppvRight <= ppvLeft)
+   for (;;)
    {
-      while ((*pfCompare)(*ppvRight, pvPivot) < 0)
-         ppvRight++;
-      while ((*pfCompare)(pvPivot, *ppvLeft) < 0)
-         ppvLeft--;
-      if (ppvRight <= ppvLeft)
+      while ((size_t)(ppvHi - ppvLo) >= INSERTION_SORT_LENGTH
+             && uDepth > 0)
       {
-         /* Swap *ppvRight and *ppvLeft. */
-         pvTemp = *ppvRight;
-         *ppvRight = *ppvLeft;
-         *ppvLeft = pvTemp;
+         uDepth--;
+
+         /* Order *ppvLo, *ppvMid and *ppvHi, and take the middle one
+            as the pivot.  The outer two then keep each scan below
+            from running off its end. */
+         ppvMid = ppvLo + ((ppvHi - ppvLo) / 2);
+         if ((*pfCompare)(*ppvMid, *ppvLo) < 0)
+         {
+            pvTemp = *ppvMid; *ppvMid = *ppvLo; *ppvLo = pvTemp;
+         }
+         if ((*pfCompare)(*ppvHi, *ppvMid) < 0)
+         {
+            pvTemp = *ppvHi; *ppvHi = *ppvMid; *ppvMid = pvTemp;
+            if ((*pfCompare)(*ppvMid, *ppvLo) < 0)
+            {
+               pvTemp = *ppvMid; *ppvMid = *ppvLo; *ppvLo = pvTemp;
+            }
+         }
+         pvPivot = *ppvMid;
+
+         ppvRight = ppvLo;
+         ppvLeft = ppvHi;
+         while (ppvRight <= ppvLeft)
+         {
+            while ((*pfCompare)(*ppvRight, pvPivot) < 0)
+               ppvRight++;
+            while ((*pfCompare)(pvPivot, *ppvLeft) < 0)
+               ppvLeft--;
+            if (ppvRight <= ppvLeft)
+            {
+               /* Swap *ppvRight and *ppvLeft. */
+               pvTemp = *ppvRight;
+               *ppvRight = *ppvLeft;
+               *ppvLeft = pvTemp;
+
+               ppvRight++;
+               ppvLeft--;
+            }
+         }
+
+         /* Now ppvLo...ppvLeft and ppvRight...ppvHi remain to be
+            sorted.  Stack the larger and go on with the smaller. */
+         assert(uTop < sizeof(asStack) / sizeof(asStack[0]));
+         if (ppvLeft - ppvLo > ppvHi - ppvRight)
+         {
+            asStack[uTop].ppvLo = ppvLo;
+            asStack[uTop].ppvHi = ppvLeft;
+            ppvLo = ppvRight;
+         }
+         else
+         {
+            asStack[uTop].ppvLo = ppvRight;
+            asStack[uTop].ppvHi = ppvHi;
+            ppvHi = ppvLeft;
+         }
+         asStack[uTop].uDepth = uDepth;
+         uTop++;
+      }
 
-         ppvRight++;
-         ppvLeft--;
+      if (ppvLo < ppvHi)
+      {
+         if (uDepth == 0)
+            DynArray_heapsort(ppvLo, ppvHi, pfCompare);
+         else
+            DynArray_insertionSort(ppvLo, ppvHi, pfCompare);
       }
-   }
 
-   if (ppvLo < ppvLeft)
-      DynArray_qsort(ppvLo, ppvLeft, pfCompare);
-   if (ppvRight < ppvHi)
-      DynArray_qsort(ppvRight, ppvHi, pfCompare);
+      if (uTop == 0)
+         return;
+      uTop--;
+      ppvLo = asStack[uTop].ppvLo;
+      ppvHi = asStack[uTop].ppvHi;
+      uDepth = asStack[uTop].uDepth;
+   }
 }
 
 /*--------------------------------------------------------------------*/
@@ -322,7 +723,7 @@ void DynArray_sort(DynArray_T oDynArray,
    if (oDynArray->uLength < 2)
       return;
 
-   DynArray_qsort(
+   DynArray_introsort(
       &oDynArray->ppvArray[0],
       &oDynArray->ppvArray[oDynArray->uLength-1],
       pfCompare);
@@ -332,6 +733,184 @@ void DynArray_sort(DynArray_T oDynArray,
 
 /*--------------------------------------------------------------------*/
 
+/* A SortTask is one thread's share of DynArray_sortParallel: either
+   sorting the run ppvLo...ppvEnd-1 in place (if ppvOut is NULL), or
+   merging the sorted runs ppvLo...ppvMid-1 and ppvMid...ppvEnd-1
+   into ppvOut. */
+
+struct SortTask
+{
+   const void **ppvLo;
+   const void **ppvMid;
+   const void **ppvEnd;
+   const void **ppvOut;
+   int (*pfCompare)(const void *pvElement1, const void *pvElement2);
+   pthread_t thread;
+   int iStarted;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Do the SortTask pvTask.  Return NULL.  This is the start routine of
+   DynArray_sortParallel's threads. */
+
+static void *DynArray_doSortTask(void *pvTask)
+{
+   struct SortTask *psTask = (struct SortTask*)pvTask;
+   const void **ppvLeft;
+   const void **ppvRight;
+   const void **ppvOut;
+
+   assert(psTask != NULL);
+
+   if (psTask->ppvOut == NULL)
+   {
+      if (psTask->ppvEnd - psTask->ppvLo > 1)
+         DynArray_introsort(psTask->ppvLo, psTask->ppvEnd - 1,
+                            psTask->pfCompare);
+      return NULL;
+   }
+
+   /* Take from the left run on ties, so that equal elements keep
+      their order. */
+   ppvLeft = psTask->ppvLo;
+   ppvRight = psTask->ppvMid;
+   ppvOut = psTask->ppvOut;
+   while (ppvLeft < psTask->ppvMid && ppvRight < psTask->ppvEnd)
+      if ((*psTask->pfCompare)(*ppvRight, *ppvLeft) < 0)
+         *ppvOut++ = *ppvRight++;
+      else
+         *ppvOut++ = *ppvLeft++;
+   while (ppvLeft < psTask->ppvMid)
+      *ppvOut++ = *ppvLeft++;
+   while (ppvRight < psTask->ppvEnd)
+      *ppvOut++ = *ppvRight++;
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Do the uTasks SortTasks at asTasks, each in its own thread, and
+   wait for them all.  A task whose thread cannot be created is done
+   in the calling thread instead. */
+
+static void DynArray_doSortTasks(struct SortTask *asTasks, size_t uTasks)
+{
+   size_t u;
+
+   assert(asTasks != NULL);
+
+   for (u = 1; u < uTasks; u++)
+      asTasks[u].iStarted = pthread_create(&asTasks[u].thread, NULL,
+         DynArray_doSortTask, &asTasks[u]) == 0;
+   (void)DynArray_doSortTask(&asTasks[0]);
+   for (u = 1; u < uTasks; u++)
+      if (asTasks[u].iStarted)
+         (void)pthread_join(asTasks[u].thread, NULL);
+      else
+         (void)DynArray_doSortTask(&asTasks[u]);
+}
+
+/*--------------------------------------------------------------------*/
+
+void DynArray_sortParallel(DynArray_T oDynArray,
+                           int (*pfCompare)(const void *pvElement1,
+                                            const void *pvElement2),
+                           size_t uThreads)
+{
+   struct SortTask asTasks[MAX_SORT_THREADS];
+   const void **ppvRuns[MAX_SORT_THREADS + 1];
+   const void **ppvSource;
+   const void **ppvTarget;
+   const void **ppvBuffer;
+   const void **ppvTemp;
+   size_t uRuns;
+   size_t uTasks;
+   size_t u;
+   long lProcessors;
+
+   assert(oDynArray != NULL);
+   assert(pfCompare != NULL);
+   assert(DynArray_isValid(oDynArray));
+
+   if (uThreads == 0)
+   {
+      lProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+      uThreads = lProcessors > 0 ? (size_t)lProcessors : 1;
+   }
+   if (uThreads > MAX_SORT_THREADS)
+      uThreads = MAX_SORT_THREADS;
+
+   if (uThreads < 2 || oDynArray->uLength < PARALLEL_SORT_LENGTH)
+   {
+      DynArray_sort(oDynArray, pfCompare);
+      return;
+   }
+
+   ppvBuffer = (const void**)malloc(sizeof(void*) * oDynArray->uLength);
+   if (ppvBuffer == NULL)
+   {
+      DynArray_sort(oDynArray, pfCompare);
+      return;
+   }
+   STATS_ADD(mallocs, 1);
+
+   /* Sort one run per thread in place. */
+   uRuns = uThreads;
+   for (u = 0; u <= uRuns; u++)
+      ppvRuns[u] = oDynArray->ppvArray + oDynArray->uLength * u / uRuns;
+   for (u = 0; u < uRuns; u++)
+   {
+      asTasks[u].ppvLo = ppvRuns[u];
+      asTasks[u].ppvMid = NULL;
+      asTasks[u].ppvEnd = ppvRuns[u+1];
+      asTasks[u].ppvOut = NULL;
+      asTasks[u].pfCompare = pfCompare;
+   }
+   DynArray_doSortTasks(asTasks, uRuns);
+
+   /* Merge pairs of runs, back and forth between the array and
+      ppvBuffer, until one run remains. */
+   ppvSource = oDynArray->ppvArray;
+   ppvTarget = ppvBuffer;
+   while (uRuns > 1)
+   {
+      uTasks = 0;
+      for (u = 0; u < uRuns; u += 2)
+      {
+         asTasks[uTasks].ppvLo = ppvRuns[u];
+         asTasks[uTasks].ppvMid = ppvRuns[u+1];
+         /* A last run without a partner is merged with nothing. */
+         asTasks[uTasks].ppvEnd = u + 1 < uRuns ? ppvRuns[u+2] :
+            ppvRuns[u+1];
+         asTasks[uTasks].ppvOut = ppvTarget + (ppvRuns[u] - ppvSource);
+         asTasks[uTasks].pfCompare = pfCompare;
+         uTasks++;
+      }
+      DynArray_doSortTasks(asTasks, uTasks);
+
+      /* The runs now start at the same offsets in ppvTarget. */
+      for (u = 0; u < uTasks; u++)
+         ppvRuns[u] = ppvTarget + (ppvRuns[2*u] - ppvSource);
+      ppvRuns[uTasks] = ppvTarget + oDynArray->uLength;
+      uRuns = uTasks;
+
+      ppvTemp = ppvSource;
+      ppvSource = ppvTarget;
+      ppvTarget = ppvTemp;
+   }
+
+   if (ppvSource != oDynArray->ppvArray)
+      memcpy((void*)oDynArray->ppvArray, (void*)ppvSource,
+             sizeof(void*) * oDynArray->uLength);
+   free((void*)ppvBuffer);
+   STATS_ADD(frees, 1);
+
+   assert(DynArray_isValid(oDynArray));
+}
+
+/*--------------------------------------------------------------------*/
+
 int DynArray_search(DynArray_T oDynArray,
                     void *pvSoughtElement,
                     size_t *puIndex,
@@ -13,6 +13,28 @@
 
 typedef struct DynArray *DynArray_T;
 
+/* A DynArray_Policy determines how a DynArray's physical length (its
+   capacity) changes.  When the DynArray is full, it grows by
+   uGrowthPercent percent of its physical length, but by no more than
+   uMaxGrowth elements unless uMaxGrowth is 0, and by at least one.
+   When a removal leaves it less than uShrinkPercent percent full, its
+   physical length shrinks to twice its length; it never shrinks by
+   itself if uShrinkPercent is 0.  uShrinkPercent must be less than
+   50, so that the DynArray must then halve again, or double, before
+   its physical length changes again. */
+
+struct DynArray_Policy
+{
+   size_t uGrowthPercent;
+   size_t uMaxGrowth;
+   size_t uShrinkPercent;
+};
+
+/* The policy of every new DynArray: {100, 0, 25}, that is, double
+   when full and halve when a quarter full. */
+
+extern const struct DynArray_Policy DynArray_defaultPolicy;
+
 /*--------------------------------------------------------------------*/
 
 /* Return a new DynArray_T object whose length is uLength, or
@@ -34,6 +56,37 @@ size_t DynArray_getLength(DynArray_T oDynArray);
 
 /*--------------------------------------------------------------------*/
 
+/* Return the physical length of oDynArray: the length it can reach
+   before it must grow. */
+
+size_t DynArray_getCapacity(DynArray_T oDynArray);
+
+/*--------------------------------------------------------------------*/
+
+/* Make *psPolicy, which must remain valid as long as oDynArray does,
+   the policy of oDynArray; or if psPolicy is NULL,
+   DynArray_defaultPolicy. */
+
+void DynArray_setPolicy(DynArray_T oDynArray,
+                        const struct DynArray_Policy *psPolicy);
+
+/*--------------------------------------------------------------------*/
+
+/* Make the physical length of oDynArray at least uCapacity, so that
+   it can reach that length without growing again.  Return 1 (TRUE)
+   if successful, or 0 (FALSE) if insufficient memory is available. */
+
+int DynArray_reserve(DynArray_T oDynArray, size_t uCapacity);
+
+/*--------------------------------------------------------------------*/
+
+/* Reduce the physical length of oDynArray to its length, releasing
+   the memory beyond it. */
+
+void DynArray_shrinkToFit(DynArray_T oDynArray);
+
+/*--------------------------------------------------------------------*/
+
 /* Return the uIndex'th element of oDynArray. */
 
 void *DynArray_get(DynArray_T oDynArray, size_t uIndex);
@@ -65,12 +118,48 @@ int DynArray_addAt(DynArray_T oDynArray, size_t uIndex,
 
 /*--------------------------------------------------------------------*/
 
-/* Remove and return the uIndex'th element of oDynArray. */
+/* Remove and return the uIndex'th element of oDynArray, shrinking it
+   if its policy says to. */
 
 void *DynArray_removeAt(DynArray_T oDynArray, size_t uIndex);
 
 /*--------------------------------------------------------------------*/
 
+/* Add the uCount elements of ppvElements to oDynArray such that they
+   are its uIndex'th element onward, in order, growing it at most
+   once and moving each later element once.  Return 1 (TRUE) if
+   successful, or 0 (FALSE), leaving oDynArray unchanged, if
+   insufficient memory is available. */
+
+int DynArray_addRangeAt(DynArray_T oDynArray, size_t uIndex,
+                        const void **ppvElements, size_t uCount);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the uCount elements of oDynArray from its uIndex'th onward,
+   moving each later element once, then shrink it if its policy says
+   to. */
+
+void DynArray_removeRange(DynArray_T oDynArray, size_t uIndex,
+                          size_t uCount);
+
+/*--------------------------------------------------------------------*/
+
+/* Add the uCount elements of ppvElements to oDynArray, both of which
+   must be sorted as determined by *pfCompare, such that oDynArray
+   stays sorted, with each new element after any equal elements
+   already there.  Grows oDynArray at most once and takes time linear
+   in the elements that move.  Return 1 (TRUE) if successful, or 0
+   (FALSE), leaving oDynArray unchanged, if insufficient memory is
+   available.  *pfCompare is as for DynArray_sort. */
+
+int DynArray_mergeSorted(DynArray_T oDynArray,
+                         const void **ppvElements, size_t uCount,
+                         int (*pfCompare)(const void *pvElement1,
+                                          const void *pvElement2));
+
+/*--------------------------------------------------------------------*/
+
 /* Fill ppvArray with the elements of oDynArray.  ppvArray must point
    to an area of memory that is large enough to hold all elements of
    oDynArray. */
@@ -92,7 +181,7 @@ void DynArray_map(DynArray_T oDynArray,
 /* Sort oDynArray in the order determined by *pfCompare.
    *pfCompare must return <0, 0, or >0 depending upon whether
    *pvElement1 is less than, equal to, or greater than *pvElement2,
-   respectively. */
+   respectively.  Takes O(n log n) time for any order of input. */
 
 void DynArray_sort(DynArray_T oDynArray,
                    int (*pfCompare)(const void *pvElement1,
@@ -100,6 +189,21 @@ void DynArray_sort(DynArray_T oDynArray,
 
 /*--------------------------------------------------------------------*/
 
+/* Sort oDynArray as DynArray_sort does, but for a long oDynArray
+   split the work among up to uThreads threads, or one per online
+   processor if uThreads is 0: each sorts a run of the elements, and
+   the runs are then merged pairwise.  Sort in the calling thread
+   alone if oDynArray is short, or if insufficient memory is
+   available for the merges.  *pfCompare is called from several
+   threads at once, and so must not modify shared state. */
+
+void DynArray_sortParallel(DynArray_T oDynArray,
+                           int (*pfCompare)(const void *pvElement1,
+                                            const void *pvElement2),
+                           size_t uThreads);
+
+/*--------------------------------------------------------------------*/
+
 /* Linear search oDynArray for *pvSoughtElement using *pfCompare to
    determine equality.  If the element is found, then assign its
    index to *puIndex and return 1.  If the element is not found, then
@@ -0,0 +1,841 @@
+/*--------------------------------------------------------------------*/
+/* frozen.c                                                           */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#include "frozen.h"
+#include "stats.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The average number of keys per bucket of the perfect hash.  More
+   keys per bucket make the displacement table smaller, but the
+   buckets harder to place, and so freezing slower. */
+
+#ifndef FROZEN_BUCKET_KEYS
+#define FROZEN_BUCKET_KEYS 3
+#endif
+
+/* The number of displacements tried for one bucket, and the number of
+   seeds tried for the whole hash, before giving up on them. */
+
+#define MAX_DISPLACEMENTS 0x100000UL
+enum { MAX_SEEDS = 32 };
+
+/* The index that no node has: the parent of the root, and the
+   contents of an unfilled slot of the hash. */
+
+#define NO_NODE ((size_t) -1)
+
+/* Hash values are kept to 32 bits, so that every platform computes
+   the same ones. */
+
+#define MASK32 0xffffffffUL
+
+/*--------------------------------------------------------------------*/
+
+/* One node of a Frozen: its parent, its name, its type, and either
+   the range of indices its children occupy or its contents. */
+
+struct FrozenNode
+{
+   /* The index of the parent, or NO_NODE for the root. */
+   size_t uParent;
+
+   /* The offset of the name in the pool, and its length. */
+   size_t uName;
+   size_t uNameLength;
+
+   /* Whether this is a directory or a file. */
+   nodeType eType;
+
+   union
+   {
+      /* For a directory: the index of its first child, and the number
+         of children, which follow the first in the order
+         Node_getChild gives them (files, then directories, each
+         sorted by name). */
+      struct
+      {
+         size_t uFirst;
+         size_t uCount;
+      } sDir;
+
+      /* For a file: its contents, their length, and whether they
+         were the Node's own. */
+      struct
+      {
+         void *pvContents;
+         size_t uLength;
+         int iOwned;
+      } sFile;
+   } u;
+};
+
+/* A Frozen consists of its nodes, their names, the size of its string
+   form, and a perfect hash: the key of a path, computed with the seed,
+   picks a bucket, whose code gives the slot of each path in that
+   bucket, and the slot holds the path's node index.  A code with its
+   low bit set holds the slot itself, for a bucket with one path; any
+   other holds a displacement, d, and the slot of each path in the
+   bucket is the d'th probe of its key. */
+
+struct Frozen
+{
+   /* The number of nodes. */
+   size_t uLength;
+
+   /* The nodes, with the root at index 0 and the children of each
+      directory adjacent, directories taking their places in
+      depth-first order. */
+   struct FrozenNode *psNodes;
+
+   /* Every node's name, with no separators. */
+   char *pcPool;
+
+   /* The length of the string Frozen_toString returns, and of the
+      longest path. */
+   size_t uStringLength;
+   size_t uMaxPathLength;
+
+   /* The seed of the keys. */
+   unsigned long ulSeed;
+
+   /* The number of buckets, and each bucket's code. */
+   size_t uBuckets;
+   size_t *puCodes;
+
+   /* The node index of each of the uLength slots. */
+   size_t *puSlots;
+
+   /* Whether the contents the nodes mark as owned are this object's,
+      to be freed with it, rather than the Nodes'. */
+   int iOwnsContents;
+};
+
+/* The key of a path: two independent 32-bit hashes of it, one to
+   choose its bucket and one from which its probes are computed. */
+
+struct FrozenKey
+{
+   unsigned long ulBucket;
+   unsigned long ulProbe;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return ulValue with its 32 bits thoroughly mixed. */
+
+static unsigned long Frozen_mix(unsigned long ulValue)
+{
+   ulValue &= MASK32;
+   ulValue ^= ulValue >> 16;
+   ulValue = (ulValue * 0x85ebca6bUL) & MASK32;
+   ulValue ^= ulValue >> 13;
+   ulValue = (ulValue * 0xc2b2ae35UL) & MASK32;
+   ulValue ^= ulValue >> 16;
+   return ulValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Hash pcPath, using ulSeed, into *psKey.  Runs of '/' count as one,
+   and leading and trailing ones not at all, so that every spelling of
+   a path has the key of the path as Node_getPath gives it.  Return 1
+   (TRUE) if pcPath has any components, or 0 (FALSE) if not. */
+
+static int Frozen_hashPath(unsigned long ulSeed, const char *pcPath,
+                           struct FrozenKey *psKey)
+{
+   unsigned long ulBucket = (2166136261UL ^ ulSeed) & MASK32;
+   unsigned long ulProbe = Frozen_mix(ulSeed + 1);
+   int iStarted = 0;
+   unsigned char c;
+
+   assert(pcPath != NULL);
+   assert(psKey != NULL);
+
+   for (;;)
+   {
+      while (*pcPath == '/')
+         pcPath++;
+      if (*pcPath == '\0')
+         break;
+      if (iStarted)
+      {
+         ulBucket = ((ulBucket ^ '/') * 16777619UL) & MASK32;
+         ulProbe = ((ulProbe ^ '/') * 0x5bd1e995UL) & MASK32;
+      }
+      while (*pcPath != '\0' && *pcPath != '/')
+      {
+         c = (unsigned char)*pcPath++;
+         ulBucket = ((ulBucket ^ c) * 16777619UL) & MASK32;
+         ulProbe = ((ulProbe ^ c) * 0x5bd1e995UL) & MASK32;
+      }
+      iStarted = 1;
+   }
+
+   psKey->ulBucket = ulBucket;
+   psKey->ulProbe = ulProbe;
+   return iStarted;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the bucket of *psKey among uBuckets. */
+
+static size_t Frozen_bucket(const struct FrozenKey *psKey,
+                            size_t uBuckets)
+{
+   return (size_t)(Frozen_mix(psKey->ulBucket) % uBuckets);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the uDisplacement'th probe of *psKey among uLength slots. */
+
+static size_t Frozen_probe(const struct FrozenKey *psKey,
+                           size_t uDisplacement, size_t uLength)
+{
+   unsigned long ulProbe;
+
+   ulProbe = psKey->ulProbe + (unsigned long)uDisplacement * 0x9e3779b9UL;
+   return (size_t)(Frozen_mix(ulProbe) % uLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the slot of oFrozen that *psKey maps to. */
+
+static size_t Frozen_slot(Frozen_T oFrozen,
+                          const struct FrozenKey *psKey)
+{
+   size_t uCode;
+
+   uCode = oFrozen->puCodes[Frozen_bucket(psKey, oFrozen->uBuckets)];
+   if (uCode & 1)
+      return uCode >> 1;
+   return Frozen_probe(psKey, uCode >> 1, oFrozen->uLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Fill in the uIndex'th node of oFrozen from oSource, the child of
+   the uParent'th node, or the root if uParent is NO_NODE, giving it
+   the name at offset *puPool of the pool and advancing *puPool past
+   it.  The pool itself is filled in later. */
+
+static void Frozen_copyNode(Frozen_T oFrozen, size_t uIndex,
+                            Node oSource, size_t uParent,
+                            Node oParent, size_t *puPool)
+{
+   struct FrozenNode *psNode = &oFrozen->psNodes[uIndex];
+   size_t uPathLength = Node_getPathLength(oSource);
+
+   psNode->uParent = uParent;
+   psNode->uName = *puPool;
+   psNode->uNameLength = uPathLength;
+   if (oParent != NULL)
+      psNode->uNameLength -= Node_getPathLength(oParent) + 1;
+   *puPool += psNode->uNameLength;
+
+   psNode->eType = Node_getType(oSource);
+   if (psNode->eType == FILE_S)
+   {
+      psNode->u.sFile.pvContents = Node_getFileContents(oSource);
+      psNode->u.sFile.uLength = Node_getFileLength(oSource);
+      psNode->u.sFile.iOwned = Node_isContentsOwned(oSource);
+   }
+   else
+   {
+      psNode->u.sDir.uFirst = 0;
+      psNode->u.sDir.uCount = 0;
+   }
+
+   oFrozen->uStringLength += uPathLength + 1;
+   if (uPathLength > oFrozen->uMaxPathLength)
+      oFrozen->uMaxPathLength = uPathLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Number the uLength Nodes of the hierarchy rooted at oRoot into the
+   nodes of oFrozen, assigning each Node to its index of apoSources:
+   when the directory at the top of auStack is taken off it, its
+   children get the next indices, and those that are directories go
+   on the stack in reverse, so that the first is taken next.  Return
+   the total length of the names. */
+
+static size_t Frozen_layout(Frozen_T oFrozen, Node oRoot,
+                            Node *apoSources, size_t *auStack)
+{
+   struct FrozenNode *psNode;
+   size_t uNext = 1;
+   size_t uDepth = 0;
+   size_t uPool = 0;
+   size_t uIndex;
+   size_t uChild;
+
+   apoSources[0] = oRoot;
+   Frozen_copyNode(oFrozen, 0, oRoot, NO_NODE, NULL, &uPool);
+   if (oFrozen->psNodes[0].eType == DIRECTORY)
+      auStack[uDepth++] = 0;
+
+   while (uDepth > 0)
+   {
+      uIndex = auStack[--uDepth];
+      psNode = &oFrozen->psNodes[uIndex];
+      psNode->u.sDir.uFirst = uNext;
+      psNode->u.sDir.uCount = Node_getNumChildren(apoSources[uIndex]);
+      for (uChild = 0; uChild < psNode->u.sDir.uCount; uChild++)
+      {
+         assert(uNext < oFrozen->uLength);
+         apoSources[uNext] = Node_getChild(apoSources[uIndex], uChild);
+         Frozen_copyNode(oFrozen, uNext, apoSources[uNext], uIndex,
+                         apoSources[uIndex], &uPool);
+         uNext++;
+      }
+      for (uChild = psNode->u.sDir.uCount; uChild > 0; uChild--)
+         if (oFrozen->psNodes[psNode->u.sDir.uFirst + uChild - 1].eType
+             == DIRECTORY)
+            auStack[uDepth++] = psNode->u.sDir.uFirst + uChild - 1;
+   }
+
+   assert(uNext == oFrozen->uLength);
+   return uPool;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Try to fill the slots and bucket codes of oFrozen with its current
+   seed, given the key of every node in asKeys.  auStart and auMembers
+   receive the members of each bucket, as the indices
+   auMembers[auStart[b]] up to auMembers[auStart[b + 1]]; auCursor
+   and auProbes are scratch space of uBuckets and uLength elements.
+   Return 1 (TRUE) if successful, or 0 (FALSE) if some bucket could
+   not be placed, in which case another seed should be tried. */
+
+static int Frozen_place(Frozen_T oFrozen,
+                        const struct FrozenKey *asKeys,
+                        size_t *auStart, size_t *auMembers,
+                        size_t *auCursor, size_t *auProbes)
+{
+   size_t uLength = oFrozen->uLength;
+   size_t uBuckets = oFrozen->uBuckets;
+   size_t uMaxSize = 0;
+   size_t uSize;
+   size_t uBucket;
+   size_t uIndex;
+   size_t uMember;
+   size_t uOther;
+   size_t uDisplacement;
+   size_t uFree;
+
+   /* Gather the members of each bucket. */
+   for (uBucket = 0; uBucket <= uBuckets; uBucket++)
+      auStart[uBucket] = 0;
+   for (uIndex = 0; uIndex < uLength; uIndex++)
+      auStart[Frozen_bucket(&asKeys[uIndex], uBuckets) + 1]++;
+   for (uBucket = 0; uBucket < uBuckets; uBucket++)
+   {
+      if (auStart[uBucket + 1] > uMaxSize)
+         uMaxSize = auStart[uBucket + 1];
+      auStart[uBucket + 1] += auStart[uBucket];
+      auCursor[uBucket] = auStart[uBucket];
+   }
+   for (uIndex = 0; uIndex < uLength; uIndex++)
+      auMembers[auCursor[Frozen_bucket(&asKeys[uIndex], uBuckets)]++] =
+         uIndex;
+
+   for (uIndex = 0; uIndex < uLength; uIndex++)
+      oFrozen->puSlots[uIndex] = NO_NODE;
+   for (uBucket = 0; uBucket < uBuckets; uBucket++)
+      oFrozen->puCodes[uBucket] = 0;
+
+   /* Place the buckets of two or more, largest first, each at the
+      first displacement whose probes all land in distinct free
+      slots. */
+   for (uSize = uMaxSize; uSize >= 2; uSize--)
+      for (uBucket = 0; uBucket < uBuckets; uBucket++)
+      {
+         if (auStart[uBucket + 1] - auStart[uBucket] != uSize)
+            continue;
+         for (uDisplacement = 0; uDisplacement < MAX_DISPLACEMENTS;
+              uDisplacement++)
+         {
+            for (uMember = 0; uMember < uSize; uMember++)
+            {
+               uIndex = auMembers[auStart[uBucket] + uMember];
+               auProbes[uMember] = Frozen_probe(&asKeys[uIndex],
+                                                uDisplacement, uLength);
+               if (oFrozen->puSlots[auProbes[uMember]] != NO_NODE)
+                  break;
+               for (uOther = 0; uOther < uMember; uOther++)
+                  if (auProbes[uOther] == auProbes[uMember])
+                     break;
+               if (uOther < uMember)
+                  break;
+            }
+            if (uMember == uSize)
+               break;
+         }
+         if (uDisplacement == MAX_DISPLACEMENTS)
+            return 0;
+
+         for (uMember = 0; uMember < uSize; uMember++)
+            oFrozen->puSlots[auProbes[uMember]] =
+               auMembers[auStart[uBucket] + uMember];
+         oFrozen->puCodes[uBucket] = uDisplacement << 1;
+      }
+
+   /* Give each bucket of one a free slot of its own. */
+   uFree = 0;
+   for (uBucket = 0; uBucket < uBuckets; uBucket++)
+   {
+      if (auStart[uBucket + 1] - auStart[uBucket] != 1)
+         continue;
+      while (oFrozen->puSlots[uFree] != NO_NODE)
+         uFree++;
+      oFrozen->puSlots[uFree] = auMembers[auStart[uBucket]];
+      oFrozen->puCodes[uBucket] = (uFree << 1) | 1;
+   }
+
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Build the perfect hash of oFrozen, whose nodes were copied from
+   apoSources.  Return 1 (TRUE) if successful, or 0 (FALSE) if
+   insufficient memory is available or no seed could be placed. */
+
+static int Frozen_buildHash(Frozen_T oFrozen, Node *apoSources)
+{
+   struct FrozenKey *asKeys;
+   size_t *auStart;
+   size_t *auMembers;
+   size_t *auScratch;
+   size_t uLength = oFrozen->uLength;
+   size_t uIndex;
+   int iSeed;
+   int iSuccessful = 0;
+
+   oFrozen->uBuckets = uLength / FROZEN_BUCKET_KEYS + 1;
+   oFrozen->puCodes = malloc(oFrozen->uBuckets * sizeof(size_t));
+   oFrozen->puSlots = malloc(uLength * sizeof(size_t));
+   asKeys = malloc(uLength * sizeof(struct FrozenKey));
+   auStart = malloc((oFrozen->uBuckets + 1) * sizeof(size_t));
+   auMembers = malloc(uLength * sizeof(size_t));
+   auScratch = malloc((oFrozen->uBuckets + uLength) * sizeof(size_t));
+   STATS_ADD(mallocs, 6);
+
+   if (oFrozen->puCodes != NULL && oFrozen->puSlots != NULL &&
+       asKeys != NULL && auStart != NULL && auMembers != NULL &&
+       auScratch != NULL)
+      for (iSeed = 0; iSeed < MAX_SEEDS && !iSuccessful; iSeed++)
+      {
+         oFrozen->ulSeed = Frozen_mix((unsigned long)iSeed);
+         for (uIndex = 0; uIndex < uLength; uIndex++)
+            (void)Frozen_hashPath(oFrozen->ulSeed,
+                                  Node_getPath(apoSources[uIndex]),
+                                  &asKeys[uIndex]);
+         iSuccessful = Frozen_place(oFrozen, asKeys, auStart, auMembers,
+                                    auScratch,
+                                    auScratch + oFrozen->uBuckets);
+      }
+
+   free(asKeys);
+   free(auStart);
+   free(auMembers);
+   free(auScratch);
+   STATS_ADD(frees, 4);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+Frozen_T Frozen_new(Node oRoot, size_t uCount)
+{
+   Frozen_T oFrozen;
+   Node *apoSources;
+   size_t *auStack;
+   size_t uPool;
+   size_t uIndex;
+   struct FrozenNode *psNode;
+   int iSuccessful = 1;
+
+   assert(oRoot != NULL || uCount == 0);
+
+   oFrozen = calloc(1, sizeof(struct Frozen));
+   if (oFrozen == NULL)
+      return NULL;
+   STATS_ADD(mallocs, 1);
+   if (oRoot == NULL)
+      return oFrozen;
+
+   oFrozen->uLength = uCount;
+   oFrozen->psNodes = malloc(uCount * sizeof(struct FrozenNode));
+   apoSources = malloc(uCount * sizeof(Node));
+   auStack = malloc(uCount * sizeof(size_t));
+   STATS_ADD(mallocs, 3);
+   if (oFrozen->psNodes == NULL || apoSources == NULL || auStack == NULL)
+      iSuccessful = 0;
+
+   if (iSuccessful)
+   {
+      uPool = Frozen_layout(oFrozen, oRoot, apoSources, auStack);
+      oFrozen->pcPool = malloc(uPool + 1);
+      STATS_ADD(mallocs, 1);
+      iSuccessful = oFrozen->pcPool != NULL;
+   }
+   if (iSuccessful)
+   {
+      for (uIndex = 0; uIndex < uCount; uIndex++)
+      {
+         psNode = &oFrozen->psNodes[uIndex];
+         memcpy(oFrozen->pcPool + psNode->uName,
+                Node_getPath(apoSources[uIndex]) +
+                Node_getPathLength(apoSources[uIndex]) -
+                psNode->uNameLength,
+                psNode->uNameLength);
+      }
+      iSuccessful = Frozen_buildHash(oFrozen, apoSources);
+   }
+
+   /* the contents the Nodes own are this object's from here on */
+   if (iSuccessful)
+   {
+      for (uIndex = 0; uIndex < uCount; uIndex++)
+         if (oFrozen->psNodes[uIndex].eType == FILE_S)
+            Node_setContentsOwned(apoSources[uIndex], FALSE);
+      oFrozen->iOwnsContents = 1;
+   }
+
+   free(apoSources);
+   free(auStack);
+   STATS_ADD(frees, 2);
+   if (!iSuccessful)
+   {
+      Frozen_free(oFrozen);
+      return NULL;
+   }
+   return oFrozen;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Frozen_free(Frozen_T oFrozen)
+{
+   size_t uIndex;
+   struct FrozenNode *psNode;
+
+   if (oFrozen == NULL)
+      return;
+
+   if (oFrozen->iOwnsContents)
+      for (uIndex = 0; uIndex < oFrozen->uLength; uIndex++)
+      {
+         psNode = &oFrozen->psNodes[uIndex];
+         if (psNode->eType == FILE_S && psNode->u.sFile.iOwned)
+         {
+            free(psNode->u.sFile.pvContents);
+            STATS_ADD(frees, 1);
+         }
+      }
+
+   free(oFrozen->psNodes);
+   free(oFrozen->pcPool);
+   free(oFrozen->puCodes);
+   free(oFrozen->puSlots);
+   free(oFrozen);
+   STATS_ADD(frees, 5);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t Frozen_getLength(Frozen_T oFrozen)
+{
+   assert(oFrozen != NULL);
+
+   return oFrozen->uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Frozen_find(Frozen_T oFrozen, const char *pcPath, size_t *puIndex)
+{
+   struct FrozenKey sKey;
+   const struct FrozenNode *psNode;
+   const char *pcEnd;
+   const char *pcStart;
+   size_t uIndex;
+   size_t uFound;
+
+   assert(oFrozen != NULL);
+   assert(pcPath != NULL);
+   assert(puIndex != NULL);
+
+   if (oFrozen->uLength == 0 ||
+       !Frozen_hashPath(oFrozen->ulSeed, pcPath, &sKey))
+      return 0;
+   uFound = oFrozen->puSlots[Frozen_slot(oFrozen, &sKey)];
+   STATS_ADD(traversals, 1);
+
+   /* Every path hashes to some node, so confirm that it is this one,
+      by matching its names, parent by parent, against the components
+      of pcPath from the last. */
+   uIndex = uFound;
+   pcEnd = pcPath + strlen(pcPath);
+   for (;;)
+   {
+      while (pcEnd > pcPath && pcEnd[-1] == '/')
+         pcEnd--;
+      if (pcEnd == pcPath)
+         break;
+      if (uIndex == NO_NODE)
+         return 0;
+      pcStart = pcEnd;
+      while (pcStart > pcPath && pcStart[-1] != '/')
+         pcStart--;
+
+      psNode = &oFrozen->psNodes[uIndex];
+      STATS_ADD(nodesVisited, 1);
+      if ((size_t)(pcEnd - pcStart) != psNode->uNameLength)
+         return 0;
+      STATS_COMPARE(pcStart, oFrozen->pcPool + psNode->uName,
+                    psNode->uNameLength);
+      if (memcmp(pcStart, oFrozen->pcPool + psNode->uName,
+                 psNode->uNameLength) != 0)
+         return 0;
+      uIndex = psNode->uParent;
+      pcEnd = pcStart;
+   }
+   if (uIndex != NO_NODE)
+      return 0;
+
+   *puIndex = uFound;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+nodeType Frozen_getType(Frozen_T oFrozen, size_t uIndex)
+{
+   assert(oFrozen != NULL);
+   assert(uIndex < oFrozen->uLength);
+
+   return oFrozen->psNodes[uIndex].eType;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *Frozen_getFileContents(Frozen_T oFrozen, size_t uIndex)
+{
+   assert(oFrozen != NULL);
+   assert(uIndex < oFrozen->uLength);
+   assert(oFrozen->psNodes[uIndex].eType == FILE_S);
+
+   return oFrozen->psNodes[uIndex].u.sFile.pvContents;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t Frozen_getFileLength(Frozen_T oFrozen, size_t uIndex)
+{
+   assert(oFrozen != NULL);
+   assert(uIndex < oFrozen->uLength);
+   assert(oFrozen->psNodes[uIndex].eType == FILE_S);
+
+   return oFrozen->psNodes[uIndex].u.sFile.uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the paths of the uIndex'th node of oFrozen and of every node
+   beneath it, in pre-order, each followed by a newline, to pcOut.
+   pcPath holds the path of the node's parent, which is uPathLength
+   characters long, and has room for the longest path.  Return the end
+   of what was written. */
+
+static char *Frozen_writeSubtree(Frozen_T oFrozen, size_t uIndex,
+                                 char *pcPath, size_t uPathLength,
+                                 char *pcOut)
+{
+   const struct FrozenNode *psNode = &oFrozen->psNodes[uIndex];
+   size_t uChild;
+
+   if (psNode->uParent != NO_NODE)
+      pcPath[uPathLength++] = '/';
+   memcpy(pcPath + uPathLength, oFrozen->pcPool + psNode->uName,
+          psNode->uNameLength);
+   uPathLength += psNode->uNameLength;
+
+   memcpy(pcOut, pcPath, uPathLength);
+   pcOut += uPathLength;
+   *pcOut++ = '\n';
+
+   if (psNode->eType == DIRECTORY)
+      for (uChild = 0; uChild < psNode->u.sDir.uCount; uChild++)
+         pcOut = Frozen_writeSubtree(oFrozen,
+                                     psNode->u.sDir.uFirst + uChild,
+                                     pcPath, uPathLength, pcOut);
+   return pcOut;
+}
+
+/*--------------------------------------------------------------------*/
+
+char *Frozen_toString(Frozen_T oFrozen)
+{
+   char *pcResult;
+   char *pcPath;
+   char *pcEnd;
+
+   assert(oFrozen != NULL);
+
+   pcResult = malloc(oFrozen->uStringLength + 1);
+   if (pcResult == NULL)
+      return NULL;
+   STATS_ADD(mallocs, 1);
+   if (oFrozen->uLength == 0)
+   {
+      *pcResult = '\0';
+      return pcResult;
+   }
+
+   pcPath = malloc(oFrozen->uMaxPathLength + 1);
+   if (pcPath == NULL)
+   {
+      free(pcResult);
+      STATS_ADD(frees, 1);
+      return NULL;
+   }
+   STATS_ADD(mallocs, 1);
+
+   pcEnd = Frozen_writeSubtree(oFrozen, 0, pcPath, 0, pcResult);
+   assert(pcEnd == pcResult + oFrozen->uStringLength);
+   *pcEnd = '\0';
+
+   free(pcPath);
+   STATS_ADD(frees, 1);
+   return pcResult;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new Node for the uIndex'th node of oFrozen, a child of
+   oParent, or NULL if insufficient memory is available. */
+
+static Node Frozen_createNode(Frozen_T oFrozen, size_t uIndex,
+                              Node oParent)
+{
+   const struct FrozenNode *psNode = &oFrozen->psNodes[uIndex];
+   Node oNode;
+
+   oNode = Node_createN(oFrozen->pcPool + psNode->uName,
+                        psNode->uNameLength, oParent, psNode->eType);
+   if (oNode != NULL && psNode->eType == FILE_S)
+      Node_insertFileContents(oNode, psNode->u.sFile.pvContents,
+                              psNode->u.sFile.uLength);
+   return oNode;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Frozen_thaw(Frozen_T oFrozen, Node *poRoot)
+{
+   Node *apoNodes;
+   const struct FrozenNode *psNode;
+   size_t uIndex;
+   size_t uFirst;
+   size_t uEnd;
+   size_t uFiles;
+   size_t uChild;
+   size_t uLinked;
+
+   assert(oFrozen != NULL);
+   assert(poRoot != NULL);
+
+   if (oFrozen->uLength == 0)
+   {
+      *poRoot = NULL;
+      return SUCCESS;
+   }
+
+   apoNodes = malloc(oFrozen->uLength * sizeof(Node));
+   if (apoNodes == NULL)
+      return MEMORY_ERROR;
+   STATS_ADD(mallocs, 1);
+   apoNodes[0] = Frozen_createNode(oFrozen, 0, NULL);
+   if (apoNodes[0] == NULL)
+   {
+      free(apoNodes);
+      STATS_ADD(frees, 1);
+      return MEMORY_ERROR;
+   }
+
+   /* Every parent comes before its children, so each directory's
+      Node exists by the time its children are created, and each block
+      of children is created and linked, files then directories, in
+      one sorted batch apiece, before the next. */
+   for (uIndex = 0; uIndex < oFrozen->uLength; uIndex++)
+   {
+      psNode = &oFrozen->psNodes[uIndex];
+      if (psNode->eType != DIRECTORY || psNode->u.sDir.uCount == 0)
+         continue;
+      uFirst = psNode->u.sDir.uFirst;
+      uEnd = uFirst + psNode->u.sDir.uCount;
+
+      uLinked = uFirst;
+      for (uChild = uFirst; uChild < uEnd; uChild++)
+      {
+         apoNodes[uChild] = Frozen_createNode(oFrozen, uChild,
+                                              apoNodes[uIndex]);
+         if (apoNodes[uChild] == NULL)
+            break;
+      }
+      if (uChild == uEnd)
+      {
+         for (uFiles = 0; uFirst + uFiles < uEnd &&
+                 oFrozen->psNodes[uFirst + uFiles].eType == FILE_S;
+              uFiles++)
+            ;
+         if (uFiles == 0 ||
+             Node_addChildren(apoNodes[uIndex], apoNodes + uFirst,
+                              uFiles) == SUCCESS)
+         {
+            uLinked = uFirst + uFiles;
+            if (uLinked == uEnd ||
+                Node_addChildren(apoNodes[uIndex], apoNodes + uLinked,
+                                 uEnd - uLinked) == SUCCESS)
+               continue;
+         }
+      }
+
+      /* Destroy the Nodes of this block not yet linked, then the
+         hierarchy. */
+      while (uChild > uLinked)
+         (void)Node_destroy(apoNodes[--uChild]);
+      (void)Node_destroy(apoNodes[0]);
+      free(apoNodes);
+      STATS_ADD(frees, 1);
+      return MEMORY_ERROR;
+   }
+
+   /* the contents this object owns are the Nodes' from here on */
+   if (oFrozen->iOwnsContents)
+   {
+      for (uIndex = 0; uIndex < oFrozen->uLength; uIndex++)
+         if (oFrozen->psNodes[uIndex].eType == FILE_S)
+            Node_setContentsOwned(apoNodes[uIndex],
+                                  oFrozen->psNodes[uIndex].u.sFile.iOwned);
+      oFrozen->iOwnsContents = 0;
+   }
+
+   *poRoot = apoNodes[0];
+   free(apoNodes);
+   STATS_ADD(frees, 1);
+   return SUCCESS;
+}
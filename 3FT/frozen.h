@@ -0,0 +1,95 @@
+/*--------------------------------------------------------------------*/
+/* frozen.h                                                           */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#ifndef FROZEN_INCLUDED
+#define FROZEN_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+#include "node.h"
+
+/* A Frozen_T object is a read-only copy of a hierarchy of Nodes,
+   compacted into a few contiguous arrays: one entry per node, with
+   the children of each directory adjacent, so that a directory names
+   them by the index of the first and their number; one pool holding
+   every name; and a minimal perfect hash from each full path to its
+   node's index, so that a lookup costs one hash of the path and one
+   comparison of it, however deep the path.  Nodes are identified by
+   their index, from 0 (the root) to the length less 1.  The contents
+   of files are shared with, not copied from, the Nodes; those the
+   Nodes own pass to the Frozen_T object when it is made, and back to
+   the Nodes when it is thawed. */
+
+typedef struct Frozen *Frozen_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new Frozen_T object holding a copy of the uCount Nodes of
+   the hierarchy rooted at oRoot, which may be NULL for an empty
+   hierarchy, or NULL if insufficient memory is available.  The
+   contents the Nodes own become the object's. */
+
+Frozen_T Frozen_new(Node oRoot, size_t uCount);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oFrozen, and the contents it owns. */
+
+void Frozen_free(Frozen_T oFrozen);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of nodes in oFrozen. */
+
+size_t Frozen_getLength(Frozen_T oFrozen);
+
+/*--------------------------------------------------------------------*/
+
+/* Find the node of oFrozen whose path is pcPath, a '\0'-terminated
+   string of components separated by one or more '/' characters, as
+   FT paths are.  If there is one, then assign its index to *puIndex
+   and return 1.  Otherwise assign nothing to *puIndex and return 0. */
+
+int Frozen_find(Frozen_T oFrozen, const char *pcPath, size_t *puIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the type of the uIndex'th node of oFrozen. */
+
+nodeType Frozen_getType(Frozen_T oFrozen, size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the contents of the uIndex'th node of oFrozen, which must be
+   a file. */
+
+void *Frozen_getFileContents(Frozen_T oFrozen, size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the length of the contents of the uIndex'th node of oFrozen,
+   which must be a file. */
+
+size_t Frozen_getFileLength(Frozen_T oFrozen, size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the full path of every node of oFrozen, each followed by a
+   newline, in the order FT_toString lists them, as a string owned by
+   the caller, or NULL if insufficient memory is available. */
+
+char *Frozen_toString(Frozen_T oFrozen);
+
+/*--------------------------------------------------------------------*/
+
+/* Rebuild the hierarchy of Nodes that oFrozen was made from, with the
+   same paths, types and contents, and assign its root, or NULL if it
+   is empty, to *poRoot, handing the contents oFrozen owns back to the
+   Nodes.  Return SUCCESS, or MEMORY_ERROR, assigning nothing, if
+   insufficient memory is available. */
+
+int Frozen_thaw(Frozen_T oFrozen, Node *poRoot);
+
+#endif
@@ -9,10 +9,19 @@
 #include <stddef.h>
 #include <stdlib.h>
 
-#include "dynarray.h"
 #include "ft.h"
 #include "node.h"
+#include "frozen.h"
+#include "louds.h"
+#include "nameindex.h"
+#include "btree.h"
+#include "dirscan.h"
+#include "grep.h"
+#include "tar.h"
 #include "checker.h"
+#include "stats.h"
+#include "trace.h"
+#include "typedarray.h"
 
 /* A Directory Tree is an AO with 3 state variables: */
 /* a flag for if it is in an initialized state (TRUE) or not (FALSE) */
@@ -21,482 +30,4233 @@ static boolean isInitialized;
 static Node root;
 /* a counter of the number of Nodes in the hierarchy */
 static size_t count;
+/* the frozen form of the hierarchy while FT_freeze is in effect, in
+   which case root is NULL and count 0, or NULL otherwise */
+static Frozen_T frozen;
 
 /*
-   Starting at the parameter curr, traverses as far down
-   the hierarchy as possible while still matching the path
-   parameter.
+   An open directory handle refers to a DirSlot: the directory it
+   names, the generation number a handle must carry to still be valid,
+   and the number of FT_openDir calls sharing the slot. A slot whose
+   dir is NULL is free for reuse.
+*/
+struct DirSlot {
+   Node dir;
+   unsigned long generation;
+   size_t refs;
+};
+
+/* An array of DirSlot pointers */
+DEFINE_DYNARRAY(DirSlotArray, struct DirSlot*);
+
+/* The directory handle table is 3 more state variables: */
+/* the DirSlots, indexed by FT_DirHandle.slot, or NULL if none yet */
+static DirSlotArray_T dirSlots;
+/* the number of DirSlots currently in use */
+static size_t openDirs;
+/* the last generation number handed out; never reused, even across
+   FT_destroy, so no stale handle can ever match a later slot */
+static unsigned long lastGeneration;
+
+/* the trace started by FT_startTrace, or NULL if not tracing */
+static Trace_T trace;
 
-   Returns a pointer to the farthest matching Node down that path,
-   or NULL if there is no node in curr's hierarchy that matches
-   a prefix of the path
+/* The index of names is 2 more state variables: */
+/* the index kept for FT_findByName and FT_findByExtension, or NULL
+   if there is none */
+static NameIndex_T names;
+/* whether FT_indexNames has turned it on, so that FT_thaw rebuilds
+   it */
+static boolean namesWanted;
+
+/* The index of sizes is 3 more state variables: */
+/* every file, largest first, and every directory, largest total
+   length of the files beneath it first, kept for FT_topKFiles and
+   FT_topKDirs, or NULL if there is no such index; while they are
+   not, each directory's total and maximum lengths are kept too */
+static BTree_T fileSizes;
+static BTree_T dirSizes;
+/* whether FT_indexSizes has turned it on, so that FT_thaw rebuilds
+   it */
+static boolean sizesWanted;
+
+/*
+   A PathCursor steps through the components of a path, either by
+   scanning a '\0'-terminated string as it goes or by indexing into a
+   pre-parsed FT_Path, so the traversal code below serves both forms
+   of every operation without ever copying or allocating.
 */
-static Node FT_traversePathFrom(char* path, Node curr) {
-   Node found;
-   size_t i;
+struct PathCursor {
+   /* the pre-parsed path, or NULL if scanning a string */
+   const FT_Path* parsed;
+   /* when scanning a string, the not-yet-consumed remainder */
+   const char* rest;
+   /* when indexing an FT_Path, the index of the next component */
+   size_t index;
+};
 
+/*
+   Returns the length of the path component that begins at path,
+   i.e., the number of characters before the next '/' or the end.
+*/
+static size_t FT_componentLength(const char* path) {
    assert(path != NULL);
+   return strcspn(path, "/");
+}
 
-   if(curr == NULL)
-      return NULL;
-
-   else if(!strcmp(path,Node_getPath(curr)))
-      return curr;
+/*
+   Returns path advanced past any '/' separators at its start.
+*/
+static const char* FT_skipSeparators(const char* path) {
+   assert(path != NULL);
+   while(*path == '/')
+      path++;
+   return path;
+}
 
-   else if(!strncmp(path, Node_getPath(curr), strlen(Node_getPath(curr))) 
-           && Node_getType(curr) == DIRECTORY) {
-      for(i = 0; i < Node_getNumChildren(curr); i++) {
-         found = FT_traversePathFrom(path,
-                                Node_getChild(curr, i));
-         if(found != NULL)
-            return found;
-      }
-      return curr;
-   }
+/*
+   Positions cursor *c at the first component of the string path.
+*/
+static void FT_cursorFromString(struct PathCursor* c, const char* path) {
+   assert(c != NULL);
+   assert(path != NULL);
 
-   return NULL;
+   c->parsed = NULL;
+   c->rest = FT_skipSeparators(path);
+   c->index = 0;
 }
 
 /*
-   Returns the farthest Node reachable from the root following a given
-   path, or NULL if there is no Node in the hierarchy that matches a
-   prefix of the path.
+   Positions cursor *c at the first component of the parsed path.
 */
-static Node FT_traversePath(char* path) {
+static void FT_cursorFromPath(struct PathCursor* c, const FT_Path* path) {
+   assert(c != NULL);
    assert(path != NULL);
-   return FT_traversePathFrom(path, root);
+
+   c->parsed = path;
+   c->rest = NULL;
+   c->index = 0;
 }
 
 /*
-   Destroys the entire hierarchy of Nodes rooted at curr,
-   including curr itself.
+   Returns TRUE if cursor c has consumed every component of its path.
 */
-static void FT_removePathFrom(Node curr) {
-   if(curr != NULL) {
-      count -= Node_destroy(curr);
+static boolean FT_cursorAtEnd(const struct PathCursor* c) {
+   assert(c != NULL);
+
+   if(c->parsed != NULL)
+      return (boolean) (c->index >= c->parsed->numComponents);
+   return (boolean) (*c->rest == '\0');
+}
+
+/*
+   Stores the next component of cursor c in *pName and its length in
+   *pLen, without consuming it. c must not be at its end.
+*/
+static void FT_cursorPeek(const struct PathCursor* c,
+                          const char** pName, size_t* pLen) {
+   const struct FT_PathComponent* comp;
+
+   assert(c != NULL);
+   assert(!FT_cursorAtEnd(c));
+   assert(pName != NULL);
+   assert(pLen != NULL);
+
+   if(c->parsed != NULL) {
+      comp = &c->parsed->components[c->index];
+      *pName = c->parsed->string + comp->offset;
+      *pLen = comp->length;
    }
+   else {
+      *pName = c->rest;
+      *pLen = FT_componentLength(c->rest);
+   }
+}
+
+/*
+   Consumes the next component of cursor *c, whose length len was
+   reported by FT_cursorPeek.
+*/
+static void FT_cursorAdvance(struct PathCursor* c, size_t len) {
+   assert(c != NULL);
+   assert(!FT_cursorAtEnd(c));
+
+   if(c->parsed != NULL)
+      c->index++;
+   else
+      c->rest = FT_skipSeparators(c->rest + len);
+}
+
+/*
+   Returns the string of the path under cursor c, which must not yet
+   have been advanced: for a pre-parsed path, the string it was parsed
+   from, which has the same components.
+*/
+static const char* FT_cursorString(const struct PathCursor* c) {
+   assert(c != NULL);
+
+   if(c->parsed != NULL)
+      return c->parsed->string;
+   return c->rest;
+}
+
+/*
+   Returns TRUE if directory dir has a child of type type named by the
+   next component of cursor c, whose characters FT_cursorPeek stored
+   in name and len, and if so stores its identifier in *pChildID. A
+   pre-parsed path's hash turns most absent names away unsearched.
+*/
+static boolean FT_cursorFindChild(const struct PathCursor* c, Node dir,
+                                  const char* name, size_t len,
+                                  nodeType type, size_t* pChildID) {
+   assert(c != NULL);
+   assert(!FT_cursorAtEnd(c));
+
+   if(c->parsed != NULL)
+      return Node_findChildHashed(dir, name, len,
+                                  c->parsed->components[c->index].hash,
+                                  type, pChildID);
+   return Node_findChild(dir, name, len, type, pChildID);
 }
 
 /*
-   Given a prospective parent and child Node,
-   adds child to parent's children list, if possible
+   Starting at the directory or file curr, traverses as far down the
+   hierarchy as possible while still matching the path under cursor
+   *c, one component at a time. Each level costs a binary search of
+   one directory's children rather than a walk of the whole hierarchy.
 
-   If not possible, destroys the hierarchy rooted at child
-   and returns PARENT_CHILD_ERROR, otherwise, returns SUCCESS.
+   Returns the farthest matching Node down that path, and leaves *c at
+   the first unmatched component, so *c is at its end if the returned
+   Node is the Node for the path itself.
 */
-static int FT_linkParentToChild(Node parent, Node child) {
+static Node FT_traversePathFrom(struct PathCursor* c, Node curr) {
+   const char* name;
+   size_t len;
+   size_t childID;
 
-   assert(parent != NULL);
+   assert(c != NULL);
+   assert(curr != NULL);
 
-   if(Node_linkChild(parent, child) != SUCCESS) {
-      (void) Node_destroy(child);
-      return PARENT_CHILD_ERROR;
+   STATS_ADD(traversals, 1);
+   STATS_ADD(nodesVisited, 1);
+   while(!FT_cursorAtEnd(c) && Node_getType(curr) == DIRECTORY) {
+      FT_cursorPeek(c, &name, &len);
+      if(FT_cursorFindChild(c, curr, name, len, DIRECTORY, &childID) ||
+         FT_cursorFindChild(c, curr, name, len, FILE_S, &childID))
+         curr = Node_getChild(curr, childID);
+      else
+         break;
+      STATS_ADD(nodesVisited, 1);
+      FT_cursorAdvance(c, len);
    }
 
-   return SUCCESS;
+   return curr;
 }
 
 /*
-   Inserts a new path into the tree rooted at parent, or, if
-   parent is NULL, as the root of the data structure.
+   Traverses the hierarchy as FT_traversePathFrom does, starting at
+   Node start, or, if start is NULL, at the root, whose own path must
+   then match the first component.
+
+   Returns the farthest matching Node down that path, or NULL if there
+   is no node in the hierarchy that matches a prefix of the path.
+   Leaves *c at the first unmatched component.
+*/
+static Node FT_traversePath(struct PathCursor* c, Node start) {
+   const char* name;
+   size_t len;
 
-   If a Node representing path already exists, returns ALREADY_IN_TREE
+   assert(c != NULL);
 
-   If there is an allocation error in creating any of the new nodes or
-   their fields, returns MEMORY_ERROR
+   if(start != NULL)
+      return FT_traversePathFrom(c, start);
+
+   if(root == NULL || FT_cursorAtEnd(c))
+      return NULL;
+
+   FT_cursorPeek(c, &name, &len);
+   if(len == Node_getPathLength(root))
+      STATS_COMPARE(name, Node_getPath(root), len);
+   if(len != Node_getPathLength(root) ||
+      strncmp(name, Node_getPath(root), len))
+      return NULL;
 
-   If there is an error linking any of the new nodes,
-   returns PARENT_CHID_ERROR
+   FT_cursorAdvance(c, len);
+   return FT_traversePathFrom(c, root);
+}
 
-   Otherwise, returns SUCCESS
+/*
+   Returns the Node for exactly the path under cursor *c, taken
+   relative to start as for FT_traversePath, or NULL if there is none.
 */
-static int FT_insertRestOfPath(char* path, Node parent, nodeType type) {
+static Node FT_findNode(struct PathCursor* c, Node start) {
+   Node curr;
 
-   Node curr = parent;
-   Node firstNew = NULL;
-   Node new;
-   char* copyPath;
-   char* restPath = path;
-   char* dirToken, *nextDirToken;
-   int result;
-   size_t newCount = 0;
+   assert(c != NULL);
 
-   assert(path != NULL);
+   curr = FT_traversePath(c, start);
+   if(!FT_cursorAtEnd(c))
+      return NULL;
+   return curr;
+}
 
-   if(curr == NULL) {
-      if(root != NULL) {
-         return CONFLICTING_PATH;
+/*
+   Returns the size by which Node n is ranked: a file's length, or the
+   total length of the files beneath a directory, as last measured.
+*/
+static size_t FT_sizeOf(Node n) {
+   assert(n != NULL);
+
+   if(Node_getType(n) == FILE_S)
+      return Node_getFileLength(n);
+   return Node_getTotalLength(n);
+}
+
+/*
+   Compares the Nodes pv1 and pv2, both files or both directories, by
+   size, the larger first, and then as Node_compare does.
+*/
+static int FT_compareSizes(const void* pv1, const void* pv2) {
+   size_t size1 = FT_sizeOf((Node) pv1);
+   size_t size2 = FT_sizeOf((Node) pv2);
+
+   if(size1 != size2)
+      return (size1 > size2) ? -1 : 1;
+   return Node_compare((Node) pv1, (Node) pv2);
+}
+
+/*
+   Frees the index of sizes, after an allocation error in keeping it
+   up to date or when it is turned off. FT_topKFiles and FT_topKDirs
+   then measure the hierarchy they are asked about instead, until
+   FT_indexSizes builds it again.
+*/
+static void FT_dropSizes(void) {
+   if(fileSizes != NULL)
+      BTree_free(fileSizes);
+   if(dirSizes != NULL)
+      BTree_free(dirSizes);
+   fileSizes = NULL;
+   dirSizes = NULL;
+}
+
+/*
+   Adds Node n to the index of sizes, which must exist, at its current
+   size. Returns FALSE if there is an allocation error, and TRUE
+   otherwise.
+*/
+static boolean FT_sizeAdd(Node n) {
+   BTree_T sizes;
+   size_t i;
+
+   assert(n != NULL);
+   assert(fileSizes != NULL);
+
+   sizes = (Node_getType(n) == FILE_S) ? fileSizes : dirSizes;
+   (void) BTree_bsearch(sizes, n, &i, FT_compareSizes);
+   return (boolean) BTree_addAt(sizes, i, n);
+}
+
+/*
+   Removes Node n, whose size must not have changed since it was
+   added, from the index of sizes, which must exist.
+*/
+static void FT_sizeRemove(Node n) {
+   BTree_T sizes;
+   size_t i;
+   int found;
+
+   assert(n != NULL);
+   assert(fileSizes != NULL);
+
+   sizes = (Node_getType(n) == FILE_S) ? fileSizes : dirSizes;
+   found = BTree_bsearch(sizes, n, &i, FT_compareSizes);
+   assert(found);
+   (void) found;
+   (void) BTree_removeAt(sizes, i);
+}
+
+/*
+   Brings the directories above Node n up to date after added bytes
+   have come to lie beneath each of them, in one file of that length,
+   and removed bytes have gone, moving each within the index of
+   sizes, if there is one, as its total changes.
+*/
+static void FT_sizeAncestors(Node n, size_t added, size_t removed) {
+   Node dir;
+
+   assert(n != NULL);
+
+   if(added == removed)
+      return;
+   for(dir = Node_getParent(n); dir != NULL && fileSizes != NULL;
+       dir = Node_getParent(dir)) {
+      FT_sizeRemove(dir);
+      Node_setTotalLength(dir, Node_getTotalLength(dir) - removed +
+                          added);
+      if(Node_getMaxLength(dir) < added)
+         Node_setMaxLength(dir, added);
+      if(!FT_sizeAdd(dir))
+         FT_dropSizes();
+   }
+}
+
+/*
+   Measures the total length of the files beneath each directory in
+   the hierarchy rooted at curr, and the length of the largest, and,
+   if index is TRUE, adds every Node in it to the index of sizes,
+   which must then exist. Returns FALSE if there is an allocation
+   error part-way, and TRUE otherwise.
+*/
+static boolean FT_measureFrom(Node curr, boolean index) {
+   Node child;
+   size_t total = 0;
+   size_t max = 0;
+   size_t c;
+
+   assert(curr != NULL);
+   assert(!index || fileSizes != NULL);
+
+   if(Node_getType(curr) == DIRECTORY) {
+      for(c = 0; c < Node_getNumChildren(curr); c++) {
+         child = Node_getChild(curr, c);
+         if(!FT_measureFrom(child, index))
+            return FALSE;
+         total += FT_sizeOf(child);
+         if(Node_getType(child) == FILE_S) {
+            if(Node_getFileLength(child) > max)
+               max = Node_getFileLength(child);
+         }
+         else if(Node_getMaxLength(child) > max)
+            max = Node_getMaxLength(child);
       }
+      Node_setTotalLength(curr, total);
+      Node_setMaxLength(curr, max);
    }
-   else {
-      if(!strcmp(path, Node_getPath(curr)))
-         return ALREADY_IN_TREE;
+   return (boolean) (!index || FT_sizeAdd(curr));
+}
+
+/*
+   Removes every Node in the hierarchy rooted at curr from the index
+   of sizes, which must exist.
+*/
+static void FT_unsizeFrom(Node curr) {
+   size_t c;
+
+   assert(curr != NULL);
+   assert(fileSizes != NULL);
+
+   FT_sizeRemove(curr);
+   for(c = 0; c < Node_getNumChildren(curr); c++)
+      FT_unsizeFrom(Node_getChild(curr, c));
+}
 
-      restPath += (strlen(Node_getPath(curr)) + 1);
+/*
+   Builds the index of sizes over the current hierarchy. Returns
+   FALSE, leaving it dropped, if there is an allocation error, and
+   TRUE otherwise.
+*/
+static boolean FT_buildSizes(void) {
+   fileSizes = BTree_new();
+   dirSizes = BTree_new();
+   if(fileSizes == NULL || dirSizes == NULL ||
+      (root != NULL && !FT_measureFrom(root, TRUE))) {
+      FT_dropSizes();
+      return FALSE;
    }
+   return TRUE;
+}
 
-   copyPath = malloc(strlen(restPath)+1);
-   if(copyPath == NULL)
-      return MEMORY_ERROR;
-   strcpy(copyPath, restPath);
-   dirToken = strtok(copyPath, "/");
-   nextDirToken = strtok(NULL, "/");
+/*
+   Gives file n the contents contents of length length, keeping the
+   index of sizes, if there is one, up to date.
+*/
+static void FT_setContents(Node n, void* contents, size_t length) {
+   size_t old;
 
-   while(dirToken != NULL) {
+   assert(n != NULL);
 
-      if (nextDirToken) new = Node_create(dirToken, curr, DIRECTORY);
-      else new = Node_create(dirToken, curr, type);
-      newCount++;
+   old = Node_getFileLength(n);
+   if(fileSizes == NULL || old == length) {
+      Node_insertFileContents(n, contents, length);
+      return;
+   }
+   FT_sizeRemove(n);
+   Node_insertFileContents(n, contents, length);
+   if(!FT_sizeAdd(n))
+      FT_dropSizes();
+   else
+      FT_sizeAncestors(n, length, old);
+}
 
-      if(firstNew == NULL)
-         firstNew = new;
-      else {
-         result = FT_linkParentToChild(curr, new);
-         if(result != SUCCESS) {
-            (void) Node_destroy(new);
-            (void) Node_destroy(firstNew);
-            free(copyPath);
-            return result;
-         }
+/*
+   Frees the index of names after an allocation error in keeping it
+   up to date. FT_findByName and FT_findByExtension then walk the
+   hierarchy instead, until FT_indexNames builds it again.
+*/
+static void FT_dropNames(void) {
+   NameIndex_free(names);
+   names = NULL;
+}
+
+/*
+   Adds Node n, but not its descendants, to the indexes of names and
+   of sizes, if there are any, and counts a file's length in the
+   directories above it. A directory must be new and empty.
+*/
+static void FT_indexNode(Node n) {
+   assert(n != NULL);
+
+   if(names != NULL && !NameIndex_add(names, n))
+      FT_dropNames();
+   if(fileSizes == NULL)
+      return;
+   if(!FT_sizeAdd(n))
+      FT_dropSizes();
+   else if(Node_getType(n) == FILE_S)
+      FT_sizeAncestors(n, Node_getFileLength(n), 0);
+}
+
+/*
+   Adds every Node in the hierarchy rooted at curr to the index of
+   names, which must exist. Returns FALSE if there is an allocation
+   error part-way, and TRUE otherwise.
+*/
+static boolean FT_indexFrom(Node curr) {
+   size_t c;
+
+   assert(curr != NULL);
+   assert(names != NULL);
+
+   if(!NameIndex_add(names, curr))
+      return FALSE;
+   for(c = 0; c < Node_getNumChildren(curr); c++)
+      if(!FT_indexFrom(Node_getChild(curr, c)))
+         return FALSE;
+   return TRUE;
+}
+
+/*
+   Removes every Node in the hierarchy rooted at curr from the index
+   of names, which must exist.
+*/
+static void FT_unindexFrom(Node curr) {
+   size_t c;
+
+   assert(curr != NULL);
+   assert(names != NULL);
+
+   NameIndex_remove(names, curr);
+   for(c = 0; c < Node_getNumChildren(curr); c++)
+      FT_unindexFrom(Node_getChild(curr, c));
+}
+
+/*
+   Destroys the entire hierarchy of Nodes rooted at curr,
+   including curr itself.
+*/
+static void FT_removePathFrom(Node curr) {
+   if(curr != NULL) {
+      if(names != NULL)
+         FT_unindexFrom(curr);
+      if(fileSizes != NULL) {
+         FT_unsizeFrom(curr);
+         FT_sizeAncestors(curr, 0, FT_sizeOf(curr));
       }
+      count -= Node_destroy(curr);
+   }
+}
+
+/*
+   Inserts the remaining components of the path under cursor *c as a
+   chain of new Nodes beneath parent, or, if parent is NULL, as the
+   root of the data structure. Every component but the last becomes a
+   directory; the last becomes a Node of type type. parent must be the
+   deepest existing Node along the path and must not already have a
+   child named the next component, as established by FT_traversePath.
+
+   The chain is built detached, linking each new Node directly into
+   its freshly created (and so empty) parent, and is only attached to
+   parent once complete, so a failure part-way leaves the hierarchy
+   untouched.
+
+   If there is an allocation error in creating any of the new nodes or
+   their fields, returns MEMORY_ERROR. Otherwise, stores the last new
+   Node in *pLeaf and returns SUCCESS.
+*/
+static int FT_insertRestOfPath(struct PathCursor* c, Node parent,
+                               nodeType type, Node* pLeaf) {
+   Node curr = parent;
+   Node firstNew = NULL;
+   Node new;
+   const char* name;
+   size_t len;
+   size_t childID = 0;
+   size_t newCount = 0;
+   nodeType newType;
+
+   assert(c != NULL);
+   assert(!FT_cursorAtEnd(c));
+   assert(pLeaf != NULL);
+
+   while(!FT_cursorAtEnd(c)) {
+      FT_cursorPeek(c, &name, &len);
+      FT_cursorAdvance(c, len);
+      newType = FT_cursorAtEnd(c) ? type : DIRECTORY;
 
+      new = Node_createN(name, len, curr, newType);
       if(new == NULL) {
+         if(firstNew != NULL)
+            (void) Node_destroy(firstNew);
+         return MEMORY_ERROR;
+      }
+      newCount++;
+
+      if(firstNew == NULL) {
+         firstNew = new;
+         if(parent != NULL)
+            (void) Node_findChild(parent, name, len, newType,
+                                  &childID);
+      }
+      else if(Node_addChildAt(curr, new, 0) != SUCCESS) {
+         (void) Node_destroy(new);
          (void) Node_destroy(firstNew);
-         free(copyPath);
          return MEMORY_ERROR;
       }
 
       curr = new;
-      dirToken = nextDirToken;
-      if(dirToken) nextDirToken = strtok(NULL, "/");
    }
 
-   free(copyPath);
-
-   if(parent == NULL) {
+   if(parent == NULL)
       root = firstNew;
-      count = newCount;
-      return SUCCESS;
+   else if(Node_addChildAt(parent, firstNew, childID) != SUCCESS) {
+      (void) Node_destroy(firstNew);
+      return MEMORY_ERROR;
    }
-   else {
-      result = FT_linkParentToChild(parent, firstNew);
-      if(result == SUCCESS)
-         count += newCount;
-      else
-         (void) Node_destroy(firstNew);
 
-      return result;
+   count += newCount;
+   for(new = firstNew; new != curr; new = Node_getChild(new, 0))
+      FT_indexNode(new);
+   FT_indexNode(curr);
+   *pLeaf = curr;
+   return SUCCESS;
+}
+
+/*
+   Inserts the path under cursor *c, taken relative to start as for
+   FT_traversePath, into the hierarchy as a Node of type type,
+   creating any missing ancestor directories, with a single descent.
+   On SUCCESS, stores the new Node in *pLeaf. Returns the status codes
+   documented for FT_insertDir and FT_insertFile.
+*/
+static int FT_insertPath(struct PathCursor* c, Node start,
+                         nodeType type, Node* pLeaf) {
+   Node curr;
+
+   assert(c != NULL);
+   assert(pLeaf != NULL);
+
+   curr = FT_traversePath(c, start);
+   if(curr == NULL) {
+      if(root != NULL || FT_cursorAtEnd(c))
+         return CONFLICTING_PATH;
    }
+   else if(FT_cursorAtEnd(c))
+      return ALREADY_IN_TREE;
+   else if(Node_getType(curr) == FILE_S)
+      return NOT_A_DIRECTORY;
+
+   return FT_insertRestOfPath(c, curr, type, pLeaf);
 }
 
 /*
-  Removes the directory hierarchy rooted at path starting from Node
-  curr. If curr is the data structure's root, root becomes NULL.
+   Frees the DirSlot with index slot, invalidating every handle that
+   refers to it, and detaches it from its directory.
+*/
+static void FT_freeDirSlot(size_t slot) {
+   struct DirSlot* ds;
 
-  Returns NO_SUCH_PATH if curr is not the Node for path,
-  and SUCCESS otherwise.
- */
-static int FT_rmPathAt(char* path, Node curr) {
+   assert(dirSlots != NULL);
+
+   ds = DirSlotArray_get(dirSlots, slot);
+   assert(ds->dir != NULL);
+
+   Node_setHandleID(ds->dir, 0);
+   ds->dir = NULL;
+   ds->refs = 0;
+   openDirs--;
+}
+
+/*
+   Invalidates every directory handle open on curr or any directory
+   beneath it.
+*/
+static void FT_closeDirsIn(Node curr) {
+   size_t c;
+
+   assert(curr != NULL);
+
+   if(Node_getType(curr) != DIRECTORY)
+      return;
+   if(Node_getHandleID(curr) != 0)
+      FT_freeDirSlot(Node_getHandleID(curr) - 1);
+   for(c = 0; c < Node_getNumChildren(curr) && openDirs > 0; c++)
+      FT_closeDirsIn(Node_getChild(curr, c));
+}
 
+/*
+  Removes the hierarchy rooted at Node curr, including curr itself,
+  invalidating any directory handles open within it.
+  If curr is the data structure's root, root becomes NULL.
+ */
+static void FT_rmNode(Node curr) {
    Node parent;
 
-   assert(path != NULL);
    assert(curr != NULL);
 
+   if(openDirs > 0)
+      FT_closeDirsIn(curr);
+
    parent = Node_getParent(curr);
+   if(parent == NULL)
+      root = NULL;
+   else
+      (void) Node_unlinkChild(parent, curr);
 
-   if(!strcmp(path,Node_getPath(curr))) {
-      if(parent == NULL)
-         root = NULL;
-      else
-         Node_unlinkChild(parent, curr);
+   FT_removePathFrom(curr);
+}
+
+/*
+   Returns the directory that handle h refers to, or NULL if h is not
+   a currently valid handle.
+*/
+static Node FT_handleDir(FT_DirHandle h) {
+   struct DirSlot* ds;
 
-      FT_removePathFrom(curr);
+   if(dirSlots == NULL || h.slot >= DirSlotArray_getLength(dirSlots))
+      return NULL;
 
-      return SUCCESS;
-   }
-   else
-      return NO_SUCH_PATH;
+   ds = DirSlotArray_get(dirSlots, h.slot);
+   if(ds->dir == NULL || ds->generation != h.generation)
+      return NULL;
+   return ds->dir;
+}
+
+/* An array of paths, for FT_toString */
+DEFINE_DYNARRAY(PathArray, const char*);
+
+/*
+   Performs a pre-order traversal of the tree rooted at n,
+   inserting each payload to PathArray_T d beginning at index i.
+   Returns the next unused index in d after the insertion(s).
+*/
+static size_t FT_preOrderTraversal(Node n, PathArray_T d, size_t i) {
+   size_t c;
+
+   assert(d != NULL);
+
+   if(n != NULL) {
+      (void) PathArray_set(d, i, Node_getPath(n));
+      i++;
+      for(c = 0; c < Node_getNumChildren(n); c++)
+         i = FT_preOrderTraversal(Node_getChild(n, c), d, i);
+   }
+   return i;
+}
+
+/*
+   Alternate version of strlen that uses pAcc as an in-out parameter
+   to accumulate a string length, rather than returning the length of
+   str, and also always adds one more in addition to str's length.
+*/
+static void FT_strlenAccumulate(const char* str, size_t* pAcc) {
+   assert(pAcc != NULL);
+
+   if(str != NULL)
+      *pAcc += (strlen(str) + 1);
+}
+
+/*
+   Alternate version of strcat that inverts the typical argument
+   order, appending str onto acc, and also always adds a newline at
+   the end of the concatenated string.
+*/
+static void FT_strcatAccumulate(const char* str, char* acc) {
+   assert(acc != NULL);
+
+   if(str != NULL)
+      strcat(acc, str); strcat(acc, "\n");
+}
+
+/* Apply FT_strlenAccumulate and FT_strcatAccumulate to a PathArray */
+DEFINE_DYNARRAY_MAP(PathArray, PathArray_strlenAccumulate, const char*,
+                    size_t*, FT_strlenAccumulate);
+DEFINE_DYNARRAY_MAP(PathArray, PathArray_strcatAccumulate, const char*,
+                    char*, FT_strcatAccumulate);
+
+/*
+   The FT_insertDir operation on the path under cursor *c.
+*/
+static int FT_insertDirFrom(struct PathCursor* c) {
+
+   Node new;
+   int result;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized || frozen != NULL)
+      return INITIALIZATION_ERROR;
+   result = FT_insertPath(c, NULL, DIRECTORY, &new);
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   return result;
+}
+
+/*
+   The FT_containsDir operation on the path under cursor *c.
+*/
+static boolean FT_containsDirFrom(struct PathCursor* c) {
+   Node curr;
+   size_t index;
+   boolean result;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized)
+      return FALSE;
+
+   if(frozen != NULL)
+      return (boolean) (Frozen_find(frozen, FT_cursorString(c), &index) &&
+                        Frozen_getType(frozen, index) == DIRECTORY);
+
+   curr = FT_findNode(c, NULL);
+
+   if(curr == NULL || Node_getType(curr) == FILE_S)
+      result = FALSE;
+   else
+      result = TRUE;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   return result;
+}
+
+/*
+   The FT_rmDir operation on the path under cursor *c.
+*/
+static int FT_rmDirFrom(struct PathCursor* c) {
+   Node curr;
+   int result;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized || frozen != NULL)
+      return INITIALIZATION_ERROR;
+
+   curr = FT_findNode(c, NULL);
+   if(curr == NULL)
+      result =  NO_SUCH_PATH;
+   else if (Node_getType(curr) == DIRECTORY) {
+      FT_rmNode(curr);
+      result = SUCCESS;
+   }
+   else
+      result = NOT_A_DIRECTORY;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   return result;
+}
+
+/*
+   The FT_insertFile operation on the path under cursor *c.
+*/
+static int FT_insertFileFrom(struct PathCursor* c, void *contents,
+                             size_t length) {
+
+   Node new;
+   int result;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized || frozen != NULL)
+      return INITIALIZATION_ERROR;
+   result = FT_insertPath(c, NULL, FILE_S, &new);
+
+   if( result == SUCCESS )
+      FT_setContents(new, contents, length);
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   return result;
+}
+
+/*
+   The FT_containsFile operation on the path under cursor *c.
+*/
+static boolean FT_containsFileFrom(struct PathCursor* c) {
+   Node curr;
+   size_t index;
+   boolean result;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized)
+      return FALSE;
+
+   if(frozen != NULL)
+      return (boolean) (Frozen_find(frozen, FT_cursorString(c), &index) &&
+                        Frozen_getType(frozen, index) == FILE_S);
+
+   curr = FT_findNode(c, NULL);
+
+   if(curr == NULL || Node_getType(curr) == DIRECTORY)
+      result = FALSE;
+   else
+      result = TRUE;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   return result;
+}
+
+/*
+   The FT_rmFile operation on the path under cursor *c.
+*/
+static int FT_rmFileFrom(struct PathCursor* c) {
+   Node curr;
+   int result;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized || frozen != NULL)
+      return INITIALIZATION_ERROR;
+
+   curr = FT_findNode(c, NULL);
+   if(curr == NULL)
+      result =  NO_SUCH_PATH;
+   else if( Node_getType(curr) == FILE_S) {
+      FT_rmNode(curr);
+      result = SUCCESS;
+   }
+   else
+      result = NOT_A_FILE;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   return result;
+}
+
+/*
+   The FT_getFileContents operation on the path under cursor *c.
+*/
+static void *FT_getFileContentsFrom(struct PathCursor* c){
+   Node curr;
+   size_t index;
+   void* result;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized)
+      return NULL;
+
+   if(frozen != NULL) {
+      if(!Frozen_find(frozen, FT_cursorString(c), &index) ||
+         Frozen_getType(frozen, index) == DIRECTORY)
+         return NULL;
+      return Frozen_getFileContents(frozen, index);
+   }
+
+   curr = FT_findNode(c, NULL);
+   if(curr == NULL || Node_getType(curr) == DIRECTORY)
+      result =  NULL;
+   else
+      result = Node_getFileContents(curr);
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   return result;
+}
+
+/*
+   The FT_replaceFileContents operation on the path under cursor *c.
+*/
+static void *FT_replaceFileContentsFrom(struct PathCursor* c,
+                                        void *newContents,
+                                        size_t newLength){
+   Node curr;
+   void * result;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized || frozen != NULL)
+      return NULL;
+
+   curr = FT_findNode(c, NULL);
+   if(curr == NULL || Node_getType(curr) == DIRECTORY)
+      result =  NULL;
+   else{
+      result = Node_getFileContents(curr);
+      FT_setContents(curr, newContents, newLength);
+   }
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   return result;
+
+}
+
+/*
+   The FT_stat operation on the path under cursor *c.
+*/
+static int FT_statFrom(struct PathCursor* c, boolean* type,
+                       size_t* length){
+   Node curr;
+   size_t index;
+   int result;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   assert(length != NULL);
+
+   if(!isInitialized)
+      return INITIALIZATION_ERROR;
+
+   if(frozen != NULL) {
+      if(!Frozen_find(frozen, FT_cursorString(c), &index))
+         return NO_SUCH_PATH;
+      *type = (boolean)Frozen_getType(frozen, index);
+      if(*type == (boolean)FILE_S)
+         *length = Frozen_getFileLength(frozen, index);
+      return SUCCESS;
+   }
+
+   curr = FT_findNode(c, NULL);
+   if(curr == NULL)
+      result =  NO_SUCH_PATH;
+   else{
+      result = SUCCESS;
+      *type = (boolean)Node_getType(curr);
+      if(*type == (boolean)FILE_S) *length = Node_getFileLength(curr);
+   }
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   return result;
+}
+
+/*
+   Returns the time at which a public call starts, to be passed to
+   FT_traceCall when it ends, or 0 if not tracing.
+*/
+static unsigned long FT_traceStart(void) {
+   return (trace == NULL) ? 0 : Trace_now();
+}
+
+/*
+   Returns TRACE_HAS_CONTENTS if contents is non-NULL, else 0.
+*/
+static int FT_contentsFlag(const void* contents) {
+   return (contents == NULL) ? 0 : TRACE_HAS_CONTENTS;
+}
+
+/*
+   Writes a record of the operation op to the trace, as FT_traceCall
+   does, but taking duration ns.
+*/
+static void FT_traceWrite(int op, int flags, const char* path,
+                          const FT_DirHandle* pHandle, size_t length,
+                          int result, unsigned long start,
+                          unsigned long duration) {
+   struct TraceRecord r;
+
+   assert(trace != NULL);
+
+   r.iOp = op;
+   r.iFlags = flags;
+   r.iResult = result;
+   r.ulStart = start;
+   r.ulDuration = duration;
+   r.ulLength = length;
+   r.ulSlot = (pHandle == NULL) ? 0 : pHandle->slot;
+   r.ulGeneration = (pHandle == NULL) ? 0 : pHandle->generation;
+   r.pcPath = (path == NULL) ? "" : path;
+   (void) Trace_write(trace, &r);
+}
+
+/*
+   If tracing, records a call to the operation op, with the given
+   TRACE_* flags, path (or NULL) and handle (or NULL), that began at
+   time start and returned result. length is the contents length, for
+   FT_listAt, the number of children visited, and for a batch, the
+   number of TRACE_BATCH_ENTRY records to follow. Write errors are
+   reported by FT_stopTrace.
+*/
+static void FT_traceCall(int op, int flags, const char* path,
+                         const FT_DirHandle* pHandle, size_t length,
+                         int result, unsigned long start) {
+   if(trace == NULL)
+      return;
+   FT_traceWrite(op, flags, path, pHandle, length, result, start,
+                 Trace_now() - start);
+}
+
+/*
+   If tracing, records an entry of the batch whose record was just
+   written, which began at start: its path, whether it is a file, and
+   if so, its contents and their length.
+*/
+static void FT_traceEntry(const char* path, boolean isFile,
+                          const void* contents, size_t length,
+                          unsigned long start) {
+   if(trace == NULL)
+      return;
+   FT_traceWrite(TRACE_BATCH_ENTRY,
+                 isFile ? TRACE_IS_FILE | FT_contentsFlag(contents) : 0,
+                 path, NULL, isFile ? length : 0, 0, start, 0);
+}
+
+/* see ft.h for specification */
+boolean FT_startTrace(const char* filename) {
+   assert(filename != NULL);
+
+   if(trace != NULL)
+      return FALSE;
+   trace = Trace_create(filename);
+   return trace != NULL;
+}
+
+/* see ft.h for specification */
+boolean FT_stopTrace(void) {
+   boolean result;
+
+   if(trace == NULL)
+      return FALSE;
+   result = Trace_close(trace) ? TRUE : FALSE;
+   trace = NULL;
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_parsePath(const char* path, FT_Path* pPath,
+                 struct FT_PathComponent* components,
+                 size_t maxComponents) {
+   const char* p;
+   size_t n = 0;
+   size_t len;
+
+   assert(path != NULL);
+   assert(pPath != NULL);
+   assert(components != NULL || maxComponents == 0);
+
+   p = FT_skipSeparators(path);
+   while(*p != '\0') {
+      if(n == maxComponents)
+         return MEMORY_ERROR;
+      len = FT_componentLength(p);
+      components[n].offset = (size_t) (p - path);
+      components[n].length = len;
+      components[n].hash = Node_hashName(p, len);
+      n++;
+      p = FT_skipSeparators(p + len);
+   }
+
+   pPath->string = path;
+   pPath->numComponents = n;
+   pPath->components = components;
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_insertDir(char* path) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   int result;
+
+   assert(path != NULL);
+
+   FT_cursorFromString(&c, path);
+   result = FT_insertDirFrom(&c);
+   FT_traceCall(TRACE_INSERT_DIR, 0, path, NULL, 0, result, start);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_insertDirP(const FT_Path* path) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   int result;
+
+   assert(path != NULL);
+
+   FT_cursorFromPath(&c, path);
+   result = FT_insertDirFrom(&c);
+   FT_traceCall(TRACE_INSERT_DIR, TRACE_PARSED, path->string, NULL, 0,
+                result, start);
+   return result;
+}
+
+/* see ft.h for specification */
+boolean FT_containsDir(char* path) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   boolean result;
+
+   assert(path != NULL);
+
+   FT_cursorFromString(&c, path);
+   result = FT_containsDirFrom(&c);
+   FT_traceCall(TRACE_CONTAINS_DIR, 0, path, NULL, 0, result, start);
+   return result;
+}
+
+/* see ft.h for specification */
+boolean FT_containsDirP(const FT_Path* path) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   boolean result;
+
+   assert(path != NULL);
+
+   FT_cursorFromPath(&c, path);
+   result = FT_containsDirFrom(&c);
+   FT_traceCall(TRACE_CONTAINS_DIR, TRACE_PARSED, path->string, NULL, 0,
+                result, start);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_rmDir(char* path) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   int result;
+
+   assert(path != NULL);
+
+   FT_cursorFromString(&c, path);
+   result = FT_rmDirFrom(&c);
+   FT_traceCall(TRACE_RM_DIR, 0, path, NULL, 0, result, start);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_rmDirP(const FT_Path* path) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   int result;
+
+   assert(path != NULL);
+
+   FT_cursorFromPath(&c, path);
+   result = FT_rmDirFrom(&c);
+   FT_traceCall(TRACE_RM_DIR, TRACE_PARSED, path->string, NULL, 0,
+                result, start);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_insertFile(char* path, void *contents, size_t length) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   int result;
+
+   assert(path != NULL);
+
+   FT_cursorFromString(&c, path);
+   result = FT_insertFileFrom(&c, contents, length);
+   FT_traceCall(TRACE_INSERT_FILE,
+                FT_contentsFlag(contents),
+                path, NULL, length, result, start);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_insertFileP(const FT_Path* path, void *contents, size_t length) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   int result;
+
+   assert(path != NULL);
+
+   FT_cursorFromPath(&c, path);
+   result = FT_insertFileFrom(&c, contents, length);
+   FT_traceCall(TRACE_INSERT_FILE,
+                TRACE_PARSED | FT_contentsFlag(contents),
+                path->string, NULL, length, result, start);
+   return result;
+}
+
+/* see ft.h for specification */
+boolean FT_containsFile(char* path) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   boolean result;
+
+   assert(path != NULL);
+
+   FT_cursorFromString(&c, path);
+   result = FT_containsFileFrom(&c);
+   FT_traceCall(TRACE_CONTAINS_FILE, 0, path, NULL, 0, result, start);
+   return result;
+}
+
+/* see ft.h for specification */
+boolean FT_containsFileP(const FT_Path* path) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   boolean result;
+
+   assert(path != NULL);
+
+   FT_cursorFromPath(&c, path);
+   result = FT_containsFileFrom(&c);
+   FT_traceCall(TRACE_CONTAINS_FILE, TRACE_PARSED,
+                path->string, NULL, 0, result, start);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_rmFile(char* path) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   int result;
+
+   assert(path != NULL);
+
+   FT_cursorFromString(&c, path);
+   result = FT_rmFileFrom(&c);
+   FT_traceCall(TRACE_RM_FILE, 0, path, NULL, 0, result, start);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_rmFileP(const FT_Path* path) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   int result;
+
+   assert(path != NULL);
+
+   FT_cursorFromPath(&c, path);
+   result = FT_rmFileFrom(&c);
+   FT_traceCall(TRACE_RM_FILE, TRACE_PARSED, path->string, NULL, 0,
+                result, start);
+   return result;
+}
+
+/* see ft.h for specification */
+void *FT_getFileContents(char *path) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   void *result;
+
+   assert(path != NULL);
+
+   FT_cursorFromString(&c, path);
+   result = FT_getFileContentsFrom(&c);
+   FT_traceCall(TRACE_GET_CONTENTS, 0, path, NULL, 0,
+                result != NULL, start);
+   return result;
+}
+
+/* see ft.h for specification */
+void *FT_getFileContentsP(const FT_Path* path) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   void *result;
+
+   assert(path != NULL);
+
+   FT_cursorFromPath(&c, path);
+   result = FT_getFileContentsFrom(&c);
+   FT_traceCall(TRACE_GET_CONTENTS, TRACE_PARSED, path->string, NULL, 0,
+                result != NULL, start);
+   return result;
+}
+
+/* see ft.h for specification */
+void *FT_replaceFileContents(char *path, void *newContents,
+                             size_t newLength) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   void *result;
+
+   assert(path != NULL);
+
+   FT_cursorFromString(&c, path);
+   result = FT_replaceFileContentsFrom(&c, newContents, newLength);
+   FT_traceCall(TRACE_REPLACE_CONTENTS,
+                FT_contentsFlag(newContents),
+                path, NULL, newLength, result != NULL, start);
+   return result;
+}
+
+/* see ft.h for specification */
+void *FT_replaceFileContentsP(const FT_Path* path, void *newContents,
+                              size_t newLength) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   void *result;
+
+   assert(path != NULL);
+
+   FT_cursorFromPath(&c, path);
+   result = FT_replaceFileContentsFrom(&c, newContents, newLength);
+   FT_traceCall(TRACE_REPLACE_CONTENTS,
+                TRACE_PARSED | FT_contentsFlag(newContents),
+                path->string, NULL, newLength, result != NULL, start);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_stat(char *path, boolean* type, size_t* length) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   int result;
+
+   assert(path != NULL);
+
+   FT_cursorFromString(&c, path);
+   result = FT_statFrom(&c, type, length);
+   FT_traceCall(TRACE_STAT, 0, path, NULL, 0, result, start);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_statP(const FT_Path* path, boolean* type, size_t* length) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   int result;
+
+   assert(path != NULL);
+
+   FT_cursorFromPath(&c, path);
+   result = FT_statFrom(&c, type, length);
+   FT_traceCall(TRACE_STAT, TRACE_PARSED, path->string, NULL, 0,
+                result, start);
+   return result;
+}
+
+/*
+   Does FT_openDir without tracing it.
+*/
+static int FT_openDirUntraced(char* path, FT_DirHandle* pHandle) {
+   struct PathCursor c;
+   Node dir;
+   struct DirSlot* ds = NULL;
+   size_t slot;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   assert(path != NULL);
+   assert(pHandle != NULL);
+
+   if(!isInitialized || frozen != NULL)
+      return INITIALIZATION_ERROR;
+
+   FT_cursorFromString(&c, path);
+   dir = FT_findNode(&c, NULL);
+   if(dir == NULL)
+      return NO_SUCH_PATH;
+   if(Node_getType(dir) != DIRECTORY)
+      return NOT_A_DIRECTORY;
+
+   /* share the directory's existing slot, if it has one */
+   if(Node_getHandleID(dir) != 0) {
+      slot = Node_getHandleID(dir) - 1;
+      ds = DirSlotArray_get(dirSlots, slot);
+      ds->refs++;
+      pHandle->slot = slot;
+      pHandle->generation = ds->generation;
+      return SUCCESS;
+   }
+
+   if(dirSlots == NULL) {
+      dirSlots = DirSlotArray_new(0);
+      if(dirSlots == NULL)
+         return MEMORY_ERROR;
+   }
+
+   /* handles are opened rarely relative to the operations on them,
+      so a linear scan for a free slot is cheap enough */
+   for(slot = 0; slot < DirSlotArray_getLength(dirSlots); slot++) {
+      ds = DirSlotArray_get(dirSlots, slot);
+      if(ds->dir == NULL)
+         break;
+   }
+   if(slot == DirSlotArray_getLength(dirSlots)) {
+      ds = malloc(sizeof(struct DirSlot));
+      if(ds == NULL)
+         return MEMORY_ERROR;
+      STATS_ADD(mallocs, 1);
+      if(!DirSlotArray_add(dirSlots, ds)) {
+         free(ds);
+         STATS_ADD(frees, 1);
+         return MEMORY_ERROR;
+      }
+   }
+
+   ds->dir = dir;
+   ds->generation = ++lastGeneration;
+   ds->refs = 1;
+   openDirs++;
+   Node_setHandleID(dir, slot + 1);
+
+   pHandle->slot = slot;
+   pHandle->generation = ds->generation;
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_openDir(char* path, FT_DirHandle* pHandle) {
+   unsigned long start = FT_traceStart();
+   int result;
+
+   result = FT_openDirUntraced(path, pHandle);
+   FT_traceCall(TRACE_OPEN_DIR, 0, path,
+                result == SUCCESS ? pHandle : NULL, 0, result, start);
+   return result;
+}
+
+/*
+   Does FT_closeDir without tracing it.
+*/
+static int FT_closeDirUntraced(FT_DirHandle h) {
+   struct DirSlot* ds;
+
+   if(!isInitialized)
+      return INITIALIZATION_ERROR;
+   if(FT_handleDir(h) == NULL)
+      return NO_SUCH_PATH;
+
+   ds = DirSlotArray_get(dirSlots, h.slot);
+   if(--ds->refs == 0)
+      FT_freeDirSlot(h.slot);
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_closeDir(FT_DirHandle h) {
+   unsigned long start = FT_traceStart();
+   int result;
+
+   result = FT_closeDirUntraced(h);
+   FT_traceCall(TRACE_CLOSE_DIR, 0, NULL, &h, 0, result, start);
+   return result;
+}
+
+/*
+   Does FT_insertDirAt without tracing it.
+*/
+static int FT_insertDirAtUntraced(FT_DirHandle h, char* path) {
+   struct PathCursor c;
+   Node dir;
+   Node new;
+   int result;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   assert(path != NULL);
+
+   if(!isInitialized)
+      return INITIALIZATION_ERROR;
+   dir = FT_handleDir(h);
+   if(dir == NULL)
+      return NO_SUCH_PATH;
+
+   FT_cursorFromString(&c, path);
+   result = FT_insertPath(&c, dir, DIRECTORY, &new);
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_insertDirAt(FT_DirHandle h, char* path) {
+   unsigned long start = FT_traceStart();
+   int result;
+
+   result = FT_insertDirAtUntraced(h, path);
+   FT_traceCall(TRACE_INSERT_DIR_AT, 0, path, &h, 0, result, start);
+   return result;
+}
+
+/*
+   Does FT_insertFileAt without tracing it.
+*/
+static int FT_insertFileAtUntraced(FT_DirHandle h, char* path,
+                                   void *contents, size_t length) {
+   struct PathCursor c;
+   Node dir;
+   Node new;
+   int result;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   assert(path != NULL);
+
+   if(!isInitialized)
+      return INITIALIZATION_ERROR;
+   dir = FT_handleDir(h);
+   if(dir == NULL)
+      return NO_SUCH_PATH;
+
+   FT_cursorFromString(&c, path);
+   result = FT_insertPath(&c, dir, FILE_S, &new);
+   if(result == SUCCESS)
+      FT_setContents(new, contents, length);
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_insertFileAt(FT_DirHandle h, char* path, void *contents,
+                    size_t length) {
+   unsigned long start = FT_traceStart();
+   int result;
+
+   result = FT_insertFileAtUntraced(h, path, contents, length);
+   FT_traceCall(TRACE_INSERT_FILE_AT, FT_contentsFlag(contents), path,
+                &h, length, result, start);
+   return result;
+}
+
+/*
+   Does FT_statAt without tracing it.
+*/
+static int FT_statAtUntraced(FT_DirHandle h, char* path, boolean* type,
+                             size_t* length) {
+   struct PathCursor c;
+   Node dir;
+   Node curr;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   assert(path != NULL);
+   assert(type != NULL);
+   assert(length != NULL);
+
+   if(!isInitialized)
+      return INITIALIZATION_ERROR;
+   dir = FT_handleDir(h);
+   if(dir == NULL)
+      return NO_SUCH_PATH;
+
+   FT_cursorFromString(&c, path);
+   curr = FT_findNode(&c, dir);
+   if(curr == NULL)
+      return NO_SUCH_PATH;
+
+   *type = (boolean)Node_getType(curr);
+   if(*type == (boolean)FILE_S) *length = Node_getFileLength(curr);
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_statAt(FT_DirHandle h, char* path, boolean* type,
+              size_t* length) {
+   unsigned long start = FT_traceStart();
+   int result;
+
+   result = FT_statAtUntraced(h, path, type, length);
+   FT_traceCall(TRACE_STAT_AT, 0, path, &h, 0, result, start);
+   return result;
+}
+
+/*
+   Does FT_rmAt without tracing it.
+*/
+static int FT_rmAtUntraced(FT_DirHandle h, char* path) {
+   struct PathCursor c;
+   Node dir;
+   Node curr;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   assert(path != NULL);
+
+   if(!isInitialized)
+      return INITIALIZATION_ERROR;
+   dir = FT_handleDir(h);
+   if(dir == NULL)
+      return NO_SUCH_PATH;
+
+   FT_cursorFromString(&c, path);
+   curr = FT_findNode(&c, dir);
+   if(curr == NULL)
+      return NO_SUCH_PATH;
+
+   FT_rmNode(curr);
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_rmAt(FT_DirHandle h, char* path) {
+   unsigned long start = FT_traceStart();
+   int result;
+
+   result = FT_rmAtUntraced(h, path);
+   FT_traceCall(TRACE_RM_AT, 0, path, &h, 0, result, start);
+   return result;
+}
+
+/*
+   Does FT_listAt without tracing it, storing in *pVisited the number
+   of calls made to pfVisit.
+*/
+static int FT_listAtUntraced(FT_DirHandle h, char* path,
+                             FT_ListCallback pfVisit, void* pvExtra,
+                             size_t* pVisited) {
+   struct PathCursor c;
+   Node dir;
+   Node child;
+   size_t i;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   assert(path != NULL);
+   assert(pfVisit != NULL);
+   assert(pVisited != NULL);
+
+   *pVisited = 0;
+   if(!isInitialized)
+      return INITIALIZATION_ERROR;
+   dir = FT_handleDir(h);
+   if(dir == NULL)
+      return NO_SUCH_PATH;
+
+   FT_cursorFromString(&c, path);
+   dir = FT_findNode(&c, dir);
+   if(dir == NULL)
+      return NO_SUCH_PATH;
+   if(Node_getType(dir) != DIRECTORY)
+      return NOT_A_DIRECTORY;
+
+   for(i = 0; i < Node_getNumChildren(dir); i++) {
+      child = Node_getChild(dir, i);
+      (*pVisited)++;
+      if(Node_getType(child) == FILE_S) {
+         if(!(*pfVisit)(Node_getPath(child), TRUE,
+                        Node_getFileLength(child), pvExtra))
+            break;
+      }
+      else if(!(*pfVisit)(Node_getPath(child), FALSE, 0, pvExtra))
+         break;
+   }
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_listAt(FT_DirHandle h, char* path, FT_ListCallback pfVisit,
+              void* pvExtra) {
+   unsigned long start = FT_traceStart();
+   size_t visited;
+   int result;
+
+   result = FT_listAtUntraced(h, path, pfVisit, pvExtra, &visited);
+   FT_traceCall(TRACE_LIST_AT, 0, path, &h, visited, result, start);
+   return result;
+}
+
+/*
+   Stores in *pName and *pLen the last component of path, or an empty
+   one if path has none.
+*/
+static void FT_lastComponent(const char* path, const char** pName,
+                             size_t* pLen) {
+   assert(path != NULL);
+   assert(pName != NULL);
+   assert(pLen != NULL);
+
+   path = FT_skipSeparators(path);
+   *pName = path;
+   *pLen = 0;
+   while(*path != '\0') {
+      *pName = path;
+      *pLen = FT_componentLength(path);
+      path = FT_skipSeparators(path + *pLen);
+   }
+}
+
+/*
+   Calls pfVisit with pvExtra on n, a file or directory, returning
+   what it returns.
+*/
+static boolean FT_visitNode(Node n, FT_ListCallback pfVisit,
+                            void* pvExtra) {
+   assert(n != NULL);
+   assert(pfVisit != NULL);
+
+   if(Node_getType(n) == FILE_S)
+      return (*pfVisit)(Node_getPath(n), TRUE, Node_getFileLength(n),
+                        pvExtra);
+   return (*pfVisit)(Node_getPath(n), FALSE, 0, pvExtra);
+}
+
+/*
+   One '/'-separated component of a glob pattern: its characters, how
+   many of them come before the first '*', '?' or '[', and whether it
+   is "**".
+*/
+struct GlobComponent {
+   const char* chars;
+   size_t length;
+   size_t literal;
+   boolean any;
+};
+
+/* The sets of pattern positions reached along a glob's path */
+DEFINE_DYNARRAY(StateArray, size_t);
+
+/*
+   A Glob is the state of FT_glob: the pattern's components, the
+   positions in it reached so far, and where to report matches.
+*/
+struct Glob {
+   struct GlobComponent* comps;
+   size_t numComps;
+   /* for each node on the path being searched, the positions in
+      the pattern its children are to be matched against, position
+      numComps meaning that the whole pattern has matched */
+   StateArray_T states;
+   FT_ListCallback pfVisit;
+   void* pvExtra;
+   /* whether pfVisit has asked to stop */
+   boolean stopped;
+};
+
+/*
+   Returns TRUE if the bracket expression that begins at *pPattern,
+   just after its '[', and ends before end contains c, and advances
+   *pPattern past its ']'. If it has no ']', returns whether c is
+   '[', leaving *pPattern as it was, since the '[' is then literal.
+*/
+static boolean FT_globBracket(const char** pPattern, const char* end,
+                              unsigned char c) {
+   const char* p;
+   boolean negate = FALSE;
+   boolean found = FALSE;
+   unsigned char lo;
+   unsigned char hi;
+
+   assert(pPattern != NULL);
+   assert(end != NULL);
+
+   p = *pPattern;
+   if(p < end && (*p == '!' || *p == '^')) {
+      negate = TRUE;
+      p++;
+   }
+   /* a ']' first is literal */
+   do {
+      if(p == end)
+         return (boolean) (c == '[');
+      lo = (unsigned char) *p++;
+      hi = lo;
+      if(p + 1 < end && *p == '-' && p[1] != ']') {
+         hi = (unsigned char) p[1];
+         p += 2;
+      }
+      if(lo <= c && c <= hi)
+         found = TRUE;
+   } while(p == end || *p != ']');
+
+   *pPattern = p + 1;
+   return (boolean) (found != negate);
+}
+
+/*
+   Returns TRUE if the len characters of name match component comp,
+   in which '*' matches any run of characters, '?' any one character,
+   and '[...]' any one character in (or with '!' or '^', not in) the
+   brackets, and any other character itself.
+*/
+static boolean FT_globMatch(const struct GlobComponent* comp,
+                            const char* name, size_t len) {
+   const char* p;
+   const char* pEnd;
+   const char* n;
+   const char* nEnd;
+   /* where to resume after the last '*', if the match fails */
+   const char* pStar = NULL;
+   const char* nStar = NULL;
+
+   assert(comp != NULL);
+   assert(name != NULL);
+
+   p = comp->chars;
+   pEnd = p + comp->length;
+   n = name;
+   nEnd = name + len;
+   for(;;) {
+      if(p < pEnd && *p == '*') {
+         pStar = ++p;
+         nStar = n;
+         continue;
+      }
+      if(n == nEnd) {
+         if(p == pEnd)
+            return TRUE;
+      }
+      else if(p < pEnd && *p == '?') {
+         p++;
+         n++;
+         continue;
+      }
+      else if(p < pEnd && *p == '[') {
+         p++;
+         if(FT_globBracket(&p, pEnd, (unsigned char) *n)) {
+            n++;
+            continue;
+         }
+      }
+      else if(p < pEnd && *p == *n) {
+         p++;
+         n++;
+         continue;
+      }
+
+      /* a mismatch: let the last '*' take one more character */
+      if(pStar == NULL || nStar == nEnd)
+         return FALSE;
+      p = pStar;
+      n = ++nStar;
+   }
+}
+
+/*
+   Adds position state, and if its component is "**", which may match
+   no components at all, those after it, to the set of positions of
+   glob *g that begins at index first of its states, if not there.
+   Returns TRUE, or FALSE if there is an allocation error.
+*/
+static boolean FT_globAdd(struct Glob* g, size_t first, size_t state) {
+   size_t i;
+
+   assert(g != NULL);
+
+   for(;;) {
+      for(i = first; i < StateArray_getLength(g->states); i++)
+         if(StateArray_get(g->states, i) == state)
+            return TRUE;
+      if(!StateArray_add(g->states, state))
+         return FALSE;
+      if(state == g->numComps || !g->comps[state].any)
+         return TRUE;
+      state++;
+   }
+}
+
+/* declared here, as FT_globChild and FT_globFrom call each other */
+static int FT_globFrom(struct Glob* g, Node dir, size_t first,
+                       size_t num);
+
+/*
+   Matches node n, a child of the node whose positions are the num
+   states of glob *g from index first, against them; reports n if it
+   matches the whole pattern, and if it is a directory that may have
+   descendants that do, searches them. Returns SUCCESS, or
+   MEMORY_ERROR if there is an allocation error.
+*/
+static int FT_globChild(struct Glob* g, Node n, size_t first,
+                        size_t num) {
+   const char* name;
+   size_t len;
+   size_t next;
+   size_t state;
+   size_t i;
+   boolean matched = FALSE;
+   boolean deeper = FALSE;
+   int result = SUCCESS;
+
+   assert(g != NULL);
+   assert(n != NULL);
+
+   name = Node_getPath(n);
+   len = Node_getPathLength(n);
+   if(Node_getParent(n) != NULL) {
+      name += Node_getPathLength(Node_getParent(n)) + 1;
+      len -= Node_getPathLength(Node_getParent(n)) + 1;
+   }
+   next = StateArray_getLength(g->states);
+   for(i = first; i < first + num && result == SUCCESS; i++) {
+      state = StateArray_get(g->states, i);
+      if(state == g->numComps)
+         continue;
+      if(g->comps[state].any) {
+         if(!FT_globAdd(g, next, state))
+            result = MEMORY_ERROR;
+      }
+      else if(FT_globMatch(&g->comps[state], name, len) &&
+              !FT_globAdd(g, next, state + 1))
+         result = MEMORY_ERROR;
+   }
+
+   for(i = next; i < StateArray_getLength(g->states); i++) {
+      if(StateArray_get(g->states, i) == g->numComps)
+         matched = TRUE;
+      else
+         deeper = TRUE;
+   }
+   if(result == SUCCESS && matched)
+      g->stopped = !FT_visitNode(n, g->pfVisit, g->pvExtra);
+   if(result == SUCCESS && !g->stopped && deeper &&
+      Node_getType(n) == DIRECTORY)
+      result = FT_globFrom(g, n, next,
+                           StateArray_getLength(g->states) - next);
+
+   StateArray_removeRange(g->states, next,
+                          StateArray_getLength(g->states) - next);
+   return result;
+}
+
+/*
+   Matches each child of type type of directory dir whose name begins
+   with the literal characters of the single position of glob *g at
+   index first of its states, as FT_globChild does. Those children sit
+   together in dir's sorted children, from where a child with just
+   those characters as its name would be. Returns SUCCESS, or
+   MEMORY_ERROR if there is an allocation error.
+*/
+static int FT_globRange(struct Glob* g, Node dir, nodeType type,
+                        size_t first) {
+   const struct GlobComponent* comp;
+   size_t numChildren;
+   size_t childID;
+   size_t dirLen;
+   boolean found;
+   Node child;
+   int result = SUCCESS;
+
+   assert(g != NULL);
+   assert(dir != NULL);
+
+   comp = &g->comps[StateArray_get(g->states, first)];
+   found = Node_findChild(dir, comp->chars, comp->literal, type,
+                          &childID);
+   if(comp->literal == comp->length)
+      return found ? FT_globChild(g, Node_getChild(dir, childID), first,
+                                  1) : SUCCESS;
+
+   numChildren = Node_getNumChildren(dir);
+   dirLen = Node_getPathLength(dir);
+   for(; childID < numChildren && result == SUCCESS && !g->stopped;
+       childID++) {
+      child = Node_getChild(dir, childID);
+      STATS_COMPARE(Node_getPath(child) + dirLen + 1, comp->chars,
+                    comp->literal);
+      if(Node_getType(child) != type ||
+         strncmp(Node_getPath(child) + dirLen + 1, comp->chars,
+                 comp->literal) != 0)
+         break;
+      result = FT_globChild(g, child, first, 1);
+   }
+   return result;
+}
+
+/*
+   Matches each child of directory dir against the num positions of
+   glob *g from index first of its states, as FT_globChild does. When
+   they are a single component that begins with literal characters,
+   only the children that begin with them are looked at, and only the
+   directories among them if the pattern goes on below them. Returns
+   SUCCESS, or MEMORY_ERROR if there is an allocation error.
+*/
+static int FT_globFrom(struct Glob* g, Node dir, size_t first,
+                       size_t num) {
+   const struct GlobComponent* comp;
+   size_t numChildren;
+   size_t childID;
+   size_t rest;
+   int result = SUCCESS;
+
+   assert(g != NULL);
+   assert(dir != NULL);
+
+   comp = &g->comps[StateArray_get(g->states, first)];
+   if(num != 1 || comp->any || comp->literal == 0) {
+      numChildren = Node_getNumChildren(dir);
+      for(childID = 0; childID < numChildren && result == SUCCESS &&
+             !g->stopped; childID++)
+         result = FT_globChild(g, Node_getChild(dir, childID), first,
+                               num);
+      return result;
+   }
+
+   /* files can only match if nothing but "**" follows */
+   for(rest = (size_t) (comp - g->comps) + 1;
+       rest < g->numComps && g->comps[rest].any; rest++)
+      ;
+   if(rest == g->numComps)
+      result = FT_globRange(g, dir, FILE_S, first);
+   if(result == SUCCESS && !g->stopped)
+      result = FT_globRange(g, dir, DIRECTORY, first);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_glob(const char* pattern, FT_ListCallback pfVisit,
+            void* pvExtra) {
+   struct Glob g;
+   const char* p;
+   size_t len;
+   size_t i;
+   int result = SUCCESS;
+
+   assert(pattern != NULL);
+   assert(pfVisit != NULL);
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized || frozen != NULL)
+      return INITIALIZATION_ERROR;
+
+   /* split the pattern into its components */
+   g.numComps = 0;
+   for(p = FT_skipSeparators(pattern); *p != '\0';
+       p = FT_skipSeparators(p + FT_componentLength(p)))
+      g.numComps++;
+   if(g.numComps == 0 || root == NULL)
+      return SUCCESS;
+   g.comps = malloc(g.numComps * sizeof(struct GlobComponent));
+   g.states = StateArray_new(0);
+   if(g.comps == NULL || g.states == NULL) {
+      free(g.comps);
+      if(g.states != NULL)
+         StateArray_free(g.states);
+      return MEMORY_ERROR;
+   }
+   STATS_ADD(mallocs, 1);
+   i = 0;
+   for(p = FT_skipSeparators(pattern); *p != '\0';
+       p = FT_skipSeparators(p + len)) {
+      len = FT_componentLength(p);
+      g.comps[i].chars = p;
+      g.comps[i].length = len;
+      g.comps[i].literal = strcspn(p, "*?[");
+      if(g.comps[i].literal > len)
+         g.comps[i].literal = len;
+      g.comps[i].any = (boolean) (len == 2 && p[0] == '*' &&
+                                  p[1] == '*');
+      i++;
+   }
+   g.pfVisit = pfVisit;
+   g.pvExtra = pvExtra;
+   g.stopped = FALSE;
+
+   /* the root is matched as the only child of a directory above it */
+   if(!FT_globAdd(&g, 0, 0))
+      result = MEMORY_ERROR;
+   else
+      result = FT_globChild(&g, root, 0, StateArray_getLength(g.states));
+
+   free(g.comps);
+   STATS_ADD(frees, 1);
+   StateArray_free(g.states);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_listDir(char* path, const char* afterName, size_t limit,
+               FT_ListCallback pfVisit, void* pvExtra) {
+   struct PathCursor c;
+   const char* name;
+   size_t len;
+   size_t childID = 0;
+   size_t numChildren;
+   Node dir;
+
+   assert(path != NULL);
+   assert(pfVisit != NULL);
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized || frozen != NULL)
+      return INITIALIZATION_ERROR;
+   FT_cursorFromString(&c, path);
+   dir = FT_findNode(&c, NULL);
+   if(dir == NULL)
+      return NO_SUCH_PATH;
+   if(Node_getType(dir) != DIRECTORY)
+      return NOT_A_DIRECTORY;
+
+   /* seek just past afterName: a directory's name if there is such a
+      directory or a '/' follows it, and otherwise a file's */
+   if(afterName != NULL) {
+      FT_lastComponent(afterName, &name, &len);
+      if(Node_findChild(dir, name, len, DIRECTORY, &childID))
+         childID++;
+      else if(name[len] == '\0' &&
+              Node_findChild(dir, name, len, FILE_S, &childID))
+         childID++;
+   }
+
+   numChildren = Node_getNumChildren(dir);
+   for(; childID < numChildren; childID++) {
+      if(!FT_visitNode(Node_getChild(dir, childID), pfVisit, pvExtra))
+         break;
+      if(limit != 0 && --limit == 0)
+         break;
+   }
+   return SUCCESS;
+}
+
+/*
+   Returns <0, 0, or >0 as the len1 characters of name1 sort before,
+   the same as, or after the len2 characters of name2 among siblings.
+*/
+static int FT_compareNames(const char* name1, size_t len1,
+                           const char* name2, size_t len2) {
+   int result;
+
+   assert(name1 != NULL);
+   assert(name2 != NULL);
+
+   STATS_COMPARE(name1, name2, (len1 < len2) ? len1 : len2);
+   result = strncmp(name1, name2, (len1 < len2) ? len1 : len2);
+   if(result == 0 && len1 != len2)
+      result = (len1 < len2) ? -1 : 1;
+   return result;
+}
+
+/*
+   Returns <0, 0, or >0 as path1 comes before, is, or comes after
+   path2 when they are compared a component at a time by
+   FT_compareNames, a path coming just before those that extend it.
+*/
+static int FT_comparePaths(const char* path1, const char* path2) {
+   size_t len1;
+   size_t len2;
+   int result;
+
+   assert(path1 != NULL);
+   assert(path2 != NULL);
+
+   path1 = FT_skipSeparators(path1);
+   path2 = FT_skipSeparators(path2);
+   while(*path1 != '\0' && *path2 != '\0') {
+      len1 = FT_componentLength(path1);
+      len2 = FT_componentLength(path2);
+      result = FT_compareNames(path1, len1, path2, len2);
+      if(result != 0)
+         return result;
+      path1 = FT_skipSeparators(path1 + len1);
+      path2 = FT_skipSeparators(path2 + len2);
+   }
+   if(*path1 == *path2)
+      return 0;
+   return (*path1 == '\0') ? -1 : 1;
+}
+
+/*
+   A RangeScan is the state of FT_scanRange: where it ends, where to
+   report what it finds, and whether it has ended.
+*/
+struct RangeScan {
+   const char* toPath;
+   FT_ListCallback pfVisit;
+   void* pvExtra;
+   boolean stopped;
+};
+
+/*
+   Reports n and then its descendants, in the order of
+   FT_comparePaths, to *s until it stops: when its callback asks to,
+   or at the first node that is not before its toPath. If from is not
+   NULL, the path under cursor *from, whose components up to n's name
+   have been consumed, is where to begin: n itself is skipped unless
+   *from is at its end, and so are n's children that sort before the
+   next component, the child with that name being entered in the same
+   way.
+*/
+static void FT_scanFrom(struct RangeScan* s, Node n,
+                        struct PathCursor* from) {
+   const char* name = NULL;
+   size_t len = 0;
+   size_t fileID = 0;
+   size_t dirID;
+   size_t numFiles;
+   size_t numChildren;
+   size_t dirLen;
+   Node file;
+   Node sub;
+   Node child;
+
+   assert(s != NULL);
+   assert(n != NULL);
+
+   if(from == NULL || FT_cursorAtEnd(from)) {
+      if(s->toPath != NULL &&
+         FT_comparePaths(Node_getPath(n), s->toPath) >= 0) {
+         s->stopped = TRUE;
+         return;
+      }
+      s->stopped = !FT_visitNode(n, s->pfVisit, s->pvExtra);
+      from = NULL;
+   }
+   if(s->stopped || Node_getType(n) != DIRECTORY)
+      return;
+
+   numFiles = Node_getNumFiles(n);
+   numChildren = Node_getNumChildren(n);
+   dirID = numFiles;
+   if(from != NULL) {
+      /* seek each run of children to the next component */
+      FT_cursorPeek(from, &name, &len);
+      FT_cursorAdvance(from, len);
+      (void) Node_findChild(n, name, len, FILE_S, &fileID);
+      (void) Node_findChild(n, name, len, DIRECTORY, &dirID);
+   }
+
+   /* merge the runs by name; a child with the next component's name,
+      if any, comes first */
+   dirLen = Node_getPathLength(n) + 1;
+   while(!s->stopped && (fileID < numFiles || dirID < numChildren)) {
+      file = (fileID < numFiles) ? Node_getChild(n, fileID) : NULL;
+      sub = (dirID < numChildren) ? Node_getChild(n, dirID) : NULL;
+      if(sub == NULL ||
+         (file != NULL &&
+          FT_compareNames(Node_getPath(file) + dirLen,
+                          Node_getPathLength(file) - dirLen,
+                          Node_getPath(sub) + dirLen,
+                          Node_getPathLength(sub) - dirLen) < 0)) {
+         child = file;
+         fileID++;
+      }
+      else {
+         child = sub;
+         dirID++;
+      }
+
+      if(from != NULL &&
+         FT_compareNames(Node_getPath(child) + dirLen,
+                         Node_getPathLength(child) - dirLen,
+                         name, len) == 0)
+         FT_scanFrom(s, child, from);
+      else
+         FT_scanFrom(s, child, NULL);
+      from = NULL;
+   }
+}
+
+/* see ft.h for specification */
+int FT_scanRange(const char* fromPath, const char* toPath,
+                 FT_ListCallback pfVisit, void* pvExtra) {
+   struct RangeScan s;
+   struct PathCursor c;
+   const char* name;
+   size_t len;
+   int cmp;
+
+   assert(pfVisit != NULL);
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized || frozen != NULL)
+      return INITIALIZATION_ERROR;
+   if(root == NULL)
+      return SUCCESS;
+
+   s.toPath = toPath;
+   s.pfVisit = pfVisit;
+   s.pvExtra = pvExtra;
+   s.stopped = FALSE;
+
+   /* the root comes before fromPath, after it, or begins it */
+   FT_cursorFromString(&c, (fromPath == NULL) ? "" : fromPath);
+   if(!FT_cursorAtEnd(&c)) {
+      FT_cursorPeek(&c, &name, &len);
+      FT_cursorAdvance(&c, len);
+      cmp = FT_compareNames(Node_getPath(root),
+                            Node_getPathLength(root), name, len);
+      if(cmp < 0)
+         return SUCCESS;
+      if(cmp > 0) {
+         FT_scanFrom(&s, root, NULL);
+         return SUCCESS;
+      }
+   }
+   FT_scanFrom(&s, root, &c);
+   return SUCCESS;
+}
+
+/*
+   Returns the child of directory dir with identifier childID, if
+   childID is below end and the child's name begins with the len
+   characters at prefix, and NULL otherwise.
+*/
+static Node FT_completion(Node dir, size_t childID, size_t end,
+                          const char* prefix, size_t len) {
+   Node child;
+   size_t dirLen;
+
+   assert(dir != NULL);
+   assert(prefix != NULL);
+
+   if(childID >= end)
+      return NULL;
+   child = Node_getChild(dir, childID);
+   dirLen = Node_getPathLength(dir);
+   if(Node_getPathLength(child) - dirLen - 1 < len)
+      return NULL;
+   STATS_COMPARE(Node_getPath(child) + dirLen + 1, prefix, len);
+   if(strncmp(Node_getPath(child) + dirLen + 1, prefix, len) != 0)
+      return NULL;
+   return child;
+}
+
+/* see ft.h for specification */
+int FT_complete(const char* partialPath, size_t limit,
+                FT_ListCallback pfVisit, void* pvExtra) {
+   struct PathCursor c;
+   const char* typed;
+   const char* name;
+   size_t len;
+   size_t nameLen;
+   size_t file;
+   size_t sub;
+   size_t numFiles;
+   size_t numChildren;
+   Node dir;
+   Node nextFile;
+   Node nextSub;
+   Node next;
+
+   assert(partialPath != NULL);
+   assert(pfVisit != NULL);
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized || frozen != NULL)
+      return INITIALIZATION_ERROR;
+
+   /* the name being typed: whatever follows the last '/' */
+   typed = strrchr(partialPath, '/');
+   typed = (typed == NULL) ? partialPath : typed + 1;
+   len = strlen(typed);
+
+   /* with no '/' after the first name, it is the root's being typed */
+   if(typed == FT_skipSeparators(partialPath)) {
+      if(root != NULL && Node_getPathLength(root) >= len &&
+         strncmp(Node_getPath(root), typed, len) == 0)
+         (void) FT_visitNode(root, pfVisit, pvExtra);
+      return SUCCESS;
+   }
+
+   /* descend to the directory the name is typed in: the Node the
+      descent stops at, if it stops at that name, or, if it matches
+      it in full, that Node's parent */
+   FT_cursorFromString(&c, partialPath);
+   dir = FT_traversePath(&c, NULL);
+   if(dir == NULL)
+      return NO_SUCH_PATH;
+   if(FT_cursorAtEnd(&c)) {
+      if(len > 0)
+         dir = Node_getParent(dir);
+   }
+   else {
+      FT_cursorPeek(&c, &name, &nameLen);
+      if(name != typed && Node_getType(dir) == DIRECTORY)
+         return NO_SUCH_PATH;
+   }
+   if(Node_getType(dir) != DIRECTORY)
+      return NOT_A_DIRECTORY;
+
+   /* the names with the prefix are adjacent in each run of children,
+      from where the prefix itself would go; merge the two by name */
+   (void) Node_findChild(dir, typed, len, FILE_S, &file);
+   (void) Node_findChild(dir, typed, len, DIRECTORY, &sub);
+   numFiles = Node_getNumFiles(dir);
+   numChildren = Node_getNumChildren(dir);
+   nextFile = FT_completion(dir, file, numFiles, typed, len);
+   nextSub = FT_completion(dir, sub, numChildren, typed, len);
+   while(nextFile != NULL || nextSub != NULL) {
+      if(nextSub == NULL || (nextFile != NULL &&
+         strcmp(Node_getPath(nextFile), Node_getPath(nextSub)) < 0)) {
+         next = nextFile;
+         nextFile = FT_completion(dir, ++file, numFiles, typed, len);
+      }
+      else {
+         next = nextSub;
+         nextSub = FT_completion(dir, ++sub, numChildren, typed, len);
+      }
+
+      if(!FT_visitNode(next, pfVisit, pvExtra))
+         break;
+      if(limit != 0 && --limit == 0)
+         break;
+   }
+   return SUCCESS;
+}
+
+/*
+   A search for the nodes with a name, or whose names end in a
+   suffix: the name or suffix and its length, which of the two it is,
+   the callback to call on each node found and its pvExtra, and
+   whether the callback has asked to stop.
+*/
+struct NameSearch {
+   const char* key;
+   size_t len;
+   boolean suffix;
+   FT_ListCallback pfVisit;
+   void* pvExtra;
+   boolean stopped;
+};
+
+/*
+   Calls the callback of the NameSearch at pvSearch on Node n,
+   returning FALSE, and marking the search stopped, if the callback
+   does.
+*/
+static int FT_findVisit(Node n, void* pvSearch) {
+   struct NameSearch* s = pvSearch;
+
+   assert(s != NULL);
+
+   if(!FT_visitNode(n, s->pfVisit, s->pvExtra)) {
+      s->stopped = TRUE;
+      return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+   Searches the hierarchy rooted at curr for the nodes that search *s
+   looks for, in pre-order, until the search is stopped: what
+   FT_findByName and FT_findByExtension do without an index of names.
+*/
+static void FT_findFrom(struct NameSearch* s, Node curr) {
+   Node parent;
+   const char* name;
+   size_t len;
+   size_t c;
+
+   assert(s != NULL);
+   assert(curr != NULL);
+
+   parent = Node_getParent(curr);
+   name = Node_getPath(curr);
+   len = Node_getPathLength(curr);
+   if(parent != NULL) {
+      name += Node_getPathLength(parent) + 1;
+      len -= Node_getPathLength(parent) + 1;
+   }
+
+   if(s->suffix ? (len > s->len &&
+                   strncmp(name + len - s->len, s->key, s->len) == 0)
+                : (len == s->len && strncmp(name, s->key, len) == 0))
+      if(!FT_findVisit(curr, s))
+         return;
+
+   for(c = 0; c < Node_getNumChildren(curr) && !s->stopped; c++)
+      FT_findFrom(s, Node_getChild(curr, c));
+}
+
+/*
+   Calls pfVisit with pvExtra on each node named key, or, if suffix
+   is TRUE, on each node whose name ends in key and is longer than
+   it, until pfVisit returns FALSE. Returns the status documented for
+   FT_findByName.
+*/
+static int FT_find(const char* key, boolean suffix,
+                   FT_ListCallback pfVisit, void* pvExtra) {
+   struct NameSearch s;
+
+   assert(key != NULL);
+   assert(pfVisit != NULL);
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized || frozen != NULL)
+      return INITIALIZATION_ERROR;
+
+   s.key = key;
+   s.len = strlen(key);
+   s.suffix = suffix;
+   s.pfVisit = pfVisit;
+   s.pvExtra = pvExtra;
+   s.stopped = FALSE;
+
+   if(names == NULL) {
+      if(root != NULL)
+         FT_findFrom(&s, root);
+   }
+   else if(suffix)
+      (void) NameIndex_mapSuffix(names, key, s.len, FT_findVisit, &s);
+   else
+      (void) NameIndex_mapName(names, key, s.len, FT_findVisit, &s);
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_findByName(const char* name, FT_ListCallback pfVisit,
+                  void* pvExtra) {
+   return FT_find(name, FALSE, pfVisit, pvExtra);
+}
+
+/* see ft.h for specification */
+int FT_findByExtension(const char* extension, FT_ListCallback pfVisit,
+                       void* pvExtra) {
+   return FT_find(extension, TRUE, pfVisit, pvExtra);
+}
+
+/*
+   Does FT_indexNames without tracing it.
+*/
+static int FT_indexNamesUntraced(boolean enable) {
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized)
+      return INITIALIZATION_ERROR;
+
+   namesWanted = enable;
+   if(!enable) {
+      FT_dropNames();
+      return SUCCESS;
+   }
+   /* while frozen, FT_thaw builds it */
+   if(names != NULL || frozen != NULL)
+      return SUCCESS;
+
+   names = NameIndex_new();
+   if(names == NULL || (root != NULL && !FT_indexFrom(root))) {
+      FT_dropNames();
+      namesWanted = FALSE;
+      return MEMORY_ERROR;
+   }
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_indexNames(boolean enable) {
+   unsigned long start = FT_traceStart();
+   int result;
+
+   result = FT_indexNamesUntraced(enable);
+   FT_traceCall(TRACE_INDEX_NAMES, enable ? TRACE_ENABLE : 0, NULL,
+                NULL, 0, result, start);
+   return result;
+}
+
+/* see ft.h for specification */
+boolean FT_getNameIndexSize(size_t* pBytes) {
+   assert(pBytes != NULL);
+
+   if(names == NULL) {
+      *pBytes = 0;
+      return FALSE;
+   }
+   *pBytes = NameIndex_getSize(names);
+   return TRUE;
+}
+
+/* A batch of Nodes of one type, for FT_insertBatch and FT_rmBatch */
+DEFINE_DYNARRAY(NodeBatch, Node);
+
+/*
+   A BatchRun gathers consecutive entries of a batch that name
+   children of one directory in increasing order, so that they can be
+   linked into it, or unlinked from it, together.
+*/
+struct BatchRun {
+   /* the directory, or NULL if no run is open */
+   Node parent;
+   /* the name of the entry last seen in the run, and its length */
+   const char* last;
+   size_t lastLen;
+   /* the Nodes gathered so far, by type */
+   NodeBatch_T files;
+   NodeBatch_T dirs;
+};
+
+/*
+   Starts *r off with no run open. Returns TRUE, or FALSE if there is
+   an allocation error.
+*/
+static boolean FT_runInit(struct BatchRun* r) {
+   assert(r != NULL);
+
+   r->parent = NULL;
+   r->files = NodeBatch_new(0);
+   r->dirs = NodeBatch_new(0);
+   if(r->files == NULL || r->dirs == NULL) {
+      if(r->files != NULL)
+         NodeBatch_free(r->files);
+      if(r->dirs != NULL)
+         NodeBatch_free(r->dirs);
+      return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+   Opens a run in *r beneath parent (or none, if parent is NULL) whose
+   first entry has path path.
+*/
+static void FT_runOpen(struct BatchRun* r, Node parent,
+                       const char* path) {
+   assert(r != NULL);
+   assert(NodeBatch_getLength(r->files) == 0);
+   assert(NodeBatch_getLength(r->dirs) == 0);
+
+   r->parent = parent;
+   FT_lastComponent(path, &r->last, &r->lastLen);
+}
+
+/*
+   Returns TRUE if path, exactly as written, names a child of the open
+   run's directory whose name sorts after that of the run's last
+   entry, storing the name in *pName and its length in *pLen and
+   making it the run's last. Returns FALSE otherwise.
+*/
+static boolean FT_runAccepts(struct BatchRun* r, const char* path,
+                             const char** pName, size_t* pLen) {
+   size_t parentLen;
+   int cmp;
+
+   assert(r != NULL);
+   assert(path != NULL);
+   assert(pName != NULL);
+   assert(pLen != NULL);
+
+   if(r->parent == NULL)
+      return FALSE;
+
+   parentLen = Node_getPathLength(r->parent);
+   STATS_COMPARE(path, Node_getPath(r->parent), parentLen);
+   if(strncmp(path, Node_getPath(r->parent), parentLen) ||
+      path[parentLen] != '/')
+      return FALSE;
+   *pName = path + parentLen + 1;
+   *pLen = FT_componentLength(*pName);
+   if(*pLen == 0 || (*pName)[*pLen] != '\0')
+      return FALSE;
+
+   cmp = strncmp(*pName, r->last,
+                 (*pLen < r->lastLen) ? *pLen : r->lastLen);
+   if(cmp < 0 || (cmp == 0 && *pLen <= r->lastLen))
+      return FALSE;
+
+   r->last = *pName;
+   r->lastLen = *pLen;
+   return TRUE;
+}
+
+/*
+   Links the Nodes gathered in run *r into its directory. Returns
+   SUCCESS, or MEMORY_ERROR, destroying them instead, if there is an
+   allocation error. Either way, leaves the run empty.
+*/
+static int FT_flushInsertRun(struct BatchRun* r) {
+   Node* files;
+   Node* dirs;
+   size_t numFiles;
+   size_t numDirs;
+   size_t i;
+   int result = SUCCESS;
+
+   assert(r != NULL);
+
+   numFiles = NodeBatch_getLength(r->files);
+   numDirs = NodeBatch_getLength(r->dirs);
+   if(numFiles + numDirs == 0)
+      return SUCCESS;
+
+   /* size the directory's children for the whole run up front, so
+      that both types fail, if at all, before either is linked */
+   files = NodeBatch_slot(r->files, 0);
+   dirs = NodeBatch_slot(r->dirs, 0);
+   if(Node_reserveChildren(r->parent, FILE_S, numFiles) != SUCCESS ||
+      Node_reserveChildren(r->parent, DIRECTORY, numDirs) != SUCCESS ||
+      Node_addChildren(r->parent, files, numFiles) != SUCCESS)
+      result = MEMORY_ERROR;
+   else if(Node_addChildren(r->parent, dirs, numDirs) != SUCCESS) {
+      Node_unlinkChildren(r->parent, files, numFiles);
+      result = MEMORY_ERROR;
+   }
+
+   if(result == SUCCESS) {
+      count += numFiles + numDirs;
+      for(i = 0; i < numFiles; i++)
+         FT_indexNode(NodeBatch_get(r->files, i));
+      for(i = 0; i < numDirs; i++)
+         FT_indexNode(NodeBatch_get(r->dirs, i));
+   }
+   else {
+      for(i = 0; i < numFiles; i++)
+         (void) Node_destroy(NodeBatch_get(r->files, i));
+      for(i = 0; i < numDirs; i++)
+         (void) Node_destroy(NodeBatch_get(r->dirs, i));
+   }
+
+   NodeBatch_removeRange(r->files, 0, numFiles);
+   NodeBatch_removeRange(r->dirs, 0, numDirs);
+   return result;
+}
+
+/*
+   Removes the hierarchies rooted at the Nodes gathered in run *r,
+   invalidating any directory handles open within them, and leaves
+   the run empty.
+*/
+static void FT_flushRmRun(struct BatchRun* r) {
+   size_t numFiles;
+   size_t numDirs;
+   size_t i;
+
+   assert(r != NULL);
+
+   numFiles = NodeBatch_getLength(r->files);
+   numDirs = NodeBatch_getLength(r->dirs);
+   if(numFiles + numDirs == 0)
+      return;
+
+   for(i = 0; i < numDirs && openDirs > 0; i++)
+      FT_closeDirsIn(NodeBatch_get(r->dirs, i));
+   Node_unlinkChildren(r->parent, NodeBatch_slot(r->files, 0), numFiles);
+   Node_unlinkChildren(r->parent, NodeBatch_slot(r->dirs, 0), numDirs);
+   for(i = 0; i < numFiles; i++)
+      FT_removePathFrom(NodeBatch_get(r->files, i));
+   for(i = 0; i < numDirs; i++)
+      FT_removePathFrom(NodeBatch_get(r->dirs, i));
+
+   NodeBatch_removeRange(r->files, 0, numFiles);
+   NodeBatch_removeRange(r->dirs, 0, numDirs);
+}
+
+/*
+   Frees the arrays of run *r, which must be empty.
+*/
+static void FT_runFree(struct BatchRun* r) {
+   assert(r != NULL);
+   assert(NodeBatch_getLength(r->files) == 0);
+   assert(NodeBatch_getLength(r->dirs) == 0);
+
+   NodeBatch_free(r->files);
+   NodeBatch_free(r->dirs);
+}
+
+/*
+   Does FT_insertBatch without tracing it.
+*/
+static int FT_insertBatchUntraced(const struct FT_BatchEntry* entries,
+                                  size_t n, size_t* pDone) {
+   struct BatchRun r;
+   struct PathCursor c;
+   const char* name;
+   size_t len;
+   size_t childID;
+   size_t runStart = 0;
+   size_t i;
+   nodeType type;
+   Node new;
+   int result = SUCCESS;
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   assert(entries != NULL || n == 0);
+   assert(pDone != NULL);
+
+   *pDone = 0;
+   if(!isInitialized || frozen != NULL)
+      return INITIALIZATION_ERROR;
+   if(!FT_runInit(&r))
+      return MEMORY_ERROR;
+
+   for(i = 0; i < n; i++) {
+      assert(entries[i].path != NULL);
+      type = entries[i].isFile ? FILE_S : DIRECTORY;
+
+      if(FT_runAccepts(&r, entries[i].path, &name, &len)) {
+         /* a new child of the run's directory: hold it back */
+         if(Node_findChild(r.parent, name, len, DIRECTORY, &childID) ||
+            Node_findChild(r.parent, name, len, FILE_S, &childID)) {
+            result = ALREADY_IN_TREE;
+            break;
+         }
+         new = Node_createN(name, len, r.parent, type);
+         if(new == NULL) {
+            result = MEMORY_ERROR;
+            break;
+         }
+         /* its contents go in before it is indexed, when linked */
+         if(type == FILE_S)
+            Node_insertFileContents(new, entries[i].contents,
+                                    entries[i].length);
+         if(!NodeBatch_add((type == FILE_S) ? r.files : r.dirs, new)) {
+            (void) Node_destroy(new);
+            result = MEMORY_ERROR;
+            break;
+         }
+      }
+      else {
+         /* anything else: insert it alone, and start a new run
+            among its siblings */
+         if(FT_flushInsertRun(&r) != SUCCESS) {
+            result = MEMORY_ERROR;
+            i = runStart;
+            break;
+         }
+         FT_cursorFromString(&c, entries[i].path);
+         result = FT_insertPath(&c, NULL, type, &new);
+         if(result != SUCCESS)
+            break;
+         if(type == FILE_S)
+            FT_setContents(new, entries[i].contents,
+                           entries[i].length);
+         FT_runOpen(&r, Node_getParent(new), entries[i].path);
+         runStart = i + 1;
+      }
+   }
+
+   if(FT_flushInsertRun(&r) != SUCCESS) {
+      result = MEMORY_ERROR;
+      i = runStart;
+   }
+   FT_runFree(&r);
+
+   *pDone = i;
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_insertBatch(const struct FT_BatchEntry* entries, size_t n,
+                   size_t* pDone) {
+   unsigned long start = FT_traceStart();
+   size_t i;
+   int result;
+
+   result = FT_insertBatchUntraced(entries, n, pDone);
+   if(trace == NULL)
+      return result;
+   n = (*pDone < n) ? *pDone + 1 : n;
+   FT_traceCall(TRACE_INSERT_BATCH, 0, NULL, NULL, n, result, start);
+   for(i = 0; i < n; i++)
+      FT_traceEntry(entries[i].path, entries[i].isFile,
+                    entries[i].contents, entries[i].length, start);
+   return result;
+}
+
+/*
+   Makes the non-NULL contents of each file in the hierarchy rooted at
+   curr, which an import has just allocated, the hierarchy's own.
+*/
+static void FT_ownContentsFrom(Node curr) {
+   size_t c;
+
+   assert(curr != NULL);
+
+   if(Node_getType(curr) == FILE_S) {
+      if(Node_getFileContents(curr) != NULL)
+         Node_setContentsOwned(curr, TRUE);
+      return;
+   }
+   for(c = 0; c < Node_getNumChildren(curr); c++)
+      FT_ownContentsFrom(Node_getChild(curr, c));
+}
+
+/* see ft.h for specification */
+int FT_importDir(const char* fsPath, char* path,
+                 const struct FT_ImportOptions* options) {
+   static const struct FT_ImportOptions defaults = {0, FALSE, 0};
+   DirScan_T scan;
+   const struct FT_BatchEntry* entries;
+   struct PathCursor c;
+   Node dir;
+   size_t n;
+   size_t done;
+   int result;
+
+   assert(fsPath != NULL);
+   assert(path != NULL);
+
+   if(options == NULL)
+      options = &defaults;
+
+   result = FT_insertDir(path);
+   if(result != SUCCESS)
+      return result;
+
+   /* name the entries from the directory's own path, so that each
+      listing is taken as a run of its children */
+   FT_cursorFromString(&c, path);
+   dir = FT_findNode(&c, NULL);
+   assert(dir != NULL);
+   result = DirScan_run(fsPath, Node_getPath(dir), options->threads,
+                        options->readContents, options->maxReads,
+                        &scan);
+   if(result == SUCCESS) {
+      entries = DirScan_getEntries(scan, &n);
+      result = FT_insertBatch(entries, n, &done);
+      if(result != SUCCESS)
+         (void) FT_rmDir(path);
+      else if(options->readContents)
+         FT_ownContentsFrom(dir);
+      DirScan_free(scan, result != SUCCESS);
+   }
+   else
+      (void) FT_rmDir(path);
+   return result;
+}
+
+/*
+   Returns path with any leading "/" and "./" removed, as tar paths
+   may have them.
+*/
+static char* FT_tarPath(char* path) {
+   assert(path != NULL);
+
+   while(*path == '/' ||
+         (path[0] == '.' && (path[1] == '/' || path[1] == '\0')))
+      path++;
+   return path;
+}
+
+/*
+   Stores in *pContents a copy, from malloc, of the contents of the
+   file at target, or NULL if it has none, and their length in
+   *pLength, for a hard link to it.
+   Returns SUCCESS, NO_SUCH_PATH if no node is at target, NOT_A_FILE
+   if a directory is, or MEMORY_ERROR.
+*/
+static int FT_copyTarLink(const char* target, void** pContents,
+                          size_t* pLength) {
+   struct PathCursor c;
+   Node n;
+
+   assert(target != NULL);
+   assert(pContents != NULL);
+   assert(pLength != NULL);
+
+   FT_cursorFromString(&c, target);
+   n = FT_findNode(&c, NULL);
+   if(n == NULL)
+      return NO_SUCH_PATH;
+   if(Node_getType(n) != FILE_S)
+      return NOT_A_FILE;
+
+   *pContents = NULL;
+   *pLength = Node_getFileLength(n);
+   if(Node_getFileContents(n) != NULL && *pLength > 0) {
+      *pContents = malloc(*pLength);
+      if(*pContents == NULL)
+         return MEMORY_ERROR;
+      memcpy(*pContents, Node_getFileContents(n), *pLength);
+   }
+   return SUCCESS;
+}
+
+/*
+   Inserts a file from a tar archive at path, with contents of length
+   length, as FT_insertFile does and recorded as a call to it, and
+   makes non-NULL contents the new file's own, all in one descent.
+*/
+static int FT_insertTarFile(char* path, void* contents, size_t length) {
+   struct PathCursor c;
+   unsigned long start = FT_traceStart();
+   Node leaf;
+   int result;
+
+   assert(path != NULL);
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   FT_cursorFromString(&c, path);
+   result = FT_insertPath(&c, NULL, FILE_S, &leaf);
+   if(result == SUCCESS) {
+      FT_setContents(leaf, contents, length);
+      if(contents != NULL)
+         Node_setContentsOwned(leaf, TRUE);
+   }
+
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   FT_traceCall(TRACE_INSERT_FILE, FT_contentsFlag(contents),
+                path, NULL, length, result, start);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_importTar(int fd) {
+   TarReader_T reader;
+   enum TarType type;
+   char* path;
+   void* contents;
+   size_t length;
+   int result;
+
+   if(!isInitialized || frozen != NULL)
+      return INITIALIZATION_ERROR;
+   reader = TarReader_new(fd);
+   if(reader == NULL)
+      return MEMORY_ERROR;
+
+   for(;;) {
+      result = TarReader_next(reader, &type, &path, &length);
+      if(result != SUCCESS || type == TAR_END)
+         break;
+      path = FT_tarPath(path);
+      if(*path == '\0')
+         continue;
+
+      if(type == TAR_DIR) {
+         result = FT_insertDir(path);
+         if(result == ALREADY_IN_TREE && FT_containsDir(path))
+            result = SUCCESS;
+      }
+      else {
+         contents = NULL;
+         if(type == TAR_LINK)
+            result = FT_copyTarLink(
+               FT_tarPath(TarReader_getLinkPath(reader)),
+               &contents, &length);
+         else if(length > 0) {
+            contents = malloc(length);
+            if(contents == NULL) {
+               result = MEMORY_ERROR;
+               break;
+            }
+            result = TarReader_read(reader, contents, length);
+         }
+         if(result == SUCCESS)
+            result = FT_insertTarFile(path, contents, length);
+         if(result != SUCCESS)
+            free(contents);
+      }
+      if(result != SUCCESS)
+         break;
+   }
+
+   TarReader_free(reader);
+   return result;
+}
+
+/*
+   Adds the hierarchy rooted at n to the archive of writer in
+   pre-order. Returns SUCCESS, or the status of the first addition to
+   fail.
+*/
+static int FT_exportTarFrom(Node n, TarWriter_T writer) {
+   size_t i;
+   int result;
+
+   assert(n != NULL);
+   assert(writer != NULL);
+
+   if(Node_getType(n) == FILE_S)
+      return TarWriter_add(writer, Node_getPath(n), TRUE,
+                           Node_getFileContents(n),
+                           Node_getFileLength(n));
+
+   result = TarWriter_add(writer, Node_getPath(n), FALSE, NULL, 0);
+   for(i = 0; i < Node_getNumChildren(n) && result == SUCCESS; i++)
+      result = FT_exportTarFrom(Node_getChild(n, i), writer);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_exportTar(int fd, char* path) {
+   TarWriter_T writer;
+   struct PathCursor c;
+   Node n;
+   int result;
+
+   assert(path != NULL);
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized || frozen != NULL)
+      return INITIALIZATION_ERROR;
+   FT_cursorFromString(&c, path);
+   n = FT_findNode(&c, NULL);
+   if(n == NULL)
+      return NO_SUCH_PATH;
+
+   writer = TarWriter_new(fd);
+   if(writer == NULL)
+      return MEMORY_ERROR;
+   result = FT_exportTarFrom(n, writer);
+   if(result == SUCCESS)
+      result = TarWriter_finish(writer);
+   TarWriter_free(writer);
+   return result;
+}
+
+/* The contents of the files FT_grep searches */
+DEFINE_DYNARRAY(GrepFileArray, struct GrepFile);
+
+/*
+   A content search: the files with contents in the hierarchy being
+   searched, in the order FT_toString lists them, with their Nodes,
+   and the callback to report matches to and its pvExtra.
+*/
+struct GrepSearch {
+   GrepFileArray_T files;
+   NodeBatch_T nodes;
+   FT_GrepCallback pfMatch;
+   void* pvExtra;
+};
+
+/*
+   Adds to search *s each file in the hierarchy rooted at n that has
+   contents, in pre-order. Returns FALSE if there is an allocation
+   error, and TRUE otherwise.
+*/
+static boolean FT_grepGather(struct GrepSearch* s, Node n) {
+   struct GrepFile file;
+   size_t i;
+
+   assert(s != NULL);
+   assert(n != NULL);
+
+   if(Node_getType(n) == FILE_S) {
+      file.pcContents = Node_getFileContents(n);
+      file.uLength = Node_getFileLength(n);
+      if(file.pcContents == NULL || file.uLength == 0)
+         return TRUE;
+      return GrepFileArray_add(s->files, file) &&
+         NodeBatch_add(s->nodes, n);
+   }
+
+   for(i = 0; i < Node_getNumChildren(n); i++)
+      if(!FT_grepGather(s, Node_getChild(n, i)))
+         return FALSE;
+   return TRUE;
+}
+
+/*
+   Reports the match at offset in the file'th file of the GrepSearch
+   at pvSearch to its callback, returning what it returns.
+*/
+static int FT_grepReport(size_t file, size_t offset, void* pvSearch) {
+   struct GrepSearch* s = pvSearch;
+
+   assert(s != NULL);
+
+   return (*s->pfMatch)(Node_getPath(NodeBatch_get(s->nodes, file)),
+                        offset, s->pvExtra);
+}
+
+/* see ft.h for specification */
+int FT_grep(char* path, const char* needle, int flags,
+            FT_GrepCallback pfMatch, void* pvExtra) {
+   struct GrepSearch s;
+   struct PathCursor c;
+   Node n;
+   int result = MEMORY_ERROR;
+
+   assert(path != NULL);
+   assert(needle != NULL);
+   assert(pfMatch != NULL);
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized || frozen != NULL)
+      return INITIALIZATION_ERROR;
+   FT_cursorFromString(&c, path);
+   n = FT_findNode(&c, NULL);
+   if(n == NULL)
+      return NO_SUCH_PATH;
+
+   s.files = GrepFileArray_new(0);
+   s.nodes = NodeBatch_new(0);
+   s.pfMatch = pfMatch;
+   s.pvExtra = pvExtra;
+   if(s.files != NULL && s.nodes != NULL && FT_grepGather(&s, n))
+      result = Grep_run(GrepFileArray_slot(s.files, 0),
+                        GrepFileArray_getLength(s.files), needle,
+                        strlen(needle), flags, 0, FT_grepReport, &s);
+
+   if(s.files != NULL)
+      GrepFileArray_free(s.files);
+   if(s.nodes != NULL)
+      NodeBatch_free(s.nodes);
+   return result;
+}
+
+/*
+   A search for the largest files or directories beneath a directory,
+   best first: a heap of the Nodes that may yet be reported, the one
+   to come off next at the top. Each is keyed by FT_topKKey, and a
+   directory's key is never less than that of any Node beneath it, so
+   a Node comes off the heap only when nothing larger remains, and a
+   directory too small to matter is never opened.
+*/
+struct TopK {
+   NodeBatch_T heap;
+   /* TRUE for FT_topKDirs, and FALSE for FT_topKFiles */
+   boolean dirs;
+};
+
+/*
+   Returns the key of Node n in search *t: a file's length, or, for a
+   directory, the total length of the files beneath it when
+   directories are sought, and the bound on the length of any one of
+   them when files are.
+*/
+static size_t FT_topKKey(const struct TopK* t, Node n) {
+   assert(t != NULL);
+   assert(n != NULL);
+
+   if(Node_getType(n) == FILE_S)
+      return Node_getFileLength(n);
+   if(t->dirs)
+      return Node_getTotalLength(n);
+   return Node_getMaxLength(n);
+}
+
+/*
+   Returns TRUE if Node n1 is to come off the heap of search *t before
+   Node n2: the larger key first, and then in the order of
+   FT_compareSizes.
+*/
+static boolean FT_topKBefore(const struct TopK* t, Node n1, Node n2) {
+   size_t key1 = FT_topKKey(t, n1);
+   size_t key2 = FT_topKKey(t, n2);
+
+   if(key1 != key2)
+      return (boolean) (key1 > key2);
+   /* a directory as large as a file may hold a file as large that
+      comes first in path order, so it is opened first */
+   if(Node_getType(n1) != Node_getType(n2))
+      return (boolean) (Node_getType(n1) == DIRECTORY);
+   return (boolean) (Node_compare(n1, n2) < 0);
+}
+
+/*
+   Adds Node n to the heap of search *t. Returns FALSE if there is an
+   allocation error, and TRUE otherwise.
+*/
+static boolean FT_topKPush(struct TopK* t, Node n) {
+   size_t i;
+   size_t up;
+
+   assert(t != NULL);
+   assert(n != NULL);
+
+   if(!NodeBatch_add(t->heap, n))
+      return FALSE;
+   for(i = NodeBatch_getLength(t->heap) - 1; i > 0; i = up) {
+      up = (i - 1) / 2;
+      if(!FT_topKBefore(t, n, NodeBatch_get(t->heap, up)))
+         break;
+      (void) NodeBatch_set(t->heap, i, NodeBatch_get(t->heap, up));
+   }
+   (void) NodeBatch_set(t->heap, i, n);
+   return TRUE;
+}
+
+/*
+   Removes the Node at the top of the heap of search *t, which must
+   not be empty, and returns it.
+*/
+static Node FT_topKPop(struct TopK* t) {
+   Node top;
+   Node last;
+   size_t length;
+   size_t i = 0;
+   size_t child;
+
+   assert(t != NULL);
+   assert(NodeBatch_getLength(t->heap) > 0);
+
+   top = NodeBatch_get(t->heap, 0);
+   length = NodeBatch_getLength(t->heap) - 1;
+   last = NodeBatch_removeAt(t->heap, length);
+   if(length == 0)
+      return top;
+
+   for(child = 1; child < length; child = 2 * i + 1) {
+      if(child + 1 < length &&
+         FT_topKBefore(t, NodeBatch_get(t->heap, child + 1),
+                       NodeBatch_get(t->heap, child)))
+         child++;
+      if(!FT_topKBefore(t, NodeBatch_get(t->heap, child), last))
+         break;
+      (void) NodeBatch_set(t->heap, i, NodeBatch_get(t->heap, child));
+      i = child;
+   }
+   (void) NodeBatch_set(t->heap, i, last);
+   return top;
+}
+
+/*
+   Opens directory dir in search *t, adding to its heap each of dir's
+   children that is sought or may hold one that is. When files are
+   sought, dir's bound on their length is tightened to the largest of
+   its children's, as the bounds kept by the index only ever grow.
+   Returns FALSE if there is an allocation error, and TRUE otherwise.
+*/
+static boolean FT_topKOpen(struct TopK* t, Node dir) {
+   Node child;
+   size_t max = 0;
+   size_t c;
+
+   assert(t != NULL);
+   assert(dir != NULL);
+
+   c = t->dirs ? Node_getNumFiles(dir) : 0;
+   for(; c < Node_getNumChildren(dir); c++) {
+      child = Node_getChild(dir, c);
+      if(FT_topKKey(t, child) > max)
+         max = FT_topKKey(t, child);
+      if(!FT_topKPush(t, child))
+         return FALSE;
+   }
+   if(!t->dirs)
+      Node_setMaxLength(dir, max);
+   return TRUE;
+}
+
+/*
+   Calls pfVisit, with pvExtra, on Node n, passing a file's length, or
+   a directory's total length. Returns what pfVisit returns.
+*/
+static boolean FT_topKVisit(Node n, FT_ListCallback pfVisit,
+                            void* pvExtra) {
+   assert(n != NULL);
+   assert(pfVisit != NULL);
+
+   return (*pfVisit)(Node_getPath(n),
+                     (boolean) (Node_getType(n) == FILE_S),
+                     FT_sizeOf(n), pvExtra);
+}
+
+/*
+   FT_topKFiles, if dirs is FALSE, or FT_topKDirs, if it is TRUE.
+*/
+static int FT_topK(char* path, size_t k, boolean dirs,
+                   FT_ListCallback pfVisit, void* pvExtra) {
+   struct TopK t;
+   struct PathCursor c;
+   BTree_T sizes;
+   Node n;
+   size_t i;
+   int result = SUCCESS;
+
+   assert(path != NULL);
+   assert(pfVisit != NULL);
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized || frozen != NULL)
+      return INITIALIZATION_ERROR;
+   FT_cursorFromString(&c, path);
+   n = FT_findNode(&c, NULL);
+   if(n == NULL)
+      return NO_SUCH_PATH;
+
+   /* beneath the root, the index holds the answer in order */
+   if(n == root && fileSizes != NULL) {
+      sizes = dirs ? dirSizes : fileSizes;
+      for(i = 0; i < k && i < BTree_getLength(sizes); i++)
+         if(!FT_topKVisit(BTree_get(sizes, i), pfVisit, pvExtra))
+            break;
+      return SUCCESS;
+   }
+
+   /* without the index, the sizes beneath n are not kept */
+   if(fileSizes == NULL)
+      (void) FT_measureFrom(n, FALSE);
+   if(k == 0 || (dirs && Node_getType(n) == FILE_S))
+      return SUCCESS;
+
+   t.heap = NodeBatch_new(0);
+   t.dirs = dirs;
+   if(t.heap == NULL || !FT_topKPush(&t, n))
+      result = MEMORY_ERROR;
+   while(result == SUCCESS && k > 0 &&
+         NodeBatch_getLength(t.heap) > 0) {
+      n = FT_topKPop(&t);
+      if(dirs || Node_getType(n) == FILE_S) {
+         if(!FT_topKVisit(n, pfVisit, pvExtra))
+            break;
+         k--;
+      }
+      if(k > 0 && Node_getType(n) == DIRECTORY && !FT_topKOpen(&t, n))
+         result = MEMORY_ERROR;
+   }
+
+   if(t.heap != NULL)
+      NodeBatch_free(t.heap);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_topKFiles(char* path, size_t k, FT_ListCallback pfVisit,
+                 void* pvExtra) {
+   return FT_topK(path, k, FALSE, pfVisit, pvExtra);
+}
+
+/* see ft.h for specification */
+int FT_topKDirs(char* path, size_t k, FT_ListCallback pfVisit,
+                void* pvExtra) {
+   return FT_topK(path, k, TRUE, pfVisit, pvExtra);
+}
+
+/*
+   Does FT_indexSizes without tracing it.
+*/
+static int FT_indexSizesUntraced(boolean enable) {
+   assert(Checker_FT_isValid(isInitialized,root,count));
+
+   if(!isInitialized)
+      return INITIALIZATION_ERROR;
+
+   sizesWanted = enable;
+   if(!enable) {
+      FT_dropSizes();
+      return SUCCESS;
+   }
+   /* while frozen, FT_thaw builds it */
+   if(fileSizes != NULL || frozen != NULL)
+      return SUCCESS;
+
+   if(!FT_buildSizes()) {
+      sizesWanted = FALSE;
+      return MEMORY_ERROR;
+   }
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_indexSizes(boolean enable) {
+   unsigned long start = FT_traceStart();
+   int result;
+
+   result = FT_indexSizesUntraced(enable);
+   FT_traceCall(TRACE_INDEX_SIZES, enable ? TRACE_ENABLE : 0, NULL,
+                NULL, 0, result, start);
+   return result;
+}
+
+/* The size of the buffer FT_fromListingStream reads through */
+#define LISTING_BUFFER_SIZE 65536
+
+/*
+   A ListingFrame is a directory of a listing being read that may
+   still gain children: those seen so far, not yet linked into it,
+   wait at the top of the listing's pending array from index start.
+*/
+struct ListingFrame {
+   Node dir;
+   size_t start;
+   /* its last child of each type, or NULL if it has none yet */
+   Node lastFile;
+   Node lastDir;
+   /* whether its files are linked and its directories pending */
+   boolean inDirs;
+   /* whether its children came out of order, so that each is now
+      looked up and linked as it comes */
+   boolean slow;
+};
+
+/* The stack of open directories of a listing */
+DEFINE_DYNARRAY(FrameArray, struct ListingFrame);
+
+/*
+   A Listing is the state of FT_fromListing or FT_fromListingStream:
+   the line last read, whose type is not known until the next line
+   shows whether that one lies beneath it, the directories open along
+   the path to it, and the children waiting to be linked into them.
+*/
+struct Listing {
+   /* the line last read, '\0'-terminated, without any trailing '/' */
+   char* held;
+   size_t heldLen;
+   size_t heldCap;
+   /* whether there is such a line, and whether it ended with '/' */
+   boolean hasHeld;
+   boolean heldIsDir;
+   /* whether the listing's first line has been inserted */
+   boolean started;
+   FrameArray_T frames;
+   NodeBatch_T pending;
+};
+
+/*
+   Starts *l off with no lines read. Returns TRUE, or FALSE if there
+   is an allocation error.
+*/
+static boolean FT_listingInit(struct Listing* l) {
+   assert(l != NULL);
+
+   l->heldCap = 64;
+   l->held = malloc(l->heldCap);
+   l->frames = FrameArray_new(0);
+   l->pending = NodeBatch_new(0);
+   l->hasHeld = FALSE;
+   l->started = FALSE;
+   if(l->held == NULL || l->frames == NULL || l->pending == NULL) {
+      free(l->held);
+      if(l->frames != NULL)
+         FrameArray_free(l->frames);
+      if(l->pending != NULL)
+         NodeBatch_free(l->pending);
+      return FALSE;
+   }
+   STATS_ADD(mallocs, 1);
+   return TRUE;
+}
+
+/*
+   Links the children of *f waiting in listing *l into its directory.
+   Returns SUCCESS, or MEMORY_ERROR, destroying them instead, if there
+   is an allocation error.
+*/
+static int FT_listingFlush(struct Listing* l, struct ListingFrame* f) {
+   nodeType type;
+   size_t n;
+   size_t i;
+   int result = SUCCESS;
+
+   assert(l != NULL);
+   assert(f != NULL);
+
+   n = NodeBatch_getLength(l->pending) - f->start;
+   if(n == 0)
+      return SUCCESS;
+
+   /* the children waiting are all of one type */
+   type = Node_getType(NodeBatch_get(l->pending, f->start));
+   if(Node_reserveChildren(f->dir, type, n) != SUCCESS ||
+      Node_addChildren(f->dir, NodeBatch_slot(l->pending, f->start),
+                       n) != SUCCESS) {
+      for(i = f->start; i < f->start + n; i++)
+         FT_removePathFrom(NodeBatch_get(l->pending, i));
+      result = MEMORY_ERROR;
+   }
+   NodeBatch_removeRange(l->pending, f->start, n);
+   return result;
+}
+
+/*
+   Closes the innermost open directory of listing *l, linking in the
+   children still waiting. Returns the status of FT_listingFlush.
+*/
+static int FT_listingPop(struct Listing* l) {
+   size_t depth;
+   int result;
+
+   assert(l != NULL);
+
+   depth = FrameArray_getLength(l->frames);
+   assert(depth > 0);
+   result = FT_listingFlush(l, FrameArray_slot(l->frames, depth - 1));
+   FrameArray_removeRange(l->frames, depth - 1, 1);
+   return result;
+}
+
+/*
+   Opens directory dir, new and empty, as the innermost of listing
+   *l. Returns TRUE, or FALSE if there is an allocation error.
+*/
+static boolean FT_listingPush(struct Listing* l, Node dir) {
+   struct ListingFrame f;
+
+   assert(l != NULL);
+   assert(dir != NULL);
+
+   f.dir = dir;
+   f.start = NodeBatch_getLength(l->pending);
+   f.lastFile = NULL;
+   f.lastDir = NULL;
+   f.inDirs = FALSE;
+   f.slow = FALSE;
+   return (boolean) FrameArray_add(l->frames, f);
+}
+
+/*
+   Returns TRUE if the len characters of line name a node beneath the
+   directory whose path is the pathLen characters of path.
+*/
+static boolean FT_listingBeneath(const char* line, size_t len,
+                                 const char* path, size_t pathLen) {
+   assert(line != NULL);
+   assert(path != NULL);
+
+   STATS_COMPARE(line, path, pathLen);
+   return (boolean) (len > pathLen && line[pathLen] == '/' &&
+                     memcmp(line, path, pathLen) == 0);
+}
+
+/*
+   Returns TRUE if the len characters of name sort after the name of
+   child last of the directory whose path has length dirLen, as
+   children are sorted, or if last is NULL.
+*/
+static boolean FT_listingAfter(const char* name, size_t len, Node last,
+                               size_t dirLen) {
+   const char* lastName;
+   size_t lastLen;
+   int cmp;
+
+   assert(name != NULL);
+
+   if(last == NULL)
+      return TRUE;
+   lastName = Node_getPath(last) + dirLen + 1;
+   lastLen = Node_getPathLength(last) - dirLen - 1;
+   STATS_COMPARE(name, lastName, (len < lastLen) ? len : lastLen);
+   cmp = strncmp(name, lastName, (len < lastLen) ? len : lastLen);
+   return (boolean) (cmp > 0 || (cmp == 0 && len > lastLen));
+}
+
+/*
+   Adds the held line of listing *l, which lies beneath the directory
+   of frame *f, to it as a child of type type, storing the new Node in
+   *pNew. Returns SUCCESS or the status documented for FT_fromListing.
+*/
+static int FT_listingChild(struct Listing* l, struct ListingFrame* f,
+                           nodeType type, Node* pNew) {
+   const char* name;
+   size_t len;
+   size_t dirLen;
+   size_t childID;
+   Node new;
+   int result = SUCCESS;
+
+   assert(l != NULL);
+   assert(f != NULL);
+   assert(pNew != NULL);
+
+   dirLen = Node_getPathLength(f->dir);
+   name = l->held + dirLen + 1;
+   len = l->heldLen - dirLen - 1;
+   if(memchr(name, '/', len) != NULL)
+      return NO_SUCH_PATH;
+
+   if(!f->slow &&
+      ((type == FILE_S && f->inDirs) ||
+       !FT_listingAfter(name, len, (type == FILE_S) ? f->lastFile :
+                        f->lastDir, dirLen))) {
+      /* out of order: link what has been held back, and look up each
+         child from here on */
+      result = FT_listingFlush(l, f);
+      f->slow = TRUE;
+   }
+   else if(!f->slow && type == DIRECTORY && !f->inDirs) {
+      /* the files are done: link them, so that each directory can be
+         checked against them */
+      result = FT_listingFlush(l, f);
+      f->inDirs = TRUE;
+   }
+   if(result != SUCCESS)
+      return result;
+
+   /* in order, a file can only clash with a directory */
+   if((f->slow && Node_findChild(f->dir, name, len, DIRECTORY,
+                                 &childID)) ||
+      ((f->slow || type == DIRECTORY) &&
+       Node_findChild(f->dir, name, len, FILE_S, &childID)))
+      return ALREADY_IN_TREE;
+
+   new = Node_createN(name, len, f->dir, type);
+   if(new == NULL)
+      return MEMORY_ERROR;
+   if(f->slow) {
+      (void) Node_findChild(f->dir, name, len, type, &childID);
+      result = Node_addChildAt(f->dir, new, childID);
+   }
+   else if(!NodeBatch_add(l->pending, new))
+      result = MEMORY_ERROR;
+   if(result != SUCCESS) {
+      (void) Node_destroy(new);
+      return MEMORY_ERROR;
+   }
 
+   count++;
+   FT_indexNode(new);
+   if(type == FILE_S)
+      f->lastFile = new;
+   else
+      f->lastDir = new;
+   *pNew = new;
+   return SUCCESS;
 }
 
 /*
-   Performs a pre-order traversal of the tree rooted at n,
-   inserting each payload to DynArray_T d beginning at index i.
-   Returns the next unused index in d after the insertion(s).
+   Adds the held line of listing *l to the hierarchy as a node of type
+   type: the first line as FT_insertDir or FT_insertFile would, and
+   each later one as a child of the innermost open directory it lies
+   beneath, closing those it does not. Returns SUCCESS or the status
+   documented for FT_fromListing.
 */
-static size_t FT_preOrderTraversal(Node n, DynArray_T d, size_t i) {
-   size_t c;
+static int FT_listingAdd(struct Listing* l, nodeType type) {
+   struct PathCursor c;
+   struct ListingFrame* f = NULL;
+   Node new;
+   int result = SUCCESS;
 
-   assert(d != NULL);
+   assert(l != NULL);
+   assert(l->hasHeld);
 
-   if(n != NULL) {
-      (void) DynArray_set(d, i, Node_getPath(n));
-      i++;
-      for(c = 0; c < Node_getNumChildren(n); c++)
-         i = FT_preOrderTraversal(Node_getChild(n, c), d, i);
+   if(!l->started) {
+      FT_cursorFromString(&c, l->held);
+      result = FT_insertPath(&c, NULL, type, &new);
+      l->started = TRUE;
    }
-   return i;
+   else {
+      while(result == SUCCESS && FrameArray_getLength(l->frames) > 0) {
+         f = FrameArray_slot(l->frames,
+                             FrameArray_getLength(l->frames) - 1);
+         if(FT_listingBeneath(l->held, l->heldLen, Node_getPath(f->dir),
+                              Node_getPathLength(f->dir)))
+            break;
+         result = FT_listingPop(l);
+         f = NULL;
+      }
+      if(result == SUCCESS && f == NULL)
+         result = CONFLICTING_PATH;
+      if(result == SUCCESS)
+         result = FT_listingChild(l, f, type, &new);
+   }
+
+   if(result == SUCCESS && type == DIRECTORY &&
+      !FT_listingPush(l, new))
+      result = MEMORY_ERROR;
+   return result;
 }
 
 /*
-   Alternate version of strlen that uses pAcc as an in-out parameter
-   to accumulate a string length, rather than returning the length of
-   str, and also always adds one more in addition to str's length.
+   Reads the line of listing *l that is the len characters of line,
+   adding the line before it, now that its type is known. Returns
+   SUCCESS or the status documented for FT_fromListing.
 */
-static void FT_strlenAccumulate(char* str, size_t* pAcc) {
-   assert(pAcc != NULL);
+static int FT_listingLine(struct Listing* l, const char* line,
+                          size_t len) {
+   unsigned long start = FT_traceStart();
+   nodeType type;
+   char* held;
+   int result;
 
-   if(str != NULL)
-      *pAcc += (strlen(str) + 1);
+   assert(l != NULL);
+   assert(line != NULL);
+
+   if(len > 0 && line[len - 1] == '\r')
+      len--;
+   if(len == 0)
+      return SUCCESS;
+
+   /* a line is a directory if it says so or has a line beneath it */
+   if(l->hasHeld) {
+      type = (l->heldIsDir ||
+              FT_listingBeneath(line, len, l->held, l->heldLen)) ?
+         DIRECTORY : FILE_S;
+      result = FT_listingAdd(l, type);
+      FT_traceCall((type == FILE_S) ? TRACE_INSERT_FILE :
+                   TRACE_INSERT_DIR, 0, l->held, NULL, 0, result, start);
+      if(result != SUCCESS)
+         return result;
+   }
+
+   l->heldIsDir = (boolean) (line[len - 1] == '/');
+   if(l->heldIsDir)
+      len--;
+   if(len >= l->heldCap) {
+      held = realloc(l->held, 2 * len);
+      if(held == NULL)
+         return MEMORY_ERROR;
+      STATS_ADD(mallocs, 1);
+      l->held = held;
+      l->heldCap = 2 * len;
+   }
+   memcpy(l->held, line, len);
+   l->held[len] = '\0';
+   l->heldLen = len;
+   l->hasHeld = TRUE;
+   return SUCCESS;
 }
 
 /*
-   Alternate version of strcat that inverts the typical argument
-   order, appending str onto acc, and also always adds a newline at
-   the end of the concatenated string.
+   Ends listing *l, which has so far come to result: if that is
+   SUCCESS, adds its last line, and either way, links the children
+   still waiting into their directories and frees *l. Returns result,
+   or the status of the first of these steps to fail.
 */
-static void FT_strcatAccumulate(char* str, char* acc) {
-   assert(acc != NULL);
+static int FT_listingFinish(struct Listing* l, int result) {
+   unsigned long start = FT_traceStart();
+   boolean last;
 
-   if(str != NULL)
-      strcat(acc, str); strcat(acc, "\n");
+   assert(l != NULL);
+
+   last = (boolean) (result == SUCCESS && l->hasHeld);
+   if(last)
+      result = FT_listingAdd(l, l->heldIsDir ? DIRECTORY : FILE_S);
+   while(FrameArray_getLength(l->frames) > 0)
+      if(FT_listingPop(l) != SUCCESS && result == SUCCESS)
+         result = MEMORY_ERROR;
+   /* the children still waiting are linked as part of the last line */
+   if(last)
+      FT_traceCall(l->heldIsDir ? TRACE_INSERT_DIR : TRACE_INSERT_FILE,
+                   0, l->held, NULL, 0, result, start);
+
+   free(l->held);
+   STATS_ADD(frees, 1);
+   FrameArray_free(l->frames);
+   NodeBatch_free(l->pending);
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   return result;
 }
 
 /* see ft.h for specification */
-int FT_insertDir(char* path) {
-
-   Node curr;
-   int result;
+int FT_fromListing(const char* listing, size_t length) {
+   struct Listing l;
+   const char* end;
+   size_t len;
+   int result = SUCCESS;
 
+   assert(listing != NULL || length == 0);
    assert(Checker_FT_isValid(isInitialized,root,count));
-   assert(path != NULL);
 
-   if(!isInitialized)
+   if(!isInitialized || frozen != NULL)
       return INITIALIZATION_ERROR;
-   curr = FT_traversePath(path);
-   result = FT_insertRestOfPath(path, curr, DIRECTORY);
-   assert(Checker_FT_isValid(isInitialized,root,count));
-   return result;
+   if(!FT_listingInit(&l))
+      return MEMORY_ERROR;
+
+   while(length > 0 && result == SUCCESS) {
+      end = memchr(listing, '\n', length);
+      len = (end == NULL) ? length : (size_t) (end - listing);
+      result = FT_listingLine(&l, listing, len);
+      if(end != NULL)
+         len++;
+      listing += len;
+      length -= len;
+   }
+   return FT_listingFinish(&l, result);
 }
 
 /* see ft.h for specification */
-boolean FT_containsDir(char* path) {
-   Node curr;
-   boolean result;
+int FT_fromListingStream(FILE* stream) {
+   struct Listing l;
+   char* buffer;
+   char* larger;
+   const char* end;
+   size_t capacity = LISTING_BUFFER_SIZE;
+   size_t used = 0;
+   size_t begin;
+   size_t n;
+   int result = SUCCESS;
 
+   assert(stream != NULL);
    assert(Checker_FT_isValid(isInitialized,root,count));
-   assert(path != NULL);
-
-   if(!isInitialized)
-      return FALSE;
 
-   curr = FT_traversePath(path);
+   if(!isInitialized || frozen != NULL)
+      return INITIALIZATION_ERROR;
+   buffer = malloc(capacity);
+   if(buffer == NULL)
+      return MEMORY_ERROR;
+   STATS_ADD(mallocs, 1);
+   if(!FT_listingInit(&l)) {
+      free(buffer);
+      STATS_ADD(frees, 1);
+      return MEMORY_ERROR;
+   }
 
+   /* read the stream a buffer at a time, keeping any line cut off at
+      the end of one for the next, and growing the buffer only for a
+      line longer than it */
+   while(result == SUCCESS) {
+      n = fread(buffer + used, 1, capacity - used, stream);
+      used += n;
+      begin = 0;
+      while(result == SUCCESS &&
+            (end = memchr(buffer + begin, '\n', used - begin)) != NULL) {
+         result = FT_listingLine(&l, buffer + begin,
+                                 (size_t) (end - buffer) - begin);
+         begin = (size_t) (end - buffer) + 1;
+      }
+      if(result != SUCCESS)
+         break;
+      if(n == 0) {
+         if(ferror(stream))
+            result = IO_ERROR;
+         else
+            result = FT_listingLine(&l, buffer + begin, used - begin);
+         break;
+      }
 
-   if(curr == NULL)
-      result = FALSE;
-   else if(strcmp(path, Node_getPath(curr))
-           || Node_getType(curr) == FILE_S)
-      result = FALSE;
-   else
-      result = TRUE;
+      memmove(buffer, buffer + begin, used - begin);
+      used -= begin;
+      if(used == capacity) {
+         larger = realloc(buffer, 2 * capacity);
+         if(larger == NULL) {
+            result = MEMORY_ERROR;
+            break;
+         }
+         STATS_ADD(mallocs, 1);
+         buffer = larger;
+         capacity *= 2;
+      }
+   }
 
-   assert(Checker_FT_isValid(isInitialized,root,count));
-   return result;
+   free(buffer);
+   STATS_ADD(frees, 1);
+   return FT_listingFinish(&l, result);
 }
 
-/* see ft.h for specification */
-int FT_rmDir(char* path) {
+/*
+   Does FT_rmBatch without tracing it.
+*/
+static int FT_rmBatchUntraced(char** paths, size_t n, size_t* pDone) {
+   struct BatchRun r;
+   struct PathCursor c;
+   const char* name;
+   size_t len;
+   size_t childID;
+   size_t i;
+   nodeType type;
    Node curr;
-   int result;
+   Node parent;
+   int result = SUCCESS;
 
    assert(Checker_FT_isValid(isInitialized,root,count));
-   assert(path != NULL);
+   assert(paths != NULL || n == 0);
+   assert(pDone != NULL);
 
-   if(!isInitialized)
+   *pDone = 0;
+   if(!isInitialized || frozen != NULL)
       return INITIALIZATION_ERROR;
+   if(!FT_runInit(&r))
+      return MEMORY_ERROR;
 
-   curr = FT_traversePath(path);
-   if(curr == NULL)
-      result =  NO_SUCH_PATH;
-   else if (Node_getType(curr) == DIRECTORY)
-      result = FT_rmPathAt(path, curr);
-   else
-      result = NOT_A_DIRECTORY;
+   for(i = 0; i < n; i++) {
+      assert(paths[i] != NULL);
+
+      if(FT_runAccepts(&r, paths[i], &name, &len)) {
+         /* a child of the run's directory: hold it back */
+         if(Node_findChild(r.parent, name, len, DIRECTORY, &childID) ||
+            Node_findChild(r.parent, name, len, FILE_S, &childID))
+            curr = Node_getChild(r.parent, childID);
+         else {
+            result = NO_SUCH_PATH;
+            break;
+         }
+         type = Node_getType(curr);
+         if(!NodeBatch_add((type == FILE_S) ? r.files : r.dirs, curr)) {
+            /* nowhere to hold it: remove the run so far, then it */
+            parent = r.parent;
+            FT_flushRmRun(&r);
+            FT_rmNode(curr);
+            FT_runOpen(&r, parent, paths[i]);
+         }
+      }
+      else {
+         /* anything else: remove it alone, and start a new run among
+            its siblings */
+         FT_flushRmRun(&r);
+         FT_cursorFromString(&c, paths[i]);
+         curr = FT_findNode(&c, NULL);
+         if(curr == NULL) {
+            result = NO_SUCH_PATH;
+            break;
+         }
+         parent = Node_getParent(curr);
+         FT_rmNode(curr);
+         FT_runOpen(&r, parent, paths[i]);
+      }
+   }
+
+   FT_flushRmRun(&r);
+   FT_runFree(&r);
 
+   *pDone = i;
    assert(Checker_FT_isValid(isInitialized,root,count));
    return result;
 }
 
 /* see ft.h for specification */
-int FT_insertFile(char* path, void *contents, size_t length) {
-
-   Node curr;
+int FT_rmBatch(char** paths, size_t n, size_t* pDone) {
+   unsigned long start = FT_traceStart();
+   size_t i;
    int result;
 
-   assert(Checker_FT_isValid(isInitialized,root,count));
-   assert(path != NULL);
+   result = FT_rmBatchUntraced(paths, n, pDone);
+   if(trace == NULL)
+      return result;
+   n = (*pDone < n) ? *pDone + 1 : n;
+   FT_traceCall(TRACE_RM_BATCH, 0, NULL, NULL, n, result, start);
+   for(i = 0; i < n; i++)
+      FT_traceEntry(paths[i], FALSE, NULL, 0, start);
+   return result;
+}
 
-   if(!isInitialized)
+/*
+   Does FT_init without tracing it.
+*/
+static int FT_initUntraced(void) {
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   if(isInitialized)
       return INITIALIZATION_ERROR;
-   curr = FT_traversePath(path);
-   result = FT_insertRestOfPath(path, curr, FILE_S);
+   isInitialized = 1;
+   root = NULL;
+   count = 0;
+   assert(Checker_FT_isValid(isInitialized,root,count));
+   return SUCCESS;
+}
 
-   if( result == SUCCESS ){
-      curr = FT_traversePath(path);
-      Node_insertFileContents(curr, contents, length);
-   }
+/* see ft.h for specification */
+int FT_init(void) {
+   unsigned long start = FT_traceStart();
+   int result;
 
-   assert(Checker_FT_isValid(isInitialized,root,count));
+   result = FT_initUntraced();
+   FT_traceCall(TRACE_INIT, 0, NULL, NULL, 0, result, start);
    return result;
 }
 
-/* see ft.h for specification */
-boolean FT_containsFile(char* path) {
-   Node curr;
-   boolean result;
+/*
+   Does FT_destroy without tracing it.
+*/
+static int FT_destroyUntraced(void) {
+   size_t slot;
 
    assert(Checker_FT_isValid(isInitialized,root,count));
-   assert(path != NULL);
-
    if(!isInitialized)
-      return FALSE;
-
-   curr = FT_traversePath(path);
-
-
-   if(curr == NULL)
-      result = FALSE;
-   else if(strcmp(path, Node_getPath(curr))
-           || Node_getType(curr) == DIRECTORY)
-      result = FALSE;
-   else
-      result = TRUE;
-
+      return INITIALIZATION_ERROR;
+   FT_dropNames();
+   namesWanted = FALSE;
+   FT_dropSizes();
+   sizesWanted = FALSE;
+   FT_removePathFrom(root);
+   root = NULL;
+   Frozen_free(frozen);
+   frozen = NULL;
+   if(dirSlots != NULL) {
+      for(slot = 0; slot < DirSlotArray_getLength(dirSlots); slot++)
+         free(DirSlotArray_get(dirSlots, slot));
+      STATS_ADD(frees, DirSlotArray_getLength(dirSlots));
+      DirSlotArray_free(dirSlots);
+      dirSlots = NULL;
+      openDirs = 0;
+   }
+   isInitialized = 0;
    assert(Checker_FT_isValid(isInitialized,root,count));
-   return result;
+   return SUCCESS;
 }
 
 /* see ft.h for specification */
-int FT_rmFile(char* path) {
-   Node curr;
+int FT_destroy(void) {
+   unsigned long start = FT_traceStart();
    int result;
 
+   result = FT_destroyUntraced();
+   FT_traceCall(TRACE_DESTROY, 0, NULL, NULL, 0, result, start);
+   return result;
+}
+
+/*
+   Does FT_freeze without tracing it.
+*/
+static int FT_freezeUntraced(void) {
+   Frozen_T new;
+
    assert(Checker_FT_isValid(isInitialized,root,count));
-   assert(path != NULL);
 
-   if(!isInitialized)
+   if(!isInitialized || frozen != NULL)
       return INITIALIZATION_ERROR;
 
-   curr = FT_traversePath(path);
-   if(curr == NULL)
-      result =  NO_SUCH_PATH;
-   else if( Node_getType(curr) == FILE_S)
-      result = FT_rmPathAt(path, curr);
-   else
-      result = NOT_A_FILE;
+   new = Frozen_new(root, count);
+   if(new == NULL)
+      return MEMORY_ERROR;
+   FT_dropNames();
+   FT_dropSizes();
+   if(root != NULL)
+      FT_rmNode(root);
+   frozen = new;
 
    assert(Checker_FT_isValid(isInitialized,root,count));
-   return result;
+   return SUCCESS;
 }
 
 /* see ft.h for specification */
-void *FT_getFileContents(char *path){
-   Node curr;
-   void* result;
-
-   assert(Checker_FT_isValid(isInitialized,root,count));
-   assert(path != NULL);
-
-   if(!isInitialized)
-      return NULL;
-
-   curr = FT_traversePath(path);
-   if(curr == NULL)
-      result =  NULL;
-   else
-      result = Node_getFileContents(curr);
+int FT_freeze(void) {
+   unsigned long start = FT_traceStart();
+   int result;
 
-   assert(Checker_FT_isValid(isInitialized,root,count));
+   result = FT_freezeUntraced();
+   FT_traceCall(TRACE_FREEZE, 0, NULL, NULL, 0, result, start);
    return result;
 }
 
-/* see ft.h for specification */
-void *FT_replaceFileContents(char *path, void *newContents,
-                             size_t newLength){
-   Node curr;
-   void * result;
+/*
+   Does FT_thaw without tracing it.
+*/
+static int FT_thawUntraced(void) {
+   Node thawed;
+   int result;
 
    assert(Checker_FT_isValid(isInitialized,root,count));
-   assert(path != NULL);
 
-   if(!isInitialized)
-      return NULL;
+   if(!isInitialized || frozen == NULL)
+      return INITIALIZATION_ERROR;
 
-   curr = FT_traversePath(path);
-   if(curr == NULL || Node_getType(curr) == DIRECTORY)
-      result =  NULL;
-   else{
-      result = Node_getFileContents(curr);
-      Node_insertFileContents(curr, newContents, newLength);
+   result = Frozen_thaw(frozen, &thawed);
+   if(result != SUCCESS)
+      return result;
+   root = thawed;
+   count = Frozen_getLength(frozen);
+   Frozen_free(frozen);
+   frozen = NULL;
+
+   /* rebuild the indexes, or, failing that, do without them */
+   if(namesWanted) {
+      names = NameIndex_new();
+      if(names == NULL || (root != NULL && !FT_indexFrom(root)))
+         FT_dropNames();
    }
+   if(sizesWanted)
+      (void) FT_buildSizes();
 
    assert(Checker_FT_isValid(isInitialized,root,count));
-   return result;
-
+   return SUCCESS;
 }
 
-int FT_stat(char *path, boolean* type, size_t* length){
-   Node curr;
+/* see ft.h for specification */
+int FT_thaw(void) {
+   unsigned long start = FT_traceStart();
    int result;
 
+   result = FT_thawUntraced();
+   FT_traceCall(TRACE_THAW, 0, NULL, NULL, 0, result, start);
+   return result;
+}
+
+/* see ft.h for specification */
+boolean FT_exportLouds(const char* filename) {
+   Louds_T louds;
+   FILE* file;
+   boolean result;
+
+   assert(filename != NULL);
    assert(Checker_FT_isValid(isInitialized,root,count));
-   assert(path != NULL);
-   assert(length != NULL);
 
-   if(!isInitialized)
-      return INITIALIZATION_ERROR;
+   if(!isInitialized || frozen != NULL)
+      return FALSE;
 
-   curr = FT_traversePath(path);
-   if(curr == NULL)
-      result =  NO_SUCH_PATH;
-   else{
-      result = SUCCESS;
-      *type = (boolean)Node_getType(curr);
-      if(*type == (boolean)FILE_S) *length = Node_getFileLength(curr);
+   louds = Louds_new(root, count);
+   if(louds == NULL)
+      return FALSE;
+   file = fopen(filename, "wb");
+   if(file == NULL) {
+      Louds_free(louds);
+      return FALSE;
    }
-   assert(Checker_FT_isValid(isInitialized,root,count));
+   result = (boolean) Louds_write(louds, file);
+   if(fclose(file) != 0)
+      result = FALSE;
+   Louds_free(louds);
    return result;
 }
 
 /* see ft.h for specification */
-int FT_init(void) {
-   assert(Checker_FT_isValid(isInitialized,root,count));
-   if(isInitialized)
-      return INITIALIZATION_ERROR;
-   isInitialized = 1;
-   root = NULL;
-   count = 0;
-   assert(Checker_FT_isValid(isInitialized,root,count));
-   return SUCCESS;
+boolean FT_getStats(struct FT_Stats* pStats) {
+   struct Stats total;
+
+   assert(pStats != NULL);
+
+   Stats_sum(&total);
+   pStats->traversals = total.traversals;
+   pStats->nodesVisited = total.nodesVisited;
+   pStats->compares = total.compares;
+   pStats->bytesCompared = total.bytesCompared;
+   pStats->mallocs = total.mallocs;
+   pStats->frees = total.frees;
+   pStats->grows = total.grows;
+   pStats->shifts = total.shifts;
+   pStats->checks = total.checks;
+   pStats->checkerSeconds = total.checkerSeconds;
+#ifdef COLLECT_STATS
+   return TRUE;
+#else
+   return FALSE;
+#endif
 }
 
 /* see ft.h for specification */
-int FT_destroy(void) {
-   assert(Checker_FT_isValid(isInitialized,root,count));
-   if(!isInitialized)
-      return INITIALIZATION_ERROR;
-   FT_removePathFrom(root);
-   root = NULL;
-   isInitialized = 0;
-   assert(Checker_FT_isValid(isInitialized,root,count));
-   return SUCCESS;
+void FT_resetStats(void) {
+   Stats_reset();
 }
 
-/* see ft.h for specification */
-char* FT_toString(void) {
-   DynArray_T nodes;
+/*
+   Does FT_toString without tracing it.
+*/
+static char* FT_toStringUntraced(void) {
+   PathArray_T nodes;
    size_t totalStrlen = 1;
    char* result = NULL;
 
@@ -504,23 +4264,37 @@ char* FT_toString(void) {
 
    if(!isInitialized)
       return NULL;
+   if(frozen != NULL)
+      return Frozen_toString(frozen);
 
-   nodes = DynArray_new(count);
+   nodes = PathArray_new(count);
    (void) FT_preOrderTraversal(root, nodes, 0);
 
-   DynArray_map(nodes, (void (*)(void *, void*)) FT_strlenAccumulate, (void*) &totalStrlen);
+   PathArray_strlenAccumulate(nodes, &totalStrlen);
 
    result = malloc(totalStrlen);
    if(result == NULL) {
-      DynArray_free(nodes);
+      PathArray_free(nodes);
       assert(Checker_FT_isValid(isInitialized,root,count));
       return NULL;
    }
+   STATS_ADD(mallocs, 1);
    *result = '\0';
 
-   DynArray_map(nodes, (void (*)(void *, void*)) FT_strcatAccumulate, (void *) result);
+   PathArray_strcatAccumulate(nodes, result);
 
-   DynArray_free(nodes);
+   PathArray_free(nodes);
    assert(Checker_FT_isValid(isInitialized,root,count));
    return result;
 }
+
+/* see ft.h for specification */
+char* FT_toString(void) {
+   unsigned long start = FT_traceStart();
+   char* result;
+
+   result = FT_toStringUntraced();
+   FT_traceCall(TRACE_TO_STRING, 0, NULL, NULL, 0, result != NULL,
+                start);
+   return result;
+}
@@ -13,24 +13,63 @@
 */
 
 #include <stddef.h>
+#include <stdio.h>
 #include "a4def.h"
 
+/*
+   One component of a parsed path: where it starts in the path string,
+   how many characters it spans, and a hash of those characters.
+*/
+struct FT_PathComponent {
+   size_t offset;
+   size_t length;
+   unsigned long hash;
+};
+
+/*
+   An FT_Path is a path that has been split into its components once,
+   by FT_parsePath, so that it can be handed to the FT_*P variants of
+   the operations below any number of times without being re-scanned.
+   It refers to, but does not copy, the path string and the component
+   array given to FT_parsePath: both must outlive the FT_Path and must
+   not change while it is in use.
+*/
+typedef struct FT_Path {
+   const char* string;
+   size_t numComponents;
+   struct FT_PathComponent* components;
+} FT_Path;
+
+/*
+   Parses path into *pPath, storing one entry per '/'-separated
+   component in the caller-supplied array components, which has room
+   for maxComponents entries. Never allocates memory.
+   Returns SUCCESS if path is parsed, or
+   returns MEMORY_ERROR if path has more than maxComponents components.
+*/
+int FT_parsePath(const char* path, FT_Path* pPath,
+                 struct FT_PathComponent* components,
+                 size_t maxComponents);
+
 /*
    Inserts a new directory into the tree at path, if possible.
    Returns SUCCESS if the new directory is inserted,
    returns INITIALIZATION_ERROR if not in an initialized state,
    returns CONFLICTING_PATH if path is not underneath existing root,
    returns ALREADY_IN_TREE if the path already exists (as dir or file),
+   returns NOT_A_DIRECTORY if a proper prefix of path exists as a file,
    returns PARENT_CHILD_ERROR if a new child cannot be added in path
    returns MEMORY_ERROR if unable to allocate sufficient memory.
 */
 int FT_insertDir(char *path);
+int FT_insertDirP(const FT_Path* path);
 
 /*
   Returns TRUE if the tree contains the full path parameter as a
   directory and FALSE otherwise.
 */
 boolean FT_containsDir(char *path);
+boolean FT_containsDirP(const FT_Path* path);
 
 /*
   Removes the FT hierarchy rooted at the directory path.
@@ -40,6 +79,7 @@ boolean FT_containsDir(char *path);
   Returns NO_SUCH_PATH if the path does not exist in the hierarchy.
 */
 int FT_rmDir(char *path);
+int FT_rmDirP(const FT_Path* path);
 
 /*
    Inserts a new file into the hierarchy at the given path, with the
@@ -49,17 +89,19 @@ int FT_rmDir(char *path);
    returns INITIALIZATION_ERROR if not in an initialized state,
    returns ALREADY_IN_TREE if the path already exists (as dir or file),
    returns NO_SUCH_PATH if the path's parent doesn't exist,
-   returns NOT_A_DIRECTORY if the path's parent exists as a file,
+   returns NOT_A_DIRECTORY if a proper prefix of path exists as a file,
    returns PARENT_CHILD_ERROR if a new child cannot be added in path,
    returns MEMORY_ERROR if unable to allocate sufficient memory.
 */
 int FT_insertFile(char *path, void *contents, size_t length);
+int FT_insertFileP(const FT_Path* path, void *contents, size_t length);
 
 /*
   Returns TRUE if the tree contains the full path parameter as a
   file and FALSE otherwise.
 */
 boolean FT_containsFile(char *path);
+boolean FT_containsFileP(const FT_Path* path);
 
 /*
   Removes the FT file at path.
@@ -69,6 +111,7 @@ boolean FT_containsFile(char *path);
   Returns NO_SUCH_PATH if the path does not exist in the hierarchy.
 */
 int FT_rmFile(char *path);
+int FT_rmFileP(const FT_Path* path);
 
 /*
   Returns the contents of the file at the full path parameter.
@@ -78,15 +121,19 @@ int FT_rmFile(char *path);
   contains check -- the contents of a file may be NULL.
 */
 void *FT_getFileContents(char *path);
+void *FT_getFileContentsP(const FT_Path* path);
 
 /*
   Replaces current contents of the file at the full path parameter with
   the parameter newContents of size newLength.
-  Returns the old contents if successful.
+  Returns the old contents if successful; if the hierarchy owned them
+  (see FT_importDir), they now belong to the caller.
   Returns NULL if the path does not already exist or is a directory.
 */
 void *FT_replaceFileContents(char *path, void *newContents,
                              size_t newLength);
+void *FT_replaceFileContentsP(const FT_Path* path, void *newContents,
+                              size_t newLength);
 
 /*
   Returns SUCCESS if path exists in the hierarchy,
@@ -101,6 +148,525 @@ void *FT_replaceFileContents(char *path, void *newContents,
   When returning a non-SUCCESS status, *type and *length are unchanged.
  */
 int FT_stat(char *path, boolean* type, size_t* length);
+int FT_statP(const FT_Path* path, boolean* type, size_t* length);
+
+/*
+  Each FT_*P function above behaves exactly as its namesake without
+  the P, on the path that was parsed into *path by FT_parsePath.
+*/
+
+/*
+   One entry of a batch for FT_insertBatch: the path to insert, and
+   whether it is a file (TRUE), with the given contents and length, or
+   a directory (FALSE), for which both are ignored.
+*/
+struct FT_BatchEntry {
+   char* path;
+   boolean isFile;
+   void* contents;
+   size_t length;
+};
+
+/*
+  Inserts each of the n entries, in order, as FT_insertFile or
+  FT_insertDir would, stopping at the first that cannot be inserted,
+  and stores in *pDone the number that were.
+  Returns SUCCESS if every entry was inserted, and otherwise the
+  status that inserting the entry at index *pDone returned.
+  A run of entries naming new children of one directory in
+  increasing order -- as a sorted listing has -- is linked into the
+  directory in one pass over its children, rather than one per entry.
+*/
+int FT_insertBatch(const struct FT_BatchEntry* entries, size_t n,
+                   size_t* pDone);
+
+/*
+  Removes the file, or the hierarchy rooted at the directory, at each
+  of the n paths, in order, invalidating any handles open within
+  them, stopping at the first that does not exist, and stores in
+  *pDone the number removed.
+  Returns SUCCESS if every path was removed,
+  returns INITIALIZATION_ERROR if not in an initialized state,
+  returns NO_SUCH_PATH if the path at index *pDone does not exist.
+  A run of paths naming children of one directory in increasing
+  order is unlinked from the directory in one pass over its children.
+*/
+int FT_rmBatch(char** paths, size_t n, size_t* pDone);
+
+/*
+   Options for FT_importDir: the number of threads to scan with (0 for
+   one per online processor); whether to read each file's contents
+   into memory (TRUE) or leave them NULL (FALSE); and, if reading,
+   the most reads to have under way at once (0 for no limit).
+*/
+struct FT_ImportOptions {
+   size_t threads;
+   boolean readContents;
+   size_t maxReads;
+};
+
+/*
+  Inserts the directory tree on disk at fsPath as a new directory at
+  path: one directory or file for each directory or regular file
+  beneath it, each file with its length on disk. Symbolic links and
+  special files are skipped, directories that cannot be listed are
+  left empty, and files that cannot be read get NULL contents.
+  options may be NULL, for the defaults, all 0 or FALSE.
+  The tree is scanned by several threads, then inserted as by
+  FT_insertBatch, each directory's children sorted, so every child
+  array is built in one pass; the trace records those insertions.
+  Contents read are in buffers from malloc that belong to the
+  hierarchy: each is freed when its file is removed or the hierarchy
+  destroyed, unless FT_replaceFileContents has first handed it back to
+  the caller, who then owns it.
+  Returns SUCCESS if the tree was inserted,
+  returns NO_SUCH_PATH if fsPath cannot be opened,
+  returns NOT_A_DIRECTORY if fsPath is not a directory,
+  returns MEMORY_ERROR if unable to allocate sufficient memory,
+  and otherwise the status FT_insertDir(path) returns; on failure
+  the directory at path is not left in the hierarchy.
+*/
+int FT_importDir(const char* fsPath, char* path,
+                 const struct FT_ImportOptions* options);
+
+/*
+  Inserts each file and directory of the tar archive read from fd, in
+  ustar form with pax or GNU long names and sizes, as FT_insertFile
+  and FT_insertDir would, with any leading "/" and "./" removed from
+  its path; directories that already exist are skipped, as are
+  symbolic links and special files. A hard link is inserted as a file
+  whose contents are a copy of those of the file it links to, which
+  must come before it in the archive. The archive is read as it
+  arrives through a fixed-size buffer, each file's contents straight
+  into a buffer from malloc that belongs to the hierarchy, as for
+  FT_importDir. The trace records the insertions.
+  Returns SUCCESS if the archive was read to its end,
+  returns INITIALIZATION_ERROR if not in an initialized state or
+  frozen,
+  returns IO_ERROR if fd cannot be read or the archive is malformed,
+  returns NO_SUCH_PATH if a hard link's target is not in the
+  hierarchy, or NOT_A_FILE if it is a directory,
+  returns MEMORY_ERROR if unable to allocate sufficient memory,
+  and otherwise the status of the first insertion to fail. Either
+  way, the entries before the one that failed stay inserted.
+*/
+int FT_importTar(int fd);
+
+/*
+  Writes the hierarchy rooted at path to fd as a tar archive, in
+  ustar form with pax records for paths and sizes too long for it:
+  each node in the order FT_toString lists them, under its full path,
+  and each file's contents written straight from memory, or zeros if
+  they are NULL. Only fixed-size buffers are used, however large the
+  hierarchy.
+  Returns SUCCESS if the archive was written,
+  returns INITIALIZATION_ERROR if not in an initialized state or
+  frozen,
+  returns NO_SUCH_PATH if path does not exist in the hierarchy,
+  returns IO_ERROR if fd cannot be written,
+  returns MEMORY_ERROR if unable to allocate sufficient memory.
+*/
+int FT_exportTar(int fd, char* path);
+
+/*
+  Inserts the hierarchy described by the length characters of listing
+  in the form FT_toString writes: one full path per line, each node's
+  line before those of its descendants. The first line is inserted as
+  FT_insertDir or FT_insertFile would, and each later line as a child
+  of the nearest line before it that it lies beneath, found from a
+  stack of the directories open along the way rather than by a
+  traversal from the root, and linked into it together with its
+  siblings, so a listing sorted as FT_toString sorts it is read in
+  time linear in its length. A line ending in "/" is a directory, as
+  is a line with another beneath it, and any other line a file with
+  NULL contents; so a listing from FT_toString keeps its types except
+  that empty directories come back as files, unless marked with "/".
+  Blank lines are skipped. The trace records the insertions.
+  Returns SUCCESS if every line was inserted,
+  returns INITIALIZATION_ERROR if not in an initialized state or
+  frozen,
+  returns CONFLICTING_PATH if a line does not lie beneath the first,
+  returns NO_SUCH_PATH if a line's parent does not come before it in
+  pre-order,
+  returns ALREADY_IN_TREE if a line repeats one before it,
+  returns MEMORY_ERROR if unable to allocate sufficient memory,
+  and otherwise the status inserting the first line returned. Either
+  way, the lines before the one that failed stay inserted.
+*/
+int FT_fromListing(const char* listing, size_t length);
+
+/*
+  Does FT_fromListing on the listing read from stream to its end, a
+  fixed-size buffer at a time.
+  Returns IO_ERROR if stream cannot be read, and otherwise as
+  FT_fromListing.
+*/
+int FT_fromListingStream(FILE* stream);
+
+/*
+   An FT_DirHandle names a directory opened with FT_openDir, so that
+   operations relative to it can begin their descent there instead of
+   at the root. A handle becomes invalid, safely, once its directory
+   is removed (directly or with an ancestor), once it is closed, or
+   once the data structure is destroyed: the generation it carries no
+   longer matches, and every operation given it returns NO_SUCH_PATH.
+*/
+typedef struct FT_DirHandle {
+   size_t slot;
+   unsigned long generation;
+} FT_DirHandle;
+
+/*
+   A function called once per node visited by a listing, with the
+   node's full path, whether it is a file (TRUE) or a directory
+   (FALSE), the file's length (0 for a directory), and the pvExtra
+   passed to the listing. Returns TRUE to continue the listing, or
+   FALSE to stop it early.
+*/
+typedef boolean (*FT_ListCallback)(const char* path, boolean isFile,
+                                   size_t length, void* pvExtra);
+
+/*
+  Opens the directory at path and stores a handle to it in *pHandle.
+  Opening the same directory again shares the same handle.
+  Returns SUCCESS if the handle is stored,
+  returns INITIALIZATION_ERROR if not in an initialized state,
+  returns NO_SUCH_PATH if path does not exist in the hierarchy,
+  returns NOT_A_DIRECTORY if path is a file,
+  returns MEMORY_ERROR if unable to allocate sufficient memory.
+*/
+int FT_openDir(char *path, FT_DirHandle* pHandle);
+
+/*
+  Releases one FT_openDir of the directory handle h; the handle
+  becomes invalid once every opener has released it.
+  Returns SUCCESS if released,
+  returns INITIALIZATION_ERROR if not in an initialized state,
+  returns NO_SUCH_PATH if h is no longer valid.
+*/
+int FT_closeDir(FT_DirHandle h);
+
+/*
+  The following operations take a path relative to the directory
+  handle h -- one whose components are looked up starting from h's
+  directory rather than the root -- and otherwise behave as their
+  absolute counterparts do. Each returns NO_SUCH_PATH if h is no
+  longer valid. An empty relative path names h's directory itself.
+*/
+
+/* As FT_insertDir, relative to h. */
+int FT_insertDirAt(FT_DirHandle h, char *path);
+
+/* As FT_insertFile, relative to h. */
+int FT_insertFileAt(FT_DirHandle h, char *path, void *contents,
+                    size_t length);
+
+/* As FT_stat, relative to h. */
+int FT_statAt(FT_DirHandle h, char *path, boolean* type,
+              size_t* length);
+
+/*
+  Removes the file, or the hierarchy rooted at the directory, at path
+  relative to h, invalidating any handles open within it.
+  Returns SUCCESS if found and removed.
+  Returns INITIALIZATION_ERROR if not in an initialized state.
+  Returns NO_SUCH_PATH if h is invalid or the path does not exist.
+*/
+int FT_rmAt(FT_DirHandle h, char *path);
+
+/*
+  Calls pfVisit on each child of the directory at path relative to h,
+  in the order FT_toString lists them, until pfVisit returns FALSE.
+  Returns SUCCESS if the directory was listed,
+  returns INITIALIZATION_ERROR if not in an initialized state,
+  returns NO_SUCH_PATH if h is invalid or the path does not exist,
+  returns NOT_A_DIRECTORY if path is a file.
+*/
+int FT_listAt(FT_DirHandle h, char *path, FT_ListCallback pfVisit,
+              void* pvExtra);
+
+/*
+  Calls pfVisit on each node whose full path matches pattern, in the
+  order FT_toString lists them, until pfVisit returns FALSE; pfVisit
+  must not change the hierarchy. pattern is matched a '/'-separated
+  component at a time: "**" as a whole component matches any number
+  of components, including none, and within a component, '*' matches
+  any run of characters, '?' any one character, "[...]" any one
+  character in the brackets (or with '!' or '^' first, not in them,
+  and with ranges such as a-z), and any other character itself, so
+  "[*]" matches a '*'. The tree is searched from the root down,
+  skipping subtrees that cannot match; where a component starts with
+  literal characters, only the children sharing them are looked at,
+  found by a search of the directory's sorted children.
+  Returns SUCCESS if the hierarchy was searched,
+  returns INITIALIZATION_ERROR if not in an initialized state or
+  frozen,
+  returns MEMORY_ERROR if unable to allocate sufficient memory.
+*/
+int FT_glob(const char* pattern, FT_ListCallback pfVisit,
+            void* pvExtra);
+
+/*
+  Calls pfVisit on at most limit (0 for no limit) children of the
+  directory at path, in the order FT_toString lists them, beginning
+  just after the child named afterName, or at the first child if
+  afterName is NULL, until pfVisit returns FALSE. afterName may be the
+  path pfVisit was last given, of which only the last component is
+  used; it is taken as a directory's name if there is such a
+  directory, or if it ends in "/", and otherwise as a file's, so a
+  page resumes in the right place even if that child has since been
+  removed. The first child is found by a search of the directory's
+  sorted children, so a page costs time in proportion to its length,
+  not the directory's. pfVisit must not change the hierarchy.
+  Returns SUCCESS if the directory was listed,
+  returns INITIALIZATION_ERROR if not in an initialized state or
+  frozen,
+  returns NO_SUCH_PATH if path does not exist in the hierarchy,
+  returns NOT_A_DIRECTORY if path is a file.
+*/
+int FT_listDir(char* path, const char* afterName, size_t limit,
+               FT_ListCallback pfVisit, void* pvExtra);
+
+/*
+  Calls pfVisit on each node whose path is at least fromPath and less
+  than toPath, in order, until pfVisit returns FALSE. Paths are
+  compared a component at a time, each pair of components as names
+  are sorted among siblings, with a path just before those that
+  extend it; so a directory comes right before its descendants, and
+  the range from "a/m" to "a/p" holds what lies beneath "a" from "m"
+  up to but not including "p". Unlike in FT_toString, a directory's
+  files and subdirectories are interleaved by name. fromPath NULL
+  begins at the root, and toPath NULL runs to the end. The first node
+  is found by a search of the sorted children of each directory on
+  the way down to fromPath, so a scan costs time in proportion to the
+  nodes it visits. pfVisit must not change the hierarchy.
+  Returns SUCCESS if the range was scanned,
+  returns INITIALIZATION_ERROR if not in an initialized state or
+  frozen.
+*/
+int FT_scanRange(const char* fromPath, const char* toPath,
+                 FT_ListCallback pfVisit, void* pvExtra);
+
+/*
+  Completes partialPath, a path whose last component, after its last
+  '/', is still being typed: calls pfVisit on at most limit (0 for no
+  limit) of the nodes in the directory it names up to that '/' whose
+  names begin with that last component, in order of name, files and
+  directories together, until pfVisit returns FALSE. A partialPath
+  with no '/' completes the root's name, and one ending in '/' lists
+  the directory. The directory is found by a descent, and the names by
+  a search of each of its sorted runs of children, so a completion
+  costs time in proportion to the depth of partialPath and the matches
+  reported, not to the size of the hierarchy or of the directory.
+  pfVisit must not change the hierarchy.
+  Returns SUCCESS if the completions were listed,
+  returns INITIALIZATION_ERROR if not in an initialized state or
+  frozen,
+  returns NO_SUCH_PATH if the directory does not exist in the
+  hierarchy,
+  returns NOT_A_DIRECTORY if it is a file.
+*/
+int FT_complete(const char* partialPath, size_t limit,
+                FT_ListCallback pfVisit, void* pvExtra);
+
+/*
+  Calls pfVisit on each node whose name, the last component of its
+  path, is name, in no particular order, until pfVisit returns FALSE;
+  pfVisit must not change the hierarchy. With the index of names on
+  (see FT_indexNames), this costs time in proportion to the nodes
+  found; without it, the whole hierarchy is walked.
+  Returns SUCCESS if the hierarchy was searched,
+  returns INITIALIZATION_ERROR if not in an initialized state or
+  frozen.
+*/
+int FT_findByName(const char* name, FT_ListCallback pfVisit,
+                  void* pvExtra);
+
+/*
+  Calls pfVisit on each node whose name ends in extension, such as
+  ".log" or ".tar.gz", and is longer than it, in no particular order,
+  until pfVisit returns FALSE; pfVisit must not change the hierarchy.
+  With the index of names on, only the names sharing extension's part
+  from its last '.' on are looked at, each once however many nodes
+  carry it; an extension with no '.' looks at every distinct name.
+  Without the index, the whole hierarchy is walked.
+  Returns SUCCESS if the hierarchy was searched,
+  returns INITIALIZATION_ERROR if not in an initialized state or
+  frozen.
+*/
+int FT_findByExtension(const char* extension, FT_ListCallback pfVisit,
+                       void* pvExtra);
+
+/*
+  Turns the index of names used by FT_findByName and
+  FT_findByExtension on, building it over the current hierarchy, if
+  enable is TRUE, or off, freeing it, if enable is FALSE. While on, it
+  is kept up to date by every insertion and removal, at a cost
+  proportional to the nodes inserted or removed, and its memory is
+  reported by FT_getNameIndexSize. It is set aside by FT_freeze and
+  rebuilt by FT_thaw, and turned off by FT_destroy. Should an
+  allocation fail while keeping it up to date, the index is dropped
+  rather than the change refused, and the searches walk the
+  hierarchy until it is turned on again.
+  Returns SUCCESS if the index is on or off as asked,
+  returns INITIALIZATION_ERROR if not in an initialized state,
+  returns MEMORY_ERROR, leaving the index off, if unable to allocate
+  sufficient memory.
+*/
+int FT_indexNames(boolean enable);
+
+/*
+  Stores in *pBytes the memory taken by the index of names, not
+  counting the nodes themselves. Returns TRUE if the index is on, and
+  FALSE (having stored 0) otherwise.
+*/
+boolean FT_getNameIndexSize(size_t* pBytes);
+
+/* Flags for FT_grep: report only the first match in each file, and
+   compare ASCII letters without regard to case */
+enum { FT_GREP_FIRST = 1, FT_GREP_IGNORE_CASE = 2 };
+
+/*
+  A function called once per match found by FT_grep, with the full
+  path of the file, the offset in its contents at which the match
+  begins, and the pvExtra passed to FT_grep. Returns TRUE to continue
+  the search, or FALSE to stop it.
+*/
+typedef boolean (*FT_GrepCallback)(const char* path, size_t offset,
+                                   void* pvExtra);
+
+/*
+  Searches the contents of each file in the hierarchy rooted at path,
+  or of the file at path, for the string needle, and calls pfMatch on
+  each place it occurs -- occurrences may overlap -- in the order
+  FT_toString lists the files and then by offset, until pfMatch
+  returns FALSE. flags is 0 or a combination of FT_GREP_FIRST and
+  FT_GREP_IGNORE_CASE. Files with NULL contents are skipped, and an
+  empty needle occurs nowhere. The contents are searched by a pool of
+  one thread per online processor, large files split among them and
+  small ones taken many at a time, while pfMatch is called on the
+  calling thread alone; neither it nor any other thread may change
+  the hierarchy or the files' contents until FT_grep returns.
+  Returns SUCCESS if the contents were searched,
+  returns INITIALIZATION_ERROR if not in an initialized state or
+  frozen,
+  returns NO_SUCH_PATH if path does not exist in the hierarchy,
+  returns MEMORY_ERROR if unable to allocate sufficient memory.
+*/
+int FT_grep(char* path, const char* needle, int flags,
+            FT_GrepCallback pfMatch, void* pvExtra);
+
+/*
+  Calls pfVisit on each of the k largest files in the hierarchy rooted
+  at path, or on the file at path, largest first and those of one
+  length in path order, until pfVisit returns FALSE; pfVisit must not
+  change the hierarchy. With the index of sizes on (see
+  FT_indexSizes), the root's answer is read off the index in O(k log
+  n) time, and a subtree's is found by opening only the directories
+  that may hold a file large enough, with the bound the index keeps
+  on the largest file beneath each; without it, the hierarchy rooted
+  at path is measured first.
+  Returns SUCCESS if the hierarchy was searched,
+  returns INITIALIZATION_ERROR if not in an initialized state or
+  frozen,
+  returns NO_SUCH_PATH if path does not exist in the hierarchy,
+  returns MEMORY_ERROR if unable to allocate sufficient memory.
+*/
+int FT_topKFiles(char* path, size_t k, FT_ListCallback pfVisit,
+                 void* pvExtra);
+
+/*
+  As FT_topKFiles, but for the k directories in the hierarchy rooted
+  at path, path itself included, with the largest total length of the
+  files beneath them, which is what pfVisit is passed as their length.
+  A directory comes before those beneath it of the same total. A file
+  at path has no directories to report.
+*/
+int FT_topKDirs(char* path, size_t k, FT_ListCallback pfVisit,
+                void* pvExtra);
+
+/*
+  Turns the index of sizes used by FT_topKFiles and FT_topKDirs on,
+  building it over the current hierarchy, if enable is TRUE, or off,
+  freeing it, if enable is FALSE. While on, every file and directory
+  is kept in order of size, and each directory's total length and a
+  bound on its largest file are kept, by every insertion, removal and
+  replacement of contents, at a cost of O(d log n) for a change d
+  directories deep. It is set aside by FT_freeze and rebuilt by
+  FT_thaw, and turned off by FT_destroy. Should an allocation fail
+  while keeping it up to date, the index is dropped rather than the
+  change refused, as for FT_indexNames.
+  Returns SUCCESS if the index is on or off as asked,
+  returns INITIALIZATION_ERROR if not in an initialized state,
+  returns MEMORY_ERROR, leaving the index off, if unable to allocate
+  sufficient memory.
+*/
+int FT_indexSizes(boolean enable);
+
+/*
+  Counters of the work done by the FT implementation since the last
+  FT_resetStats, summed over every thread that has used it. They are
+  only collected when the implementation is built with -DCOLLECT_STATS
+  ("make STATS=1"); otherwise every counter stays 0.
+*/
+struct FT_Stats {
+   /* path traversals, and nodes visited by them */
+   unsigned long traversals;
+   unsigned long nodesVisited;
+   /* node and path comparisons, and bytes examined by them */
+   unsigned long compares;
+   unsigned long bytesCompared;
+   /* heap blocks allocated and freed */
+   unsigned long mallocs;
+   unsigned long frees;
+   /* DynArray reallocations on growth, and elements shifted by
+      DynArray_addAt and DynArray_removeAt */
+   unsigned long grows;
+   unsigned long shifts;
+   /* invariant checks run, and seconds spent in them */
+   unsigned long checks;
+   double checkerSeconds;
+};
+
+/*
+  Stores the current counters in *pStats.
+  Returns TRUE if the counters are collected in this build,
+  and FALSE (having stored all zeros) otherwise.
+*/
+boolean FT_getStats(struct FT_Stats* pStats);
+
+/*
+  Sets every counter back to 0.
+*/
+void FT_resetStats(void);
+
+/*
+  Starts recording calls to a binary trace file named filename, each
+  with its arguments, contents length, result, start time and
+  duration, for replay with ft_replay. The calls recorded are those
+  to FT_init, FT_destroy, FT_toString, FT_freeze, FT_thaw,
+  FT_indexNames and FT_indexSizes; to FT_insertDir, FT_insertFile,
+  FT_containsDir, FT_containsFile, FT_rmDir, FT_rmFile, FT_stat,
+  FT_getFileContents and FT_replaceFileContents and their *P
+  variants; to FT_openDir, FT_closeDir, FT_insertDirAt,
+  FT_insertFileAt, FT_statAt, FT_rmAt and FT_listAt; and to
+  FT_insertBatch and FT_rmBatch, each timed as a whole and recorded
+  with its entries. FT_importDir, FT_importTar, FT_fromListing and
+  FT_fromListingStream are recorded as the calls above that they
+  make or stand for. No other call is recorded: the searches,
+  listings and exports, FT_parsePath and the stats functions leave
+  no trace. When not tracing, each call pays only a NULL check.
+  Returns TRUE if the trace file was created, and FALSE if it could
+  not be or a trace is already being recorded.
+*/
+boolean FT_startTrace(const char* filename);
+
+/*
+  Stops recording and closes the trace file.
+  Returns TRUE if every record was written successfully, and FALSE
+  on a write error or if no trace was being recorded.
+*/
+boolean FT_stopTrace(void);
 
 /*
   Sets the data structure to initialized status.
@@ -128,4 +694,46 @@ int FT_destroy(void);
 */
 char *FT_toString(void);
 
+/*
+  Compacts the data structure into a read-only form for a hierarchy
+  that will no longer change: its nodes in one array, with each
+  directory's children adjacent, their names in one pool, and a
+  perfect hash from each full path to its node, so that FT_contains*,
+  FT_stat and FT_getFileContents look a path up with one hash and one
+  comparison of it, however deep it is. FT_toString works as before.
+  Until FT_thaw, every operation that would change the hierarchy, and
+  FT_openDir, returns INITIALIZATION_ERROR (FT_replaceFileContents,
+  NULL), and every directory handle is invalidated.
+  Returns SUCCESS if the data structure was frozen,
+  returns INITIALIZATION_ERROR if not in an initialized state or
+  already frozen,
+  returns MEMORY_ERROR if unable to allocate sufficient memory, in
+  which case it is left as it was.
+*/
+int FT_freeze(void);
+
+/*
+  Converts the data structure frozen by FT_freeze back into its
+  mutable form, with the same paths, types and contents.
+  Returns SUCCESS if the data structure was thawed,
+  returns INITIALIZATION_ERROR if not in an initialized state or not
+  frozen,
+  returns MEMORY_ERROR if unable to allocate sufficient memory, in
+  which case it stays frozen.
+*/
+int FT_thaw(void);
+
+/*
+  Writes the hierarchy to the file filename, replacing it, in the
+  succinct form of louds.h: its shape in about 2 bits per node, one
+  bit per node telling files from directories, the file lengths, and
+  the names, front-coded. File contents are not written. Louds_read
+  loads the file, and answers contains, stat, listing and enumeration
+  directly on that form.
+  Returns TRUE if the file was written, and FALSE if not in an
+  initialized state, frozen, unable to allocate sufficient memory, or
+  unable to write the file.
+*/
+boolean FT_exportLouds(const char* filename);
+
 #endif
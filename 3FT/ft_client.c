@@ -3,12 +3,296 @@
 /* Author: Christopher Moretti                                        */
 /*--------------------------------------------------------------------*/
 
+#define _POSIX_C_SOURCE 200112L
+
 #include <assert.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "ft.h"
+#include "louds.h"
+#include "dynarray.h"
+#include "segarray.h"
+
+/* Counts the children passed to it by FT_listAt in *(size_t*)pvExtra,
+   checking that files come before directories. Returns TRUE. */
+static boolean countChild(const char* path, boolean isFile,
+                          size_t length, void* pvExtra) {
+  static boolean seenDir = FALSE;
+  size_t* pCount = pvExtra;
+
+  assert(path != NULL);
+  if(*pCount == 0)
+    seenDir = FALSE;
+  if(isFile)
+    assert(!seenDir);
+  else
+    seenDir = TRUE;
+  (*pCount)++;
+  return TRUE;
+}
+
+/* Appends path and a newline to the string pvExtra, which must have
+   room for them. Returns TRUE. */
+static boolean appendPath(const char* path, boolean isFile,
+                          size_t length, void* pvExtra) {
+  strcat(pvExtra, path);
+  strcat(pvExtra, "\n");
+  return TRUE;
+}
+
+/* Counts the nodes passed to it in *(size_t*)pvExtra, in any order.
+   Returns TRUE. */
+static boolean countPath(const char* path, boolean isFile,
+                         size_t length, void* pvExtra) {
+  assert(path != NULL);
+  (*(size_t*)pvExtra)++;
+  return TRUE;
+}
+
+/* Appends path, a colon, offset and a newline to the string pvExtra,
+   which must have room for them. Returns TRUE. */
+static boolean appendMatch(const char* path, size_t offset,
+                           void* pvExtra) {
+  sprintf((char*)pvExtra + strlen(pvExtra), "%s:%lu\n", path,
+          (unsigned long)offset);
+  return TRUE;
+}
+
+/* Orders the size_t values at pvKey1 and pvKey2. */
+static int compareKeys(const void* pvKey1, const void* pvKey2) {
+  size_t key1 = *(const size_t*)pvKey1;
+  size_t key2 = *(const size_t*)pvKey2;
+
+  return (key1 > key2) - (key1 < key2);
+}
+
+/* Sorts n keys in the given order -- 0 random, 1 ascending, 2
+   descending, 3 few distinct values, 4 rising then falling -- with
+   DynArray_sortParallel in 3 threads if parallel is TRUE and with
+   DynArray_sort otherwise, and checks the result against qsort. */
+static void checkSort(size_t n, int order, boolean parallel) {
+  size_t* keys = malloc(n * sizeof(size_t));
+  size_t* expected = malloc(n * sizeof(size_t));
+  DynArray_T array = DynArray_new(0);
+  unsigned long random = 217;
+  size_t i;
+
+  assert(keys != NULL && expected != NULL && array != NULL);
+  for(i = 0; i < n; i++) {
+    random = random * 6364136223846793005UL + 1442695040888963407UL;
+    switch(order) {
+      case 0: keys[i] = (size_t)(random >> 20); break;
+      case 1: keys[i] = i; break;
+      case 2: keys[i] = n - i; break;
+      case 3: keys[i] = (size_t)(random >> 20) % 7; break;
+      default: keys[i] = (i < n / 2) ? i : n - i; break;
+    }
+    assert(DynArray_add(array, &keys[i]));
+  }
+  memcpy(expected, keys, n * sizeof(size_t));
+  qsort(expected, n, sizeof(size_t), compareKeys);
+
+  if(parallel)
+    DynArray_sortParallel(array, compareKeys, 3);
+  else
+    DynArray_sort(array, compareKeys);
+  assert(DynArray_getLength(array) == n);
+  for(i = 0; i < n; i++)
+    assert(*(size_t*)DynArray_get(array, i) == expected[i]);
+
+  DynArray_free(array);
+  free(keys);
+  free(expected);
+}
+
+/* The values compareAdversary has given the keys so far, the
+   number it has given, and the value of a key not yet given one */
+static size_t* adversaryValues;
+static size_t adversarySolid;
+static size_t adversaryGas;
+static size_t adversaryCandidate;
+
+/* Orders the keys, indices into adversaryValues, at pvKey1 and
+   pvKey2, as McIlroy's "killer adversary for quicksort" does: a key
+   keeps the largest value until the sort compares it with another
+   such key, and is then given the next smallest value, so that every
+   partition around a pivot is as lopsided as can be. */
+static int compareAdversary(const void* pvKey1, const void* pvKey2) {
+  size_t key1 = *(const size_t*)pvKey1;
+  size_t key2 = *(const size_t*)pvKey2;
+
+  if(adversaryValues[key1] == adversaryGas &&
+     adversaryValues[key2] == adversaryGas)
+    adversaryValues[(key1 == adversaryCandidate) ? key1 : key2] =
+      adversarySolid++;
+  if(adversaryValues[key1] == adversaryGas)
+    adversaryCandidate = key1;
+  else if(adversaryValues[key2] == adversaryGas)
+    adversaryCandidate = key2;
+  return (adversaryValues[key1] > adversaryValues[key2]) -
+    (adversaryValues[key1] < adversaryValues[key2]);
+}
+
+/* Sorts n keys against compareAdversary, which drives the quicksort
+   of DynArray_sort to its depth limit so that heapsort finishes, and
+   checks that they come out in the order of the values it gave. */
+static void checkAdversarialSort(size_t n) {
+  size_t* keys = malloc(n * sizeof(size_t));
+  DynArray_T array = DynArray_new(0);
+  size_t i;
+
+  adversaryValues = malloc(n * sizeof(size_t));
+  assert(keys != NULL && array != NULL && adversaryValues != NULL);
+  adversarySolid = 0;
+  adversaryGas = n;
+  adversaryCandidate = 0;
+  for(i = 0; i < n; i++) {
+    keys[i] = i;
+    adversaryValues[i] = adversaryGas;
+    assert(DynArray_add(array, &keys[i]));
+  }
+
+  DynArray_sort(array, compareAdversary);
+  for(i = 1; i < n; i++)
+    assert(adversaryValues[*(size_t*)DynArray_get(array, i - 1)] <=
+           adversaryValues[*(size_t*)DynArray_get(array, i)]);
+
+  DynArray_free(array);
+  free(keys);
+  free(adversaryValues);
+}
+
+/* Asserts that segments and array hold the same elements, in the
+   same order, and that toArray copies them out of segments. */
+static void checkSameElements(SegArray_T segments, DynArray_T array) {
+  size_t n = DynArray_getLength(array);
+  void** copy = malloc((n + 1) * sizeof(void*));
+  size_t i;
+
+  assert(copy != NULL);
+  assert(SegArray_getLength(segments) == n);
+  assert(SegArray_getCapacity(segments) >= n);
+  SegArray_toArray(segments, copy);
+  for(i = 0; i < n; i++) {
+    assert(SegArray_get(segments, i) == DynArray_get(array, i));
+    assert(copy[i] == DynArray_get(array, i));
+  }
+  free(copy);
+}
+
+/* Applies n random adds, insertions, removals, assignments, reserves
+   and shrinks to a SegArray and a DynArray in step, checking after
+   each that they agree and that a slot taken beforehand still holds
+   its element when nothing was inserted or removed before it, then
+   sorts and searches both. */
+static void checkSegArray(size_t n) {
+  size_t* keys = malloc(n * sizeof(size_t));
+  SegArray_T segments = SegArray_new(0);
+  DynArray_T array = DynArray_new(0);
+  unsigned long random = 4242;
+  size_t i, length, index, segIndex, dynIndex;
+  const void** slot;
+  const void* held;
+  int segFound, dynFound;
+
+  assert(keys != NULL && segments != NULL && array != NULL);
+  for(i = 0; i < n; i++) {
+    random = random * 6364136223846793005UL + 1442695040888963407UL;
+    keys[i] = (size_t)(random >> 33) % (n / 4 + 1);
+    length = DynArray_getLength(array);
+    index = (length == 0) ? 0 : (size_t)(random >> 20) % length;
+    slot = (length == 0) ? NULL : SegArray_slot(segments, index);
+    held = (slot == NULL) ? NULL : *slot;
+    switch((random >> 8) % 8) {
+      case 0: case 1: case 2:
+        assert(SegArray_add(segments, &keys[i]));
+        assert(DynArray_add(array, &keys[i]));
+        break;
+      case 3:
+        assert(SegArray_addAt(segments, index, &keys[i]));
+        assert(DynArray_addAt(array, index, &keys[i]));
+        slot = NULL;
+        break;
+      case 4:
+        if(length != 0) {
+          assert(SegArray_removeAt(segments, index) ==
+                 DynArray_removeAt(array, index));
+          slot = NULL;
+        }
+        break;
+      case 5:
+        if(length != 0) {
+          assert(SegArray_set(segments, index, &keys[i]) ==
+                 DynArray_set(array, index, &keys[i]));
+          held = &keys[i];
+        }
+        break;
+      case 6:
+        assert(SegArray_reserve(segments, length + i % 3000));
+        break;
+      default:
+        SegArray_shrinkToFit(segments);
+        slot = NULL;
+        break;
+    }
+    if(slot != NULL)
+      assert(*slot == held && *slot == DynArray_get(array, index));
+    if(i % 97 == 0)
+      checkSameElements(segments, array);
+  }
+  checkSameElements(segments, array);
+
+  SegArray_sort(segments, compareKeys);
+  DynArray_sort(array, compareKeys);
+  length = DynArray_getLength(array);
+  for(i = 1; i < length; i++)
+    assert(compareKeys(SegArray_get(segments, i - 1),
+                       SegArray_get(segments, i)) <= 0);
+  for(i = 0; i < n; i += 7) {
+    segFound = SegArray_bsearch(segments, &keys[i], &segIndex,
+                                compareKeys);
+    dynFound = DynArray_bsearch(array, &keys[i], &dynIndex,
+                                compareKeys);
+    assert(segFound == dynFound);
+    if(segFound)
+      assert(compareKeys(SegArray_get(segments, segIndex),
+                         &keys[i]) == 0);
+    else
+      assert(segIndex == dynIndex);
+    assert(SegArray_search(segments, &keys[i], &segIndex,
+                           compareKeys) == segFound);
+  }
+
+  SegArray_free(segments);
+  DynArray_free(array);
+  free(keys);
+}
+
+/* Writes to fd a tar archive of one ustar hard link, at path to
+   target. */
+static void writeLinkTar(int fd, const char* path, const char* target) {
+  unsigned char block[1024];
+  unsigned long sum = 0;
+  size_t i;
+
+  memset(block, 0, sizeof(block));
+  strcpy((char*)block, path);
+  strcpy((char*)block + 100, "0000644");
+  strcpy((char*)block + 124, "00000000000");
+  block[156] = '1';
+  strcpy((char*)block + 157, target);
+  memcpy(block + 257, "ustar\00000", 8);
+  memset(block + 148, ' ', 8);
+  for(i = 0; i < 512; i++)
+    sum += block[i];
+  sprintf((char*)block + 148, "%06lo", sum);
+  assert(write(fd, block, sizeof(block)) == (ssize_t)sizeof(block));
+}
 
 /* Tests the FT implementation with an assortment of checks.
    Prints the status of the data structure along the way to stderr.
@@ -17,6 +301,21 @@ int main(void) {
   char* temp;
   boolean b;
   size_t l;
+  FT_Path path;
+  struct FT_PathComponent comps[4];
+  FT_DirHandle h, h2;
+  struct FT_Stats stats;
+  char name[32];
+  char batchNames[300][24];
+  struct FT_BatchEntry entries[300];
+  char* paths[300];
+  char* frozenString;
+  Louds_T louds;
+  FILE* file;
+  struct FT_ImportOptions options;
+  char longPath[160];
+  int fd;
+  int i;
 
   /* Before the data structure is initialized, insert*, remove*,
      and destroy operations should return INITIALIZATION_ERROR, and
@@ -64,6 +363,18 @@ int main(void) {
   assert(FT_insertDir("d/e/f") == CONFLICTING_PATH);
   assert(FT_insertFile("d/D", NULL, 0) == CONFLICTING_PATH);
 
+  /* A file cannot be an ancestor, and a path only matches whole
+     components, so a root named "a" is not a prefix of "ab". */
+  assert(FT_insertFile("a/d/A/B", NULL, 0) == NOT_A_DIRECTORY);
+  assert(FT_insertDir("a/d/A/B") == NOT_A_DIRECTORY);
+  assert(FT_containsFile("a/d/A/B") == FALSE);
+  assert(FT_containsDir("ab") == FALSE);
+  assert(FT_insertDir("ab") == CONFLICTING_PATH);
+  assert(FT_insertFile("a/dd", NULL, 0) == SUCCESS);
+  assert(FT_containsFile("a/dd") == TRUE);
+  assert(FT_containsDir("a/d") == TRUE);
+  assert(FT_rmFile("a/dd") == SUCCESS);
+
   /* Trying to insert a third child should succeed, unlike in BFT*/
   assert(FT_insertDir("a/g") == SUCCESS);
   assert(FT_containsDir("a/g") == TRUE);
@@ -172,6 +483,579 @@ int main(void) {
   fprintf(stderr, "%s\n", temp);
   free(temp);
 
+  /* a parsed path can be reused across operations, and behaves
+     just like the string it was parsed from */
+  assert(FT_parsePath("a/b/c/d/e", &path, comps, 4) == MEMORY_ERROR);
+  assert(FT_parsePath("a/y/CHILD2DIR/P", &path, comps, 4) == SUCCESS);
+  assert(path.numComponents == 4);
+  assert(comps[2].offset == 4 && comps[2].length == 9);
+  assert(FT_containsFileP(&path) == FALSE);
+  assert(FT_insertFileP(&path, "Pike", 5) == SUCCESS);
+  assert(FT_insertFileP(&path, NULL, 0) == ALREADY_IN_TREE);
+  assert(FT_containsFile("a/y/CHILD2DIR/P") == TRUE);
+  assert(FT_containsFileP(&path) == TRUE);
+  assert(FT_containsDirP(&path) == FALSE);
+  assert(FT_statP(&path, &b, &l) == SUCCESS);
+  assert(b == TRUE && l == 5);
+  assert(!strcmp((char*)FT_getFileContentsP(&path), "Pike"));
+  assert(!strcmp((char*)FT_replaceFileContentsP(&path, NULL, 0),
+                 "Pike"));
+  assert(FT_rmDirP(&path) == NOT_A_DIRECTORY);
+  assert(FT_rmFileP(&path) == SUCCESS);
+  assert(FT_rmFileP(&path) == NO_SUCH_PATH);
+  assert(FT_insertDirP(&path) == SUCCESS);
+  assert(FT_rmDirP(&path) == SUCCESS);
+
+  /* operations relative to a directory handle start there, and
+     the handle goes stale once its directory is removed */
+  assert(FT_openDir("a/y/CHILD1FILE", &h) == NOT_A_DIRECTORY);
+  assert(FT_openDir("a/q", &h) == NO_SUCH_PATH);
+  assert(FT_openDir("a/y", &h) == SUCCESS);
+  assert(FT_insertFileAt(h, "CHILD3DIR/Q", "Ken", 4) == SUCCESS);
+  assert(FT_containsFile("a/y/CHILD3DIR/Q") == TRUE);
+  assert(FT_insertFileAt(h, "CHILD3DIR/Q", NULL, 0) == ALREADY_IN_TREE);
+  assert(FT_insertDirAt(h, "CHILD3DIR/R/S") == SUCCESS);
+  assert(FT_statAt(h, "CHILD3DIR/Q", &b, &l) == SUCCESS);
+  assert(b == TRUE && l == 4);
+  assert(FT_statAt(h, "", &b, &l) == SUCCESS);
+  assert(b == FALSE);
+  l = 0;
+  assert(FT_listAt(h, "", countChild, &l) == SUCCESS);
+  assert(l == 5);
+  assert(FT_listAt(h, "CHILD1FILE", countChild, &l) == NOT_A_DIRECTORY);
+  assert(FT_openDir("a/y/CHILD3DIR/R", &h2) == SUCCESS);
+  assert(FT_rmAt(h, "CHILD3DIR") == SUCCESS);
+  assert(FT_statAt(h2, "", &b, &l) == NO_SUCH_PATH);
+  assert(FT_closeDir(h2) == NO_SUCH_PATH);
+  assert(FT_containsDir("a/y/CHILD3DIR") == FALSE);
+  assert(FT_insertDir("a/y/CHILD3DIR") == SUCCESS);
+  assert(FT_openDir("a/y", &h2) == SUCCESS);
+  assert(FT_closeDir(h2) == SUCCESS);
+  assert(FT_rmDir("a/y") == SUCCESS);
+  assert(FT_insertFileAt(h, "Z", NULL, 0) == NO_SUCH_PATH);
+  assert(FT_closeDir(h) == NO_SUCH_PATH);
+  assert(FT_insertDir("a/y") == SUCCESS);
+  assert(FT_rmAt(h, "") == NO_SUCH_PATH);
+
+  /* a directory large enough to change how its children are stored
+     still finds, orders and removes them correctly, both on the way
+     up and on the way back down (build with small thresholds, e.g.
+     -DNODE_INLINE_CHILDREN=1 -DNODE_TREE_CHILDREN=8 -DBTREE_ORDER=4,
+     to take this through every representation) */
+  for(i = 499; i >= 0; i--) {
+    sprintf(name, "a/big/F%04d", i);
+    assert(FT_insertFile(name, NULL, (size_t)i) == SUCCESS);
+  }
+  assert(FT_openDir("a/big", &h) == SUCCESS);
+  assert(FT_insertDirAt(h, "D") == SUCCESS);
+  l = 0;
+  assert(FT_listAt(h, "", countChild, &l) == SUCCESS);
+  assert(l == 501);
+  for(i = 0; i < 500; i += 2) {
+    sprintf(name, "F%04d", i);
+    assert(FT_statAt(h, name, &b, &l) == SUCCESS);
+    assert(b == TRUE && l == (size_t)i);
+    assert(FT_rmAt(h, name) == SUCCESS);
+  }
+  for(i = 1; i < 500; i += 2) {
+    sprintf(name, "a/big/F%04d", i);
+    assert(FT_containsFile(name) == TRUE);
+    if(i > 9)
+      assert(FT_rmFile(name) == SUCCESS);
+  }
+  assert(FT_containsFile("a/big/F0002") == FALSE);
+  assert(FT_containsDir("a/big/D") == TRUE);
+  assert(FT_closeDir(h) == SUCCESS);
+  assert(FT_rmDir("a/big") == SUCCESS);
+
+  /* a batch goes in, or out, entry by entry just as the single
+     operations would, stopping at the first that fails; runs of
+     sorted siblings are linked and unlinked together */
+  sprintf(batchNames[0], "a/batch");
+  for(i = 1; i <= 200; i++)
+    sprintf(batchNames[i], "a/batch/E%04d", i);
+  sprintf(batchNames[201], "a/batch/E0099/x");
+  sprintf(batchNames[202], "a/batch/E0050");
+  for(i = 0; i <= 202; i++) {
+    entries[i].path = batchNames[i];
+    entries[i].isFile = (boolean) (i > 0 && i % 3 != 0);
+    entries[i].contents = NULL;
+    entries[i].length = (size_t) i;
+  }
+  assert(FT_insertBatch(entries, 203, &l) == ALREADY_IN_TREE);
+  assert(l == 202);
+  assert(FT_containsDir("a/batch/E0099") == TRUE);
+  assert(FT_containsDir("a/batch/E0099/x") == TRUE);
+  assert(FT_stat("a/batch/E0200", &b, &l) == SUCCESS);
+  assert(b == TRUE && l == 200);
+  for(i = 0; i < 100; i++) {
+    sprintf(batchNames[i], "a/batch/E%04dx", 2 * i + 1);
+    entries[i].path = batchNames[i];
+    entries[i].isFile = TRUE;
+  }
+  assert(FT_insertBatch(entries, 100, &l) == SUCCESS);
+  assert(l == 100);
+  assert(FT_openDir("a/batch", &h) == SUCCESS);
+  l = 0;
+  assert(FT_listAt(h, "", countChild, &l) == SUCCESS);
+  assert(l == 300);
+  assert(FT_openDir("a/batch/E0012", &h2) == SUCCESS);
+  for(i = 0; i < 50; i++) {
+    sprintf(batchNames[i], "a/batch/E%04d", i + 10);
+    paths[i] = batchNames[i];
+  }
+  paths[50] = batchNames[0];
+  assert(FT_rmBatch(paths, 51, &l) == NO_SUCH_PATH);
+  assert(l == 50);
+  assert(FT_closeDir(h2) == NO_SUCH_PATH);
+  assert(FT_containsFile("a/batch/E0010") == FALSE);
+  assert(FT_containsFile("a/batch/E0011x") == TRUE);
+  assert(FT_containsFile("a/batch/E0060") == FALSE);
+  l = 0;
+  assert(FT_listAt(h, "", countChild, &l) == SUCCESS);
+  assert(l == 250);
+  paths[0] = "a/batch";
+  assert(FT_rmBatch(paths, 1, &l) == SUCCESS);
+  assert(l == 1);
+  assert(FT_closeDir(h) == NO_SUCH_PATH);
+  assert(FT_containsDir("a/batch") == FALSE);
+
+  /* a frozen tree answers every read as the mutable one did, however
+     its paths are spelled, but refuses writes and handles until it
+     is thawed, which restores it unchanged */
+  assert(FT_insertDir("a/frozen/d") == SUCCESS);
+  assert(FT_insertFile("a/frozen/f", name, 5) == SUCCESS);
+  assert(FT_openDir("a/frozen", &h) == SUCCESS);
+  assert(FT_thaw() == INITIALIZATION_ERROR);
+  temp = FT_toString();
+  assert(temp != NULL);
+  assert(FT_freeze() == SUCCESS);
+  assert(FT_freeze() == INITIALIZATION_ERROR);
+  assert(FT_closeDir(h) == NO_SUCH_PATH);
+  frozenString = FT_toString();
+  assert(frozenString != NULL && strcmp(frozenString, temp) == 0);
+  free(frozenString);
+  assert(FT_containsDir("a/frozen") == TRUE);
+  assert(FT_containsDir("/a//frozen/d/") == TRUE);
+  assert(FT_containsFile("a/frozen/d") == FALSE);
+  assert(FT_containsFile("a/frozen/f") == TRUE);
+  assert(FT_containsDir("a/frozen/g") == FALSE);
+  assert(FT_containsDir("frozen/d") == FALSE);
+  assert(FT_containsDir("") == FALSE);
+  assert(FT_getFileContents("a/frozen/f") == name);
+  assert(FT_getFileContents("a/frozen") == NULL);
+  assert(FT_stat("a/frozen/f", &b, &l) == SUCCESS);
+  assert(b == TRUE && l == 5);
+  assert(FT_stat("a/frozen/x", &b, &l) == NO_SUCH_PATH);
+  assert(FT_parsePath("a/frozen/f", &path, comps, 4) == SUCCESS);
+  assert(FT_containsFileP(&path) == TRUE);
+  assert(FT_insertDir("a/frozen/e") == INITIALIZATION_ERROR);
+  assert(FT_rmFile("a/frozen/f") == INITIALIZATION_ERROR);
+  assert(FT_replaceFileContents("a/frozen/f", NULL, 0) == NULL);
+  assert(FT_openDir("a", &h) == INITIALIZATION_ERROR);
+  assert(FT_thaw() == SUCCESS);
+  frozenString = FT_toString();
+  assert(frozenString != NULL && strcmp(frozenString, temp) == 0);
+  free(frozenString);
+  free(temp);
+  assert(FT_getFileContents("a/frozen/f") == name);
+  assert(FT_insertDir("a/frozen/e") == SUCCESS);
+  assert(FT_rmDir("a/frozen") == SUCCESS);
+
+  /* a LOUDS export, read back, answers the same reads and lists the
+     same paths as the tree it was written from */
+  assert(FT_insertDir("a/louds/d") == SUCCESS);
+  assert(FT_insertFile("a/louds/f", name, 5) == SUCCESS);
+  assert(FT_exportLouds("ft_client.louds") == TRUE);
+  file = fopen("ft_client.louds", "rb");
+  assert(file != NULL);
+  louds = Louds_read(file);
+  assert(fclose(file) == 0);
+  assert(louds != NULL);
+  assert(Louds_containsDir(louds, "a/louds") == TRUE);
+  assert(Louds_containsDir(louds, "/a//louds/d/") == TRUE);
+  assert(Louds_containsFile(louds, "a/louds/d") == FALSE);
+  assert(Louds_containsFile(louds, "a/louds/f") == TRUE);
+  assert(Louds_containsDir(louds, "a/louds/g") == FALSE);
+  assert(Louds_stat(louds, "a/louds/f", &b, &l) == SUCCESS);
+  assert(b == TRUE && l == 5);
+  assert(Louds_stat(louds, "louds/f", &b, &l) == NO_SUCH_PATH);
+  l = 0;
+  assert(Louds_list(louds, "a/louds", countChild, &l) == SUCCESS);
+  assert(l == 2);
+  assert(Louds_list(louds, "a/louds/f", countChild, &l) ==
+         NOT_A_DIRECTORY);
+  temp = FT_toString();
+  assert(temp != NULL);
+  frozenString = calloc(strlen(temp) + 1, 1);
+  assert(frozenString != NULL);
+  assert(Louds_enumerate(louds, appendPath, frozenString) == SUCCESS);
+  assert(strcmp(frozenString, temp) == 0);
+  free(frozenString);
+  free(temp);
+  Louds_free(louds);
+  assert(remove("ft_client.louds") == 0);
+  assert(FT_freeze() == SUCCESS);
+  assert(FT_exportLouds("ft_client.louds") == FALSE);
+  assert(FT_thaw() == SUCCESS);
+  assert(FT_rmDir("a/louds") == SUCCESS);
+
+  /* importing a directory from disk mirrors its tree, with each
+     file's length and, if asked for, its contents */
+  assert(mkdir("ft_client.dir", 0700) == 0);
+  assert(mkdir("ft_client.dir/sub", 0700) == 0);
+  file = fopen("ft_client.dir/sub/f", "wb");
+  assert(file != NULL);
+  assert(fputs("abc", file) >= 0);
+  assert(fclose(file) == 0);
+  options.threads = 2;
+  options.readContents = TRUE;
+  options.maxReads = 1;
+  assert(FT_importDir("ft_client.dir/none", "a/imported", &options) ==
+         NO_SUCH_PATH);
+  assert(FT_importDir("ft_client.dir/sub/f", "a/imported", NULL) ==
+         NOT_A_DIRECTORY);
+  assert(FT_containsDir("a/imported") == FALSE);
+  assert(FT_importDir("ft_client.dir", "a/imported", &options) ==
+         SUCCESS);
+  assert(FT_containsDir("a/imported/sub") == TRUE);
+  assert(FT_stat("a/imported/sub/f", &b, &l) == SUCCESS);
+  assert(b == TRUE && l == 3);
+  temp = FT_getFileContents("a/imported/sub/f");
+  assert(temp != NULL && strncmp(temp, "abc", 3) == 0);
+  /* the contents it read are the hierarchy's until a replacement
+     hands them back, and are not read unless asked for */
+  temp = FT_replaceFileContents("a/imported/sub/f", NULL, 0);
+  assert(temp != NULL && strncmp(temp, "abc", 3) == 0);
+  free(temp);
+  assert(FT_rmDir("a/imported") == SUCCESS);
+  options.readContents = FALSE;
+  assert(FT_importDir("ft_client.dir", "a/imported", &options) ==
+         SUCCESS);
+  assert(FT_stat("a/imported/sub/f", &b, &l) == SUCCESS);
+  assert(b == TRUE && l == 3);
+  assert(FT_getFileContents("a/imported/sub/f") == NULL);
+  assert(FT_importDir("ft_client.dir", "a/imported", NULL) ==
+         ALREADY_IN_TREE);
+  assert(FT_rmDir("a/imported") == SUCCESS);
+  assert(remove("ft_client.dir/sub/f") == 0);
+  assert(rmdir("ft_client.dir/sub") == 0);
+  assert(rmdir("ft_client.dir") == 0);
+
+  /* a tar export, even of paths too long for a ustar header, imports
+     back as the same hierarchy */
+  assert(FT_insertFile("a/tar/f", name, 5) == SUCCESS);
+  strcpy(longPath, "a/tar/");
+  memset(longPath + 6, 'y', 60);
+  longPath[66] = '/';
+  memset(longPath + 67, 'z', 60);
+  longPath[127] = '\0';
+  assert(FT_insertDir(longPath) == SUCCESS);
+  memset(longPath + 6, 'x', 120);
+  longPath[126] = '\0';
+  assert(FT_insertFile(longPath, NULL, 0) == SUCCESS);
+  fd = open("ft_client.tar", O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  assert(fd >= 0);
+  assert(FT_exportTar(fd, "a/none") == NO_SUCH_PATH);
+  assert(FT_exportTar(fd, "a/tar") == SUCCESS);
+  assert(close(fd) == 0);
+  temp = FT_toString();
+  assert(temp != NULL);
+  assert(FT_rmDir("a/tar") == SUCCESS);
+  fd = open("ft_client.tar", O_RDONLY);
+  assert(fd >= 0);
+  assert(FT_importTar(fd) == SUCCESS);
+  assert(close(fd) == 0);
+  frozenString = FT_toString();
+  assert(frozenString != NULL && strcmp(frozenString, temp) == 0);
+  free(frozenString);
+  free(temp);
+  /* the imported contents are the hierarchy's, through a freeze and
+     thaw, until handed back by a replacement */
+  assert(FT_freeze() == SUCCESS);
+  assert(FT_thaw() == SUCCESS);
+  temp = FT_replaceFileContents("a/tar/f", NULL, 0);
+  assert(temp != NULL && temp != name && memcmp(temp, name, 5) == 0);
+  free(temp);
+  assert(FT_containsFile(longPath) == TRUE);
+  /* a hard link imports as a copy of the file it links to */
+  fd = open("ft_client.tar", O_WRONLY | O_TRUNC);
+  assert(fd >= 0);
+  writeLinkTar(fd, "a/tar/h", "./a/tar/f");
+  assert(close(fd) == 0);
+  assert(FT_replaceFileContents("a/tar/f", name, 5) == NULL);
+  fd = open("ft_client.tar", O_RDONLY);
+  assert(fd >= 0);
+  assert(FT_importTar(fd) == SUCCESS);
+  assert(close(fd) == 0);
+  temp = FT_getFileContents("a/tar/h");
+  assert(temp != NULL && temp != name && memcmp(temp, name, 5) == 0);
+  assert(FT_rmFile("a/tar/h") == SUCCESS);
+  fd = open("ft_client.tar", O_WRONLY | O_TRUNC);
+  assert(fd >= 0);
+  writeLinkTar(fd, "a/tar/h", "a/tar/none");
+  assert(close(fd) == 0);
+  fd = open("ft_client.tar", O_RDONLY);
+  assert(fd >= 0);
+  assert(FT_importTar(fd) == NO_SUCH_PATH);
+  assert(close(fd) == 0);
+  assert(FT_containsFile("a/tar/h") == FALSE);
+  assert(FT_importTar(-1) == IO_ERROR);
+  assert(FT_rmDir("a/tar") == SUCCESS);
+  assert(remove("ft_client.tar") == 0);
+
+  /* a listing is read back in one pass, lines with lines beneath them
+     and lines ending in "/" as directories, even out of order */
+  strcpy(longPath, "a/list\na/list/f\na/list/d\na/list/d/e/\n"
+         "a/list/d/b\na/list/g\n");
+  assert(FT_fromListing(longPath, strlen(longPath)) == SUCCESS);
+  assert(FT_containsFile("a/list/f") == TRUE);
+  assert(FT_containsFile("a/list/g") == TRUE);
+  assert(FT_containsDir("a/list/d/e") == TRUE);
+  assert(FT_containsFile("a/list/d/b") == TRUE);
+  assert(FT_fromListing(longPath, strlen(longPath)) == ALREADY_IN_TREE);
+  temp = FT_toString();
+  assert(temp != NULL);
+  assert(FT_rmDir("a/list") == SUCCESS);
+  file = tmpfile();
+  assert(file != NULL);
+  assert(fputs(longPath, file) >= 0);
+  rewind(file);
+  assert(FT_fromListingStream(file) == SUCCESS);
+  assert(fclose(file) == 0);
+  frozenString = FT_toString();
+  assert(frozenString != NULL && strcmp(frozenString, temp) == 0);
+  free(frozenString);
+  free(temp);
+  assert(FT_fromListing("a/list2\nb/x", 11) == CONFLICTING_PATH);
+  assert(FT_containsFile("a/list2") == TRUE);
+  assert(FT_fromListing("a/list3\na/list3/x/y", 19) == NO_SUCH_PATH);
+  assert(FT_containsDir("a/list3") == TRUE);
+  assert(FT_fromListing("a/list4\na/list4/f\na/list4/f", 27) ==
+         ALREADY_IN_TREE);
+  assert(FT_rmDir("a/list") == SUCCESS);
+  assert(FT_rmFile("a/list2") == SUCCESS);
+  assert(FT_rmDir("a/list3") == SUCCESS);
+  assert(FT_rmDir("a/list4") == SUCCESS);
+
+  /* globbing walks only the subtrees a pattern can match */
+  strcpy(longPath, "a/glob\na/glob/x.c\na/glob/y.h\na/glob/src\n"
+         "a/glob/src/m.c\na/glob/src/lib\na/glob/src/lib/u.c\n");
+  assert(FT_fromListing(longPath, strlen(longPath)) == SUCCESS);
+  *longPath = '\0';
+  assert(FT_glob("a/glob/**/*.c", appendPath, longPath) == SUCCESS);
+  assert(strcmp(longPath, "a/glob/x.c\na/glob/src/m.c\n"
+                "a/glob/src/lib/u.c\n") == 0);
+  *longPath = '\0';
+  assert(FT_glob("a/*/s[q-s]?/[!a-k]*", appendPath, longPath) ==
+         SUCCESS);
+  assert(strcmp(longPath, "a/glob/src/m.c\na/glob/src/lib\n") == 0);
+  l = 0;
+  assert(FT_glob("a/glob/nothing*", countChild, &l) == SUCCESS);
+  assert(l == 0);
+
+  /* a directory lists a page at a time, and a range of paths scans
+     in path order, files and directories interleaved */
+  *longPath = '\0';
+  assert(FT_listDir("a/glob", NULL, 2, appendPath, longPath) ==
+         SUCCESS);
+  assert(strcmp(longPath, "a/glob/x.c\na/glob/y.h\n") == 0);
+  assert(FT_listDir("a/glob", "a/glob/y.h", 2, appendPath, longPath) ==
+         SUCCESS);
+  assert(strcmp(longPath, "a/glob/x.c\na/glob/y.h\na/glob/src\n") == 0);
+  *longPath = '\0';
+  assert(FT_listDir("a/glob", "removed", 0, appendPath, longPath) ==
+         SUCCESS);
+  assert(strcmp(longPath, "a/glob/x.c\na/glob/y.h\na/glob/src\n") == 0);
+  *longPath = '\0';
+  assert(FT_listDir("a/glob", "removed/", 0, appendPath, longPath) ==
+         SUCCESS);
+  assert(strcmp(longPath, "a/glob/src\n") == 0);
+  assert(FT_listDir("a/glob/x.c", NULL, 0, appendPath, longPath) ==
+         NOT_A_DIRECTORY);
+  assert(FT_listDir("a/none", NULL, 0, appendPath, longPath) ==
+         NO_SUCH_PATH);
+  *longPath = '\0';
+  assert(FT_scanRange("a/glob/src", "a/glob/x.c", appendPath,
+                      longPath) == SUCCESS);
+  assert(strcmp(longPath, "a/glob/src\na/glob/src/lib\n"
+                "a/glob/src/lib/u.c\na/glob/src/m.c\n") == 0);
+
+  /* completions take files and directories together, by name */
+  assert(FT_insertFile("a/comp/make", NULL, 0) == SUCCESS);
+  assert(FT_insertDir("a/comp/main") == SUCCESS);
+  assert(FT_insertFile("a/comp/mz", NULL, 0) == SUCCESS);
+  assert(FT_insertFile("a/comp/x", NULL, 0) == SUCCESS);
+  *longPath = '\0';
+  assert(FT_complete("a/comp/ma", 0, appendPath, longPath) == SUCCESS);
+  assert(strcmp(longPath, "a/comp/main\na/comp/make\n") == 0);
+  *longPath = '\0';
+  assert(FT_complete("a/comp/", 3, appendPath, longPath) == SUCCESS);
+  assert(strcmp(longPath, "a/comp/main\na/comp/make\na/comp/mz\n")
+         == 0);
+  *longPath = '\0';
+  assert(FT_complete("a/comp/main", 0, appendPath, longPath) ==
+         SUCCESS);
+  assert(strcmp(longPath, "a/comp/main\n") == 0);
+  *longPath = '\0';
+  assert(FT_complete("a/com", 0, appendPath, longPath) == SUCCESS);
+  assert(strcmp(longPath, "a/comp\n") == 0);
+  *longPath = '\0';
+  assert(FT_complete("", 0, appendPath, longPath) == SUCCESS);
+  assert(strcmp(longPath, "a\n") == 0);
+  assert(FT_complete("a/none/m", 0, appendPath, longPath) ==
+         NO_SUCH_PATH);
+  assert(FT_complete("a/comp/x/", 0, appendPath, longPath) ==
+         NOT_A_DIRECTORY);
+  assert(FT_rmDir("a/comp") == SUCCESS);
+
+  /* names and extensions are found by a walk, or by the index of
+     names, which follows inserts and removals */
+  l = 0;
+  assert(FT_findByExtension(".c", countPath, &l) == SUCCESS);
+  assert(l == 3);
+  l = 0;
+  assert(FT_findByExtension("c", countPath, &l) == SUCCESS);
+  assert(l == 4);
+  assert(FT_getNameIndexSize(&l) == FALSE && l == 0);
+  assert(FT_indexNames(TRUE) == SUCCESS);
+  assert(FT_getNameIndexSize(&l) == TRUE && l > 0);
+  l = 0;
+  assert(FT_findByExtension(".c", countPath, &l) == SUCCESS);
+  assert(l == 3);
+  l = 0;
+  assert(FT_findByExtension("c", countPath, &l) == SUCCESS);
+  assert(l == 4);
+  assert(FT_insertFile("a/glob/src/lib/x.c", NULL, 0) == SUCCESS);
+  *longPath = '\0';
+  assert(FT_findByName("u.c", appendPath, longPath) == SUCCESS);
+  assert(strcmp(longPath, "a/glob/src/lib/u.c\n") == 0);
+  l = 0;
+  assert(FT_findByName("x.c", countPath, &l) == SUCCESS);
+  assert(l == 2);
+  assert(FT_rmDir("a/glob/src") == SUCCESS);
+  l = 0;
+  assert(FT_findByExtension(".c", countPath, &l) == SUCCESS);
+  assert(l == 1);
+  l = 0;
+  assert(FT_findByName("lib", countPath, &l) == SUCCESS);
+  assert(l == 0);
+  assert(FT_indexNames(FALSE) == SUCCESS);
+  assert(FT_getNameIndexSize(&l) == FALSE);
+  assert(FT_rmDir("a/glob") == SUCCESS);
+
+  /* contents are searched in listing order, then by offset */
+  assert(FT_insertFile("a/grep/b", "key=aaa, KEY=b", 14) == SUCCESS);
+  assert(FT_insertFile("a/grep/a/x", "no match", 8) == SUCCESS);
+  assert(FT_insertFile("a/grep/c", "aaaa", 4) == SUCCESS);
+  assert(FT_insertFile("a/grep/d", NULL, 0) == SUCCESS);
+  *longPath = '\0';
+  assert(FT_grep("a/grep", "aa", 0, appendMatch, longPath) == SUCCESS);
+  assert(strcmp(longPath, "a/grep/b:4\na/grep/b:5\na/grep/c:0\n"
+                "a/grep/c:1\na/grep/c:2\n") == 0);
+  *longPath = '\0';
+  assert(FT_grep("a/grep", "key=", FT_GREP_IGNORE_CASE, appendMatch,
+                 longPath) == SUCCESS);
+  assert(strcmp(longPath, "a/grep/b:0\na/grep/b:9\n") == 0);
+  *longPath = '\0';
+  assert(FT_grep("a/grep/c", "a", FT_GREP_FIRST, appendMatch,
+                 longPath) == SUCCESS);
+  assert(strcmp(longPath, "a/grep/c:0\n") == 0);
+  assert(FT_grep("a/grep/none", "a", 0, appendMatch, longPath) ==
+         NO_SUCH_PATH);
+  assert(FT_rmDir("a/grep") == SUCCESS);
+
+  /* the largest files and directories come largest first, found by
+     measuring or by the index of sizes, which follows changes */
+  assert(FT_insertFile("a/size/big", "0123456789", 10) == SUCCESS);
+  assert(FT_insertFile("a/size/d/mid", "01234", 5) == SUCCESS);
+  assert(FT_insertFile("a/size/d/e/small", "012", 3) == SUCCESS);
+  assert(FT_insertFile("a/size/f/tie", "01234", 5) == SUCCESS);
+  *longPath = '\0';
+  assert(FT_topKFiles("a/size", 3, appendPath, longPath) == SUCCESS);
+  assert(strcmp(longPath, "a/size/big\na/size/d/mid\na/size/f/tie\n")
+         == 0);
+  *longPath = '\0';
+  assert(FT_topKDirs("a/size", 2, appendPath, longPath) == SUCCESS);
+  assert(strcmp(longPath, "a/size\na/size/d\n") == 0);
+  assert(FT_indexSizes(TRUE) == SUCCESS);
+  assert(FT_replaceFileContents("a/size/d/e/small", "0123456789ab",
+                                12) != NULL);
+  *longPath = '\0';
+  assert(FT_topKFiles("a/size", 2, appendPath, longPath) == SUCCESS);
+  assert(strcmp(longPath, "a/size/d/e/small\na/size/big\n") == 0);
+  *longPath = '\0';
+  assert(FT_topKDirs("a/size/d", 5, appendPath, longPath) == SUCCESS);
+  assert(strcmp(longPath, "a/size/d\na/size/d/e\n") == 0);
+  assert(FT_rmDir("a/size/d/e") == SUCCESS);
+  *longPath = '\0';
+  assert(FT_topKFiles("a/size/d", 5, appendPath, longPath) == SUCCESS);
+  assert(strcmp(longPath, "a/size/d/mid\n") == 0);
+  assert(FT_insertFile("a/size/huge", NULL, 1000000) == SUCCESS);
+  *longPath = '\0';
+  assert(FT_topKFiles("a", 1, appendPath, longPath) == SUCCESS);
+  assert(strcmp(longPath, "a/size/huge\n") == 0);
+  *longPath = '\0';
+  assert(FT_topKDirs("a", 2, appendPath, longPath) == SUCCESS);
+  assert(strcmp(longPath, "a\na/size\n") == 0);
+  assert(FT_topKFiles("a/none", 1, appendPath, longPath) ==
+         NO_SUCH_PATH);
+  assert(FT_indexSizes(FALSE) == SUCCESS);
+  assert(FT_rmDir("a/size") == SUCCESS);
+
+  /* Tracing is opt-in and one trace at a time */
+  assert(FT_stopTrace() == FALSE);
+  assert(FT_startTrace("ft_client.trace") == TRUE);
+  assert(FT_startTrace("ft_client.trace") == FALSE);
+  assert(FT_insertFile("a/y/z/traced", NULL, 0) == SUCCESS);
+  assert(FT_rmFile("a/y/z/traced") == SUCCESS);
+  assert(FT_stopTrace() == TRUE);
+  assert(FT_stopTrace() == FALSE);
+  assert(remove("ft_client.trace") == 0);
+
+  /* Sorts, in one thread or in several for a long array, order any
+     input as qsort does */
+  for(i = 0; i < 5; i++) {
+    checkSort(1000, i, FALSE);
+    checkSort(100000, i, TRUE);
+  }
+  checkAdversarialSort(10000);
+
+  /* A SegArray behaves as a DynArray, and its slots stay put */
+  checkSegArray(20000);
+
+  /* The stats counters only move when compiled in */
+  FT_resetStats();
+  if(FT_getStats(&stats)) {
+    assert(stats.traversals == 0 && stats.mallocs == 0);
+    assert(FT_insertFile("a/y/z/stat", NULL, 0) == SUCCESS);
+    assert(FT_containsFile("a/y/z/stat") == TRUE);
+    assert(FT_getStats(&stats));
+    assert(stats.traversals >= 2 && stats.nodesVisited >= 4);
+    assert(stats.compares > 0 && stats.bytesCompared > 0);
+    assert(stats.mallocs >= 2 && stats.checks > 0);
+    assert(FT_rmFile("a/y/z/stat") == SUCCESS);
+    FT_resetStats();
+    assert(FT_getStats(&stats) && stats.compares == 0);
+  }
+  else
+    assert(stats.traversals == 0 && stats.checkerSeconds == 0);
+
+  /* a frozen hierarchy holds the contents an import gave the Nodes,
+     so destroying it while frozen still frees them */
+  assert(mkdir("ft_client.dir", 0700) == 0);
+  file = fopen("ft_client.dir/f", "wb");
+  assert(file != NULL);
+  assert(fputs("xyz", file) >= 0);
+  assert(fclose(file) == 0);
+  options.readContents = TRUE;
+  assert(FT_importDir("ft_client.dir", "a/owned", &options) == SUCCESS);
+  assert(remove("ft_client.dir/f") == 0);
+  assert(rmdir("ft_client.dir") == 0);
+  assert(FT_freeze() == SUCCESS);
+  temp = FT_getFileContents("a/owned/f");
+  assert(temp != NULL && strncmp(temp, "xyz", 3) == 0);
+
   assert(FT_destroy() == SUCCESS);
   assert(FT_destroy() == INITIALIZATION_ERROR);
   assert(FT_containsDir("a") == FALSE);
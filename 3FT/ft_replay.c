@@ -0,0 +1,441 @@
+/*--------------------------------------------------------------------*/
+/* ft_replay.c                                                        */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ft.h"
+#include "trace.h"
+
+/*
+   Replays a trace recorded with FT_startTrace against the FT
+   implementation it is linked with, checking that every call returns
+   the same result as when it was recorded, and reports throughput and
+   per-function latency percentiles, replayed beside recorded.
+
+   usage: ft_replay [--paced] [--format=text|csv] tracefile
+
+   By default calls are issued back to back, as fast as possible; with
+   --paced each is issued at its recorded offset from the first.
+   Exits 0 if every result matched, 1 if any differed, and 2 if the
+   trace could not be read.
+*/
+
+/* The most mismatches printed individually */
+enum { MAX_REPORTED_MISMATCHES = 10 };
+
+/* The latencies of every replayed call to one function, and of the
+   same calls as recorded */
+struct Samples {
+   unsigned long* replayed;
+   unsigned long* recorded;
+   size_t n;
+   size_t cap;
+};
+
+static struct Samples samples[TRACE_NUM_OPS];
+
+/* A recorded handle and the handle its FT_openDir returned on
+   replay */
+struct HandleMapping {
+   unsigned long slot;
+   unsigned long generation;
+   FT_DirHandle handle;
+};
+
+static struct HandleMapping* handles;
+static size_t numHandles;
+static size_t capHandles;
+
+/* The stand-in for all non-NULL file contents */
+static char contents[1];
+
+/* The entries of the batch being replayed, and their paths alone,
+   for FT_rmBatch */
+static struct FT_BatchEntry* batch;
+static char** batchPaths;
+static size_t numBatch;
+static size_t capBatch;
+
+/*--------------------------------------------------------------------*/
+
+/* Exits with a message if p is NULL; returns p otherwise. */
+static void* Replay_check(void* p) {
+   if(p == NULL) {
+      fprintf(stderr, "ft_replay: out of memory\n");
+      exit(2);
+   }
+   return p;
+}
+
+/* Records that a call to op took replayed ns, and recorded ns when it
+   was traced. */
+static void Replay_record(int op, unsigned long replayed,
+                          unsigned long recorded) {
+   struct Samples* s = &samples[op];
+
+   if(s->n == s->cap) {
+      s->cap = (s->cap == 0) ? 1024 : 2 * s->cap;
+      s->replayed = Replay_check(realloc(s->replayed,
+                                         s->cap * sizeof(unsigned long)));
+      s->recorded = Replay_check(realloc(s->recorded,
+                                         s->cap * sizeof(unsigned long)));
+   }
+   s->replayed[s->n] = replayed;
+   s->recorded[s->n] = recorded;
+   s->n++;
+}
+
+/* Orders unsigned longs for qsort. */
+static int Replay_compare(const void* a, const void* b) {
+   unsigned long x = *(const unsigned long*)a;
+   unsigned long y = *(const unsigned long*)b;
+   return (x < y) ? -1 : (x > y);
+}
+
+/* Returns the q'th quantile of the n sorted values in v. */
+static unsigned long Replay_quantile(const unsigned long* v, size_t n,
+                                     double q) {
+   assert(n > 0);
+   return v[(size_t)(q * (double)(n - 1) + 0.5)];
+}
+
+/* Remembers that the handle recorded as slot/generation was replayed
+   as h. */
+static void Replay_mapHandle(unsigned long slot,
+                             unsigned long generation, FT_DirHandle h) {
+   if(numHandles == capHandles) {
+      capHandles = (capHandles == 0) ? 16 : 2 * capHandles;
+      handles = Replay_check(realloc(handles,
+                                     capHandles * sizeof(*handles)));
+   }
+   handles[numHandles].slot = slot;
+   handles[numHandles].generation = generation;
+   handles[numHandles].handle = h;
+   numHandles++;
+}
+
+/* Returns the replayed handle for the handle recorded as
+   slot/generation, or, if it was never returned by a replayed
+   FT_openDir, that handle itself. */
+static FT_DirHandle Replay_handle(unsigned long slot,
+                                  unsigned long generation) {
+   FT_DirHandle h;
+   size_t i;
+
+   for(i = numHandles; i > 0; i--)
+      if(handles[i - 1].slot == slot &&
+         handles[i - 1].generation == generation)
+         return handles[i - 1].handle;
+
+   h.slot = (size_t)slot;
+   h.generation = generation;
+   return h;
+}
+
+/* Stops a replayed FT_listAt after as many children as were visited
+   when it was recorded: *(size_t*)pvExtra counts down the visits
+   left. */
+static boolean Replay_visit(const char* path, boolean isFile,
+                            size_t length, void* pvExtra) {
+   size_t* pLeft = pvExtra;
+
+   (void) path;
+   (void) isFile;
+   (void) length;
+   if(*pLeft > 0)
+      (*pLeft)--;
+   return *pLeft > 0;
+}
+
+/* Sleeps until offset ns after origin, a time from Trace_now. */
+static void Replay_waitUntil(unsigned long origin, unsigned long offset) {
+   unsigned long now = Trace_now();
+   struct timespec ts;
+
+   if(now - origin >= offset)
+      return;
+   ts.tv_sec = (time_t)((offset - (now - origin)) / 1000000000UL);
+   ts.tv_nsec = (long)((offset - (now - origin)) % 1000000000UL);
+   nanosleep(&ts, NULL);
+}
+
+/* Reads the n TRACE_BATCH_ENTRY records that follow a batch record
+   in trace as the batch to replay. Returns TRUE, or FALSE if they are
+   missing or malformed. */
+static boolean Replay_readBatch(Trace_T trace, unsigned long n) {
+   struct TraceRecord e;
+   size_t i;
+
+   for(i = 0; i < numBatch; i++)
+      free(batchPaths[i]);
+   numBatch = 0;
+
+   for(; n > 0; n--) {
+      if(!Trace_read(trace, &e) || e.iOp != TRACE_BATCH_ENTRY)
+         return FALSE;
+      if(numBatch == capBatch) {
+         capBatch = (capBatch == 0) ? 1024 : 2 * capBatch;
+         batch = Replay_check(realloc(batch,
+                                      capBatch * sizeof(*batch)));
+         batchPaths = Replay_check(realloc(batchPaths,
+                                           capBatch * sizeof(char*)));
+      }
+      batchPaths[numBatch] = Replay_check(malloc(strlen(e.pcPath) + 1));
+      strcpy(batchPaths[numBatch], e.pcPath);
+      batch[numBatch].path = batchPaths[numBatch];
+      batch[numBatch].isFile = (e.iFlags & TRACE_IS_FILE) != 0;
+      batch[numBatch].contents =
+         (e.iFlags & TRACE_HAS_CONTENTS) ? contents : NULL;
+      batch[numBatch].length = (size_t)e.ulLength;
+      numBatch++;
+   }
+   return TRUE;
+}
+
+/* Replays the call in *r, storing its replay latency in *pElapsed.
+   Returns its result, encoded as in struct TraceRecord. */
+static int Replay_call(const struct TraceRecord* r,
+                       unsigned long* pElapsed) {
+   char* path = (char*)r->pcPath;
+   void* pvContents = (r->iFlags & TRACE_HAS_CONTENTS) ? contents : NULL;
+   boolean parsed = (r->iFlags & TRACE_PARSED) != 0;
+   struct FT_PathComponent* components = NULL;
+   FT_Path p;
+   FT_DirHandle h;
+   boolean type;
+   size_t length;
+   size_t left;
+   char* listing;
+   unsigned long start;
+   int result = 0;
+
+   h = Replay_handle(r->ulSlot, r->ulGeneration);
+
+   /* the client parsed its path before the traced call */
+   if(parsed && path != NULL) {
+      components = Replay_check(malloc((strlen(path) / 2 + 1) *
+                                       sizeof(*components)));
+      if(FT_parsePath(path, &p, components, strlen(path) / 2 + 1)
+         != SUCCESS)
+         parsed = FALSE;
+   }
+
+   start = Trace_now();
+   switch(r->iOp) {
+      case TRACE_INIT:
+         result = FT_init();
+         break;
+      case TRACE_DESTROY:
+         result = FT_destroy();
+         break;
+      case TRACE_TO_STRING:
+         listing = FT_toString();
+         result = (listing != NULL);
+         free(listing);
+         break;
+      case TRACE_INSERT_DIR:
+         result = parsed ? FT_insertDirP(&p) : FT_insertDir(path);
+         break;
+      case TRACE_CONTAINS_DIR:
+         result = parsed ? FT_containsDirP(&p) : FT_containsDir(path);
+         break;
+      case TRACE_RM_DIR:
+         result = parsed ? FT_rmDirP(&p) : FT_rmDir(path);
+         break;
+      case TRACE_INSERT_FILE:
+         result = parsed ?
+            FT_insertFileP(&p, pvContents, r->ulLength) :
+            FT_insertFile(path, pvContents, r->ulLength);
+         break;
+      case TRACE_CONTAINS_FILE:
+         result = parsed ? FT_containsFileP(&p) : FT_containsFile(path);
+         break;
+      case TRACE_RM_FILE:
+         result = parsed ? FT_rmFileP(&p) : FT_rmFile(path);
+         break;
+      case TRACE_GET_CONTENTS:
+         result = (parsed ? FT_getFileContentsP(&p) :
+                   FT_getFileContents(path)) != NULL;
+         break;
+      case TRACE_REPLACE_CONTENTS:
+         result = (parsed ?
+                   FT_replaceFileContentsP(&p, pvContents, r->ulLength) :
+                   FT_replaceFileContents(path, pvContents, r->ulLength))
+            != NULL;
+         break;
+      case TRACE_STAT:
+         result = parsed ? FT_statP(&p, &type, &length) :
+            FT_stat(path, &type, &length);
+         break;
+      case TRACE_OPEN_DIR:
+         result = FT_openDir(path, &h);
+         break;
+      case TRACE_CLOSE_DIR:
+         result = FT_closeDir(h);
+         break;
+      case TRACE_INSERT_DIR_AT:
+         result = FT_insertDirAt(h, path);
+         break;
+      case TRACE_INSERT_FILE_AT:
+         result = FT_insertFileAt(h, path, pvContents, r->ulLength);
+         break;
+      case TRACE_STAT_AT:
+         result = FT_statAt(h, path, &type, &length);
+         break;
+      case TRACE_RM_AT:
+         result = FT_rmAt(h, path);
+         break;
+      case TRACE_LIST_AT:
+         left = r->ulLength;
+         result = FT_listAt(h, path, Replay_visit, &left);
+         break;
+      case TRACE_FREEZE:
+         result = FT_freeze();
+         break;
+      case TRACE_THAW:
+         result = FT_thaw();
+         break;
+      case TRACE_INDEX_NAMES:
+         result = FT_indexNames((r->iFlags & TRACE_ENABLE) != 0);
+         break;
+      case TRACE_INDEX_SIZES:
+         result = FT_indexSizes((r->iFlags & TRACE_ENABLE) != 0);
+         break;
+      case TRACE_INSERT_BATCH:
+         result = FT_insertBatch(batch, numBatch, &length);
+         break;
+      case TRACE_RM_BATCH:
+         result = FT_rmBatch(batchPaths, numBatch, &length);
+         break;
+      default:
+         assert(0);
+   }
+   *pElapsed = Trace_now() - start;
+
+   if(r->iOp == TRACE_OPEN_DIR && result == SUCCESS)
+      Replay_mapHandle(r->ulSlot, r->ulGeneration, h);
+   free(components);
+   return result;
+}
+
+/* Prints the per-function latencies, as a table or as CSV. */
+static void Replay_report(boolean csv) {
+   struct Samples* s;
+   int op;
+
+   if(csv)
+      printf("operation,count,p50_ns,p99_ns,p999_ns,"
+             "recorded_p50_ns,recorded_p99_ns,recorded_p999_ns\n");
+   else
+      printf("%-24s %10s %9s %9s %9s   %9s %9s %9s\n", "operation",
+             "count", "p50 ns", "p99 ns", "p999 ns", "rec p50",
+             "rec p99", "rec p999");
+
+   for(op = 0; op < TRACE_NUM_OPS; op++) {
+      s = &samples[op];
+      if(s->n == 0)
+         continue;
+      qsort(s->replayed, s->n, sizeof(unsigned long), Replay_compare);
+      qsort(s->recorded, s->n, sizeof(unsigned long), Replay_compare);
+      printf(csv ? "%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n" :
+             "%-24s %10lu %9lu %9lu %9lu   %9lu %9lu %9lu\n",
+             Trace_opName(op), (unsigned long)s->n,
+             Replay_quantile(s->replayed, s->n, 0.50),
+             Replay_quantile(s->replayed, s->n, 0.99),
+             Replay_quantile(s->replayed, s->n, 0.999),
+             Replay_quantile(s->recorded, s->n, 0.50),
+             Replay_quantile(s->recorded, s->n, 0.99),
+             Replay_quantile(s->recorded, s->n, 0.999));
+   }
+}
+
+/* Replays the trace named on the command line; see the top of this
+   file. */
+int main(int argc, char* argv[]) {
+   const char* filename = NULL;
+   boolean paced = FALSE;
+   boolean csv = FALSE;
+   boolean usage = FALSE;
+   Trace_T trace;
+   struct TraceRecord r;
+   unsigned long origin;
+   unsigned long wall;
+   unsigned long elapsed;
+   double busy = 0;
+   size_t calls = 0;
+   size_t mismatches = 0;
+   int result;
+   int i;
+
+   for(i = 1; i < argc; i++) {
+      if(!strcmp(argv[i], "--paced"))
+         paced = TRUE;
+      else if(!strcmp(argv[i], "--format=csv"))
+         csv = TRUE;
+      else if(!strcmp(argv[i], "--format=text"))
+         csv = FALSE;
+      else if(filename == NULL && argv[i][0] != '-')
+         filename = argv[i];
+      else
+         usage = TRUE;
+   }
+   if(usage || filename == NULL) {
+      fprintf(stderr, "usage: ft_replay [--paced] "
+              "[--format=text|csv] tracefile\n");
+      return 2;
+   }
+
+   trace = Trace_open(filename);
+   if(trace == NULL) {
+      fprintf(stderr, "ft_replay: %s is not a readable trace\n",
+              filename);
+      return 2;
+   }
+
+   origin = Trace_now();
+   while(Trace_read(trace, &r)) {
+      if(r.iOp == TRACE_BATCH_ENTRY ||
+         ((r.iOp == TRACE_INSERT_BATCH || r.iOp == TRACE_RM_BATCH) &&
+          !Replay_readBatch(trace, r.ulLength))) {
+         fprintf(stderr, "ft_replay: %s has a malformed batch\n",
+                 filename);
+         return 2;
+      }
+      if(paced)
+         Replay_waitUntil(origin, r.ulStart);
+      result = Replay_call(&r, &elapsed);
+      Replay_record(r.iOp, elapsed, r.ulDuration);
+      busy += (double)elapsed;
+      calls++;
+
+      if(result != r.iResult) {
+         if(mismatches < MAX_REPORTED_MISMATCHES)
+            fprintf(stderr, "call %lu: %s(%s) returned %d, "
+                    "recorded %d\n", (unsigned long)calls,
+                    Trace_opName(r.iOp),
+                    r.pcPath == NULL ? "" : r.pcPath, result, r.iResult);
+         mismatches++;
+      }
+   }
+   wall = Trace_now() - origin;
+   (void) Trace_close(trace);
+
+   if(!csv) {
+      printf("%lu calls, %lu mismatched results\n",
+             (unsigned long)calls, (unsigned long)mismatches);
+      printf("wall %.3f s, %.0f calls/s; in calls %.3f s, "
+             "%.0f calls/s\n", (double)wall / 1e9,
+             wall ? (double)calls * 1e9 / (double)wall : 0,
+             busy / 1e9, busy > 0 ? (double)calls * 1e9 / busy : 0);
+   }
+   Replay_report(csv);
+   return mismatches ? 1 : 0;
+}
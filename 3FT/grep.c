@@ -0,0 +1,579 @@
+/*--------------------------------------------------------------------*/
+/* grep.c                                                             */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "grep.h"
+#include "stats.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The most threads Grep_run starts. */
+
+enum { MAX_GREP_THREADS = 64 };
+
+/* The number of bytes in a task.  A file counts as at least
+   FILE_BYTES, so that a task of many small files does not take much
+   longer than one of a few large ones. */
+
+#ifndef GREP_TASK_BYTES
+#define GREP_TASK_BYTES 262144
+#endif
+enum { TASK_BYTES = GREP_TASK_BYTES };
+enum { FILE_BYTES = 256 };
+
+/* The number of tasks that may be under way or waiting to be reported
+   for each thread, so that a slow task holds up only so many behind
+   it. */
+
+enum { SLOTS_PER_THREAD = 4 };
+
+/* The number of matches a task has room for at first. */
+
+enum { MIN_MATCHES = 16 };
+
+/*--------------------------------------------------------------------*/
+
+/* A match: the index of its file, and its offset there. */
+
+struct GrepMatch
+{
+   size_t uFile;
+   size_t uOffset;
+};
+
+/* A Slot holds one task: the bytes it searches, from offset
+   uFirstOffset of file uFirstFile up to offset uEndOffset of file
+   uEndFile, and the matches found that begin there. */
+
+struct GrepSlot
+{
+   /* The number of the task, in the order tasks were taken. */
+   size_t uTask;
+
+   /* 1 (TRUE) once the task is finished. */
+   int iDone;
+
+   /* Where the task begins, and where the next begins. */
+   size_t uFirstFile;
+   size_t uFirstOffset;
+   size_t uEndFile;
+   size_t uEndOffset;
+
+   /* The matches, uLength of them in an array of uCapacity, which is
+      kept from one task to the next. */
+   struct GrepMatch *psMatches;
+   size_t uLength;
+   size_t uCapacity;
+};
+
+/* A Grep consists of what to search for, and the state its threads
+   share, guarded by a mutex. */
+
+struct Grep
+{
+   /* The files, and the needle, with the flags for matching it. */
+   const struct GrepFile *psFiles;
+   size_t uFiles;
+   const char *pcNeedle;
+   size_t uNeedleLength;
+   int iFlags;
+
+   /* The index in the needle of the character scanned for, and that
+      character, in lower and upper case if case is ignored. */
+   size_t uRare;
+   int iRareOne;
+   int iRareTwo;
+
+   /* Where to report matches. */
+   Grep_Report pfReport;
+   void *pvExtra;
+
+   /* Guards the fields from uNextFile to iResult. */
+   pthread_mutex_t oMutex;
+
+   /* Signalled when a task is finished or reported, or the search
+      stops. */
+   pthread_cond_t oChanged;
+
+   /* Where the next task begins, and its number. */
+   size_t uNextFile;
+   size_t uNextOffset;
+   size_t uNextTask;
+
+   /* The number of tasks reported. */
+   size_t uReported;
+
+   /* The tasks under way or waiting to be reported, task k in slot
+      k % uSlots. */
+   struct GrepSlot *psSlots;
+   size_t uSlots;
+
+   /* 1 (TRUE) once the search is to stop early. */
+   int iStop;
+
+   /* SUCCESS, or MEMORY_ERROR if a task failed. */
+   int iResult;
+};
+
+/* A Worker is one thread of Grep_run.  The first is the calling
+   thread, which alone reports matches. */
+
+struct GrepWorker
+{
+   struct Grep *psGrep;
+   int iReports;
+   pthread_t thread;
+   int iStarted;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return c in lower case if it is an ASCII capital letter, and c
+   otherwise. */
+
+static int Grep_lower(int c)
+{
+   if (c >= 'A' && c <= 'Z')
+      return c - 'A' + 'a';
+   return c;
+}
+
+/* Return c in upper case if it is an ASCII small letter, and c
+   otherwise. */
+
+static int Grep_upper(int c)
+{
+   if (c >= 'a' && c <= 'z')
+      return c - 'a' + 'A';
+   return c;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if the uLength characters at pc1 and at pc2 are
+   equal, or equal but for the case of ASCII letters if iIgnoreCase is
+   1 (TRUE), and 0 (FALSE) otherwise. */
+
+static int Grep_equal(const char *pc1, const char *pc2, size_t uLength,
+                      int iIgnoreCase)
+{
+   size_t u;
+
+   if (!iIgnoreCase)
+      return memcmp(pc1, pc2, uLength) == 0;
+   for (u = 0; u < uLength; u++)
+      if (Grep_lower((unsigned char)pc1[u]) !=
+          Grep_lower((unsigned char)pc2[u]))
+         return 0;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add a match at offset uOffset of file uFile to *psSlot.  Return 1
+   (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+   available. */
+
+static int Grep_addMatch(struct GrepSlot *psSlot, size_t uFile,
+                         size_t uOffset)
+{
+   struct GrepMatch *psMatches;
+   size_t uCapacity;
+
+   assert(psSlot != NULL);
+
+   if (psSlot->uLength == psSlot->uCapacity)
+   {
+      uCapacity = psSlot->uCapacity == 0 ? MIN_MATCHES
+         : 2 * psSlot->uCapacity;
+      psMatches = realloc(psSlot->psMatches,
+                          uCapacity * sizeof(struct GrepMatch));
+      if (psMatches == NULL)
+         return 0;
+      if (psSlot->psMatches == NULL)
+         STATS_ADD(mallocs, 1);
+      psSlot->psMatches = psMatches;
+      psSlot->uCapacity = uCapacity;
+   }
+   psSlot->psMatches[psSlot->uLength].uFile = uFile;
+   psSlot->psMatches[psSlot->uLength].uOffset = uOffset;
+   psSlot->uLength++;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return how common the character c is in text and code: 3 for
+   small letters and spaces, 2 for capitals, digits and line breaks, 1
+   for other punctuation, and 0 for anything else. */
+
+static int Grep_commonness(int c)
+{
+   if ((c >= 'a' && c <= 'z') || c == ' ')
+      return 3;
+   if ((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+       c == '\n' || c == '\t')
+      return 2;
+   if (c >= '!' && c <= '~')
+      return 1;
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Choose the character of psGrep's needle to scan for: its first
+   among the least common, which occurs least often in the contents
+   and so stops the scan least often. */
+
+static void Grep_chooseRare(struct Grep *psGrep)
+{
+   size_t u;
+   int iRank;
+   int iBest = 4;
+
+   assert(psGrep != NULL);
+
+   for (u = 0; u < psGrep->uNeedleLength; u++)
+   {
+      iRank = Grep_commonness(
+         Grep_lower((unsigned char)psGrep->pcNeedle[u]));
+      if (iRank < iBest)
+      {
+         iBest = iRank;
+         psGrep->uRare = u;
+      }
+   }
+
+   psGrep->iRareOne = (unsigned char)psGrep->pcNeedle[psGrep->uRare];
+   psGrep->iRareTwo = psGrep->iRareOne;
+   if (psGrep->iFlags & FT_GREP_IGNORE_CASE)
+   {
+      psGrep->iRareOne = Grep_lower(psGrep->iRareOne);
+      psGrep->iRareTwo = Grep_upper(psGrep->iRareOne);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add to *psSlot the matches of psGrep's needle in file uFile that
+   begin from offset uStart up to offset uStop.  Candidates are found
+   by memchr, which the C library scans a word or a vector at a time,
+   on the needle's rare character (in either case, if case is
+   ignored), and only they are compared with the needle.  Return 1
+   (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+   available. */
+
+static int Grep_searchFile(const struct Grep *psGrep,
+                           struct GrepSlot *psSlot, size_t uFile,
+                           size_t uStart, size_t uStop)
+{
+   const char *pcHay = psGrep->psFiles[uFile].pcContents;
+   size_t uLength = psGrep->psFiles[uFile].uLength;
+   size_t uNeedleLength = psGrep->uNeedleLength;
+   size_t uRare = psGrep->uRare;
+   int iIgnoreCase = (psGrep->iFlags & FT_GREP_IGNORE_CASE) != 0;
+   const char *pcEnd;
+   const char *pcOne;
+   const char *pcTwo = NULL;
+   const char *pc;
+
+   assert(psSlot != NULL);
+
+   if (uLength < uNeedleLength)
+      return 1;
+   if (uStop > uLength - uNeedleLength + 1)
+      uStop = uLength - uNeedleLength + 1;
+   if (uStart >= uStop)
+      return 1;
+
+   /* pcOne and pcTwo are the next places the rare character occurs
+      in each case, where a match would have it */
+   pcEnd = pcHay + uStop + uRare;
+   pcOne = memchr(pcHay + uStart + uRare, psGrep->iRareOne,
+                  uStop - uStart);
+   if (psGrep->iRareTwo != psGrep->iRareOne)
+      pcTwo = memchr(pcHay + uStart + uRare, psGrep->iRareTwo,
+                     uStop - uStart);
+
+   while (pcOne != NULL || pcTwo != NULL)
+   {
+      pc = (pcTwo == NULL || (pcOne != NULL && pcOne < pcTwo))
+         ? pcOne : pcTwo;
+      if (Grep_equal(pc - uRare, psGrep->pcNeedle, uNeedleLength,
+                     iIgnoreCase))
+      {
+         if (!Grep_addMatch(psSlot, uFile, (size_t)(pc - uRare - pcHay)))
+            return 0;
+         if (psGrep->iFlags & FT_GREP_FIRST)
+            return 1;
+      }
+      if (pc == pcOne)
+         pcOne = memchr(pc + 1, psGrep->iRareOne,
+                        (size_t)(pcEnd - pc - 1));
+      else
+         pcTwo = memchr(pc + 1, psGrep->iRareTwo,
+                        (size_t)(pcEnd - pc - 1));
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Search the bytes of the task in *psSlot.  Return 1 (TRUE) if
+   successful, or 0 (FALSE) if insufficient memory is available. */
+
+static int Grep_searchTask(const struct Grep *psGrep,
+                           struct GrepSlot *psSlot)
+{
+   size_t uFile;
+   size_t uStart;
+   size_t uStop;
+
+   assert(psGrep != NULL);
+   assert(psSlot != NULL);
+
+   for (uFile = psSlot->uFirstFile;
+        uFile <= psSlot->uEndFile && uFile < psGrep->uFiles; uFile++)
+   {
+      uStart = (uFile == psSlot->uFirstFile) ? psSlot->uFirstOffset : 0;
+      uStop = (uFile == psSlot->uEndFile) ? psSlot->uEndOffset
+         : psGrep->psFiles[uFile].uLength;
+      if (!Grep_searchFile(psGrep, psSlot, uFile, uStart, uStop))
+         return 0;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Take the next task of psGrep into its slot, and return the slot.
+   The mutex must be held, and there must be a task left and a slot
+   free for it. */
+
+static struct GrepSlot *Grep_take(struct Grep *psGrep)
+{
+   struct GrepSlot *psSlot;
+   size_t uBudget = TASK_BYTES;
+   size_t uLeft;
+
+   assert(psGrep != NULL);
+   assert(psGrep->uNextFile < psGrep->uFiles);
+   assert(psGrep->uNextTask < psGrep->uReported + psGrep->uSlots);
+
+   psSlot = &psGrep->psSlots[psGrep->uNextTask % psGrep->uSlots];
+   psSlot->uTask = psGrep->uNextTask++;
+   psSlot->iDone = 0;
+   psSlot->uLength = 0;
+   psSlot->uFirstFile = psGrep->uNextFile;
+   psSlot->uFirstOffset = psGrep->uNextOffset;
+
+   while (uBudget > 0 && psGrep->uNextFile < psGrep->uFiles)
+   {
+      uLeft = psGrep->psFiles[psGrep->uNextFile].uLength
+         - psGrep->uNextOffset;
+      if (uLeft > uBudget)
+      {
+         psGrep->uNextOffset += uBudget;
+         break;
+      }
+      if (uLeft < FILE_BYTES)
+         uLeft = FILE_BYTES;
+      uBudget -= (uLeft < uBudget) ? uLeft : uBudget;
+      psGrep->uNextFile++;
+      psGrep->uNextOffset = 0;
+   }
+
+   psSlot->uEndFile = psGrep->uNextFile;
+   psSlot->uEndOffset = psGrep->uNextOffset;
+   return psSlot;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Report the matches of the task in *psSlot, in order, skipping all
+   but the first in each file if only the first is wanted.  *puLast
+   is the file of the match reported last, or psGrep->uFiles if none
+   has been.  Return 0 (FALSE) if the report function asked to stop,
+   and 1 (TRUE) otherwise. */
+
+static int Grep_report(const struct Grep *psGrep,
+                       const struct GrepSlot *psSlot, size_t *puLast)
+{
+   const struct GrepMatch *psMatch;
+   size_t u;
+
+   assert(psGrep != NULL);
+   assert(psSlot != NULL);
+   assert(puLast != NULL);
+
+   for (u = 0; u < psSlot->uLength; u++)
+   {
+      psMatch = &psSlot->psMatches[u];
+      if ((psGrep->iFlags & FT_GREP_FIRST) && psMatch->uFile == *puLast)
+         continue;
+      *puLast = psMatch->uFile;
+      if (!(*psGrep->pfReport)(psMatch->uFile, psMatch->uOffset,
+                               psGrep->pvExtra))
+         return 0;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Take and search tasks of the Grep of the GrepWorker pvWorker until
+   there are none left or the search stops; if the worker reports,
+   also report each task's matches as soon as it and those before it
+   are finished, and keep on until all of them have been.  Return
+   NULL. */
+
+static void *Grep_work(void *pvWorker)
+{
+   struct GrepWorker *psWorker = pvWorker;
+   struct Grep *psGrep = psWorker->psGrep;
+   struct GrepSlot *psSlot;
+   size_t uLast = psGrep->uFiles;
+   int iContinue;
+   int iOk;
+
+   pthread_mutex_lock(&psGrep->oMutex);
+   for (;;)
+   {
+      /* first report the next task, if it is finished */
+      psSlot = &psGrep->psSlots[psGrep->uReported % psGrep->uSlots];
+      if (psWorker->iReports && !psGrep->iStop &&
+          psGrep->uReported < psGrep->uNextTask && psSlot->iDone)
+      {
+         pthread_mutex_unlock(&psGrep->oMutex);
+         iContinue = Grep_report(psGrep, psSlot, &uLast);
+         pthread_mutex_lock(&psGrep->oMutex);
+         psGrep->uReported++;
+         if (!iContinue)
+            psGrep->iStop = 1;
+         pthread_cond_broadcast(&psGrep->oChanged);
+         continue;
+      }
+
+      /* then stop, if there is nothing left to do */
+      if (psGrep->iStop || (psGrep->uNextFile == psGrep->uFiles &&
+                            (!psWorker->iReports ||
+                             psGrep->uReported == psGrep->uNextTask)))
+         break;
+
+      /* otherwise take a task if there is one and room for it, or
+         wait for that or for a task to finish */
+      if (psGrep->uNextFile < psGrep->uFiles &&
+          psGrep->uNextTask < psGrep->uReported + psGrep->uSlots)
+      {
+         psSlot = Grep_take(psGrep);
+         pthread_mutex_unlock(&psGrep->oMutex);
+         iOk = Grep_searchTask(psGrep, psSlot);
+         pthread_mutex_lock(&psGrep->oMutex);
+         psSlot->iDone = 1;
+         if (!iOk)
+         {
+            psGrep->iResult = MEMORY_ERROR;
+            psGrep->iStop = 1;
+         }
+         pthread_cond_broadcast(&psGrep->oChanged);
+      }
+      else
+         pthread_cond_wait(&psGrep->oChanged, &psGrep->oMutex);
+   }
+   pthread_mutex_unlock(&psGrep->oMutex);
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Grep_run(const struct GrepFile *psFiles, size_t uFiles,
+             const char *pcNeedle, size_t uNeedleLength, int iFlags,
+             size_t uThreads, Grep_Report pfReport, void *pvExtra)
+{
+   struct GrepWorker asWorkers[MAX_GREP_THREADS];
+   struct Grep sGrep;
+   size_t uBytes = 0;
+   size_t uTasks;
+   size_t u;
+   long lProcessors;
+
+   assert(psFiles != NULL || uFiles == 0);
+   assert(pcNeedle != NULL);
+   assert(pfReport != NULL);
+
+   if (uFiles == 0 || uNeedleLength == 0)
+      return SUCCESS;
+
+   /* no more threads than there are tasks to keep busy */
+   if (uThreads == 0)
+   {
+      lProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+      uThreads = lProcessors > 0 ? (size_t)lProcessors : 1;
+   }
+   if (uThreads > MAX_GREP_THREADS)
+      uThreads = MAX_GREP_THREADS;
+   for (u = 0; u < uFiles && uBytes / TASK_BYTES < uThreads; u++)
+      uBytes += (psFiles[u].uLength < FILE_BYTES) ? FILE_BYTES
+         : psFiles[u].uLength;
+   uTasks = uBytes / TASK_BYTES + 1;
+   if (uThreads > uTasks)
+      uThreads = uTasks;
+
+   sGrep.psFiles = psFiles;
+   sGrep.uFiles = uFiles;
+   sGrep.pcNeedle = pcNeedle;
+   sGrep.uNeedleLength = uNeedleLength;
+   sGrep.iFlags = iFlags;
+   sGrep.uRare = 0;
+   Grep_chooseRare(&sGrep);
+   sGrep.pfReport = pfReport;
+   sGrep.pvExtra = pvExtra;
+   sGrep.uNextFile = 0;
+   sGrep.uNextOffset = 0;
+   sGrep.uNextTask = 0;
+   sGrep.uReported = 0;
+   sGrep.uSlots = uThreads * SLOTS_PER_THREAD;
+   sGrep.iStop = 0;
+   sGrep.iResult = SUCCESS;
+   sGrep.psSlots = calloc(sGrep.uSlots, sizeof(struct GrepSlot));
+   if (sGrep.psSlots == NULL)
+      return MEMORY_ERROR;
+   STATS_ADD(mallocs, 1);
+   pthread_mutex_init(&sGrep.oMutex, NULL);
+   pthread_cond_init(&sGrep.oChanged, NULL);
+
+   /* The calling thread is the first Worker.  A Worker whose thread
+      cannot be created is simply left out. */
+   for (u = 0; u < uThreads; u++)
+   {
+      asWorkers[u].psGrep = &sGrep;
+      asWorkers[u].iReports = u == 0;
+      asWorkers[u].iStarted = u > 0 &&
+         pthread_create(&asWorkers[u].thread, NULL, Grep_work,
+                        &asWorkers[u]) == 0;
+   }
+   (void)Grep_work(&asWorkers[0]);
+   for (u = 1; u < uThreads; u++)
+      if (asWorkers[u].iStarted)
+         (void)pthread_join(asWorkers[u].thread, NULL);
+
+   for (u = 0; u < sGrep.uSlots; u++)
+      if (sGrep.psSlots[u].psMatches != NULL)
+      {
+         free(sGrep.psSlots[u].psMatches);
+         STATS_ADD(frees, 1);
+      }
+   free(sGrep.psSlots);
+   STATS_ADD(frees, 1);
+   pthread_mutex_destroy(&sGrep.oMutex);
+   pthread_cond_destroy(&sGrep.oChanged);
+   return sGrep.iResult;
+}
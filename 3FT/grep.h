@@ -0,0 +1,54 @@
+/*--------------------------------------------------------------------*/
+/* grep.h                                                             */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#ifndef GREP_INCLUDED
+#define GREP_INCLUDED
+
+#include <stddef.h>
+#include "ft.h"
+
+/* Grep_run searches the contents of many files for a literal string
+   with a pool of threads.  The files are cut into tasks of a few
+   hundred kilobytes each, a large file into several and many small
+   files into one, which the threads take in turn; so a search scales
+   with the number of threads whether the bytes are in a few large
+   files or in many small ones.  The matches are reported by the
+   calling thread alone, in order, as each task before them is
+   finished. */
+
+/* One file to search: its contents and their length. */
+
+struct GrepFile
+{
+   const char *pcContents;
+   size_t uLength;
+};
+
+/* A function called once per match, with the index of the file in
+   which it was found, the offset in that file at which it begins,
+   and the pvExtra passed to Grep_run.  Returns 1 (TRUE) to continue
+   the search, or 0 (FALSE) to stop it. */
+
+typedef int (*Grep_Report)(size_t uFile, size_t uOffset, void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Search the uFiles files at psFiles for each occurrence of the
+   uNeedleLength characters at pcNeedle, with uThreads threads (0 for
+   one per online processor, fewer if there is too little to search
+   to keep them busy), and call (*pfReport)(uFile, uOffset, pvExtra)
+   on each, in order of file and then offset, until it returns 0
+   (FALSE).  Occurrences may overlap.  iFlags is a combination of
+   FT_GREP_FIRST, to report only the first occurrence in each file,
+   and FT_GREP_IGNORE_CASE, to compare ASCII letters without regard
+   to case.  An empty needle occurs nowhere.  Return SUCCESS, or
+   MEMORY_ERROR if insufficient memory is available, in which case
+   some matches may have been reported. */
+
+int Grep_run(const struct GrepFile *psFiles, size_t uFiles,
+             const char *pcNeedle, size_t uNeedleLength, int iFlags,
+             size_t uThreads, Grep_Report pfReport, void *pvExtra);
+
+#endif
@@ -0,0 +1,1246 @@
+/*--------------------------------------------------------------------*/
+/* louds.c                                                            */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#include "louds.h"
+#include "stats.h"
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The number of names in each front-coded block.  The first name of
+   a block is stored whole, so that a search or a decoding can start
+   there; larger blocks store fewer whole names but decode more to
+   reach one. */
+
+#ifndef LOUDS_BLOCK_NAMES
+#define LOUDS_BLOCK_NAMES 16
+#endif
+
+/* The number of bits in a word of a bit vector, and in a superblock:
+   the run of words whose 1 bits are counted ahead of time, so that
+   rank need only count the rest of one superblock. */
+
+#define WORD_BITS (CHAR_BIT * sizeof(unsigned long))
+enum { SUPER_WORDS = 8 };
+#define SUPER_BITS (SUPER_WORDS * WORD_BITS)
+
+/* The most bytes a varint of a size_t takes. */
+
+#define MAX_VARINT ((sizeof(size_t) * CHAR_BIT + 6) / 7)
+
+/* The first bytes of a file written by Louds_write. */
+
+static const char acMagic[8] = "FTLOUDS1";
+
+/*--------------------------------------------------------------------*/
+
+/* A bit vector with rank and select support. */
+
+struct LoudsBits
+{
+   /* The bits, WORD_BITS to a word, from the least significant; the
+      bits of the last word beyond uLength are 0. */
+   unsigned long *aulWords;
+
+   /* The number of bits. */
+   size_t uLength;
+
+   /* The number of 1 bits before each superblock, and in all. */
+   size_t *auRanks;
+
+   /* The number of superblocks. */
+   size_t uSupers;
+};
+
+/* A Louds consists of its shape, which files are, their lengths, and
+   their names.  Node i is the i'th node in breadth-first order, the
+   root being node 0.  The shape begins with a 1 bit for the root and
+   a 0 bit; then node i's children, if any, are the 1 bits after its
+   0 bit, the (i+1)'th, and the 1 bit at position p is node
+   rank1(p). */
+
+struct Louds
+{
+   /* The number of nodes. */
+   size_t uLength;
+
+   /* The shape, 2 * uLength + 1 bits long. */
+   struct LoudsBits sShape;
+
+   /* A 1 bit for each node that is a file. */
+   struct LoudsBits sFiles;
+
+   /* The number of files, and the length of each, the i'th file's in
+      uLengthBits bits from bit i * uLengthBits of aulLengths. */
+   size_t uFiles;
+   size_t uLengthBits;
+   unsigned long *aulLengths;
+
+   /* The names of the nodes, in order, each as the varint length of
+      the prefix it shares with the name before it (0 for the first
+      in a block), the varint length of the rest, and the rest. */
+   unsigned char *pucNames;
+   size_t uNameBytes;
+
+   /* The offset in pucNames of the first name of each block. */
+   size_t *auBlocks;
+   size_t uBlocks;
+
+   /* The length of the longest name, and of the longest path. */
+   size_t uMaxNameLength;
+   size_t uMaxPathLength;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of 1 bits in ulWord. */
+
+static size_t Louds_popcount(unsigned long ulWord)
+{
+#ifdef __GNUC__
+   return (size_t)__builtin_popcountl(ulWord);
+#else
+   size_t uCount = 0;
+
+   while (ulWord != 0)
+   {
+      ulWord &= ulWord - 1;
+      uCount++;
+   }
+   return uCount;
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the position in ulWord of its uRank'th 1 bit, counting from
+   1, which it must have. */
+
+static size_t Louds_selectInWord(unsigned long ulWord, size_t uRank)
+{
+   size_t uBit = 0;
+
+   assert(uRank >= 1 && uRank <= Louds_popcount(ulWord));
+
+   while (--uRank > 0)
+      ulWord &= ulWord - 1;
+#ifdef __GNUC__
+   uBit = (size_t)__builtin_ctzl(ulWord);
+#else
+   while ((ulWord & 1) == 0)
+   {
+      ulWord >>= 1;
+      uBit++;
+   }
+#endif
+   return uBit;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of words that hold uBits bits. */
+
+static size_t Louds_words(size_t uBits)
+{
+   return (uBits + WORD_BITS - 1) / WORD_BITS;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make *psBits uLength 0 bits long, without its rank index.  Return 1
+   (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+   available. */
+
+static int Louds_bitsNew(struct LoudsBits *psBits, size_t uLength)
+{
+   psBits->uLength = uLength;
+   psBits->aulWords = calloc(Louds_words(uLength) + 1,
+                             sizeof(unsigned long));
+   if (psBits->aulWords == NULL)
+      return 0;
+   STATS_ADD(mallocs, 1);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count the 1 bits of each superblock of *psBits, to be ranked and
+   selected in.  Return 1 (TRUE) if successful, or 0 (FALSE) if
+   insufficient memory is available. */
+
+static int Louds_bitsIndex(struct LoudsBits *psBits)
+{
+   size_t uWords = Louds_words(psBits->uLength);
+   size_t uSuper;
+   size_t uWord;
+   size_t uRank = 0;
+
+   psBits->uSupers = (uWords + SUPER_WORDS - 1) / SUPER_WORDS;
+   psBits->auRanks = malloc((psBits->uSupers + 1) * sizeof(size_t));
+   if (psBits->auRanks == NULL)
+      return 0;
+   STATS_ADD(mallocs, 1);
+
+   for (uSuper = 0; uSuper < psBits->uSupers; uSuper++)
+   {
+      psBits->auRanks[uSuper] = uRank;
+      for (uWord = uSuper * SUPER_WORDS;
+           uWord < uWords && uWord < (uSuper + 1) * SUPER_WORDS; uWord++)
+         uRank += Louds_popcount(psBits->aulWords[uWord]);
+   }
+   psBits->auRanks[psBits->uSupers] = uRank;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the memory of *psBits. */
+
+static void Louds_bitsFree(struct LoudsBits *psBits)
+{
+   free(psBits->aulWords);
+   free(psBits->auRanks);
+   STATS_ADD(frees, 2);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Set bit uIndex of *psBits to 1. */
+
+static void Louds_bitSet(struct LoudsBits *psBits, size_t uIndex)
+{
+   assert(uIndex < psBits->uLength);
+
+   psBits->aulWords[uIndex / WORD_BITS] |= 1UL << (uIndex % WORD_BITS);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return bit uIndex of *psBits. */
+
+static int Louds_bitGet(const struct LoudsBits *psBits, size_t uIndex)
+{
+   assert(uIndex < psBits->uLength);
+
+   return (int)((psBits->aulWords[uIndex / WORD_BITS] >>
+                 (uIndex % WORD_BITS)) & 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of 1 bits of *psBits before position uIndex. */
+
+static size_t Louds_rank1(const struct LoudsBits *psBits, size_t uIndex)
+{
+   size_t uWord = uIndex / WORD_BITS;
+   size_t uBit = uIndex % WORD_BITS;
+   size_t uRank;
+   size_t u;
+
+   assert(uIndex <= psBits->uLength);
+
+   uRank = psBits->auRanks[uWord / SUPER_WORDS];
+   for (u = uWord - uWord % SUPER_WORDS; u < uWord; u++)
+      uRank += Louds_popcount(psBits->aulWords[u]);
+   if (uBit != 0)
+      uRank += Louds_popcount(psBits->aulWords[uWord] &
+                              ((1UL << uBit) - 1));
+   return uRank;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the position of the uRank'th 1 bit of *psBits if iBit is 1,
+   or of its uRank'th 0 bit if iBit is 0, counting from 1: a binary
+   search for its superblock, then a scan of that superblock's
+   words. */
+
+static size_t Louds_select(const struct LoudsBits *psBits, int iBit,
+                           size_t uRank)
+{
+   size_t uLo = 0;
+   size_t uHi = psBits->uSupers;
+   size_t uMid;
+   size_t uBefore;
+   size_t uWord;
+   size_t uCount;
+   unsigned long ulWord;
+
+   assert(uRank >= 1);
+
+   /* Find the last superblock with fewer than uRank such bits
+      before it. */
+   while (uHi - uLo > 1)
+   {
+      uMid = uLo + (uHi - uLo) / 2;
+      uBefore = psBits->auRanks[uMid];
+      if (!iBit)
+         uBefore = uMid * SUPER_BITS - uBefore;
+      if (uBefore < uRank)
+         uLo = uMid;
+      else
+         uHi = uMid;
+   }
+
+   uBefore = psBits->auRanks[uLo];
+   if (!iBit)
+      uBefore = uLo * SUPER_BITS - uBefore;
+   uRank -= uBefore;
+   for (uWord = uLo * SUPER_WORDS; ; uWord++)
+   {
+      assert(uWord < Louds_words(psBits->uLength));
+      ulWord = iBit ? psBits->aulWords[uWord] : ~psBits->aulWords[uWord];
+      uCount = Louds_popcount(ulWord);
+      if (uRank <= uCount)
+         return uWord * WORD_BITS + Louds_selectInWord(ulWord, uRank);
+      uRank -= uCount;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store uValue in the uIndex'th uWidth-bit field of aulFields, which
+   must be 0. */
+
+static void Louds_setField(unsigned long *aulFields, size_t uIndex,
+                           size_t uWidth, size_t uValue)
+{
+   size_t uPos = uIndex * uWidth;
+   size_t uOffset = uPos % WORD_BITS;
+
+   if (uWidth == 0)
+      return;
+   aulFields[uPos / WORD_BITS] |= (unsigned long)uValue << uOffset;
+   if (uOffset + uWidth > WORD_BITS)
+      aulFields[uPos / WORD_BITS + 1] |=
+         (unsigned long)uValue >> (WORD_BITS - uOffset);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the uIndex'th uWidth-bit field of aulFields. */
+
+static size_t Louds_getField(const unsigned long *aulFields,
+                             size_t uIndex, size_t uWidth)
+{
+   size_t uPos = uIndex * uWidth;
+   size_t uOffset = uPos % WORD_BITS;
+   unsigned long ulValue;
+
+   if (uWidth == 0)
+      return 0;
+   ulValue = aulFields[uPos / WORD_BITS] >> uOffset;
+   if (uOffset + uWidth > WORD_BITS)
+      ulValue |= aulFields[uPos / WORD_BITS + 1] << (WORD_BITS - uOffset);
+   if (uWidth < WORD_BITS)
+      ulValue &= (1UL << uWidth) - 1;
+   return (size_t)ulValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write uValue as a varint at pucOut: 7 bits a byte, least
+   significant first, the high bit set on all but the last.  Return
+   the end of what was written. */
+
+static unsigned char *Louds_putVarint(unsigned char *pucOut,
+                                      size_t uValue)
+{
+   while (uValue >= 0x80)
+   {
+      *pucOut++ = (unsigned char)((uValue & 0x7f) | 0x80);
+      uValue >>= 7;
+   }
+   *pucOut++ = (unsigned char)uValue;
+   return pucOut;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read a varint at pucIn into *puValue.  Return the end of what was
+   read. */
+
+static const unsigned char *Louds_getVarint(const unsigned char *pucIn,
+                                            size_t *puValue)
+{
+   size_t uValue = 0;
+   size_t uShift = 0;
+
+   while (*pucIn & 0x80)
+   {
+      uValue |= (size_t)(*pucIn++ & 0x7f) << uShift;
+      uShift += 7;
+   }
+   *puValue = uValue | ((size_t)*pucIn++ << uShift);
+   return pucIn;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the name of oNode, the last component of its path, storing
+   its length in *puLength. */
+
+static const char *Louds_nodeName(Node oNode, size_t *puLength)
+{
+   Node oParent = Node_getParent(oNode);
+   size_t uSkip = 0;
+
+   if (oParent != NULL)
+      uSkip = Node_getPathLength(oParent) + 1;
+   *puLength = Node_getPathLength(oNode) - uSkip;
+   return Node_getPath(oNode) + uSkip;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Front-code the names of the nodes of oLouds, which are apoOrder's,
+   into its blocks.  Return 1 (TRUE) if successful, or 0 (FALSE) if
+   insufficient memory is available. */
+
+static int Louds_encodeNames(Louds_T oLouds, Node *apoOrder)
+{
+   unsigned char *pucNew;
+   unsigned char *pucOut;
+   const char *pcName;
+   const char *pcPrevious = NULL;
+   size_t uCapacity;
+   size_t uLength;
+   size_t uPreviousLength = 0;
+   size_t uShared;
+   size_t uIndex;
+
+   oLouds->uBlocks = (oLouds->uLength + LOUDS_BLOCK_NAMES - 1) /
+      LOUDS_BLOCK_NAMES;
+   oLouds->auBlocks = malloc(oLouds->uBlocks * sizeof(size_t));
+   uCapacity = oLouds->uLength * 8 + 2 * MAX_VARINT;
+   oLouds->pucNames = malloc(uCapacity);
+   STATS_ADD(mallocs, 2);
+   if (oLouds->auBlocks == NULL || oLouds->pucNames == NULL)
+      return 0;
+
+   for (uIndex = 0; uIndex < oLouds->uLength; uIndex++)
+   {
+      pcName = Louds_nodeName(apoOrder[uIndex], &uLength);
+      uShared = 0;
+      if (uIndex % LOUDS_BLOCK_NAMES == 0)
+         oLouds->auBlocks[uIndex / LOUDS_BLOCK_NAMES] =
+            oLouds->uNameBytes;
+      else
+         while (uShared < uLength && uShared < uPreviousLength &&
+                pcName[uShared] == pcPrevious[uShared])
+            uShared++;
+
+      if (oLouds->uNameBytes + 2 * MAX_VARINT + uLength > uCapacity)
+      {
+         uCapacity = 2 * uCapacity + uLength;
+         pucNew = realloc(oLouds->pucNames, uCapacity);
+         if (pucNew == NULL)
+            return 0;
+         oLouds->pucNames = pucNew;
+      }
+      pucOut = oLouds->pucNames + oLouds->uNameBytes;
+      pucOut = Louds_putVarint(pucOut, uShared);
+      pucOut = Louds_putVarint(pucOut, uLength - uShared);
+      memcpy(pucOut, pcName + uShared, uLength - uShared);
+      pucOut += uLength - uShared;
+      oLouds->uNameBytes = (size_t)(pucOut - oLouds->pucNames);
+
+      if (uLength > oLouds->uMaxNameLength)
+         oLouds->uMaxNameLength = uLength;
+      pcPrevious = pcName;
+      uPreviousLength = uLength;
+   }
+
+   pucNew = realloc(oLouds->pucNames, oLouds->uNameBytes + 1);
+   if (pucNew != NULL)
+      oLouds->pucNames = pucNew;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+Louds_T Louds_new(Node oRoot, size_t uCount)
+{
+   Louds_T oLouds;
+   Node *apoOrder;
+   Node oNode;
+   size_t uTail = 1;
+   size_t uHead;
+   size_t uChild;
+   size_t uChildren;
+   size_t uBit = 2;
+   size_t uFile = 0;
+   size_t uMaxLength = 0;
+   int iSuccessful;
+
+   assert(oRoot != NULL || uCount == 0);
+
+   oLouds = calloc(1, sizeof(struct Louds));
+   if (oLouds == NULL)
+      return NULL;
+   STATS_ADD(mallocs, 1);
+   if (oRoot == NULL)
+      return oLouds;
+
+   oLouds->uLength = uCount;
+   apoOrder = malloc(uCount * sizeof(Node));
+   STATS_ADD(mallocs, 1);
+   iSuccessful = apoOrder != NULL &&
+      Louds_bitsNew(&oLouds->sShape, 2 * uCount + 1) &&
+      Louds_bitsNew(&oLouds->sFiles, uCount);
+
+   /* Number the Nodes breadth first, giving each its 1 bit among its
+      parent's children and its own 0 bit, in that order. */
+   if (iSuccessful)
+   {
+      apoOrder[0] = oRoot;
+      Louds_bitSet(&oLouds->sShape, 0);
+      for (uHead = 0; uHead < uTail; uHead++)
+      {
+         oNode = apoOrder[uHead];
+         if (Node_getPathLength(oNode) > oLouds->uMaxPathLength)
+            oLouds->uMaxPathLength = Node_getPathLength(oNode);
+         if (Node_getType(oNode) == FILE_S)
+         {
+            Louds_bitSet(&oLouds->sFiles, uHead);
+            oLouds->uFiles++;
+            if (Node_getFileLength(oNode) > uMaxLength)
+               uMaxLength = Node_getFileLength(oNode);
+         }
+         else
+         {
+            uChildren = Node_getNumChildren(oNode);
+            for (uChild = 0; uChild < uChildren; uChild++)
+            {
+               assert(uTail < uCount);
+               apoOrder[uTail++] = Node_getChild(oNode, uChild);
+               Louds_bitSet(&oLouds->sShape, uBit++);
+            }
+         }
+         uBit++;
+      }
+      assert(uTail == uCount && uBit == 2 * uCount + 1);
+
+      while (uMaxLength > 0)
+      {
+         oLouds->uLengthBits++;
+         uMaxLength >>= 1;
+      }
+      oLouds->aulLengths =
+         calloc(Louds_words(oLouds->uFiles * oLouds->uLengthBits) + 1,
+                sizeof(unsigned long));
+      STATS_ADD(mallocs, 1);
+      iSuccessful = oLouds->aulLengths != NULL;
+   }
+
+   if (iSuccessful)
+   {
+      for (uHead = 0; uHead < uCount; uHead++)
+         if (Node_getType(apoOrder[uHead]) == FILE_S)
+            Louds_setField(oLouds->aulLengths, uFile++,
+                           oLouds->uLengthBits,
+                           Node_getFileLength(apoOrder[uHead]));
+      iSuccessful = Louds_encodeNames(oLouds, apoOrder) &&
+         Louds_bitsIndex(&oLouds->sShape) &&
+         Louds_bitsIndex(&oLouds->sFiles);
+   }
+
+   free(apoOrder);
+   STATS_ADD(frees, 1);
+   if (!iSuccessful)
+   {
+      Louds_free(oLouds);
+      return NULL;
+   }
+   return oLouds;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Louds_free(Louds_T oLouds)
+{
+   if (oLouds == NULL)
+      return;
+
+   Louds_bitsFree(&oLouds->sShape);
+   Louds_bitsFree(&oLouds->sFiles);
+   free(oLouds->aulLengths);
+   free(oLouds->pucNames);
+   free(oLouds->auBlocks);
+   free(oLouds);
+   STATS_ADD(frees, 4);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write uValue to psFile as 8 bytes, least significant first.  Return
+   1 (TRUE) if successful, or 0 (FALSE) if not. */
+
+static int Louds_writeSize(FILE *psFile, size_t uValue)
+{
+   int i;
+
+   for (i = 0; i < 8; i++)
+   {
+      if (putc((int)(uValue & 0xff), psFile) == EOF)
+         return 0;
+      uValue >>= 4;
+      uValue >>= 4;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read 8 bytes written by Louds_writeSize from psFile into *puValue.
+   Return 1 (TRUE) if successful, or 0 (FALSE) if they could not be
+   read or do not fit a size_t. */
+
+static int Louds_readSize(FILE *psFile, size_t *puValue)
+{
+   size_t uValue = 0;
+   size_t i;
+   int c;
+
+   for (i = 0; i < 8; i++)
+   {
+      c = getc(psFile);
+      if (c == EOF)
+         return 0;
+      if (i < sizeof(size_t))
+         uValue |= (size_t)c << (8 * i);
+      else if (c != 0)
+         return 0;
+   }
+   *puValue = uValue;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the first uBits bits of aulWords to psFile, 8 to a byte, from
+   the least significant.  Return 1 (TRUE) if successful, or 0 (FALSE)
+   if not. */
+
+static int Louds_putBits(FILE *psFile, const unsigned long *aulWords,
+                         size_t uBits)
+{
+   size_t uByte;
+   size_t uPos;
+
+   for (uByte = 0; uByte < (uBits + 7) / 8; uByte++)
+   {
+      uPos = uByte * 8;
+      if (putc((int)((aulWords[uPos / WORD_BITS] >> (uPos % WORD_BITS))
+                     & 0xff), psFile) == EOF)
+         return 0;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read uBits bits written by Louds_putBits from psFile into aulWords,
+   which must be 0, leaving the bits beyond them 0.  Return 1 (TRUE)
+   if successful, or 0 (FALSE) if not. */
+
+static int Louds_getBits(FILE *psFile, unsigned long *aulWords,
+                         size_t uBits)
+{
+   size_t uByte;
+   size_t uPos;
+   int c;
+
+   for (uByte = 0; uByte < (uBits + 7) / 8; uByte++)
+   {
+      c = getc(psFile);
+      if (c == EOF)
+         return 0;
+      uPos = uByte * 8;
+      if (uPos + 8 > uBits)
+         c &= (1 << (uBits - uPos)) - 1;
+      aulWords[uPos / WORD_BITS] |= (unsigned long)c << (uPos % WORD_BITS);
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Louds_write(Louds_T oLouds, FILE *psFile)
+{
+   size_t uBlock;
+
+   assert(oLouds != NULL);
+   assert(psFile != NULL);
+
+   if (fwrite(acMagic, 1, sizeof(acMagic), psFile) != sizeof(acMagic) ||
+       !Louds_writeSize(psFile, oLouds->uLength) ||
+       !Louds_writeSize(psFile, oLouds->uFiles) ||
+       !Louds_writeSize(psFile, oLouds->uLengthBits) ||
+       !Louds_writeSize(psFile, oLouds->uNameBytes) ||
+       !Louds_writeSize(psFile, oLouds->uMaxNameLength) ||
+       !Louds_writeSize(psFile, oLouds->uMaxPathLength))
+      return 0;
+   if (oLouds->uLength == 0)
+      return 1;
+
+   if (!Louds_putBits(psFile, oLouds->sShape.aulWords,
+                      oLouds->sShape.uLength) ||
+       !Louds_putBits(psFile, oLouds->sFiles.aulWords,
+                      oLouds->sFiles.uLength) ||
+       !Louds_putBits(psFile, oLouds->aulLengths,
+                      oLouds->uFiles * oLouds->uLengthBits))
+      return 0;
+   for (uBlock = 0; uBlock < oLouds->uBlocks; uBlock++)
+      if (!Louds_writeSize(psFile, oLouds->auBlocks[uBlock]))
+         return 0;
+   return fwrite(oLouds->pucNames, 1, oLouds->uNameBytes, psFile) ==
+      oLouds->uNameBytes;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read the parts of oLouds after its header from psFile.  Return 1
+   (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+   available or they cannot be read or are inconsistent. */
+
+static int Louds_readBody(Louds_T oLouds, FILE *psFile)
+{
+   size_t uBlock;
+
+   if (!Louds_bitsNew(&oLouds->sShape, 2 * oLouds->uLength + 1) ||
+       !Louds_bitsNew(&oLouds->sFiles, oLouds->uLength))
+      return 0;
+   oLouds->aulLengths =
+      calloc(Louds_words(oLouds->uFiles * oLouds->uLengthBits) + 1,
+             sizeof(unsigned long));
+   oLouds->uBlocks = (oLouds->uLength + LOUDS_BLOCK_NAMES - 1) /
+      LOUDS_BLOCK_NAMES;
+   oLouds->auBlocks = malloc(oLouds->uBlocks * sizeof(size_t));
+   oLouds->pucNames = malloc(oLouds->uNameBytes + 1);
+   STATS_ADD(mallocs, 3);
+   if (oLouds->aulLengths == NULL || oLouds->auBlocks == NULL ||
+       oLouds->pucNames == NULL)
+      return 0;
+
+   if (!Louds_getBits(psFile, oLouds->sShape.aulWords,
+                      oLouds->sShape.uLength) ||
+       !Louds_getBits(psFile, oLouds->sFiles.aulWords,
+                      oLouds->sFiles.uLength) ||
+       !Louds_getBits(psFile, oLouds->aulLengths,
+                      oLouds->uFiles * oLouds->uLengthBits))
+      return 0;
+   for (uBlock = 0; uBlock < oLouds->uBlocks; uBlock++)
+      if (!Louds_readSize(psFile, &oLouds->auBlocks[uBlock]) ||
+          oLouds->auBlocks[uBlock] >= oLouds->uNameBytes)
+         return 0;
+   if (fread(oLouds->pucNames, 1, oLouds->uNameBytes, psFile) !=
+       oLouds->uNameBytes)
+      return 0;
+
+   /* A shape of n nodes has n 1 bits, and ends with a 0 bit. */
+   return Louds_bitsIndex(&oLouds->sShape) &&
+      Louds_bitsIndex(&oLouds->sFiles) &&
+      oLouds->sShape.auRanks[oLouds->sShape.uSupers] == oLouds->uLength &&
+      !Louds_bitGet(&oLouds->sShape, 2 * oLouds->uLength) &&
+      oLouds->sFiles.auRanks[oLouds->sFiles.uSupers] == oLouds->uFiles;
+}
+
+/*--------------------------------------------------------------------*/
+
+Louds_T Louds_read(FILE *psFile)
+{
+   Louds_T oLouds;
+   char acHeader[sizeof(acMagic)];
+
+   assert(psFile != NULL);
+
+   if (fread(acHeader, 1, sizeof(acHeader), psFile) != sizeof(acHeader)
+       || memcmp(acHeader, acMagic, sizeof(acMagic)) != 0)
+      return NULL;
+
+   oLouds = calloc(1, sizeof(struct Louds));
+   if (oLouds == NULL)
+      return NULL;
+   STATS_ADD(mallocs, 1);
+   if (!Louds_readSize(psFile, &oLouds->uLength) ||
+       !Louds_readSize(psFile, &oLouds->uFiles) ||
+       !Louds_readSize(psFile, &oLouds->uLengthBits) ||
+       !Louds_readSize(psFile, &oLouds->uNameBytes) ||
+       !Louds_readSize(psFile, &oLouds->uMaxNameLength) ||
+       !Louds_readSize(psFile, &oLouds->uMaxPathLength) ||
+       oLouds->uLength > ((size_t)-1 - 1) / 2 / LOUDS_BLOCK_NAMES ||
+       oLouds->uFiles > oLouds->uLength ||
+       oLouds->uLengthBits > WORD_BITS ||
+       (oLouds->uLength > 0 && !Louds_readBody(oLouds, psFile)))
+   {
+      Louds_free(oLouds);
+      return NULL;
+   }
+   return oLouds;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t Louds_getLength(Louds_T oLouds)
+{
+   assert(oLouds != NULL);
+
+   return oLouds->uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t Louds_getSize(Louds_T oLouds)
+{
+   size_t uSize = sizeof(struct Louds);
+
+   assert(oLouds != NULL);
+
+   if (oLouds->uLength == 0)
+      return uSize;
+   uSize += (Louds_words(oLouds->sShape.uLength) + 1 +
+             Louds_words(oLouds->sFiles.uLength) + 1 +
+             Louds_words(oLouds->uFiles * oLouds->uLengthBits) + 1) *
+      sizeof(unsigned long);
+   uSize += (oLouds->sShape.uSupers + 1 + oLouds->sFiles.uSupers + 1 +
+             oLouds->uBlocks) * sizeof(size_t);
+   return uSize + oLouds->uNameBytes + 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store the index of the first child of the uNode'th node of oLouds
+   in *puFirst, and the number of its children in *puCount. */
+
+static void Louds_children(Louds_T oLouds, size_t uNode,
+                           size_t *puFirst, size_t *puCount)
+{
+   size_t uStart;
+   size_t uEnd;
+
+   uStart = Louds_select(&oLouds->sShape, 0, uNode + 1);
+   uEnd = Louds_select(&oLouds->sShape, 0, uNode + 2);
+   *puFirst = Louds_rank1(&oLouds->sShape, uStart + 1);
+   *puCount = uEnd - uStart - 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return <0, 0, or >0 as the first name of the uBlock'th block of
+   oLouds is less than, equal to, or greater than the uLength
+   characters at pcName. */
+
+static int Louds_compareHead(Louds_T oLouds, size_t uBlock,
+                             const char *pcName, size_t uLength)
+{
+   const unsigned char *puc;
+   size_t uShared;
+   size_t uHeadLength;
+   int iCmp;
+
+   puc = oLouds->pucNames + oLouds->auBlocks[uBlock];
+   puc = Louds_getVarint(puc, &uShared);
+   puc = Louds_getVarint(puc, &uHeadLength);
+   assert(uShared == 0);
+
+   STATS_COMPARE((const char *)puc, pcName,
+                 uHeadLength < uLength ? uHeadLength : uLength);
+   iCmp = memcmp(puc, pcName,
+                 uHeadLength < uLength ? uHeadLength : uLength);
+   if (iCmp != 0)
+      return iCmp;
+   if (uHeadLength < uLength)
+      return -1;
+   return uHeadLength > uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Scan the names of oLouds from the start of the uBlock'th block for
+   one equal to the uLength characters at pcName among those of
+   indices uTestLo up to uTestHi.  No name is decoded: the scan only
+   tracks how long a prefix of pcName each name shares, which follows
+   from the prefix it shares with the name before it.  If there is
+   one, then assign its index to *puNode and return 1 (TRUE),
+   otherwise return 0 (FALSE). */
+
+static int Louds_scanBlock(Louds_T oLouds, size_t uBlock,
+                           size_t uTestLo, size_t uTestHi,
+                           const char *pcName, size_t uLength,
+                           size_t *puNode)
+{
+   const unsigned char *puc;
+   size_t uIndex;
+   size_t uShared;
+   size_t uRest;
+   size_t uMatch = 0;
+
+   puc = oLouds->pucNames + oLouds->auBlocks[uBlock];
+   for (uIndex = uBlock * LOUDS_BLOCK_NAMES; uIndex < uTestHi; uIndex++)
+   {
+      puc = Louds_getVarint(puc, &uShared);
+      puc = Louds_getVarint(puc, &uRest);
+      if (uShared == uMatch)
+      {
+         uRest += uShared;
+         while (uMatch < uRest && uMatch < uLength &&
+                puc[uMatch - uShared] == (unsigned char)pcName[uMatch])
+            uMatch++;
+         uRest -= uShared;
+      }
+      else if (uShared < uMatch)
+         uMatch = uShared;
+      if (uIndex >= uTestLo && uMatch == uLength &&
+          uShared + uRest == uLength)
+      {
+         *puNode = uIndex;
+         return 1;
+      }
+      puc += uRest;
+   }
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Search the nodes of oLouds of indices uLo up to uHi, whose names
+   must be sorted, for the one named by the uLength characters at
+   pcName: a binary search among the blocks that begin in that range,
+   by their first names, then a scan of one block.  If there is one,
+   then assign its index to *puNode and return 1 (TRUE), otherwise
+   return 0 (FALSE). */
+
+static int Louds_searchRun(Louds_T oLouds, size_t uLo, size_t uHi,
+                           const char *pcName, size_t uLength,
+                           size_t *puNode)
+{
+   size_t uFirstHead;
+   size_t uLastHead;
+   size_t uMid;
+   size_t uBlock;
+   size_t uTestLo = uLo;
+   size_t uTestHi = uHi;
+
+   if (uLo >= uHi)
+      return 0;
+
+   uFirstHead = (uLo + LOUDS_BLOCK_NAMES - 1) / LOUDS_BLOCK_NAMES;
+   uLastHead = (uHi - 1) / LOUDS_BLOCK_NAMES;
+   uBlock = uLo / LOUDS_BLOCK_NAMES;
+   if (uFirstHead <= uLastHead)
+   {
+      if (Louds_compareHead(oLouds, uFirstHead, pcName, uLength) > 0)
+         /* pcName sorts before every block of the range */
+         uTestHi = uFirstHead * LOUDS_BLOCK_NAMES;
+      else
+      {
+         /* find the last block whose first name is not after it */
+         uBlock = uFirstHead;
+         uLastHead++;
+         while (uLastHead - uBlock > 1)
+         {
+            uMid = uBlock + (uLastHead - uBlock) / 2;
+            if (Louds_compareHead(oLouds, uMid, pcName, uLength) <= 0)
+               uBlock = uMid;
+            else
+               uLastHead = uMid;
+         }
+         uTestLo = uBlock * LOUDS_BLOCK_NAMES;
+         if (uTestLo + LOUDS_BLOCK_NAMES < uHi)
+            uTestHi = uTestLo + LOUDS_BLOCK_NAMES;
+      }
+   }
+   return Louds_scanBlock(oLouds, uBlock, uTestLo, uTestHi, pcName,
+                          uLength, puNode);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Find the node of oLouds whose path is pcPath.  If there is one,
+   then assign its index to *puNode and return 1 (TRUE), otherwise
+   return 0 (FALSE). */
+
+static int Louds_find(Louds_T oLouds, const char *pcPath, size_t *puNode)
+{
+   size_t uNode;
+   size_t uLength;
+   size_t uFirst;
+   size_t uCount;
+   size_t uFiles;
+
+   assert(oLouds != NULL);
+   assert(pcPath != NULL);
+
+   if (oLouds->uLength == 0)
+      return 0;
+   while (*pcPath == '/')
+      pcPath++;
+   if (*pcPath == '\0')
+      return 0;
+
+   STATS_ADD(traversals, 1);
+   uLength = strcspn(pcPath, "/");
+   if (!Louds_searchRun(oLouds, 0, 1, pcPath, uLength, &uNode))
+      return 0;
+   for (;;)
+   {
+      STATS_ADD(nodesVisited, 1);
+      pcPath += uLength;
+      while (*pcPath == '/')
+         pcPath++;
+      if (*pcPath == '\0')
+         break;
+      if (Louds_bitGet(&oLouds->sFiles, uNode))
+         return 0;
+
+      /* A directory's files come first, then its directories, each
+         sorted by name. */
+      uLength = strcspn(pcPath, "/");
+      Louds_children(oLouds, uNode, &uFirst, &uCount);
+      uFiles = Louds_rank1(&oLouds->sFiles, uFirst + uCount) -
+         Louds_rank1(&oLouds->sFiles, uFirst);
+      if (!Louds_searchRun(oLouds, uFirst, uFirst + uFiles, pcPath,
+                           uLength, &uNode) &&
+          !Louds_searchRun(oLouds, uFirst + uFiles, uFirst + uCount,
+                           pcPath, uLength, &uNode))
+         return 0;
+   }
+
+   *puNode = uNode;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+boolean Louds_containsDir(Louds_T oLouds, const char *pcPath)
+{
+   size_t uNode;
+
+   return (boolean)(Louds_find(oLouds, pcPath, &uNode) &&
+                    !Louds_bitGet(&oLouds->sFiles, uNode));
+}
+
+/*--------------------------------------------------------------------*/
+
+boolean Louds_containsFile(Louds_T oLouds, const char *pcPath)
+{
+   size_t uNode;
+
+   return (boolean)(Louds_find(oLouds, pcPath, &uNode) &&
+                    Louds_bitGet(&oLouds->sFiles, uNode));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the length of the uNode'th node of oLouds, which must be a
+   file. */
+
+static size_t Louds_fileLength(Louds_T oLouds, size_t uNode)
+{
+   assert(Louds_bitGet(&oLouds->sFiles, uNode));
+
+   return Louds_getField(oLouds->aulLengths,
+                         Louds_rank1(&oLouds->sFiles, uNode),
+                         oLouds->uLengthBits);
+}
+
+/*--------------------------------------------------------------------*/
+
+int Louds_stat(Louds_T oLouds, const char *pcPath, boolean *pbIsFile,
+               size_t *puLength)
+{
+   size_t uNode;
+
+   assert(pbIsFile != NULL);
+   assert(puLength != NULL);
+
+   if (!Louds_find(oLouds, pcPath, &uNode))
+      return NO_SUCH_PATH;
+   *pbIsFile = (boolean)Louds_bitGet(&oLouds->sFiles, uNode);
+   if (*pbIsFile)
+      *puLength = Louds_fileLength(oLouds, uNode);
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Decode the name at pucIn into pcName, which holds the name before
+   it, storing its length in *puLength.  Return the start of the next
+   name. */
+
+static const unsigned char *Louds_decodeName(const unsigned char *pucIn,
+                                             char *pcName,
+                                             size_t *puLength)
+{
+   size_t uShared;
+   size_t uRest;
+
+   pucIn = Louds_getVarint(pucIn, &uShared);
+   pucIn = Louds_getVarint(pucIn, &uRest);
+   memcpy(pcName + uShared, pucIn, uRest);
+   *puLength = uShared + uRest;
+   return pucIn + uRest;
+}
+
+/* The next two functions call each other. */
+
+static int Louds_visitChildren(Louds_T oLouds, size_t uNode,
+                               char *pcPath, size_t uPathLength,
+                               int iRecurse, Louds_Visit pfVisit,
+                               void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Call *pfVisit on the uNode'th node of oLouds, whose path is the
+   first uPathLength characters of pcPath, then, if iRecurse is 1
+   (TRUE), on every node beneath it in pre-order.  Return 1 (TRUE), or
+   0 (FALSE) if *pfVisit returned FALSE. */
+
+static int Louds_visitNode(Louds_T oLouds, size_t uNode, char *pcPath,
+                           size_t uPathLength, int iRecurse,
+                           Louds_Visit pfVisit, void *pvExtra)
+{
+   boolean bIsFile = (boolean)Louds_bitGet(&oLouds->sFiles, uNode);
+
+   pcPath[uPathLength] = '\0';
+   if (!(*pfVisit)(pcPath, bIsFile,
+                   bIsFile ? Louds_fileLength(oLouds, uNode) : 0,
+                   pvExtra))
+      return 0;
+   if (iRecurse && !bIsFile)
+      return Louds_visitChildren(oLouds, uNode, pcPath, uPathLength, 1,
+                                 pfVisit, pvExtra);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Call Louds_visitNode on each child of the uNode'th node of oLouds,
+   a directory whose path is the first uPathLength characters of
+   pcPath.  Each child's name is decoded in place after that path,
+   from the name of the child before it, which the visits beneath
+   that child leave alone.  Return 1 (TRUE), or 0 (FALSE) if *pfVisit
+   returned FALSE. */
+
+static int Louds_visitChildren(Louds_T oLouds, size_t uNode,
+                               char *pcPath, size_t uPathLength,
+                               int iRecurse, Louds_Visit pfVisit,
+                               void *pvExtra)
+{
+   const unsigned char *puc;
+   char *pcName;
+   size_t uFirst;
+   size_t uCount;
+   size_t uIndex;
+   size_t uLength = 0;
+
+   Louds_children(oLouds, uNode, &uFirst, &uCount);
+   if (uCount == 0)
+      return 1;
+
+   pcPath[uPathLength] = '/';
+   pcName = pcPath + uPathLength + 1;
+   puc = oLouds->pucNames +
+      oLouds->auBlocks[uFirst / LOUDS_BLOCK_NAMES];
+   for (uIndex = uFirst - uFirst % LOUDS_BLOCK_NAMES; uIndex < uFirst;
+        uIndex++)
+      puc = Louds_decodeName(puc, pcName, &uLength);
+
+   for (uIndex = uFirst; uIndex < uFirst + uCount; uIndex++)
+   {
+      puc = Louds_decodeName(puc, pcName, &uLength);
+      if (!Louds_visitNode(oLouds, uIndex, pcPath,
+                           uPathLength + 1 + uLength, iRecurse, pfVisit,
+                           pvExtra))
+         return 0;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a buffer large enough for any path of oLouds, and the name
+   of any node decoded after it, or NULL if insufficient memory is
+   available. */
+
+static char *Louds_pathBuffer(Louds_T oLouds)
+{
+   char *pcPath;
+
+   pcPath = malloc(oLouds->uMaxPathLength + oLouds->uMaxNameLength + 2);
+   if (pcPath != NULL)
+      STATS_ADD(mallocs, 1);
+   return pcPath;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Louds_list(Louds_T oLouds, const char *pcPath, Louds_Visit pfVisit,
+               void *pvExtra)
+{
+   char *pcBuffer;
+   size_t uNode;
+   size_t uLength;
+   size_t uPathLength = 0;
+
+   assert(pfVisit != NULL);
+
+   if (!Louds_find(oLouds, pcPath, &uNode))
+      return NO_SUCH_PATH;
+   if (Louds_bitGet(&oLouds->sFiles, uNode))
+      return NOT_A_DIRECTORY;
+   pcBuffer = Louds_pathBuffer(oLouds);
+   if (pcBuffer == NULL)
+      return MEMORY_ERROR;
+
+   /* The directory's path, as Node_getPath would spell it. */
+   for (;;)
+   {
+      while (*pcPath == '/')
+         pcPath++;
+      if (*pcPath == '\0')
+         break;
+      if (uPathLength > 0)
+         pcBuffer[uPathLength++] = '/';
+      uLength = strcspn(pcPath, "/");
+      memcpy(pcBuffer + uPathLength, pcPath, uLength);
+      uPathLength += uLength;
+      pcPath += uLength;
+   }
+
+   (void)Louds_visitChildren(oLouds, uNode, pcBuffer, uPathLength, 0,
+                             pfVisit, pvExtra);
+   free(pcBuffer);
+   STATS_ADD(frees, 1);
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Louds_enumerate(Louds_T oLouds, Louds_Visit pfVisit, void *pvExtra)
+{
+   char *pcBuffer;
+   size_t uLength;
+
+   assert(oLouds != NULL);
+   assert(pfVisit != NULL);
+
+   if (oLouds->uLength == 0)
+      return SUCCESS;
+   pcBuffer = Louds_pathBuffer(oLouds);
+   if (pcBuffer == NULL)
+      return MEMORY_ERROR;
+
+   (void)Louds_decodeName(oLouds->pucNames, pcBuffer, &uLength);
+   (void)Louds_visitNode(oLouds, 0, pcBuffer, uLength, 1, pfVisit,
+                         pvExtra);
+   free(pcBuffer);
+   STATS_ADD(frees, 1);
+   return SUCCESS;
+}
@@ -0,0 +1,126 @@
+/*--------------------------------------------------------------------*/
+/* louds.h                                                            */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#ifndef LOUDS_INCLUDED
+#define LOUDS_INCLUDED
+
+#include <stddef.h>
+#include <stdio.h>
+#include "a4def.h"
+#include "node.h"
+
+/* A Louds_T object is a read-only archive of a hierarchy of Nodes in
+   succinct form, small enough to keep billions of entries in memory.
+   Its shape is a level-order unary degree sequence (LOUDS): each
+   node, in breadth-first order, contributes a 1 bit per child and a
+   0 bit, so that the shape takes about 2 bits per node, and rank and
+   select over those bits lead from a node to its parent and children.
+   One more bit per node tells files from directories, the lengths of
+   files are packed into as few bits as the longest needs, and the
+   names are front-coded in blocks: each stores only what differs
+   from the name before it.  Contents are not archived.  The queries
+   below are the read operations of ft.h, on the same paths, and
+   allocate no memory except where noted; none change the archive, so
+   any number may run at once. */
+
+typedef struct Louds *Louds_T;
+
+/* A function called once per node visited by Louds_list or
+   Louds_enumerate, with the node's full path, whether it is a file
+   (TRUE) or a directory (FALSE), the file's length (0 for a
+   directory), and the pvExtra passed to the listing.  Returns TRUE to
+   continue the listing, or FALSE to stop it early.  The path is valid
+   only during the call. */
+
+typedef boolean (*Louds_Visit)(const char *pcPath, boolean bIsFile,
+                               size_t uLength, void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new Louds_T object archiving the uCount Nodes of the
+   hierarchy rooted at oRoot, which may be NULL for an empty
+   hierarchy, walking it with Node_getChild, or NULL if insufficient
+   memory is available. */
+
+Louds_T Louds_new(Node oRoot, size_t uCount);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oLouds. */
+
+void Louds_free(Louds_T oLouds);
+
+/*--------------------------------------------------------------------*/
+
+/* Write oLouds to psFile, in a form independent of the word size and
+   byte order of the machine.  Return 1 (TRUE) if successful, or 0
+   (FALSE) if a write failed. */
+
+int Louds_write(Louds_T oLouds, FILE *psFile);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new Louds_T object read from psFile, as Louds_write wrote
+   it, or NULL if psFile does not hold one or insufficient memory is
+   available. */
+
+Louds_T Louds_read(FILE *psFile);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of nodes in oLouds. */
+
+size_t Louds_getLength(Louds_T oLouds);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bytes of memory oLouds occupies. */
+
+size_t Louds_getSize(Louds_T oLouds);
+
+/*--------------------------------------------------------------------*/
+
+/* Return TRUE if oLouds has a directory with path pcPath, and FALSE
+   otherwise.  Paths are as for FT_containsDir. */
+
+boolean Louds_containsDir(Louds_T oLouds, const char *pcPath);
+
+/*--------------------------------------------------------------------*/
+
+/* Return TRUE if oLouds has a file with path pcPath, and FALSE
+   otherwise. */
+
+boolean Louds_containsFile(Louds_T oLouds, const char *pcPath);
+
+/*--------------------------------------------------------------------*/
+
+/* As FT_stat: if oLouds has a node with path pcPath, store in
+   *pbIsFile whether it is a file, and if so its length in *puLength,
+   and return SUCCESS; otherwise return NO_SUCH_PATH. */
+
+int Louds_stat(Louds_T oLouds, const char *pcPath, boolean *pbIsFile,
+               size_t *puLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Call *pfVisit on each child of the directory of oLouds at path
+   pcPath, in the order FT_toString lists them, until it returns
+   FALSE.  Return SUCCESS if the directory was listed, NO_SUCH_PATH if
+   there is no node at pcPath, NOT_A_DIRECTORY if it is a file, or
+   MEMORY_ERROR if insufficient memory is available for the paths. */
+
+int Louds_list(Louds_T oLouds, const char *pcPath, Louds_Visit pfVisit,
+               void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Call *pfVisit on every node of oLouds in pre-order, the order
+   FT_toString lists them, until it returns FALSE.  Return SUCCESS, or
+   MEMORY_ERROR if insufficient memory is available for the paths. */
+
+int Louds_enumerate(Louds_T oLouds, Louds_Visit pfVisit,
+                    void *pvExtra);
+
+#endif
@@ -0,0 +1,624 @@
+/*--------------------------------------------------------------------*/
+/* nameindex.c                                                        */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#include "nameindex.h"
+#include "stats.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The number of buckets a new NameIndex starts with.  The table
+   doubles whenever it holds more groups than buckets. */
+
+enum { INITIAL_BUCKETS = 64 };
+
+/*--------------------------------------------------------------------*/
+
+/* A group gathers the members that share one key.  A name group's
+   members are the Nodes with that name, and an extension group's are
+   the name groups with that extension.  Neither stores its key: a
+   name group's is the name of its first member, and an extension
+   group's is the extension of its first member's key, so a group
+   holds its key only as long as it has members. */
+
+struct NameGroup
+{
+   /* The next group in the same bucket, or NULL. */
+   struct NameGroup *psNext;
+
+   /* The hash of the key, by Node_hashName. */
+   unsigned long ulHash;
+
+   /* 1 (TRUE) for an extension group, 0 (FALSE) for a name group. */
+   int iIsExtension;
+
+   /* The members, uLength of them in an array of uCapacity.  Most
+      names are carried by only one Node, so the array starts as
+      pvFirst, and is only allocated once it needs room for two. */
+   void **ppvMembers;
+   size_t uLength;
+   size_t uCapacity;
+   void *pvFirst;
+
+   /* For a name group with an extension, that extension's group and
+      this group's index among its members; otherwise NULL and 0. */
+   struct NameGroup *psExtension;
+   size_t uExtensionSlot;
+};
+
+/* A NameIndex is a hash table of groups, chained in buckets. */
+
+struct NameIndex
+{
+   /* The buckets, uBuckets of them. */
+   struct NameGroup **ppsBuckets;
+   size_t uBuckets;
+
+   /* The number of groups in the table. */
+   size_t uGroups;
+
+   /* The number of bytes allocated. */
+   size_t uBytes;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the name of oNode: the last component of its path.  Store
+   its length in *puLength. */
+
+static const char *NameIndex_name(Node oNode, size_t *puLength)
+{
+   Node oParent;
+   size_t uOffset = 0;
+
+   assert(oNode != NULL);
+   assert(puLength != NULL);
+
+   oParent = Node_getParent(oNode);
+   if (oParent != NULL)
+      uOffset = Node_getPathLength(oParent) + 1;
+   *puLength = Node_getPathLength(oNode) - uOffset;
+   return Node_getPath(oNode) + uOffset;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the extension of the uLength characters at pcName, from its
+   last '.' on, if that '.' is not its first character, and store its
+   length in *puLength.  Return NULL if pcName has no extension. */
+
+static const char *NameIndex_extension(const char *pcName,
+                                       size_t uLength,
+                                       size_t *puLength)
+{
+   size_t uDot = uLength;
+
+   assert(pcName != NULL);
+   assert(puLength != NULL);
+
+   while (uDot > 1 && pcName[uDot - 1] != '.')
+      uDot--;
+   if (uDot <= 1)
+      return NULL;
+   *puLength = uLength - (uDot - 1);
+   return pcName + uDot - 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the key of *psGroup, which must have a member, and store its
+   length in *puLength. */
+
+static const char *NameIndex_key(const struct NameGroup *psGroup,
+                                 size_t *puLength)
+{
+   const struct NameGroup *psName;
+   const char *pcName;
+   size_t uLength;
+
+   assert(psGroup != NULL);
+   assert(psGroup->uLength > 0);
+   assert(puLength != NULL);
+
+   if (!psGroup->iIsExtension)
+      return NameIndex_name((Node)psGroup->ppvMembers[0], puLength);
+
+   psName = (const struct NameGroup *)psGroup->ppvMembers[0];
+   pcName = NameIndex_name((Node)psName->ppvMembers[0], &uLength);
+   return NameIndex_extension(pcName, uLength, puLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the group of oIndex for the key of uLength characters at
+   pcKey, whose hash is ulHash: an extension group if iIsExtension is
+   1 (TRUE), or a name group if it is 0 (FALSE).  Return NULL if there
+   is none. */
+
+static struct NameGroup *NameIndex_find(NameIndex_T oIndex,
+                                        const char *pcKey,
+                                        size_t uLength,
+                                        unsigned long ulHash,
+                                        int iIsExtension)
+{
+   struct NameGroup *psGroup;
+   const char *pcGroupKey;
+   size_t uGroupLength;
+
+   assert(oIndex != NULL);
+   assert(pcKey != NULL);
+
+   for (psGroup = oIndex->ppsBuckets[ulHash % oIndex->uBuckets];
+        psGroup != NULL; psGroup = psGroup->psNext)
+   {
+      if (psGroup->ulHash != ulHash ||
+          psGroup->iIsExtension != iIsExtension)
+         continue;
+      pcGroupKey = NameIndex_key(psGroup, &uGroupLength);
+      STATS_COMPARE(pcKey, pcGroupKey, uLength);
+      if (uGroupLength == uLength &&
+          memcmp(pcGroupKey, pcKey, uLength) == 0)
+         return psGroup;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new group with hash ulHash, an extension group if
+   iIsExtension is 1 (TRUE), with room for one member but none yet.
+   It is not yet in oIndex's table.  Return NULL if insufficient
+   memory is available. */
+
+static struct NameGroup *NameIndex_newGroup(NameIndex_T oIndex,
+                                            unsigned long ulHash,
+                                            int iIsExtension)
+{
+   struct NameGroup *psGroup;
+
+   assert(oIndex != NULL);
+
+   psGroup = malloc(sizeof(struct NameGroup));
+   if (psGroup == NULL)
+      return NULL;
+   STATS_ADD(mallocs, 1);
+   oIndex->uBytes += sizeof(struct NameGroup);
+
+   psGroup->psNext = NULL;
+   psGroup->ulHash = ulHash;
+   psGroup->iIsExtension = iIsExtension;
+   psGroup->ppvMembers = &psGroup->pvFirst;
+   psGroup->uLength = 0;
+   psGroup->uCapacity = 1;
+   psGroup->psExtension = NULL;
+   psGroup->uExtensionSlot = 0;
+   return psGroup;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free *psGroup, which is not in oIndex's table. */
+
+static void NameIndex_freeGroup(NameIndex_T oIndex,
+                                struct NameGroup *psGroup)
+{
+   assert(oIndex != NULL);
+   assert(psGroup != NULL);
+
+   oIndex->uBytes -= sizeof(struct NameGroup);
+   if (psGroup->ppvMembers != &psGroup->pvFirst)
+   {
+      oIndex->uBytes -= psGroup->uCapacity * sizeof(void *);
+      free(psGroup->ppvMembers);
+      STATS_ADD(frees, 1);
+   }
+   free(psGroup);
+   STATS_ADD(frees, 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Double the number of buckets of oIndex, if enough memory is
+   available; if not, its chains simply stay longer. */
+
+static void NameIndex_grow(NameIndex_T oIndex)
+{
+   struct NameGroup **ppsBuckets;
+   struct NameGroup *psGroup;
+   struct NameGroup *psNext;
+   size_t uBuckets;
+   size_t uBucket;
+
+   assert(oIndex != NULL);
+
+   uBuckets = oIndex->uBuckets * 2;
+   ppsBuckets = calloc(uBuckets, sizeof(struct NameGroup *));
+   if (ppsBuckets == NULL)
+      return;
+   STATS_ADD(mallocs, 1);
+
+   for (uBucket = 0; uBucket < oIndex->uBuckets; uBucket++)
+      for (psGroup = oIndex->ppsBuckets[uBucket]; psGroup != NULL;
+           psGroup = psNext)
+      {
+         psNext = psGroup->psNext;
+         psGroup->psNext = ppsBuckets[psGroup->ulHash % uBuckets];
+         ppsBuckets[psGroup->ulHash % uBuckets] = psGroup;
+      }
+
+   free(oIndex->ppsBuckets);
+   STATS_ADD(frees, 1);
+   oIndex->uBytes += (uBuckets - oIndex->uBuckets)
+      * sizeof(struct NameGroup *);
+   oIndex->ppsBuckets = ppsBuckets;
+   oIndex->uBuckets = uBuckets;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put *psGroup into oIndex's table. */
+
+static void NameIndex_link(NameIndex_T oIndex, struct NameGroup *psGroup)
+{
+   size_t uBucket;
+
+   assert(oIndex != NULL);
+   assert(psGroup != NULL);
+
+   if (oIndex->uGroups >= oIndex->uBuckets)
+      NameIndex_grow(oIndex);
+   uBucket = psGroup->ulHash % oIndex->uBuckets;
+   psGroup->psNext = oIndex->ppsBuckets[uBucket];
+   oIndex->ppsBuckets[uBucket] = psGroup;
+   oIndex->uGroups++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Take *psGroup out of oIndex's table and free it. */
+
+static void NameIndex_unlink(NameIndex_T oIndex,
+                             struct NameGroup *psGroup)
+{
+   struct NameGroup **ppsLink;
+
+   assert(oIndex != NULL);
+   assert(psGroup != NULL);
+
+   ppsLink = &oIndex->ppsBuckets[psGroup->ulHash % oIndex->uBuckets];
+   while (*ppsLink != psGroup)
+      ppsLink = &(*ppsLink)->psNext;
+   *ppsLink = psGroup->psNext;
+   oIndex->uGroups--;
+   NameIndex_freeGroup(oIndex, psGroup);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add pvMember to the end of *psGroup's members, and store its index
+   among them in *puSlot.  Return 1 (TRUE) if successful, or 0 (FALSE)
+   if insufficient memory is available. */
+
+static int NameIndex_append(NameIndex_T oIndex,
+                            struct NameGroup *psGroup, void *pvMember,
+                            size_t *puSlot)
+{
+   void **ppvMembers;
+
+   assert(oIndex != NULL);
+   assert(psGroup != NULL);
+   assert(puSlot != NULL);
+
+   if (psGroup->uLength == psGroup->uCapacity &&
+       psGroup->ppvMembers == &psGroup->pvFirst)
+   {
+      ppvMembers = malloc(2 * sizeof(void *));
+      if (ppvMembers == NULL)
+         return 0;
+      STATS_ADD(mallocs, 1);
+      oIndex->uBytes += 2 * sizeof(void *);
+      ppvMembers[0] = psGroup->pvFirst;
+      psGroup->ppvMembers = ppvMembers;
+      psGroup->uCapacity = 2;
+   }
+   else if (psGroup->uLength == psGroup->uCapacity)
+   {
+      ppvMembers = realloc(psGroup->ppvMembers,
+                           2 * psGroup->uCapacity * sizeof(void *));
+      if (ppvMembers == NULL)
+         return 0;
+      oIndex->uBytes += psGroup->uCapacity * sizeof(void *);
+      psGroup->ppvMembers = ppvMembers;
+      psGroup->uCapacity *= 2;
+   }
+   *puSlot = psGroup->uLength;
+   psGroup->ppvMembers[psGroup->uLength++] = pvMember;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+NameIndex_T NameIndex_new(void)
+{
+   NameIndex_T oIndex;
+
+   oIndex = malloc(sizeof(struct NameIndex));
+   if (oIndex == NULL)
+      return NULL;
+   oIndex->ppsBuckets = calloc(INITIAL_BUCKETS,
+                               sizeof(struct NameGroup *));
+   if (oIndex->ppsBuckets == NULL)
+   {
+      free(oIndex);
+      return NULL;
+   }
+   STATS_ADD(mallocs, 2);
+
+   oIndex->uBuckets = INITIAL_BUCKETS;
+   oIndex->uGroups = 0;
+   oIndex->uBytes = sizeof(struct NameIndex)
+      + INITIAL_BUCKETS * sizeof(struct NameGroup *);
+   return oIndex;
+}
+
+/*--------------------------------------------------------------------*/
+
+void NameIndex_free(NameIndex_T oIndex)
+{
+   struct NameGroup *psGroup;
+   struct NameGroup *psNext;
+   size_t uBucket;
+
+   if (oIndex == NULL)
+      return;
+
+   for (uBucket = 0; uBucket < oIndex->uBuckets; uBucket++)
+      for (psGroup = oIndex->ppsBuckets[uBucket]; psGroup != NULL;
+           psGroup = psNext)
+      {
+         psNext = psGroup->psNext;
+         NameIndex_freeGroup(oIndex, psGroup);
+      }
+   free(oIndex->ppsBuckets);
+   free(oIndex);
+   STATS_ADD(frees, 2);
+}
+
+/*--------------------------------------------------------------------*/
+
+int NameIndex_add(NameIndex_T oIndex, Node oNode)
+{
+   struct NameGroup *psName;
+   struct NameGroup *psExtension = NULL;
+   const char *pcName;
+   const char *pcExtension;
+   size_t uLength;
+   size_t uExtensionLength;
+   size_t uSlot;
+   unsigned long ulHash;
+   int iNewExtension = 0;
+
+   assert(oIndex != NULL);
+   assert(oNode != NULL);
+
+   pcName = NameIndex_name(oNode, &uLength);
+   ulHash = Node_hashName(pcName, uLength);
+
+   /* the usual case: another Node already has the name */
+   psName = NameIndex_find(oIndex, pcName, uLength, ulHash, 0);
+   if (psName != NULL)
+   {
+      if (!NameIndex_append(oIndex, psName, oNode, &uSlot))
+         return 0;
+      Node_setIndexSlot(oNode, uSlot + 1);
+      return 1;
+   }
+
+   /* otherwise make a group for the name, and enter it in the group
+      for its extension, making that too if need be */
+   psName = NameIndex_newGroup(oIndex, ulHash, 0);
+   if (psName == NULL)
+      return 0;
+   psName->ppvMembers[psName->uLength++] = oNode;
+
+   pcExtension = NameIndex_extension(pcName, uLength,
+                                     &uExtensionLength);
+   if (pcExtension != NULL)
+   {
+      ulHash = Node_hashName(pcExtension, uExtensionLength);
+      psExtension = NameIndex_find(oIndex, pcExtension,
+                                   uExtensionLength, ulHash, 1);
+      if (psExtension == NULL)
+      {
+         psExtension = NameIndex_newGroup(oIndex, ulHash, 1);
+         iNewExtension = 1;
+      }
+      if (psExtension == NULL ||
+          !NameIndex_append(oIndex, psExtension, psName,
+                            &psName->uExtensionSlot))
+      {
+         NameIndex_freeGroup(oIndex, psName);
+         return 0;
+      }
+      psName->psExtension = psExtension;
+      if (iNewExtension)
+         NameIndex_link(oIndex, psExtension);
+   }
+
+   NameIndex_link(oIndex, psName);
+   Node_setIndexSlot(oNode, 1);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void NameIndex_remove(NameIndex_T oIndex, Node oNode)
+{
+   struct NameGroup *psName;
+   struct NameGroup *psExtension;
+   struct NameGroup *psMoved;
+   const char *pcName;
+   size_t uLength;
+   size_t uSlot;
+   Node oMoved;
+
+   assert(oIndex != NULL);
+   assert(oNode != NULL);
+
+   if (Node_getIndexSlot(oNode) == 0)
+      return;
+   uSlot = Node_getIndexSlot(oNode) - 1;
+
+   pcName = NameIndex_name(oNode, &uLength);
+   psName = NameIndex_find(oIndex, pcName, uLength,
+                           Node_hashName(pcName, uLength), 0);
+   assert(psName != NULL);
+   assert(uSlot < psName->uLength);
+   assert(psName->ppvMembers[uSlot] == (void *)oNode);
+
+   /* move the last member into oNode's place */
+   oMoved = (Node)psName->ppvMembers[--psName->uLength];
+   psName->ppvMembers[uSlot] = oMoved;
+   Node_setIndexSlot(oMoved, uSlot + 1);
+   Node_setIndexSlot(oNode, 0);
+   if (psName->uLength > 0)
+      return;
+
+   /* the name is gone: so is its group, from its extension's */
+   psExtension = psName->psExtension;
+   if (psExtension != NULL)
+   {
+      psMoved = (struct NameGroup *)
+         psExtension->ppvMembers[--psExtension->uLength];
+      psExtension->ppvMembers[psName->uExtensionSlot] = psMoved;
+      psMoved->uExtensionSlot = psName->uExtensionSlot;
+      if (psExtension->uLength == 0)
+         NameIndex_unlink(oIndex, psExtension);
+   }
+   NameIndex_unlink(oIndex, psName);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Call (*pfApply)(oNode, pvExtra) on each member of the name group
+   *psName until it returns 0 (FALSE).  Return 0 (FALSE) if it did, and
+   1 (TRUE) otherwise. */
+
+static int NameIndex_mapGroup(const struct NameGroup *psName,
+                              NameIndex_Apply pfApply, void *pvExtra)
+{
+   size_t uMember;
+
+   assert(psName != NULL);
+   assert(!psName->iIsExtension);
+   assert(pfApply != NULL);
+
+   for (uMember = 0; uMember < psName->uLength; uMember++)
+      if (!(*pfApply)((Node)psName->ppvMembers[uMember], pvExtra))
+         return 0;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int NameIndex_mapName(NameIndex_T oIndex, const char *pcName,
+                      size_t uLength, NameIndex_Apply pfApply,
+                      void *pvExtra)
+{
+   struct NameGroup *psName;
+
+   assert(oIndex != NULL);
+   assert(pcName != NULL);
+   assert(pfApply != NULL);
+
+   psName = NameIndex_find(oIndex, pcName, uLength,
+                           Node_hashName(pcName, uLength), 0);
+   if (psName == NULL)
+      return 1;
+   return NameIndex_mapGroup(psName, pfApply, pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if the key of the name group *psName ends in the
+   uLength characters at pcSuffix and is longer than them, or 0
+   (FALSE) otherwise. */
+
+static int NameIndex_endsIn(const struct NameGroup *psName,
+                            const char *pcSuffix, size_t uLength)
+{
+   const char *pcName;
+   size_t uNameLength;
+
+   pcName = NameIndex_key(psName, &uNameLength);
+   if (uNameLength <= uLength)
+      return 0;
+   STATS_COMPARE(pcName + uNameLength - uLength, pcSuffix, uLength);
+   return memcmp(pcName + uNameLength - uLength, pcSuffix,
+                 uLength) == 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+int NameIndex_mapSuffix(NameIndex_T oIndex, const char *pcSuffix,
+                        size_t uLength, NameIndex_Apply pfApply,
+                        void *pvExtra)
+{
+   struct NameGroup *psExtension;
+   struct NameGroup *psGroup;
+   struct NameGroup *psName;
+   size_t uDot = uLength;
+   size_t uMember;
+   size_t uBucket;
+
+   assert(oIndex != NULL);
+   assert(pcSuffix != NULL);
+   assert(pfApply != NULL);
+
+   while (uDot > 0 && pcSuffix[uDot - 1] != '.')
+      uDot--;
+
+   /* with no '.', any name might end in pcSuffix */
+   if (uDot == 0)
+   {
+      for (uBucket = 0; uBucket < oIndex->uBuckets; uBucket++)
+         for (psGroup = oIndex->ppsBuckets[uBucket]; psGroup != NULL;
+              psGroup = psGroup->psNext)
+            if (!psGroup->iIsExtension &&
+                NameIndex_endsIn(psGroup, pcSuffix, uLength) &&
+                !NameIndex_mapGroup(psGroup, pfApply, pvExtra))
+               return 0;
+      return 1;
+   }
+
+   /* a name longer than pcSuffix that ends in it has a '.' before
+      its last character, so its extension is pcSuffix's */
+   psExtension = NameIndex_find(oIndex, pcSuffix + uDot - 1,
+                                uLength - (uDot - 1),
+                                Node_hashName(pcSuffix + uDot - 1,
+                                              uLength - (uDot - 1)),
+                                1);
+   if (psExtension == NULL)
+      return 1;
+   for (uMember = 0; uMember < psExtension->uLength; uMember++)
+   {
+      psName = (struct NameGroup *)psExtension->ppvMembers[uMember];
+      if (NameIndex_endsIn(psName, pcSuffix, uLength) &&
+          !NameIndex_mapGroup(psName, pfApply, pvExtra))
+         return 0;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t NameIndex_getSize(NameIndex_T oIndex)
+{
+   assert(oIndex != NULL);
+
+   return oIndex->uBytes;
+}
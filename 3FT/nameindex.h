@@ -0,0 +1,91 @@
+/*--------------------------------------------------------------------*/
+/* nameindex.h                                                        */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#ifndef NAMEINDEX_INCLUDED
+#define NAMEINDEX_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+#include "node.h"
+
+/* A NameIndex_T object is an inverted index of a hierarchy of Nodes:
+   from each name, the last component of a path, to the Nodes that
+   carry it, and from each extension, the part of a name from its last
+   '.' on when that '.' is not its first character, to the names that
+   have it.  Finding the Nodes with a name or an extension then costs
+   time in proportion to their number, not to the hierarchy's.  The
+   index records in each Node its place there, with Node_setIndexSlot,
+   so that a Node is removed in constant time; a Node can be in at
+   most one index at a time. */
+
+typedef struct NameIndex *NameIndex_T;
+
+/* A function called once per Node found by NameIndex_mapName or
+   NameIndex_mapSuffix, with the pvExtra passed to it.  Returns 1
+   (TRUE) to continue, or 0 (FALSE) to stop early.  It must not add
+   Nodes to the index or remove them. */
+
+typedef int (*NameIndex_Apply)(Node oNode, void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new empty NameIndex_T object, or NULL if insufficient
+   memory is available. */
+
+NameIndex_T NameIndex_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oIndex.  The Nodes in it are not changed, and their slots are
+   left as they were. */
+
+void NameIndex_free(NameIndex_T oIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Add oNode, which must not already be in oIndex, to oIndex under its
+   name.  Return 1 (TRUE) if successful, or 0 (FALSE), leaving oIndex
+   unchanged, if insufficient memory is available. */
+
+int NameIndex_add(NameIndex_T oIndex, Node oNode);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove oNode from oIndex, if it is there; its name must not have
+   changed since it was added. */
+
+void NameIndex_remove(NameIndex_T oIndex, Node oNode);
+
+/*--------------------------------------------------------------------*/
+
+/* Call (*pfApply)(oNode, pvExtra) on each Node in oIndex whose name is
+   the uLength characters at pcName, in no particular order, until it
+   returns 0 (FALSE).  Return 0 (FALSE) if it did, and 1 (TRUE)
+   otherwise. */
+
+int NameIndex_mapName(NameIndex_T oIndex, const char *pcName,
+                      size_t uLength, NameIndex_Apply pfApply,
+                      void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Call (*pfApply)(oNode, pvExtra) on each Node in oIndex whose name
+   ends in the uLength characters at pcSuffix and is longer than them,
+   in no particular order, until it returns 0 (FALSE).  Return 0
+   (FALSE) if it did, and 1 (TRUE) otherwise.  If pcSuffix holds a '.',
+   only the names with the extension from its last '.' on are looked
+   at; otherwise every distinct name is. */
+
+int NameIndex_mapSuffix(NameIndex_T oIndex, const char *pcSuffix,
+                        size_t uLength, NameIndex_Apply pfApply,
+                        void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bytes of memory that oIndex has allocated. */
+
+size_t NameIndex_getSize(NameIndex_T oIndex);
+
+#endif
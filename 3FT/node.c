@@ -7,14 +7,142 @@
 #include <string.h>
 #include <assert.h>
 #include <stdio.h>
+#include <limits.h>
 
-#include "dynarray.h"
+#include "btree.h"
 #include "node.h"
+#include "stats.h"
+#include "typedarray.h"
 
+/*
+   A directory's children of each type are kept in a childList whose
+   representation adapts to their number: up to NODE_INLINE_CHILDREN
+   (at least 1) sit inline in the Node itself, so that the many empty
+   and near-empty directories cost no further allocation; beyond that
+   they move to a NodeArray; and from NODE_TREE_CHILDREN on they move
+   to a BTree, so that adding or removing one of millions of children
+   no longer shifts all those after it. A list only moves back down
+   once it has shrunk to half a threshold, so that a directory whose
+   size hovers at a threshold does not convert back and forth.
+   Both thresholds may be tuned at compile time with -D. A NodeArray
+   follows DynArray_defaultPolicy, so one that loses most of its
+   children gives most of its memory back.
+*/
+#ifndef NODE_INLINE_CHILDREN
+#define NODE_INLINE_CHILDREN 2
+#endif
+
+#ifndef NODE_TREE_CHILDREN
+#define NODE_TREE_CHILDREN 4096
+#endif
+
+/*
+   A childList of at least NODE_INDEX_CHILDREN children that is
+   searched by name once for every NODE_INDEX_RATIO children it holds,
+   without changing in between, gets a childIndex: a compact copy of
+   its names that most searches can be answered from without touching
+   any Node. Any change to the list makes the index stale until it has
+   been searched that often again. Both may be tuned with -D.
+*/
+#ifndef NODE_INDEX_CHILDREN
+#define NODE_INDEX_CHILDREN 256
+#endif
+
+#ifndef NODE_INDEX_RATIO
+#define NODE_INDEX_RATIO 8
+#endif
+
+#ifdef __GNUC__
+#define NODE_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define NODE_PREFETCH(p) ((void) 0)
+#endif
+
+
+/* A NodeArray is a DynArray of Nodes, specialized by typedarray.h */
+DEFINE_DYNARRAY(NodeArray, Node);
 
 struct fileS {
    void *contents;
    size_t length;
+   /* whether contents are this node's own, to be freed with it */
+   boolean owned;
+};
+
+/* The representations a childList may currently be using */
+typedef enum {LIST_INLINE, LIST_ARRAY, LIST_TREE} listMode;
+
+/*
+   A childIndex holds, for each child of a childList, a prefix: the
+   first sizeof(unsigned long) bytes of its name after the part common
+   to all the children's names, packed big-endian and padded with
+   zeros, so that comparing prefixes as integers orders them as
+   comparing the names would. The prefixes are kept in Eytzinger
+   order -- the breadth-first order of a complete binary search tree,
+   with the children of position k at 2k and 2k+1 -- so the first
+   steps of every search share a few cache lines, and the steps after
+   can be prefetched.
+*/
+struct childIndex {
+   /* the number of searches since the list last changed */
+   size_t searches;
+
+   /* the number of prefixes, or 0 if the index is stale */
+   size_t length;
+
+   /* where the children's names start in their paths */
+   size_t offset;
+
+   /* the bytes that start every child's name, and their number */
+   char* common;
+   size_t commonLen;
+
+   /* prefixes[1..length] in Eytzinger order, and at ranks[k] the
+      index in the list of the child whose prefix is prefixes[k] */
+   unsigned long* prefixes;
+   size_t* ranks;
+};
+
+/*
+   A childList is a sequence of child Nodes, all of one type, sorted
+   by pathname.
+*/
+struct childList {
+   /* which member of u is in use */
+   listMode mode;
+
+   /* the number of children, when mode is LIST_INLINE */
+   size_t inlineLength;
+
+   union {
+      Node inlineChildren[NODE_INLINE_CHILDREN];
+      NodeArray_T array;
+      BTree_T tree;
+   } u;
+
+   /* the name index, or NULL if the list has never needed one */
+   struct childIndex* index;
+
+   /* the union of Node_hashBit of every child ever added, so that a
+      name whose bit is clear cannot be in the list */
+   unsigned long hashBits;
+};
+
+/*
+   A directory keeps its file children and its directory children in
+   two separate childLists. A child's identifier is its position in
+   the concatenation of the two -- all files, then all directories --
+   which is exactly Node_compare order.
+*/
+struct dirS {
+   struct childList files;
+   struct childList dirs;
+
+   /* the total length of the files beneath this directory, and an
+      upper bound on the length of any one of them, for whoever keeps
+      them up to date */
+   size_t totalLength;
+   size_t maxLength;
 };
 
 /*
@@ -26,6 +154,10 @@ struct node {
    /* the full path of this node */
    char* path;
 
+   /* the length of path, so that searches among this node's
+      children need not recompute it */
+   size_t pathLen;
+
    /* the parent directory of this node
       NULL for the root of the file tree */
    Node parent;
@@ -34,49 +166,642 @@ struct node {
       a file or a directory */
    nodeType type;
 
-   /* Either holds the subdirectories of 
-   this node stored in sorted order 
+   /* the identifier of the directory handle open on this node,
+      or 0 if there is none */
+   size_t handleID;
+
+   /* this node's place in the index of names, plus one,
+      or 0 if it is not in one */
+   size_t indexSlot;
+
+   /* Either holds the children of
+   this node stored in sorted order
    by pathname or the file contents*/
    union {
-      DynArray_T children;
+      struct dirS dir;
       struct fileS file;
    } storage;
 };
 
+/*
+   A nodeKey names a prospective child Node without allocating one:
+   the len characters at name are compared against each Node's path
+   starting offset characters in, and only Nodes of type type match.
+*/
+struct nodeKey {
+   const char* name;
+   size_t len;
+   size_t offset;
+   nodeType type;
+};
+
+/*
+  Compares the search key key against Node n, in the same order as
+  Node_compare would compare a Node with key's path and type to n.
+  Only ever called on Nodes from the array for key's type.
+*/
+static int Node_compareKey(const struct nodeKey* key, Node n) {
+   int result;
+
+   assert(key != NULL);
+   assert(n != NULL);
+   assert(key->type == n->type);
+
+   STATS_COMPARE(key->name, n->path + key->offset, key->len);
+   result = strncmp(key->name, n->path + key->offset, key->len);
+   if(result == 0 && n->path[key->offset + key->len] != '\0')
+      result = -1;
+   return result;
+}
+
+/* Binary searches a NodeArray by nodeKey, calling Node_compareKey
+   directly */
+DEFINE_DYNARRAY_BSEARCH(NodeArray, NodeArray_searchKey, Node,
+                        const struct nodeKey*, Node_compareKey);
+
+/* Merges a sorted batch of Nodes into a NodeArray, in path order */
+DEFINE_DYNARRAY_MERGE(NodeArray, NodeArray_mergeSorted, Node, Node_compare);
+
+
+/* Initializes *l as an empty childList. */
+static void Node_listInit(struct childList* l) {
+   assert(l != NULL);
+
+   l->mode = LIST_INLINE;
+   l->inlineLength = 0;
+   l->index = NULL;
+   l->hashBits = 0;
+}
+
+/* Returns the one bit, of an unsigned long, that a name with hash
+   hash (from Node_hashName) sets in a childList's hashBits. */
+static unsigned long Node_hashBit(unsigned long hash) {
+   return 1UL << (hash % (CHAR_BIT * sizeof(unsigned long)));
+}
+
+/* Sets the bit of child's name in the hashBits of *l. child's parent
+   must already be set. */
+static void Node_listNoteName(struct childList* l, Node child) {
+   size_t offset;
+
+   assert(l != NULL);
+   assert(child != NULL);
+   assert(child->parent != NULL);
+
+   offset = child->parent->pathLen + 1;
+   l->hashBits |= Node_hashBit(Node_hashName(child->path + offset,
+                                             child->pathLen - offset));
+}
+
+/* Marks the index of *l, if any, stale, freeing its contents. */
+static void Node_indexClear(struct childList* l) {
+   assert(l != NULL);
+
+   if(l->index == NULL || l->index->length == 0)
+      return;
+   free(l->index->common);
+   free(l->index->prefixes);
+   free(l->index->ranks);
+   STATS_ADD(frees, 3);
+   l->index->length = 0;
+   l->index->searches = 0;
+}
+
+/* Frees the index of *l, if any. */
+static void Node_indexFree(struct childList* l) {
+   assert(l != NULL);
+
+   if(l->index == NULL)
+      return;
+   Node_indexClear(l);
+   free(l->index);
+   STATS_ADD(frees, 1);
+   l->index = NULL;
+}
+
+/* Frees any storage *l holds outside the Node (but not its Nodes). */
+static void Node_listFree(struct childList* l) {
+   assert(l != NULL);
+
+   if(l->mode == LIST_ARRAY)
+      NodeArray_free(l->u.array);
+   else if(l->mode == LIST_TREE)
+      BTree_free(l->u.tree);
+   Node_indexFree(l);
+   Node_listInit(l);
+}
+
+/* Returns the number of Nodes in *l. */
+static size_t Node_listLength(const struct childList* l) {
+   assert(l != NULL);
+
+   if(l->mode == LIST_INLINE)
+      return l->inlineLength;
+   else if(l->mode == LIST_ARRAY)
+      return NodeArray_getLength(l->u.array);
+   else
+      return BTree_getLength(l->u.tree);
+}
+
+/* Returns the i'th Node of *l, which must exist. */
+static Node Node_listGet(const struct childList* l, size_t i) {
+   assert(l != NULL);
+   assert(i < Node_listLength(l));
+
+   if(l->mode == LIST_INLINE)
+      return l->u.inlineChildren[i];
+   else if(l->mode == LIST_ARRAY)
+      return NodeArray_get(l->u.array, i);
+   else
+      return BTree_get(l->u.tree, i);
+}
+
+/*
+   Returns the prefix of the len characters at name, as a childIndex
+   stores it.
+*/
+static unsigned long Node_indexPrefix(const char* name, size_t len) {
+   unsigned long prefix = 0;
+   size_t i;
+
+   assert(name != NULL);
+
+   for(i = 0; i < sizeof(unsigned long); i++) {
+      prefix <<= CHAR_BIT;
+      if(i < len)
+         prefix |= (unsigned char) name[i];
+   }
+   return prefix;
+}
+
+/*
+   The state of a pass over a childList's Nodes, in order, that stores
+   their prefixes in sorted.
+*/
+struct indexFill {
+   const struct childIndex* index;
+   unsigned long* sorted;
+   size_t i;
+};
+
+/* Stores the prefix of n's name at the next place in fill's array. */
+static void Node_indexFillOne(Node n, struct indexFill* fill) {
+   size_t start;
+
+   assert(n != NULL);
+   assert(fill != NULL);
+
+   start = fill->index->offset + fill->index->commonLen;
+   fill->sorted[fill->i++] =
+      Node_indexPrefix(n->path + start, n->pathLen - start);
+}
+
+/*
+   Copies sorted prefixes to x's Eytzinger positions k and below,
+   starting from the one of rank rank. Returns the rank after the last
+   one copied.
+*/
+static size_t Node_indexLayOut(struct childIndex* x,
+                               const unsigned long* sorted, size_t k,
+                               size_t rank) {
+   assert(x != NULL);
+   assert(sorted != NULL);
+
+   if(k <= x->length) {
+      rank = Node_indexLayOut(x, sorted, 2 * k, rank);
+      x->prefixes[k] = sorted[rank];
+      x->ranks[k] = rank;
+      rank++;
+      rank = Node_indexLayOut(x, sorted, 2 * k + 1, rank);
+   }
+   return rank;
+}
+
+/*
+   Builds the index of *l, whose children's names start offset
+   characters into their paths. Returns TRUE if successful, or FALSE
+   (leaving the index stale) if there is an allocation error.
+*/
+static boolean Node_indexBuild(struct childList* l, size_t offset) {
+   struct childIndex* x;
+   struct indexFill fill;
+   const char* first;
+   const char* last;
+   size_t length;
+   size_t commonLen = 0;
+   size_t i;
+
+   assert(l != NULL);
+   assert(l->index != NULL);
+   assert(l->mode != LIST_INLINE);
+
+   x = l->index;
+   length = Node_listLength(l);
+
+   first = Node_listGet(l, 0)->path + offset;
+   last = Node_listGet(l, length - 1)->path + offset;
+   while(first[commonLen] != '\0' && first[commonLen] == last[commonLen])
+      commonLen++;
+
+   x->common = malloc(commonLen + 1);
+   x->prefixes = malloc((length + 1) * sizeof(unsigned long));
+   x->ranks = malloc((length + 1) * sizeof(size_t));
+   fill.sorted = malloc(length * sizeof(unsigned long));
+   if(x->common == NULL || x->prefixes == NULL || x->ranks == NULL ||
+      fill.sorted == NULL) {
+      free(x->common);
+      free(x->prefixes);
+      free(x->ranks);
+      free(fill.sorted);
+      x->searches = 0;
+      return FALSE;
+   }
+   STATS_ADD(mallocs, 4);
+
+   memcpy(x->common, first, commonLen);
+   x->common[commonLen] = '\0';
+   x->commonLen = commonLen;
+   x->offset = offset;
+   x->length = length;
+
+   fill.index = x;
+   fill.i = 0;
+   if(l->mode == LIST_ARRAY)
+      for(i = 0; i < length; i++)
+         Node_indexFillOne(NodeArray_get(l->u.array, i), &fill);
+   else
+      BTree_map(l->u.tree,
+                (void (*)(void*, void*)) Node_indexFillOne, &fill);
+   (void) Node_indexLayOut(x, fill.sorted, 1, 0);
+
+   free(fill.sorted);
+   STATS_ADD(frees, 1);
+   return TRUE;
+}
+
+/*
+   Returns the Eytzinger position in x of the first prefix (in sorted
+   order) that is at least prefix, or if orEqual, more than prefix; or
+   0 if there is none. Each step is a branchless descent whose
+   grandchildren's grandchildren are prefetched.
+*/
+static size_t Node_indexProbe(const struct childIndex* x,
+                              unsigned long prefix, boolean orEqual) {
+   size_t k = 1;
+
+   assert(x != NULL);
+
+   while(k <= x->length) {
+      if(16 * k <= x->length)
+         NODE_PREFETCH(&x->prefixes[16 * k]);
+      k = 2 * k + (orEqual ? x->prefixes[k] <= prefix :
+                   x->prefixes[k] < prefix);
+   }
+
+   /* Undo the right turns taken after the last left turn, and that
+      left turn, to get back to the node it was taken at. */
+   while(k & 1)
+      k >>= 1;
+   return k >> 1;
+}
+
+/*
+   Searches *l, which has a current index, for key as Node_listSearch
+   does. Only the children whose prefix matches key's are touched.
+*/
+static int Node_indexSearch(const struct childList* l,
+                            const struct nodeKey* key, size_t* pIndex) {
+   const struct childIndex* x;
+   unsigned long prefix;
+   size_t k;
+   size_t lo;
+   size_t hi;
+   size_t mid;
+   int result;
+
+   assert(l != NULL);
+   assert(key != NULL);
+   assert(pIndex != NULL);
+
+   x = l->index;
+
+   /* A key without the common part goes before or after them all */
+   if(key->len < x->commonLen ||
+      memcmp(key->name, x->common, x->commonLen) != 0) {
+      result = memcmp(key->name, x->common,
+                      key->len < x->commonLen ? key->len : x->commonLen);
+      *pIndex = (result > 0) ? x->length : 0;
+      return 0;
+   }
+
+   prefix = Node_indexPrefix(key->name + x->commonLen,
+                             key->len - x->commonLen);
+   k = Node_indexProbe(x, prefix, FALSE);
+   if(k == 0 || x->prefixes[k] != prefix) {
+      *pIndex = (k == 0) ? x->length : x->ranks[k];
+      return 0;
+   }
+
+   /* The children whose prefix matches key's run from lo up to hi */
+   lo = x->ranks[k];
+   result = Node_compareKey(key, Node_listGet(l, lo));
+   if(result <= 0) {
+      *pIndex = lo;
+      return result == 0;
+   }
+   k = Node_indexProbe(x, prefix, TRUE);
+   hi = (k == 0) ? x->length : x->ranks[k];
+
+   lo++;
+   while(lo < hi) {
+      mid = lo + (hi - lo) / 2;
+      result = Node_compareKey(key, Node_listGet(l, mid));
+      if(result == 0) {
+         *pIndex = mid;
+         return 1;
+      }
+      if(result < 0)
+         hi = mid;
+      else
+         lo = mid + 1;
+   }
+   *pIndex = lo;
+   return 0;
+}
+
+/*
+   Counts a search of *l for a key whose name starts offset characters
+   into the children's paths, and returns TRUE if *l has, or has now
+   been given, a current index for such keys.
+*/
+static boolean Node_indexReady(struct childList* l, size_t offset) {
+   size_t length;
+
+   assert(l != NULL);
+
+   length = Node_listLength(l);
+   if(l->mode == LIST_INLINE || length < NODE_INDEX_CHILDREN ||
+      offset == 0)
+      return FALSE;
+
+   if(l->index == NULL) {
+      l->index = calloc(1, sizeof(struct childIndex));
+      if(l->index == NULL)
+         return FALSE;
+      STATS_ADD(mallocs, 1);
+   }
+   if(l->index->length != 0)
+      return (boolean) (l->index->offset == offset);
+
+   l->index->searches++;
+   if(l->index->searches < length / NODE_INDEX_RATIO)
+      return FALSE;
+   return Node_indexBuild(l, offset);
+}
+
+/*
+   Binary searches *l for key as DynArray_bsearch would: returns 1 and
+   stores the index of the match in *pIndex if there is one, and
+   otherwise returns 0 and stores the index where it would belong.
+   Answers from the list's index, if it has or now merits one.
+*/
+static int Node_listSearch(struct childList* l,
+                           const struct nodeKey* key, size_t* pIndex) {
+   size_t lo = 0;
+   size_t hi;
+   size_t mid;
+   int result;
+
+   assert(l != NULL);
+   assert(key != NULL);
+   assert(pIndex != NULL);
+
+   if(Node_indexReady(l, key->offset))
+      return Node_indexSearch(l, key, pIndex);
+
+   if(l->mode == LIST_ARRAY)
+      return NodeArray_searchKey(l->u.array, key, pIndex);
+   else if(l->mode == LIST_TREE)
+      return BTree_bsearch(l->u.tree, (void*) key, pIndex,
+                  (int (*)(const void*, const void*)) Node_compareKey);
+
+   hi = l->inlineLength;
+   while(lo < hi) {
+      mid = lo + (hi - lo) / 2;
+      result = Node_compareKey(key, l->u.inlineChildren[mid]);
+      if(result == 0) {
+         *pIndex = mid;
+         return 1;
+      }
+      if(result < 0)
+         hi = mid;
+      else
+         lo = mid + 1;
+   }
+   *pIndex = lo;
+   return 0;
+}
+
+/*
+   Moves the Nodes of inline list *l into a new NodeArray. Returns
+   TRUE if successful, or FALSE (leaving *l unchanged) if there is an
+   allocation error.
+*/
+static boolean Node_listToArray(struct childList* l) {
+   NodeArray_T array;
+   size_t i;
+
+   assert(l != NULL);
+   assert(l->mode == LIST_INLINE);
+
+   array = NodeArray_new(l->inlineLength);
+   if(array == NULL)
+      return FALSE;
+   for(i = 0; i < l->inlineLength; i++)
+      (void) NodeArray_set(array, i, l->u.inlineChildren[i]);
+
+   l->mode = LIST_ARRAY;
+   l->u.array = array;
+   return TRUE;
+}
+
+/*
+   Moves the Nodes of array list *l into a new BTree. Returns TRUE if
+   successful, or FALSE (leaving *l unchanged) if there is an
+   allocation error.
+*/
+static boolean Node_listToTree(struct childList* l) {
+   BTree_T tree;
+   size_t i;
+
+   assert(l != NULL);
+   assert(l->mode == LIST_ARRAY);
+
+   tree = BTree_new();
+   if(tree == NULL)
+      return FALSE;
+   for(i = 0; i < NodeArray_getLength(l->u.array); i++)
+      if(!BTree_addAt(tree, i, NodeArray_get(l->u.array, i))) {
+         BTree_free(tree);
+         return FALSE;
+      }
+
+   NodeArray_free(l->u.array);
+   l->mode = LIST_TREE;
+   l->u.tree = tree;
+   return TRUE;
+}
+
+/*
+   Adds child to *l as its i'th Node, first moving *l to a larger
+   representation if it has reached a threshold. Returns TRUE if
+   successful, or FALSE (leaving *l unchanged) if there is an
+   allocation error.
+*/
+static boolean Node_listAddAt(struct childList* l, size_t i,
+                              Node child) {
+   assert(l != NULL);
+   assert(i <= Node_listLength(l));
+
+   Node_indexClear(l);
+   Node_listNoteName(l, child);
+
+   if(l->mode == LIST_INLINE) {
+      if(l->inlineLength < NODE_INLINE_CHILDREN) {
+         memmove(&l->u.inlineChildren[i + 1], &l->u.inlineChildren[i],
+                 (l->inlineLength - i) * sizeof(Node));
+         l->u.inlineChildren[i] = child;
+         l->inlineLength++;
+         return TRUE;
+      }
+      if(!Node_listToArray(l))
+         return FALSE;
+   }
+
+   if(l->mode == LIST_ARRAY) {
+      if(NodeArray_getLength(l->u.array) < NODE_TREE_CHILDREN)
+         return (boolean) NodeArray_addAt(l->u.array, i, child);
+      if(!Node_listToTree(l))
+         return FALSE;
+   }
+
+   return (boolean) BTree_addAt(l->u.tree, i, child);
+}
+
+/*
+   Moves array list *l back to inline storage if removals have shrunk
+   it to half the inline threshold.
+*/
+static void Node_listSettle(struct childList* l) {
+   NodeArray_T array;
+   size_t length;
+   size_t j;
+
+   assert(l != NULL);
+   assert(l->mode == LIST_ARRAY);
+
+   array = l->u.array;
+   length = NodeArray_getLength(array);
+   if(length <= NODE_INLINE_CHILDREN / 2) {
+      for(j = 0; j < length; j++)
+         l->u.inlineChildren[j] = NodeArray_get(array, j);
+      NodeArray_free(array);
+      Node_indexFree(l);
+      l->mode = LIST_INLINE;
+      l->inlineLength = length;
+   }
+}
+
+/*
+   Removes and returns the i'th Node of *l, then moves *l to a smaller
+   representation if it has shrunk to half a threshold (unless that
+   move fails to allocate, in which case *l simply stays as it is).
+*/
+static Node Node_listRemoveAt(struct childList* l, size_t i) {
+   Node removed;
+   NodeArray_T array;
+   BTree_T tree;
+   size_t length;
+   size_t j;
+
+   assert(l != NULL);
+   assert(i < Node_listLength(l));
+
+   Node_indexClear(l);
+
+   if(l->mode == LIST_INLINE) {
+      removed = l->u.inlineChildren[i];
+      memmove(&l->u.inlineChildren[i], &l->u.inlineChildren[i + 1],
+              (l->inlineLength - i - 1) * sizeof(Node));
+      l->inlineLength--;
+      return removed;
+   }
+
+   if(l->mode == LIST_TREE) {
+      tree = l->u.tree;
+      removed = BTree_removeAt(tree, i);
+      length = BTree_getLength(tree);
+      if(length < NODE_TREE_CHILDREN / 2) {
+         array = NodeArray_new(length);
+         if(array != NULL) {
+            for(j = 0; j < length; j++)
+               (void) NodeArray_set(array, j, BTree_get(tree, j));
+            BTree_free(tree);
+            l->mode = LIST_ARRAY;
+            l->u.array = array;
+         }
+      }
+      return removed;
+   }
+
+   removed = NodeArray_removeAt(l->u.array, i);
+   Node_listSettle(l);
+   return removed;
+}
 
 /*
   returns a path with contents
   n->path/name
+  where name is the first len characters of the name parameter,
   or NULL if there is an allocation error.
 
   Allocates memory for the returned string,
   which is then owened by the caller!
 */
-static char* Node_buildPath(Node n, const char* name) {
+static char* Node_buildPath(Node n, const char* name, size_t len) {
    char* path;
+   size_t prefixLen = 0;
 
    assert(name != NULL);
 
-   if(n == NULL)
-      path = malloc(strlen(name)+1);
-   else
-      path = malloc(strlen(n->path) + 1 + strlen(name) + 1);
+   if(n != NULL)
+      prefixLen = n->pathLen + 1;
 
+   path = malloc(prefixLen + len + 1);
    if(path == NULL)
       return NULL;
-   *path = '\0';
+   STATS_ADD(mallocs, 1);
 
    if(n != NULL) {
-      strcpy(path, n->path);
-      strcat(path, "/");
+      memcpy(path, n->path, prefixLen - 1);
+      path[prefixLen - 1] = '/';
    }
-   strcat(path, name);
+   memcpy(path + prefixLen, name, len);
+   path[prefixLen + len] = '\0';
 
    return path;
 }
 
 /* see node.h for specification */
 Node Node_create(const char* name, Node parent, nodeType type){
+   assert(name != NULL);
+
+   return Node_createN(name, strlen(name), parent, type);
+}
+
+/* see node.h for specification */
+Node Node_createN(const char* name, size_t len, Node parent,
+                  nodeType type){
 
    Node new;
 
@@ -85,24 +810,32 @@ Node Node_create(const char* name, Node parent, nodeType type){
    new = malloc(sizeof(struct node));
    if(new == NULL)
       return NULL;
+   STATS_ADD(mallocs, 1);
 
-   new->path = Node_buildPath(parent, name);
+   new->path = Node_buildPath(parent, name, len);
 
    if(new->path == NULL) {
       free(new);
+      STATS_ADD(frees, 1);
       return NULL;
    }
+   new->pathLen = (parent == NULL) ? len : parent->pathLen + 1 + len;
 
    new->parent = parent;
    new->type = type;
+   new->handleID = 0;
+   new->indexSlot = 0;
 
    if(type == DIRECTORY){
-      new->storage.children = DynArray_new(0);
-      if(new->storage.children == NULL) {
-         free(new->path);
-         free(new);
-         return NULL;
-      }
+      Node_listInit(&new->storage.dir.files);
+      Node_listInit(&new->storage.dir.dirs);
+      new->storage.dir.totalLength = 0;
+      new->storage.dir.maxLength = 0;
+   }
+   else {
+      new->storage.file.contents = NULL;
+      new->storage.file.length = 0;
+      new->storage.file.owned = FALSE;
    }
    return new;
 }
@@ -116,16 +849,27 @@ size_t Node_destroy(Node n) {
    assert(n != NULL);
    
    if(n->type == DIRECTORY){
-      for(i = 0; i < DynArray_getLength(n->storage.children); i++)
+      for(i = 0; i < Node_listLength(&n->storage.dir.files); i++)
+         {
+            c = Node_listGet(&n->storage.dir.files, i);
+            count += Node_destroy(c);
+         }
+      for(i = 0; i < Node_listLength(&n->storage.dir.dirs); i++)
          {
-            c = DynArray_get(n->storage.children, i);
+            c = Node_listGet(&n->storage.dir.dirs, i);
             count += Node_destroy(c);
          }
-      DynArray_free(n->storage.children);
+      Node_listFree(&n->storage.dir.files);
+      Node_listFree(&n->storage.dir.dirs);
+   }
+   else if(n->storage.file.owned) {
+      free(n->storage.file.contents);
+      STATS_ADD(frees, 1);
    }
 
    free(n->path);
    free(n);
+   STATS_ADD(frees, 2);
    
    count++;
 
@@ -151,6 +895,28 @@ const char* Node_getPath(Node n) {
    return n->path;
 }
 
+/* see node.h for specification */
+size_t Node_getPathLength(Node n) {
+
+   assert(n != NULL);
+   return n->pathLen;
+}
+
+/* see node.h for specification */
+unsigned long Node_hashName(const char* name, size_t len) {
+   /* 32-bit FNV-1a */
+   unsigned long hash = 2166136261UL;
+   size_t i;
+
+   assert(name != NULL);
+
+   for(i = 0; i < len; i++) {
+      hash ^= (unsigned char) name[i];
+      hash = (hash * 16777619UL) & 0xffffffffUL;
+   }
+   return hash;
+}
+
 /* see node.h for specification */
 int Node_compare(Node node1, Node node2) {
    assert(node1 != NULL);
@@ -162,6 +928,7 @@ int Node_compare(Node node1, Node node2) {
       return (node1->type)?-1:1;
    }
 
+   STATS_COMPARE(node1->path, node2->path, (size_t)-1);
    return strcmp(node1->path, node2->path);
 }
 
@@ -173,36 +940,117 @@ size_t Node_getNumChildren(Node n) {
 
    /* If n is a file, it will return 0, otherwise it will return the 
       numhber of children*/
-   return (n->type)? 0 : DynArray_getLength(n->storage.children);
+   return (n->type)? 0 : Node_listLength(&n->storage.dir.files) +
+      Node_listLength(&n->storage.dir.dirs);
+}
+
+/* see node.h for specification */
+size_t Node_getNumFiles(Node n) {
+   assert(n != NULL);
+   assert(n->type == DIRECTORY);
+
+   return Node_listLength(&n->storage.dir.files);
+}
+
+/*
+  Returns the list holding directory n's children of type type.
+*/
+static struct childList* Node_childrenOfType(Node n, nodeType type) {
+   assert(n != NULL);
+   assert(n->type == DIRECTORY);
+
+   return (type == FILE_S) ? &n->storage.dir.files :
+      &n->storage.dir.dirs;
+}
+
+/*
+  Returns the identifier of directory n's child of type type that sits
+  at index i of that type's array.
+*/
+static size_t Node_childIDOf(Node n, nodeType type, size_t i) {
+   assert(n != NULL);
+   assert(n->type == DIRECTORY);
+
+   if(type == FILE_S)
+      return i;
+   return Node_listLength(&n->storage.dir.files) + i;
 }
 
 /* see node.h for specification */
 int Node_hasChild(Node n, const char* path, nodeType type) {
+   struct nodeKey key;
    size_t index;
-   int result;
-   Node checker;
 
    assert(n != NULL);
    assert(path != NULL);
    assert(n->type != FILE_S);
 
-   checker = Node_create(path, NULL, type);
-   if(checker == NULL)
-      return -1;
-   result = DynArray_bsearch(n->storage.children, checker, &index,
-                    (int (*)(const void*, const void*)) Node_compare);
-   (void) Node_destroy(checker);
+   key.name = path;
+   key.len = strlen(path);
+   key.offset = 0;
+   key.type = type;
 
-   return result;
+   return Node_listSearch(Node_childrenOfType(n, type), &key, &index);
+}
+
+/* see node.h for specification */
+boolean Node_findChild(Node n, const char* name, size_t len,
+                       nodeType type, size_t* pChildID) {
+   struct nodeKey key;
+   size_t i;
+   boolean found;
+
+   assert(n != NULL);
+   assert(name != NULL);
+   assert(pChildID != NULL);
+   assert(n->type == DIRECTORY);
+
+   key.name = name;
+   key.len = len;
+   key.offset = n->pathLen + 1;
+   key.type = type;
+
+   found = (boolean) Node_listSearch(Node_childrenOfType(n, type),
+                                     &key, &i);
+   *pChildID = Node_childIDOf(n, type, i);
+   return found;
+}
+
+/* see node.h for specification */
+boolean Node_findChildHashed(Node n, const char* name, size_t len,
+                             unsigned long hash, nodeType type,
+                             size_t* pChildID) {
+   struct childList* l;
+   size_t childID;
+
+   assert(n != NULL);
+   assert(name != NULL);
+   assert(pChildID != NULL);
+   assert(n->type == DIRECTORY);
+   assert(hash == Node_hashName(name, len));
+
+   l = Node_childrenOfType(n, type);
+   if((l->hashBits & Node_hashBit(hash)) == 0)
+      return FALSE;
+   if(!Node_findChild(n, name, len, type, &childID))
+      return FALSE;
+   *pChildID = childID;
+   return TRUE;
 }
 
 /* see node.h for specification */
 Node Node_getChild(Node n, size_t childID) {
+   size_t numFiles;
+
    assert(n != NULL);
    assert(n->type == DIRECTORY);
 
-   if(DynArray_getLength(n->storage.children) > childID)
-      return DynArray_get(n->storage.children, childID);
+   numFiles = Node_listLength(&n->storage.dir.files);
+   if(childID < numFiles)
+      return Node_listGet(&n->storage.dir.files, childID);
+   childID -= numFiles;
+   if(Node_listLength(&n->storage.dir.dirs) > childID)
+      return Node_listGet(&n->storage.dir.dirs, childID);
    else
       return NULL;
 }
@@ -214,8 +1062,22 @@ Node Node_getParent(Node n) {
    return n->parent;
 }
 
+/*
+  Fills *key to name Node n, by its whole path, among its siblings.
+*/
+static void Node_keyOf(Node n, struct nodeKey* key) {
+   assert(n != NULL);
+   assert(key != NULL);
+
+   key->name = n->path;
+   key->len = n->pathLen;
+   key->offset = 0;
+   key->type = n->type;
+}
+
 /* see node.h for specification */
 int Node_linkChild(Node parent, Node child) {
+   struct nodeKey key;
    size_t i;
    char* rest;
 
@@ -226,6 +1088,7 @@ int Node_linkChild(Node parent, Node child) {
    if(Node_hasChild(parent, child->path, child->type))
       return ALREADY_IN_TREE;
    i = strlen(parent->path);
+   STATS_COMPARE(child->path, parent->path, i);
    if(strncmp(child->path, parent->path, i))
       return PARENT_CHILD_ERROR;
    rest = child->path + i;
@@ -237,32 +1100,181 @@ int Node_linkChild(Node parent, Node child) {
 
    child->parent = parent;
 
-   if(DynArray_bsearch(parent->storage.children, child, &i,
-         (int (*)(const void*, const void*)) Node_compare) == 1)
+   Node_keyOf(child, &key);
+   if(Node_listSearch(Node_childrenOfType(parent, child->type), &key,
+                      &i) == 1)
       return ALREADY_IN_TREE;
 
-   if(DynArray_addAt(parent->storage.children, i, child) == TRUE)
+   if(Node_listAddAt(Node_childrenOfType(parent, child->type), i,
+                     child) == TRUE)
       return SUCCESS;
    else
       return PARENT_CHILD_ERROR;
 }
 
+/* see node.h for specification */
+int Node_addChildAt(Node parent, Node child, size_t childID) {
+   assert(parent != NULL);
+   assert(parent->type == DIRECTORY);
+   assert(child != NULL);
+   assert(childID <= Node_getNumChildren(parent));
+
+   child->parent = parent;
+
+   if(child->type == DIRECTORY)
+      childID -= Node_listLength(&parent->storage.dir.files);
+
+   if(Node_listAddAt(Node_childrenOfType(parent, child->type), childID,
+                     child) == TRUE)
+      return SUCCESS;
+   else
+      return MEMORY_ERROR;
+}
+
+/* see node.h for specification */
+int Node_reserveChildren(Node n, nodeType type, size_t count) {
+   struct childList* l;
+   size_t total;
+
+   assert(n != NULL);
+   assert(n->type == DIRECTORY);
+
+   l = Node_childrenOfType(n, type);
+   total = Node_listLength(l) + count;
+
+   /* Inline lists have a fixed size, and BTrees grow a node at a
+      time; only a list that will be a NodeArray can be sized ahead. */
+   if(l->mode == LIST_TREE || total <= NODE_INLINE_CHILDREN ||
+      total >= NODE_TREE_CHILDREN)
+      return SUCCESS;
+
+   if(l->mode == LIST_INLINE && !Node_listToArray(l))
+      return MEMORY_ERROR;
+   if(!NodeArray_reserve(l->u.array, total))
+      return MEMORY_ERROR;
+   return SUCCESS;
+}
+
 /* see node.h for specification */
 int  Node_unlinkChild(Node parent, Node child) {
+   struct nodeKey key;
    size_t i;
 
    assert(parent != NULL);
    assert(parent->type == DIRECTORY);
    assert(child != NULL);
 
-   if(DynArray_bsearch(parent->storage.children, child, &i,
-         (int (*)(const void*, const void*)) Node_compare) == 0)
+   Node_keyOf(child, &key);
+   if(Node_listSearch(Node_childrenOfType(parent, child->type), &key,
+                      &i) == 0)
       return PARENT_CHILD_ERROR;
 
-   (void) DynArray_removeAt(parent->storage.children, i);
+   (void) Node_listRemoveAt(Node_childrenOfType(parent, child->type), i);
    return SUCCESS;
 }
 
+/* see node.h for specification */
+int Node_addChildren(Node parent, Node* children, size_t count) {
+   struct childList* l;
+   struct nodeKey key;
+   size_t total;
+   size_t i;
+   size_t j;
+
+   assert(parent != NULL);
+   assert(parent->type == DIRECTORY);
+   assert(children != NULL || count == 0);
+
+   if(count == 0)
+      return SUCCESS;
+
+   l = Node_childrenOfType(parent, children[0]->type);
+   for(j = 0; j < count; j++) {
+      assert(children[j]->type == children[0]->type);
+      assert(j == 0 || Node_compare(children[j - 1], children[j]) < 0);
+      children[j]->parent = parent;
+      Node_listNoteName(l, children[j]);
+   }
+   total = Node_listLength(l) + count;
+
+   /* A list that will be a NodeArray takes the whole batch in one
+      merge. Inline lists are too short to be worth it, and BTrees
+      have no merge, so those take the batch a Node at a time. */
+   if(l->mode != LIST_TREE && total > NODE_INLINE_CHILDREN) {
+      if(l->mode == LIST_INLINE && !Node_listToArray(l))
+         return MEMORY_ERROR;
+      Node_indexClear(l);
+      if(!NodeArray_mergeSorted(l->u.array, children, count))
+         return MEMORY_ERROR;
+      if(total > NODE_TREE_CHILDREN)
+         (void) Node_listToTree(l);
+      return SUCCESS;
+   }
+
+   for(j = 0; j < count; j++) {
+      Node_keyOf(children[j], &key);
+      (void) Node_listSearch(l, &key, &i);
+      if(!Node_listAddAt(l, i, children[j])) {
+         Node_unlinkChildren(parent, children, j);
+         return MEMORY_ERROR;
+      }
+   }
+   return SUCCESS;
+}
+
+/* see node.h for specification */
+void Node_unlinkChildren(Node parent, Node* children, size_t count) {
+   struct childList* l;
+   struct nodeKey key;
+   size_t i;
+   size_t j;
+   size_t first = 0;
+   size_t run = 0;
+   int found;
+
+   assert(parent != NULL);
+   assert(parent->type == DIRECTORY);
+   assert(children != NULL || count == 0);
+
+   if(count == 0)
+      return;
+
+   l = Node_childrenOfType(parent, children[0]->type);
+
+   /* Going from the last child back leaves the indices of the ones
+      before it where they were, so a NodeArray gives up each run of
+      adjacent children with one NodeArray_removeRange. */
+   for(j = count; j-- > 0; ) {
+      assert(children[j]->type == children[0]->type);
+      Node_keyOf(children[j], &key);
+      found = Node_listSearch(l, &key, &i);
+      assert(found);
+      (void) found;
+
+      if(l->mode != LIST_ARRAY)
+         (void) Node_listRemoveAt(l, i);
+      else if(run > 0 && i + 1 == first) {
+         first = i;
+         run++;
+      }
+      else {
+         assert(run == 0 || i < first);
+         if(run > 0) {
+            Node_indexClear(l);
+            NodeArray_removeRange(l->u.array, first, run);
+         }
+         first = i;
+         run = 1;
+      }
+   }
+
+   if(run > 0) {
+      Node_indexClear(l);
+      NodeArray_removeRange(l->u.array, first, run);
+      Node_listSettle(l);
+   }
+}
+
 /* See node.h for specification */
 void Node_insertFileContents(Node n, void *contents, size_t length){
    assert(n != NULL);
@@ -270,6 +1282,7 @@ void Node_insertFileContents(Node n, void *contents, size_t length){
 
    n->storage.file.contents = contents;
    n->storage.file.length = length;
+   n->storage.file.owned = FALSE;
 
 }
 
@@ -289,6 +1302,74 @@ size_t Node_getFileLength(Node n){
    return n->storage.file.length;
 }
 
+/* See node.h for specification */
+void Node_setContentsOwned(Node n, boolean owned){
+   assert(n != NULL);
+   assert(n->type == FILE_S);
+
+   n->storage.file.owned = owned;
+}
+
+/* See node.h for specification */
+boolean Node_isContentsOwned(Node n){
+   assert(n != NULL);
+   assert(n->type == FILE_S);
+
+   return n->storage.file.owned;
+}
+
+/* See node.h for specification */
+size_t Node_getHandleID(Node n){
+   assert(n != NULL);
+   return n->handleID;
+}
+
+/* See node.h for specification */
+void Node_setHandleID(Node n, size_t handleID){
+   assert(n != NULL);
+   n->handleID = handleID;
+}
+
+/* See node.h for specification */
+size_t Node_getIndexSlot(Node n){
+   assert(n != NULL);
+   return n->indexSlot;
+}
+
+/* See node.h for specification */
+void Node_setIndexSlot(Node n, size_t indexSlot){
+   assert(n != NULL);
+   n->indexSlot = indexSlot;
+}
+
+/* See node.h for specification */
+size_t Node_getTotalLength(Node n){
+   assert(n != NULL);
+   assert(n->type == DIRECTORY);
+   return n->storage.dir.totalLength;
+}
+
+/* See node.h for specification */
+void Node_setTotalLength(Node n, size_t totalLength){
+   assert(n != NULL);
+   assert(n->type == DIRECTORY);
+   n->storage.dir.totalLength = totalLength;
+}
+
+/* See node.h for specification */
+size_t Node_getMaxLength(Node n){
+   assert(n != NULL);
+   assert(n->type == DIRECTORY);
+   return n->storage.dir.maxLength;
+}
+
+/* See node.h for specification */
+void Node_setMaxLength(Node n, size_t maxLength){
+   assert(n != NULL);
+   assert(n->type == DIRECTORY);
+   n->storage.dir.maxLength = maxLength;
+}
+
 /* See node.h for specification */
 nodeType Node_getType(Node n){
    assert(n != NULL);
@@ -304,7 +1385,7 @@ char* Node_toString(Node n) {
    copyPath = malloc(strlen(n->path)+1);
    if(copyPath == NULL)
       return NULL;
-   else
-      return strcpy(copyPath, n->path);
+   STATS_ADD(mallocs, 1);
+   return strcpy(copyPath, n->path);
 }
 
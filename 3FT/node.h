@@ -35,9 +35,16 @@ typedef enum {DIRECTORY, FILE_S} nodeType;
 
 Node Node_create(const char* name, Node parent, nodeType type);
 
+/*
+   Like Node_create, but the directory/file name is the first len
+   characters of name, which need not be '\0'-terminated.
+*/
+Node Node_createN(const char* name, size_t len, Node parent,
+                  nodeType type);
+
 /*
   Destroys the entire hierarchy of Nodes rooted at n,
-  including n itself.
+  including n itself, and the contents its files own.
 
   Returns the number of Nodes destroyed.
 */
@@ -57,12 +64,32 @@ int Node_compare(Node node1, Node node2);
 */
 const char* Node_getPath(Node n);
 
+/*
+   Returns the length of Node n's path, without recomputing it.
+*/
+size_t Node_getPathLength(Node n);
+
+/*
+   Returns a hash of the first len characters of name. Equal names
+   always have equal hashes, so callers may keep hashes of path
+   components alongside them to tell many unequal names apart
+   without comparing their characters.
+*/
+unsigned long Node_hashName(const char* name, size_t len);
+
 /*
   Returns the number of child directories n has. n must be a directory,
   not a file.
 */
 size_t Node_getNumChildren(Node n);
 
+/*
+  Returns the number of child files n has: its children with
+  identifiers from 0 up to that number, before its child directories.
+  n must be a directory, not a file.
+*/
+size_t Node_getNumFiles(Node n);
+
 /*
    Returns 1 if n has a child directory with path,
    0 if it does not have such a child, and -1 if
@@ -76,6 +103,29 @@ size_t Node_getNumChildren(Node n);
 */
 int Node_hasChild(Node n, const char* path, nodeType type);
 
+/*
+   Returns TRUE if n has a child of type type whose name (the final
+   component of its path) is the first len characters of name, and
+   FALSE otherwise. Never allocates memory.
+
+   If n does have such a child, stores the child's identifier in
+   *pChildID. If it does not, stores the identifier that such a child
+   would have in *pChildID. n must be a directory, not a file.
+*/
+boolean Node_findChild(Node n, const char* name, size_t len,
+                       nodeType type, size_t* pChildID);
+
+/*
+   Returns TRUE if n has a child of type type whose name is the first
+   len characters of name, as Node_findChild does, given hash, the
+   Node_hashName of those characters. Most names that n has no child
+   of are turned away by hash alone, without a search. Stores the
+   child's identifier in *pChildID only if it is found.
+*/
+boolean Node_findChildHashed(Node n, const char* name, size_t len,
+                             unsigned long hash, nodeType type,
+                             size_t* pChildID);
+
 /*
    Returns the child Node of n with identifier childID, if one exists,
    otherwise returns NULL. n must be a directory, not a file.
@@ -100,6 +150,28 @@ Node Node_getParent(Node n);
  */
 int Node_linkChild(Node parent, Node child);
 
+/*
+  Makes child a child of parent with identifier childID, shifting
+  the identifiers of any later children up by one, and returns
+  SUCCESS, or MEMORY_ERROR if parent is unable to allocate memory to
+  store the new child link.
+
+  Unlike Node_linkChild, performs no search: the caller must already
+  know (e.g. from Node_findChild) that childID is where child belongs.
+  parent must be a directory, not a file.
+ */
+int Node_addChildAt(Node parent, Node child, size_t childID);
+
+/*
+  Prepares directory n to gain count more children of type type
+  without reallocating its store of them along the way, when that
+  store is one that can be sized ahead. Returns SUCCESS, or
+  MEMORY_ERROR (leaving n's children as they were) if there is an
+  allocation error.
+  The store gives back what goes unused as children are removed.
+ */
+int Node_reserveChildren(Node n, nodeType type, size_t count);
+
 /*
   Unlinks Node parent from its child Node child, leaving the
   child Node unchanged.
@@ -111,9 +183,33 @@ int Node_linkChild(Node parent, Node child);
  */
 int Node_unlinkChild(Node parent, Node child);
 
+/*
+  Makes each of the count Nodes in children, all of one type, a child
+  of parent, and returns SUCCESS, or MEMORY_ERROR (leaving parent's
+  children as they were) if parent is unable to allocate memory to
+  store the new child links.
+  Like Node_addChildAt, performs no checks: children must be sorted
+  by path, must be named as children of parent, and must not share a
+  name with any child parent already has. A large enough batch is
+  merged into parent's children in one pass, rather than placed one
+  child at a time.
+  parent must be a directory, not a file.
+ */
+int Node_addChildren(Node parent, Node* children, size_t count);
+
+/*
+  Unlinks Node parent from each of the count Nodes in children, all
+  of one type, sorted by path and all children of parent, leaving
+  the child Nodes unchanged. Each run of children adjacent in
+  parent's store of them is taken out in one step.
+  parent must be a directory node.
+ */
+void Node_unlinkChildren(Node parent, Node* children, size_t count);
+
 /* 
   Inserts *contents into n->storage.file.contents and length into
-  n->storage.file.length 
+  n->storage.file.length. The new contents are not n's own, whether
+  or not the old ones were.
 */
 void Node_insertFileContents(Node n, void *contents, size_t length);
 
@@ -127,6 +223,65 @@ void *Node_getFileContents(Node n);
 */
 size_t Node_getFileLength(Node n);
 
+/*
+  Records whether file n owns its contents: if owned is TRUE,
+  Node_destroy frees them with free.
+*/
+void Node_setContentsOwned(Node n, boolean owned);
+
+/*
+  Returns TRUE if file n owns its contents, and FALSE otherwise.
+*/
+boolean Node_isContentsOwned(Node n);
+
+/*
+  Returns the identifier of the directory handle open on n, as last
+  set by Node_setHandleID, or 0 if none has been set.
+*/
+size_t Node_getHandleID(Node n);
+
+/*
+  Records handleID as the identifier of the directory handle open on
+  n; 0 means there is none. The Node itself attaches no meaning to it.
+*/
+void Node_setHandleID(Node n, size_t handleID);
+
+/*
+  Returns n's place in an index of Nodes, as last set by
+  Node_setIndexSlot, or 0 if none has been set.
+*/
+size_t Node_getIndexSlot(Node n);
+
+/*
+  Records indexSlot as n's place in an index of Nodes; 0 means it is
+  in none. The Node itself attaches no meaning to it.
+*/
+void Node_setIndexSlot(Node n, size_t indexSlot);
+
+/*
+  Returns the total length of the files beneath directory n, as last
+  set by Node_setTotalLength, or 0 if none has been set.
+*/
+size_t Node_getTotalLength(Node n);
+
+/*
+  Records totalLength as the total length of the files beneath
+  directory n. The Node itself does not keep it up to date.
+*/
+void Node_setTotalLength(Node n, size_t totalLength);
+
+/*
+  Returns the bound on the length of any file beneath directory n, as
+  last set by Node_setMaxLength, or 0 if none has been set.
+*/
+size_t Node_getMaxLength(Node n);
+
+/*
+  Records maxLength as a bound on the length of any file beneath
+  directory n. The Node itself does not keep it up to date.
+*/
+void Node_setMaxLength(Node n, size_t maxLength);
+
 /* Returns n->type which is either FILE_S or DIRECTORY*/
 nodeType Node_getType(Node n);
 
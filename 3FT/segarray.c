@@ -0,0 +1,557 @@
+/*--------------------------------------------------------------------*/
+/* segarray.c                                                         */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#include "segarray.h"
+#include "stats.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* Each chunk holds 2 to the SEGARRAY_CHUNK_BITS elements: 1024, or 8
+   KB of pointers, by default.  Build with a small value, e.g.
+   -DSEGARRAY_CHUNK_BITS=1, to make every operation cross chunks. */
+
+#ifndef SEGARRAY_CHUNK_BITS
+#define SEGARRAY_CHUNK_BITS 10
+#endif
+
+#define CHUNK_LENGTH ((size_t)1 << SEGARRAY_CHUNK_BITS)
+#define CHUNK_MASK (CHUNK_LENGTH - 1)
+
+/* The minimum physical length of a SegArray's chunk directory. */
+
+static const size_t MIN_DIR_LENGTH = 4;
+
+/* The address of the uIndex'th element of oSegArray. */
+
+#define SLOT(oSegArray, uIndex) \
+   (&(oSegArray)->pppvChunks[(uIndex) >> SEGARRAY_CHUNK_BITS] \
+    [(uIndex) & CHUNK_MASK])
+
+/*--------------------------------------------------------------------*/
+
+/* A SegArray consists of a directory of chunks, along with its
+   length, the number of chunks and the directory's physical
+   length. */
+
+struct SegArray
+{
+   /* The number of elements in the SegArray from the client's
+      point of view. */
+   size_t uLength;
+
+   /* The number of chunks allocated, each of CHUNK_LENGTH
+      elements. */
+   size_t uChunks;
+
+   /* The number of entries in the directory. */
+   size_t uDirLength;
+
+   /* The directory: the first uChunks entries point to the chunks,
+      in order.  NULL while uDirLength is 0. */
+   const void ***pppvChunks;
+};
+
+/*--------------------------------------------------------------------*/
+
+#ifndef NDEBUG
+
+/* Check the invariants of oSegArray.  Return 1 (TRUE) iff oSegArray
+   is in a valid state. */
+
+static int SegArray_isValid(SegArray_T oSegArray)
+{
+   if (oSegArray->uChunks > oSegArray->uDirLength) return 0;
+   if (oSegArray->uLength > oSegArray->uChunks * CHUNK_LENGTH) return 0;
+   if (oSegArray->uDirLength > 0 && oSegArray->pppvChunks == NULL)
+      return 0;
+   return 1;
+}
+
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* Add a chunk to the end of oSegArray, zeroed if iZero is 1 (TRUE),
+   doubling its directory first if that is full.  Return 1 (TRUE) if
+   successful and 0 (FALSE) if insufficient memory is available. */
+
+static int SegArray_addChunk(SegArray_T oSegArray, int iZero)
+{
+   const void ***pppvNewChunks;
+   const void **ppvChunk;
+   size_t uNewLength;
+
+   assert(oSegArray != NULL);
+
+   if (oSegArray->uChunks == oSegArray->uDirLength)
+   {
+      uNewLength = 2 * oSegArray->uDirLength;
+      if (uNewLength < MIN_DIR_LENGTH)
+         uNewLength = MIN_DIR_LENGTH;
+      pppvNewChunks = (const void***)
+         realloc(oSegArray->pppvChunks, sizeof(void**) * uNewLength);
+      if (pppvNewChunks == NULL)
+         return 0;
+      if (oSegArray->pppvChunks == NULL)
+         STATS_ADD(mallocs, 1);
+      else
+         STATS_ADD(grows, 1);
+      oSegArray->pppvChunks = pppvNewChunks;
+      oSegArray->uDirLength = uNewLength;
+   }
+
+   if (iZero)
+      ppvChunk = (const void**)calloc(CHUNK_LENGTH, sizeof(void*));
+   else
+      ppvChunk = (const void**)malloc(CHUNK_LENGTH * sizeof(void*));
+   if (ppvChunk == NULL)
+      return 0;
+   STATS_ADD(mallocs, 1);
+
+   oSegArray->pppvChunks[oSegArray->uChunks] = ppvChunk;
+   oSegArray->uChunks++;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the chunks of oSegArray from the uChunks'th on, which must lie
+   beyond its elements, and, if that leaves its directory less than a
+   quarter full, halve the directory. */
+
+static void SegArray_freeChunksFrom(SegArray_T oSegArray,
+                                    size_t uChunks)
+{
+   const void ***pppvNewChunks;
+   size_t uNewLength;
+
+   assert(oSegArray != NULL);
+   assert(uChunks * CHUNK_LENGTH >= oSegArray->uLength);
+
+   while (oSegArray->uChunks > uChunks)
+   {
+      oSegArray->uChunks--;
+      free(oSegArray->pppvChunks[oSegArray->uChunks]);
+      STATS_ADD(frees, 1);
+   }
+
+   uNewLength = oSegArray->uDirLength / 2;
+   if (oSegArray->uChunks < oSegArray->uDirLength / 4
+       && uNewLength >= MIN_DIR_LENGTH)
+   {
+      pppvNewChunks = (const void***)
+         realloc(oSegArray->pppvChunks, sizeof(void**) * uNewLength);
+      if (pppvNewChunks != NULL)
+      {
+         oSegArray->pppvChunks = pppvNewChunks;
+         oSegArray->uDirLength = uNewLength;
+      }
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+SegArray_T SegArray_new(size_t uLength)
+{
+   SegArray_T oSegArray;
+
+   oSegArray = (struct SegArray*)malloc(sizeof(struct SegArray));
+   if (oSegArray == NULL)
+      return NULL;
+   STATS_ADD(mallocs, 1);
+
+   oSegArray->uLength = 0;
+   oSegArray->uChunks = 0;
+   oSegArray->uDirLength = 0;
+   oSegArray->pppvChunks = NULL;
+
+   while (oSegArray->uChunks * CHUNK_LENGTH < uLength)
+      if (! SegArray_addChunk(oSegArray, 1))
+      {
+         SegArray_free(oSegArray);
+         return NULL;
+      }
+   oSegArray->uLength = uLength;
+
+   return oSegArray;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SegArray_free(SegArray_T oSegArray)
+{
+   size_t u;
+
+   assert(oSegArray != NULL);
+   assert(SegArray_isValid(oSegArray));
+
+   for (u = 0; u < oSegArray->uChunks; u++)
+      free(oSegArray->pppvChunks[u]);
+   STATS_ADD(frees, oSegArray->uChunks);
+   if (oSegArray->pppvChunks != NULL)
+   {
+      free(oSegArray->pppvChunks);
+      STATS_ADD(frees, 1);
+   }
+   free(oSegArray);
+   STATS_ADD(frees, 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SegArray_getLength(SegArray_T oSegArray)
+{
+   assert(oSegArray != NULL);
+   assert(SegArray_isValid(oSegArray));
+
+   return oSegArray->uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SegArray_getCapacity(SegArray_T oSegArray)
+{
+   assert(oSegArray != NULL);
+   assert(SegArray_isValid(oSegArray));
+
+   return oSegArray->uChunks * CHUNK_LENGTH;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SegArray_reserve(SegArray_T oSegArray, size_t uCapacity)
+{
+   assert(oSegArray != NULL);
+   assert(SegArray_isValid(oSegArray));
+
+   while (oSegArray->uChunks * CHUNK_LENGTH < uCapacity)
+      if (! SegArray_addChunk(oSegArray, 0))
+         return 0;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SegArray_shrinkToFit(SegArray_T oSegArray)
+{
+   assert(oSegArray != NULL);
+   assert(SegArray_isValid(oSegArray));
+
+   SegArray_freeChunksFrom(oSegArray,
+      (oSegArray->uLength + CHUNK_MASK) >> SEGARRAY_CHUNK_BITS);
+
+   assert(SegArray_isValid(oSegArray));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SegArray_get(SegArray_T oSegArray, size_t uIndex)
+{
+   assert(oSegArray != NULL);
+   assert(uIndex < oSegArray->uLength);
+   assert(SegArray_isValid(oSegArray));
+
+   return (void*)*SLOT(oSegArray, uIndex);
+}
+
+/*--------------------------------------------------------------------*/
+
+const void **SegArray_slot(SegArray_T oSegArray, size_t uIndex)
+{
+   assert(oSegArray != NULL);
+   assert(uIndex < oSegArray->uLength);
+   assert(SegArray_isValid(oSegArray));
+
+   return SLOT(oSegArray, uIndex);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SegArray_set(SegArray_T oSegArray, size_t uIndex,
+                   const void *pvElement)
+{
+   const void *pvOldElement;
+
+   assert(oSegArray != NULL);
+   assert(uIndex < oSegArray->uLength);
+   assert(SegArray_isValid(oSegArray));
+
+   pvOldElement = *SLOT(oSegArray, uIndex);
+   *SLOT(oSegArray, uIndex) = pvElement;
+
+   return (void*)pvOldElement;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SegArray_add(SegArray_T oSegArray, const void *pvElement)
+{
+   assert(oSegArray != NULL);
+   assert(SegArray_isValid(oSegArray));
+
+   if (oSegArray->uLength == oSegArray->uChunks * CHUNK_LENGTH)
+      if (! SegArray_addChunk(oSegArray, 0))
+         return 0;
+
+   *SLOT(oSegArray, oSegArray->uLength) = pvElement;
+   oSegArray->uLength++;
+
+   assert(SegArray_isValid(oSegArray));
+
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SegArray_addAt(SegArray_T oSegArray, size_t uIndex,
+                   const void *pvElement)
+{
+   size_t u;
+   size_t uStart;
+
+   assert(oSegArray != NULL);
+   assert(uIndex <= oSegArray->uLength);
+   assert(SegArray_isValid(oSegArray));
+
+   if (oSegArray->uLength == oSegArray->uChunks * CHUNK_LENGTH)
+      if (! SegArray_addChunk(oSegArray, 0))
+         return 0;
+
+   /* Shift the elements from uIndex on up by one, a chunk at a time
+      from the last, carrying one element across each boundary.  u is
+      the slot to fill next. */
+   u = oSegArray->uLength;
+   while (u > uIndex)
+   {
+      if ((u & CHUNK_MASK) == 0)
+      {
+         *SLOT(oSegArray, u) = *SLOT(oSegArray, u - 1);
+         u--;
+         continue;
+      }
+      uStart = u & ~CHUNK_MASK;
+      if (uStart < uIndex)
+         uStart = uIndex;
+      memmove(SLOT(oSegArray, uStart + 1), SLOT(oSegArray, uStart),
+              (u - uStart) * sizeof(void*));
+      u = uStart;
+   }
+   STATS_ADD(shifts, oSegArray->uLength - uIndex);
+
+   *SLOT(oSegArray, uIndex) = pvElement;
+   oSegArray->uLength++;
+
+   assert(SegArray_isValid(oSegArray));
+
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SegArray_removeAt(SegArray_T oSegArray, size_t uIndex)
+{
+   const void *pvOldElement;
+   size_t u;
+   size_t uEnd;
+
+   assert(oSegArray != NULL);
+   assert(uIndex < oSegArray->uLength);
+   assert(SegArray_isValid(oSegArray));
+
+   pvOldElement = *SLOT(oSegArray, uIndex);
+
+   /* Shift the elements after uIndex down by one, a chunk at a time
+      from the first, carrying one element across each boundary.  u
+      is the slot to fill next. */
+   u = uIndex;
+   while (u + 1 < oSegArray->uLength)
+   {
+      if (((u + 1) & CHUNK_MASK) == 0)
+      {
+         *SLOT(oSegArray, u) = *SLOT(oSegArray, u + 1);
+         u++;
+         continue;
+      }
+      uEnd = (u | CHUNK_MASK) + 1;
+      if (uEnd > oSegArray->uLength)
+         uEnd = oSegArray->uLength;
+      memmove(SLOT(oSegArray, u), SLOT(oSegArray, u + 1),
+              (uEnd - 1 - u) * sizeof(void*));
+      u = uEnd - 1;
+   }
+   STATS_ADD(shifts, oSegArray->uLength - 1 - uIndex);
+   oSegArray->uLength--;
+
+   /* Keep one spare chunk, so that removing and adding at a chunk
+      boundary does not free and allocate a chunk every time. */
+   if (oSegArray->uLength + 2 * CHUNK_LENGTH
+       <= oSegArray->uChunks * CHUNK_LENGTH)
+      SegArray_freeChunksFrom(oSegArray, oSegArray->uChunks - 1);
+
+   assert(SegArray_isValid(oSegArray));
+
+   return (void*)pvOldElement;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SegArray_toArray(SegArray_T oSegArray, void **ppvArray)
+{
+   size_t u;
+   size_t uCount;
+
+   assert(oSegArray != NULL);
+   assert(ppvArray != NULL);
+   assert(SegArray_isValid(oSegArray));
+
+   for (u = 0; u < oSegArray->uLength; u += uCount)
+   {
+      uCount = oSegArray->uLength - u;
+      if (uCount > CHUNK_LENGTH)
+         uCount = CHUNK_LENGTH;
+      memcpy(&ppvArray[u], SLOT(oSegArray, u), uCount * sizeof(void*));
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void SegArray_map(SegArray_T oSegArray,
+                  void (*pfApply)(void *pvElement, void *pvExtra),
+                  const void *pvExtra)
+{
+   const void **ppvChunk;
+   size_t u;
+   size_t uIndex;
+   size_t uCount;
+
+   assert(oSegArray != NULL);
+   assert(pfApply != NULL);
+   assert(SegArray_isValid(oSegArray));
+
+   for (uIndex = 0; uIndex < oSegArray->uLength; uIndex += uCount)
+   {
+      ppvChunk = SLOT(oSegArray, uIndex);
+      uCount = oSegArray->uLength - uIndex;
+      if (uCount > CHUNK_LENGTH)
+         uCount = CHUNK_LENGTH;
+      for (u = 0; u < uCount; u++)
+         (*pfApply)((void*)ppvChunk[u], (void*)pvExtra);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void SegArray_sort(SegArray_T oSegArray,
+                   int (*pfCompare)(const void *pvElement1,
+                                    const void *pvElement2))
+{
+   size_t uLength;
+   size_t uStart;
+   size_t uRoot;
+   size_t uChild;
+   const void *pvTemp;
+
+   assert(oSegArray != NULL);
+   assert(pfCompare != NULL);
+   assert(SegArray_isValid(oSegArray));
+
+   /* Build a max-heap of all the elements, then repeatedly swap its
+      root, the largest, to the end of the heap and sift down the
+      element swapped in, as DynArray's heapsort does. */
+   uLength = oSegArray->uLength;
+   uStart = uLength / 2;
+   while (uLength > 1)
+   {
+      if (uStart > 0)
+         uStart--;
+      else
+      {
+         uLength--;
+         pvTemp = *SLOT(oSegArray, 0);
+         *SLOT(oSegArray, 0) = *SLOT(oSegArray, uLength);
+         *SLOT(oSegArray, uLength) = pvTemp;
+      }
+
+      uRoot = uStart;
+      while ((uChild = 2 * uRoot + 1) < uLength)
+      {
+         if (uChild + 1 < uLength
+             && (*pfCompare)(*SLOT(oSegArray, uChild),
+                             *SLOT(oSegArray, uChild + 1)) < 0)
+            uChild++;
+         if ((*pfCompare)(*SLOT(oSegArray, uRoot),
+                          *SLOT(oSegArray, uChild)) >= 0)
+            break;
+         pvTemp = *SLOT(oSegArray, uRoot);
+         *SLOT(oSegArray, uRoot) = *SLOT(oSegArray, uChild);
+         *SLOT(oSegArray, uChild) = pvTemp;
+         uRoot = uChild;
+      }
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+int SegArray_search(SegArray_T oSegArray,
+                    void *pvSoughtElement,
+                    size_t *puIndex,
+                    int (*pfCompare)(const void *pvElement1,
+                                     const void *pvElement2))
+{
+   size_t u;
+
+   assert(oSegArray != NULL);
+   assert(puIndex != NULL);
+   assert(pfCompare != NULL);
+   assert(SegArray_isValid(oSegArray));
+
+   for (u = 0; u < oSegArray->uLength; u++)
+      if ((*pfCompare)(*SLOT(oSegArray, u), pvSoughtElement) == 0)
+      {
+         *puIndex = u;
+         return 1;
+      }
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SegArray_bsearch(SegArray_T oSegArray,
+                     void *pvSoughtElement,
+                     size_t *puIndex,
+                     int (*pfCompare)(const void *pvElement1,
+                                      const void *pvElement2))
+{
+   size_t uLo = 0;
+   size_t uHi;
+   size_t uMid;
+   int iCompare;
+
+   assert(oSegArray != NULL);
+   assert(puIndex != NULL);
+   assert(pfCompare != NULL);
+   assert(SegArray_isValid(oSegArray));
+
+   uHi = oSegArray->uLength;
+   while (uLo < uHi)
+   {
+      uMid = uLo + (uHi - uLo) / 2;
+      iCompare = (*pfCompare)(pvSoughtElement, *SLOT(oSegArray, uMid));
+      if (iCompare == 0)
+      {
+         *puIndex = uMid;
+         return 1;
+      }
+      if (iCompare < 0)
+         uHi = uMid;
+      else
+         uLo = uMid + 1;
+   }
+   *puIndex = uLo;
+   return 0;
+}
@@ -0,0 +1,160 @@
+/*--------------------------------------------------------------------*/
+/* segarray.h                                                         */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#ifndef SEGARRAY_INCLUDED
+#define SEGARRAY_INCLUDED
+
+#include <stddef.h>
+
+/* A SegArray_T object is an array whose length can expand
+   dynamically, as a DynArray_T's can, but that is stored as a
+   directory of fixed-size chunks rather than as one block.  Growing
+   it adds a chunk and never moves the elements already there, so an
+   element stays at the same address until an insertion or removal
+   before it shifts it, and no append copies more than the directory.
+   The functions behave as their DynArray counterparts, described in
+   dynarray.h, except where noted. */
+
+typedef struct SegArray *SegArray_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new SegArray_T object whose length is uLength, and whose
+   elements are all NULL, or NULL if insufficient memory is
+   available. */
+
+SegArray_T SegArray_new(size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oSegArray. */
+
+void SegArray_free(SegArray_T oSegArray);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the length of oSegArray. */
+
+size_t SegArray_getLength(SegArray_T oSegArray);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of elements oSegArray can hold in the chunks it
+   has: the length it can reach before it must add another. */
+
+size_t SegArray_getCapacity(SegArray_T oSegArray);
+
+/*--------------------------------------------------------------------*/
+
+/* Add chunks to oSegArray until it can hold uCapacity elements.
+   Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory
+   is available. */
+
+int SegArray_reserve(SegArray_T oSegArray, size_t uCapacity);
+
+/*--------------------------------------------------------------------*/
+
+/* Free the chunks of oSegArray beyond those its elements occupy. */
+
+void SegArray_shrinkToFit(SegArray_T oSegArray);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the uIndex'th element of oSegArray. */
+
+void *SegArray_get(SegArray_T oSegArray, size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the address at which oSegArray holds its uIndex'th element.
+   It stays valid, and holds the same element, until an insertion or
+   removal at or before uIndex, a shrink that frees its chunk, or the
+   freeing of oSegArray. */
+
+const void **SegArray_slot(SegArray_T oSegArray, size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Assign pvElement to the uIndex'th element of oSegArray.  Return the
+   old element. */
+
+void *SegArray_set(SegArray_T oSegArray, size_t uIndex,
+                   const void *pvElement);
+
+/*--------------------------------------------------------------------*/
+
+/* Add pvElement to the end of oSegArray, thus incrementing its length.
+   Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory
+   is available.  Copies at most the chunk directory. */
+
+int SegArray_add(SegArray_T oSegArray, const void *pvElement);
+
+/*--------------------------------------------------------------------*/
+
+/* Add pvElement to oSegArray such that it is the uIndex'th element.
+   Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory
+   is available. */
+
+int SegArray_addAt(SegArray_T oSegArray, size_t uIndex,
+                   const void *pvElement);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove and return the uIndex'th element of oSegArray, freeing its
+   last chunk once a whole chunk beyond that one is unused. */
+
+void *SegArray_removeAt(SegArray_T oSegArray, size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Fill ppvArray with the elements of oSegArray.  ppvArray must point
+   to an area of memory that is large enough to hold all elements of
+   oSegArray. */
+
+void SegArray_toArray(SegArray_T oSegArray, void **ppvArray);
+
+/*--------------------------------------------------------------------*/
+
+/* Apply function *pfApply to each element of oSegArray, passing
+   pvExtra as an extra argument.  That is, for each element pvElement
+   of oSegArray, call (*pfApply)(pvElement, pvExtra). */
+
+void SegArray_map(SegArray_T oSegArray,
+                  void (*pfApply)(void *pvElement, void *pvExtra),
+                  const void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Sort oSegArray in the order determined by *pfCompare, as
+   DynArray_sort does.  Sorts in place, by heapsort, so takes O(n log
+   n) time for any order of input and no memory beyond oSegArray. */
+
+void SegArray_sort(SegArray_T oSegArray,
+                   int (*pfCompare)(const void *pvElement1,
+                                    const void *pvElement2));
+
+/*--------------------------------------------------------------------*/
+
+/* Linear search oSegArray for *pvSoughtElement as DynArray_search
+   does. */
+
+int SegArray_search(SegArray_T oSegArray,
+                    void *pvSoughtElement,
+                    size_t *puIndex,
+                    int (*pfCompare)(const void *pvElement1,
+                                     const void *pvElement2));
+
+/*--------------------------------------------------------------------*/
+
+/* Binary search oSegArray for *pvSoughtElement as DynArray_bsearch
+   does. */
+
+int SegArray_bsearch(SegArray_T oSegArray,
+                     void *pvSoughtElement,
+                     size_t *puIndex,
+                     int (*pfCompare)(const void *pvElement1,
+                                      const void *pvElement2));
+
+#endif
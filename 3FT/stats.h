@@ -0,0 +1,93 @@
+/*--------------------------------------------------------------------*/
+/* stats.h                                                            */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#ifndef STATS_INCLUDED
+#define STATS_INCLUDED
+
+#include <stddef.h>
+
+/* Counters of the work done on the hot paths of the tree, to tell
+   whether a slow lookup is slow because of depth, fanout or string
+   compares. They are only collected when the modules are compiled
+   with -DCOLLECT_STATS; otherwise the STATS_* macros below expand to
+   nothing. Each thread counts into its own Stats object, so that the
+   counters do not become a point of contention. */
+
+struct Stats {
+   /* path traversals, and nodes visited by them */
+   unsigned long traversals;
+   unsigned long nodesVisited;
+   /* node and path comparisons, and bytes examined by them */
+   unsigned long compares;
+   unsigned long bytesCompared;
+   /* heap blocks allocated and freed */
+   unsigned long mallocs;
+   unsigned long frees;
+   /* DynArray reallocations, and elements shifted by DynArray_addAt
+      and DynArray_removeAt */
+   unsigned long grows;
+   unsigned long shifts;
+   /* invariant checks run, and seconds spent in them */
+   unsigned long checks;
+   double checkerSeconds;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Assign to *psTotal the sum of every thread's counters, including
+   those of threads that have exited. All zero if the counters are not
+   compiled in. */
+
+void Stats_sum(struct Stats *psTotal);
+
+/*--------------------------------------------------------------------*/
+
+/* Zero every thread's counters. Increments that other threads make
+   while the reset is in progress may survive it. */
+
+void Stats_reset(void);
+
+#ifdef COLLECT_STATS
+
+/*--------------------------------------------------------------------*/
+
+/* The calling thread's counters, or NULL before its first count */
+
+extern __thread struct Stats *Stats_psLocal;
+
+/*--------------------------------------------------------------------*/
+
+/* Create and return the calling thread's counters. If insufficient
+   memory is available, return counters private to the thread that are
+   never summed, so that its increments are dropped. */
+
+struct Stats *Stats_register(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Count one comparison of the strings pcS1 and pcS2, which examines
+   at most uMax bytes. */
+
+void Stats_compare(const char *pcS1, const char *pcS2, size_t uMax);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current time in seconds. */
+
+double Stats_now(void);
+
+#define STATS_ADD(field, n) \
+   ((void)((Stats_psLocal != NULL ? Stats_psLocal : Stats_register()) \
+           ->field += (n)))
+#define STATS_COMPARE(s1, s2, max) Stats_compare((s1), (s2), (max))
+
+#else
+
+#define STATS_ADD(field, n) ((void)0)
+#define STATS_COMPARE(s1, s2, max) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,860 @@
+/*--------------------------------------------------------------------*/
+/* tar.c                                                              */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "tar.h"
+#include "stats.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The size of a tar block: every header, and every entry's contents
+   padded with zeros, fills whole blocks. */
+
+enum { BLOCK_SIZE = 512 };
+
+/* The size of the buffer of a reader or writer, a multiple of
+   BLOCK_SIZE.  Contents at least this long bypass it. */
+
+enum { BUFFER_SIZE = 64 * 1024 };
+
+/* The longest pax or GNU extended header a reader accepts. */
+
+enum { MAX_EXTENDED = 1024 * 1024 };
+
+/* The offsets and lengths of the fields of a ustar header. */
+
+enum { NAME_AT = 0, NAME_LENGTH = 100,
+       MODE_AT = 100, ID_LENGTH = 8, UID_AT = 108, GID_AT = 116,
+       SIZE_AT = 124, SIZE_LENGTH = 12, MTIME_AT = 136,
+       CHECKSUM_AT = 148, CHECKSUM_LENGTH = 8, TYPE_AT = 156,
+       LINK_AT = 157,
+       MAGIC_AT = 257, VERSION_AT = 263,
+       PREFIX_AT = 345, PREFIX_LENGTH = 155 };
+
+/* The name given to the pax headers a writer adds. */
+
+static const char acPaxName[] = "././@PaxHeader";
+
+/*--------------------------------------------------------------------*/
+
+/* A TarReader reads an archive through a buffer, keeping track of
+   what is left of the current entry, and of any extended path and
+   size that apply to the next one. */
+
+struct TarReader
+{
+   int iFd;
+
+   /* The bytes read ahead, from uStart up to uEnd of aucBuffer. */
+   unsigned char aucBuffer[BUFFER_SIZE];
+   size_t uStart;
+   size_t uEnd;
+
+   /* The contents of the current entry not yet read, and the padding
+      after them. */
+   size_t uRemaining;
+   size_t uPadding;
+
+   /* Whether the file descriptor has reached end-of-file. */
+   int iAtEnd;
+
+   /* The path of the current entry, if in its ustar header. */
+   char acPath[PREFIX_LENGTH + 1 + NAME_LENGTH + 1];
+
+   /* The path of the current entry if extended, or NULL. */
+   char *pcLongPath;
+
+   /* The path a hard link links to, if in its ustar header, and if
+      extended, or NULL. */
+   char acLinkPath[NAME_LENGTH + 1];
+   char *pcLongLinkPath;
+
+   /* The extended path, link path and size of the next entry, if
+      any. */
+   char *pcNextPath;
+   char *pcNextLinkPath;
+   size_t uNextSize;
+   int iHasNextSize;
+};
+
+/* A TarWriter writes an archive through a buffer. */
+
+struct TarWriter
+{
+   int iFd;
+
+   /* The bytes not yet written: the first uUsed of aucBuffer. */
+   unsigned char aucBuffer[BUFFER_SIZE];
+   size_t uUsed;
+};
+
+/*--------------------------------------------------------------------*/
+
+TarReader_T TarReader_new(int iFd)
+{
+   TarReader_T oReader;
+
+   oReader = calloc(1, sizeof(struct TarReader));
+   if (oReader == NULL)
+      return NULL;
+   STATS_ADD(mallocs, 1);
+   oReader->iFd = iFd;
+   return oReader;
+}
+
+/*--------------------------------------------------------------------*/
+
+void TarReader_free(TarReader_T oReader)
+{
+   assert(oReader != NULL);
+
+   free(oReader->pcLongPath);
+   free(oReader->pcNextPath);
+   free(oReader->pcLongLinkPath);
+   free(oReader->pcNextLinkPath);
+   free(oReader);
+   STATS_ADD(frees, 5);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read the next uLength bytes of the archive of oReader into pvOut,
+   or discard them if pvOut is NULL, storing the number read in
+   *puRead.  Return SUCCESS, or IO_ERROR if the archive ends or cannot
+   be read first. */
+
+static int TarReader_get(TarReader_T oReader, void *pvOut,
+                         size_t uLength, size_t *puRead)
+{
+   unsigned char *pucOut = pvOut;
+   size_t uChunk;
+   ssize_t iBytes;
+
+   *puRead = 0;
+   while (*puRead < uLength)
+   {
+      if (oReader->uStart < oReader->uEnd)
+      {
+         uChunk = oReader->uEnd - oReader->uStart;
+         if (uChunk > uLength - *puRead)
+            uChunk = uLength - *puRead;
+         if (pucOut != NULL)
+            memcpy(pucOut + *puRead, oReader->aucBuffer + oReader->uStart,
+                   uChunk);
+         oReader->uStart += uChunk;
+         *puRead += uChunk;
+         continue;
+      }
+
+      /* Read what is left straight into pvOut if it would fill the
+         buffer, and into the buffer otherwise. */
+      if (pucOut != NULL && uLength - *puRead >= BUFFER_SIZE)
+         iBytes = read(oReader->iFd, pucOut + *puRead, uLength - *puRead);
+      else
+         iBytes = read(oReader->iFd, oReader->aucBuffer, BUFFER_SIZE);
+      if (iBytes < 0 && errno == EINTR)
+         continue;
+      if (iBytes == 0)
+         oReader->iAtEnd = 1;
+      if (iBytes <= 0)
+         return IO_ERROR;
+      if (pucOut != NULL && uLength - *puRead >= BUFFER_SIZE)
+         *puRead += (size_t)iBytes;
+      else
+      {
+         oReader->uStart = 0;
+         oReader->uEnd = (size_t)iBytes;
+      }
+   }
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Parse the number in the uLength bytes at puc, a header field in
+   octal, or in base 256 if its first bit is set, into *puValue.
+   Return 1 (TRUE) if successful, or 0 (FALSE) if it is malformed or
+   too large. */
+
+static int Tar_parseNumber(const unsigned char *puc, size_t uLength,
+                           size_t *puValue)
+{
+   size_t uValue = 0;
+   size_t u = 0;
+
+   if (puc[0] & 0x80)
+   {
+      /* The next bit is the sign. */
+      if (puc[0] & 0x40)
+         return 0;
+      uValue = puc[0] & 0x3f;
+      for (u = 1; u < uLength; u++)
+      {
+         if (uValue > ((size_t)-1 >> 8))
+            return 0;
+         uValue = (uValue << 8) | puc[u];
+      }
+      *puValue = uValue;
+      return 1;
+   }
+
+   while (u < uLength && puc[u] == ' ')
+      u++;
+   for (; u < uLength && puc[u] >= '0' && puc[u] <= '7'; u++)
+   {
+      if (uValue > ((size_t)-1 >> 3))
+         return 0;
+      uValue = (uValue << 3) | (size_t)(puc[u] - '0');
+   }
+   if (u < uLength && puc[u] != ' ' && puc[u] != '\0')
+      return 0;
+   *puValue = uValue;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if the checksum of the header at pucHeader matches
+   the sum of its bytes, counting those of the checksum as spaces, and
+   0 (FALSE) otherwise.  Some archivers sum the bytes as signed. */
+
+static int Tar_checksumMatches(const unsigned char *pucHeader)
+{
+   size_t uChecksum;
+   unsigned long ulSum = 0;
+   long lSignedSum = 0;
+   size_t u;
+
+   if (!Tar_parseNumber(pucHeader + CHECKSUM_AT, CHECKSUM_LENGTH,
+                        &uChecksum))
+      return 0;
+   for (u = 0; u < BLOCK_SIZE; u++)
+   {
+      if (u >= CHECKSUM_AT && u < CHECKSUM_AT + CHECKSUM_LENGTH)
+      {
+         ulSum += ' ';
+         lSignedSum += ' ';
+      }
+      else
+      {
+         ulSum += pucHeader[u];
+         lSignedSum += (signed char)pucHeader[u];
+      }
+   }
+   return ulSum == uChecksum || (unsigned long)lSignedSum == uChecksum;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read the uLength bytes of an extended header of oReader into a new
+   string.  Store it in *ppcText.  Return SUCCESS, or MEMORY_ERROR or
+   IO_ERROR, storing nothing. */
+
+static int TarReader_getExtended(TarReader_T oReader, size_t uLength,
+                                 char **ppcText)
+{
+   char *pcText;
+   size_t uRead;
+
+   if (uLength > MAX_EXTENDED)
+      return IO_ERROR;
+   pcText = malloc(uLength + 1);
+   if (pcText == NULL)
+      return MEMORY_ERROR;
+   STATS_ADD(mallocs, 1);
+   if (TarReader_get(oReader, pcText, uLength, &uRead) != SUCCESS)
+   {
+      free(pcText);
+      STATS_ADD(frees, 1);
+      return IO_ERROR;
+   }
+   pcText[uLength] = '\0';
+   oReader->uRemaining = 0;
+   *ppcText = pcText;
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Take the path, link path and size in the uLength bytes of pax
+   records at pcRecords, each "<length> <key>=<value>\n", as those of
+   the next entry of oReader.  Return SUCCESS, or IO_ERROR if they are
+   malformed, or MEMORY_ERROR. */
+
+static int TarReader_parsePax(TarReader_T oReader, char *pcRecords,
+                              size_t uLength)
+{
+   char *pcRecord = pcRecords;
+   char *pcKey;
+   char *pcValue;
+   char *pcEnd;
+   char **ppcText;
+   size_t uRecord;
+   size_t uSize;
+
+   while ((size_t)(pcRecord - pcRecords) < uLength)
+   {
+      uRecord = 0;
+      for (pcKey = pcRecord; *pcKey >= '0' && *pcKey <= '9'; pcKey++)
+      {
+         if (uRecord > MAX_EXTENDED)
+            return IO_ERROR;
+         uRecord = uRecord * 10 + (size_t)(*pcKey - '0');
+      }
+      pcEnd = pcRecord + uRecord - 1;
+      if (*pcKey != ' ' || uRecord == 0 ||
+          uRecord > uLength - (size_t)(pcRecord - pcRecords) ||
+          pcEnd <= pcKey || *pcEnd != '\n')
+         return IO_ERROR;
+      pcKey++;
+      *pcEnd = '\0';
+      pcValue = strchr(pcKey, '=');
+      if (pcValue == NULL)
+         return IO_ERROR;
+      *pcValue++ = '\0';
+
+      if (strcmp(pcKey, "path") == 0)
+         ppcText = &oReader->pcNextPath;
+      else if (strcmp(pcKey, "linkpath") == 0)
+         ppcText = &oReader->pcNextLinkPath;
+      else
+         ppcText = NULL;
+
+      if (ppcText != NULL)
+      {
+         free(*ppcText);
+         *ppcText = malloc(strlen(pcValue) + 1);
+         if (*ppcText == NULL)
+            return MEMORY_ERROR;
+         STATS_ADD(mallocs, 1);
+         strcpy(*ppcText, pcValue);
+      }
+      else if (strcmp(pcKey, "size") == 0)
+      {
+         uSize = 0;
+         for (; *pcValue >= '0' && *pcValue <= '9'; pcValue++)
+         {
+            if (uSize > ((size_t)-1 - 9) / 10)
+               return IO_ERROR;
+            uSize = uSize * 10 + (size_t)(*pcValue - '0');
+         }
+         if (*pcValue != '\0')
+            return IO_ERROR;
+         oReader->uNextSize = uSize;
+         oReader->iHasNextSize = 1;
+      }
+      pcRecord = pcEnd + 1;
+   }
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make the ustar name, and prefix if it has one, of the header at
+   pucHeader the path of oReader's current entry. */
+
+static void TarReader_ustarPath(TarReader_T oReader,
+                                const unsigned char *pucHeader)
+{
+   size_t uLength = 0;
+   size_t u;
+
+   /* Only POSIX ustar has a prefix; GNU puts other things there. */
+   if (memcmp(pucHeader + MAGIC_AT, "ustar", 6) == 0 &&
+       pucHeader[PREFIX_AT] != '\0')
+   {
+      for (u = 0; u < PREFIX_LENGTH && pucHeader[PREFIX_AT + u] != '\0';
+           u++)
+         oReader->acPath[uLength++] = (char)pucHeader[PREFIX_AT + u];
+      oReader->acPath[uLength++] = '/';
+   }
+   for (u = 0; u < NAME_LENGTH && pucHeader[NAME_AT + u] != '\0'; u++)
+      oReader->acPath[uLength++] = (char)pucHeader[NAME_AT + u];
+   oReader->acPath[uLength] = '\0';
+}
+
+/*--------------------------------------------------------------------*/
+
+int TarReader_next(TarReader_T oReader, enum TarType *peType,
+                   char **ppcPath, size_t *puLength)
+{
+   unsigned char aucHeader[BLOCK_SIZE];
+   char *pcText;
+   size_t uRead;
+   size_t uSize;
+   size_t u;
+   int iResult;
+
+   assert(oReader != NULL);
+   assert(peType != NULL);
+   assert(ppcPath != NULL);
+   assert(puLength != NULL);
+
+   free(oReader->pcLongPath);
+   oReader->pcLongPath = NULL;
+   free(oReader->pcLongLinkPath);
+   oReader->pcLongLinkPath = NULL;
+
+   for (;;)
+   {
+      if (TarReader_get(oReader, NULL,
+                        oReader->uRemaining + oReader->uPadding,
+                        &uRead) != SUCCESS)
+         return IO_ERROR;
+      oReader->uRemaining = 0;
+      oReader->uPadding = 0;
+
+      /* An archive may end with end-of-file instead of its two blocks
+         of zeros. */
+      iResult = TarReader_get(oReader, aucHeader, BLOCK_SIZE, &uRead);
+      if (iResult != SUCCESS && uRead == 0 && oReader->iAtEnd)
+         break;
+      if (iResult != SUCCESS)
+         return IO_ERROR;
+      for (u = 0; u < BLOCK_SIZE && aucHeader[u] == 0; u++)
+         ;
+      if (u == BLOCK_SIZE)
+         break;
+
+      if (!Tar_checksumMatches(aucHeader) ||
+          !Tar_parseNumber(aucHeader + SIZE_AT, SIZE_LENGTH, &uSize))
+         return IO_ERROR;
+      if (oReader->iHasNextSize && aucHeader[TYPE_AT] != 'x' &&
+          aucHeader[TYPE_AT] != 'g')
+         uSize = oReader->uNextSize;
+      oReader->uRemaining = uSize;
+      oReader->uPadding = (BLOCK_SIZE - uSize % BLOCK_SIZE) % BLOCK_SIZE;
+
+      switch (aucHeader[TYPE_AT])
+      {
+         case 'x':
+            /* pax records for the next entry */
+            iResult = TarReader_getExtended(oReader, uSize, &pcText);
+            if (iResult == SUCCESS)
+            {
+               iResult = TarReader_parsePax(oReader, pcText, uSize);
+               free(pcText);
+               STATS_ADD(frees, 1);
+            }
+            if (iResult != SUCCESS)
+               return iResult;
+            break;
+
+         case 'L':
+            /* a GNU long name for the next entry */
+            iResult = TarReader_getExtended(oReader, uSize, &pcText);
+            if (iResult != SUCCESS)
+               return iResult;
+            free(oReader->pcNextPath);
+            oReader->pcNextPath = pcText;
+            break;
+
+         case 'K':
+            /* a GNU long link path for the next entry */
+            iResult = TarReader_getExtended(oReader, uSize, &pcText);
+            if (iResult != SUCCESS)
+               return iResult;
+            free(oReader->pcNextLinkPath);
+            oReader->pcNextLinkPath = pcText;
+            break;
+
+         case '0': case '\0': case '7': case '5': case '1':
+            if (oReader->pcNextPath != NULL)
+               oReader->pcLongPath = oReader->pcNextPath;
+            else
+               TarReader_ustarPath(oReader, aucHeader);
+            oReader->pcNextPath = NULL;
+            oReader->iHasNextSize = 0;
+            *ppcPath = oReader->pcLongPath != NULL ?
+               oReader->pcLongPath : oReader->acPath;
+
+            if (aucHeader[TYPE_AT] == '1')
+            {
+               if (oReader->pcNextLinkPath != NULL)
+                  oReader->pcLongLinkPath = oReader->pcNextLinkPath;
+               else
+               {
+                  for (u = 0; u < NAME_LENGTH &&
+                          aucHeader[LINK_AT + u] != '\0'; u++)
+                     oReader->acLinkPath[u] = (char)aucHeader[LINK_AT + u];
+                  oReader->acLinkPath[u] = '\0';
+               }
+               oReader->pcNextLinkPath = NULL;
+               *peType = TAR_LINK;
+            }
+            else
+            {
+               free(oReader->pcNextLinkPath);
+               oReader->pcNextLinkPath = NULL;
+               *peType = aucHeader[TYPE_AT] == '5' ? TAR_DIR : TAR_FILE;
+            }
+            *puLength = *peType == TAR_FILE ? uSize : 0;
+            return SUCCESS;
+
+         case 'g':
+            /* global pax records, which set nothing kept here */
+            break;
+
+         default:
+            /* symbolic links, devices and the like, and their
+               extensions */
+            free(oReader->pcNextPath);
+            oReader->pcNextPath = NULL;
+            free(oReader->pcNextLinkPath);
+            oReader->pcNextLinkPath = NULL;
+            oReader->iHasNextSize = 0;
+            break;
+      }
+   }
+
+   *peType = TAR_END;
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+char *TarReader_getLinkPath(TarReader_T oReader)
+{
+   assert(oReader != NULL);
+
+   return oReader->pcLongLinkPath != NULL ?
+      oReader->pcLongLinkPath : oReader->acLinkPath;
+}
+
+/*--------------------------------------------------------------------*/
+
+int TarReader_read(TarReader_T oReader, void *pvContents,
+                   size_t uLength)
+{
+   size_t uRead;
+
+   assert(oReader != NULL);
+   assert(pvContents != NULL || uLength == 0);
+   assert(uLength <= oReader->uRemaining);
+
+   oReader->uRemaining -= uLength;
+   return TarReader_get(oReader, pvContents, uLength, &uRead);
+}
+
+/*--------------------------------------------------------------------*/
+
+TarWriter_T TarWriter_new(int iFd)
+{
+   TarWriter_T oWriter;
+
+   oWriter = malloc(sizeof(struct TarWriter));
+   if (oWriter == NULL)
+      return NULL;
+   STATS_ADD(mallocs, 1);
+   oWriter->iFd = iFd;
+   oWriter->uUsed = 0;
+   return oWriter;
+}
+
+/*--------------------------------------------------------------------*/
+
+void TarWriter_free(TarWriter_T oWriter)
+{
+   free(oWriter);
+   STATS_ADD(frees, 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the uLength bytes at pvBytes to iFd.  Return SUCCESS, or
+   IO_ERROR if they cannot all be written. */
+
+static int Tar_writeAll(int iFd, const void *pvBytes, size_t uLength)
+{
+   const unsigned char *puc = pvBytes;
+   ssize_t iBytes;
+
+   while (uLength > 0)
+   {
+      iBytes = write(iFd, puc, uLength);
+      if (iBytes < 0 && errno == EINTR)
+         continue;
+      if (iBytes <= 0)
+         return IO_ERROR;
+      puc += iBytes;
+      uLength -= (size_t)iBytes;
+   }
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write out what oWriter has buffered. */
+
+static int TarWriter_flush(TarWriter_T oWriter)
+{
+   int iResult;
+
+   iResult = Tar_writeAll(oWriter->iFd, oWriter->aucBuffer,
+                          oWriter->uUsed);
+   oWriter->uUsed = 0;
+   return iResult;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Append the uLength bytes at pvBytes, or zeros if pvBytes is NULL,
+   to the archive of oWriter. */
+
+static int TarWriter_put(TarWriter_T oWriter, const void *pvBytes,
+                         size_t uLength)
+{
+   const unsigned char *puc = pvBytes;
+   size_t uChunk;
+
+   if (puc != NULL && uLength >= BUFFER_SIZE)
+   {
+      if (TarWriter_flush(oWriter) != SUCCESS)
+         return IO_ERROR;
+      return Tar_writeAll(oWriter->iFd, puc, uLength);
+   }
+
+   while (uLength > 0)
+   {
+      uChunk = BUFFER_SIZE - oWriter->uUsed;
+      if (uChunk > uLength)
+         uChunk = uLength;
+      if (puc != NULL)
+      {
+         memcpy(oWriter->aucBuffer + oWriter->uUsed, puc, uChunk);
+         puc += uChunk;
+      }
+      else
+         memset(oWriter->aucBuffer + oWriter->uUsed, 0, uChunk);
+      oWriter->uUsed += uChunk;
+      uLength -= uChunk;
+      if (oWriter->uUsed == BUFFER_SIZE &&
+          TarWriter_flush(oWriter) != SUCCESS)
+         return IO_ERROR;
+   }
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write uValue into the uLength-byte field at puc, in octal with
+   leading zeros, ending with a '\0'.  It must fit. */
+
+static void Tar_putOctal(unsigned char *puc, size_t uLength,
+                         size_t uValue)
+{
+   puc[--uLength] = '\0';
+   while (uLength > 0)
+   {
+      puc[--uLength] = (unsigned char)('0' + (uValue & 7));
+      uValue >>= 3;
+   }
+   assert(uValue == 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of decimal digits of uValue. */
+
+static size_t Tar_digits(size_t uValue)
+{
+   size_t uDigits = 1;
+
+   while (uValue >= 10)
+   {
+      uValue /= 10;
+      uDigits++;
+   }
+   return uDigits;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the length of the pax record whose key and value are
+   uLength bytes long together, counting its own length. */
+
+static size_t Tar_recordLength(size_t uLength)
+{
+   size_t uRest = uLength + 3;
+   size_t uDigits;
+
+   /* "<length> <key>=<value>\n" */
+   uDigits = Tar_digits(uRest);
+   if (Tar_digits(uRest + uDigits) != uDigits)
+      uDigits++;
+   return uRest + uDigits;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write a header to oWriter with the uPrefixLength bytes at pcPrefix
+   as its prefix, the uNameLength bytes at pcName followed by pcSuffix
+   as its name, together at most NAME_LENGTH bytes, and the given type
+   and size. */
+
+static int TarWriter_header(TarWriter_T oWriter, const char *pcPrefix,
+                            size_t uPrefixLength, const char *pcName,
+                            size_t uNameLength, const char *pcSuffix,
+                            char cType, size_t uSize)
+{
+   unsigned char aucHeader[BLOCK_SIZE];
+   size_t uSum = 0;
+   size_t u;
+
+   assert(uNameLength + strlen(pcSuffix) <= NAME_LENGTH);
+   assert(uPrefixLength <= PREFIX_LENGTH);
+
+   memset(aucHeader, 0, BLOCK_SIZE);
+   memcpy(aucHeader + NAME_AT, pcName, uNameLength);
+   memcpy(aucHeader + NAME_AT + uNameLength, pcSuffix, strlen(pcSuffix));
+   memcpy(aucHeader + PREFIX_AT, pcPrefix, uPrefixLength);
+   Tar_putOctal(aucHeader + MODE_AT, ID_LENGTH,
+                cType == '5' ? 0755 : 0644);
+   Tar_putOctal(aucHeader + UID_AT, ID_LENGTH, 0);
+   Tar_putOctal(aucHeader + GID_AT, ID_LENGTH, 0);
+   Tar_putOctal(aucHeader + SIZE_AT, SIZE_LENGTH, uSize);
+   Tar_putOctal(aucHeader + MTIME_AT, SIZE_LENGTH, 0);
+   aucHeader[TYPE_AT] = (unsigned char)cType;
+   memcpy(aucHeader + MAGIC_AT, "ustar", 6);
+   memcpy(aucHeader + VERSION_AT, "00", 2);
+
+   memset(aucHeader + CHECKSUM_AT, ' ', CHECKSUM_LENGTH);
+   for (u = 0; u < BLOCK_SIZE; u++)
+      uSum += aucHeader[u];
+   Tar_putOctal(aucHeader + CHECKSUM_AT, CHECKSUM_LENGTH - 1, uSum);
+
+   return TarWriter_put(oWriter, aucHeader, BLOCK_SIZE);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Append zeros to oWriter to fill the block of contents uLength bytes
+   long. */
+
+static int TarWriter_pad(TarWriter_T oWriter, size_t uLength)
+{
+   return TarWriter_put(oWriter, NULL,
+                        (BLOCK_SIZE - uLength % BLOCK_SIZE) % BLOCK_SIZE);
+}
+
+/*--------------------------------------------------------------------*/
+
+int TarWriter_add(TarWriter_T oWriter, const char *pcPath,
+                  boolean bIsFile, const void *pvContents,
+                  size_t uLength)
+{
+   const char *pcSuffix = bIsFile ? "" : "/";
+   size_t uPathLength;
+   size_t uSplit;
+   size_t uPaxLength = 0;
+   int iLongPath;
+   int iLongSize;
+   int iResult;
+   char acNumber[3 * sizeof(size_t) + 8];
+
+   assert(oWriter != NULL);
+   assert(pcPath != NULL);
+
+   if (!bIsFile)
+      uLength = 0;
+   uPathLength = strlen(pcPath);
+
+   /* A path too long for the name field is split at a '/' between it
+      and the prefix field if it can be, and otherwise goes in a pax
+      record. */
+   uSplit = 0;
+   iLongPath = 0;
+   if (uPathLength + strlen(pcSuffix) > NAME_LENGTH)
+   {
+      uSplit = uPathLength + strlen(pcSuffix) - NAME_LENGTH - 1;
+      while (uSplit + 1 < uPathLength && uSplit <= PREFIX_LENGTH &&
+             pcPath[uSplit] != '/')
+         uSplit++;
+      iLongPath = uSplit + 1 >= uPathLength || uSplit > PREFIX_LENGTH ||
+         pcPath[uSplit] != '/';
+   }
+
+   /* The size field holds 11 octal digits. */
+   iLongSize = (uLength >> 30 >> 3) != 0;
+
+   if (iLongPath)
+      uPaxLength += Tar_recordLength(4 + uPathLength + strlen(pcSuffix));
+   if (iLongSize)
+      uPaxLength += Tar_recordLength(4 + Tar_digits(uLength));
+   if (uPaxLength > 0)
+   {
+      if (TarWriter_header(oWriter, "", 0, acPaxName, strlen(acPaxName),
+                           "", 'x', uPaxLength) != SUCCESS)
+         return IO_ERROR;
+      if (iLongPath)
+      {
+         sprintf(acNumber, "%lu path=", (unsigned long)
+                 Tar_recordLength(4 + uPathLength + strlen(pcSuffix)));
+         if (TarWriter_put(oWriter, acNumber, strlen(acNumber)) !=
+             SUCCESS ||
+             TarWriter_put(oWriter, pcPath, uPathLength) != SUCCESS ||
+             TarWriter_put(oWriter, pcSuffix, strlen(pcSuffix)) !=
+             SUCCESS ||
+             TarWriter_put(oWriter, "\n", 1) != SUCCESS)
+            return IO_ERROR;
+      }
+      if (iLongSize)
+      {
+         sprintf(acNumber, "%lu size=%lu\n",
+                 (unsigned long)Tar_recordLength(4 + Tar_digits(uLength)),
+                 (unsigned long)uLength);
+         if (TarWriter_put(oWriter, acNumber, strlen(acNumber)) !=
+             SUCCESS)
+            return IO_ERROR;
+      }
+      if (TarWriter_pad(oWriter, uPaxLength) != SUCCESS)
+         return IO_ERROR;
+   }
+
+   /* With a pax path, the ustar name is only a fallback: as much of
+      the end of the path as fits. */
+   if (iLongPath)
+      iResult = TarWriter_header(oWriter, "", 0,
+                                 pcPath + uPathLength - NAME_LENGTH +
+                                 strlen(pcSuffix),
+                                 NAME_LENGTH - strlen(pcSuffix), pcSuffix,
+                                 bIsFile ? '0' : '5',
+                                 iLongSize ? 0 : uLength);
+   else if (uSplit > 0)
+      iResult = TarWriter_header(oWriter, pcPath, uSplit,
+                                 pcPath + uSplit + 1,
+                                 uPathLength - uSplit - 1, pcSuffix,
+                                 bIsFile ? '0' : '5',
+                                 iLongSize ? 0 : uLength);
+   else
+      iResult = TarWriter_header(oWriter, "", 0, pcPath, uPathLength,
+                                 pcSuffix, bIsFile ? '0' : '5',
+                                 iLongSize ? 0 : uLength);
+   if (iResult != SUCCESS)
+      return IO_ERROR;
+
+   if (TarWriter_put(oWriter, pvContents, uLength) != SUCCESS ||
+       TarWriter_pad(oWriter, uLength) != SUCCESS)
+      return IO_ERROR;
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+int TarWriter_finish(TarWriter_T oWriter)
+{
+   assert(oWriter != NULL);
+
+   if (TarWriter_put(oWriter, NULL, 2 * BLOCK_SIZE) != SUCCESS)
+      return IO_ERROR;
+   return TarWriter_flush(oWriter);
+}
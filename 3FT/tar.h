@@ -0,0 +1,102 @@
+/*--------------------------------------------------------------------*/
+/* tar.h                                                              */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#ifndef TAR_INCLUDED
+#define TAR_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/* A TarReader_T object reads the entries of a tar archive, in ustar
+   form with pax or GNU extended names and sizes, from a file
+   descriptor as they arrive; a TarWriter_T object writes one.  Each
+   buffers at most a fixed number of bytes, apart from the extended
+   headers of long names, so an archive of any size streams through
+   in constant memory.  Contents larger than the buffer go between
+   the file descriptor and the caller's memory directly.  Every
+   function that can fail returns SUCCESS, IO_ERROR if the file
+   descriptor cannot be read or written or the archive is malformed,
+   or MEMORY_ERROR if insufficient memory is available. */
+
+typedef struct TarReader *TarReader_T;
+typedef struct TarWriter *TarWriter_T;
+
+/* The kinds of entry TarReader_next finds. */
+
+enum TarType { TAR_END, TAR_FILE, TAR_DIR, TAR_LINK };
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new TarReader_T object reading from iFd, or NULL if
+   insufficient memory is available. */
+
+TarReader_T TarReader_new(int iFd);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oReader, without closing its file descriptor. */
+
+void TarReader_free(TarReader_T oReader);
+
+/*--------------------------------------------------------------------*/
+
+/* Skip whatever of the current entry's contents has not been read,
+   and read the header of the next file, directory or hard link,
+   skipping entries of other kinds.  Store its kind in *peType,
+   TAR_END if the archive has ended, and if it has not, its path,
+   which oReader owns and the caller may change until the next call,
+   in *ppcPath, and the length of its contents, 0 for a hard link, in
+   *puLength. */
+
+int TarReader_next(TarReader_T oReader, enum TarType *peType,
+                   char **ppcPath, size_t *puLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the path of the entry that the current entry, a hard link,
+   links to, which oReader owns and the caller may change until the
+   next call to TarReader_next. */
+
+char *TarReader_getLinkPath(TarReader_T oReader);
+
+/*--------------------------------------------------------------------*/
+
+/* Read the next uLength bytes of the current entry's contents into
+   pvContents; the entry must have that many left. */
+
+int TarReader_read(TarReader_T oReader, void *pvContents,
+                   size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new TarWriter_T object writing to iFd, or NULL if
+   insufficient memory is available. */
+
+TarWriter_T TarWriter_new(int iFd);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oWriter, without writing what it has buffered or closing its
+   file descriptor. */
+
+void TarWriter_free(TarWriter_T oWriter);
+
+/*--------------------------------------------------------------------*/
+
+/* Add an entry to oWriter for the file (if bIsFile is TRUE) with path
+   pcPath and the uLength bytes at pvContents, zeros if pvContents is
+   NULL, or for the directory with path pcPath. */
+
+int TarWriter_add(TarWriter_T oWriter, const char *pcPath,
+                  boolean bIsFile, const void *pvContents,
+                  size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* End the archive of oWriter and write out all it has buffered. */
+
+int TarWriter_finish(TarWriter_T oWriter);
+
+#endif
@@ -0,0 +1,334 @@
+/*--------------------------------------------------------------------*/
+/* trace.c                                                            */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "trace.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The bytes every trace file starts with. */
+
+static const char acMagic[8] = {'F', 'T', 'T', 'R', 'A', 'C', 'E', '1'};
+
+/* The properties of each operation, indexed by enum TraceOp. */
+
+static const struct
+{
+   const char *pcName;
+   int iHasPath;
+   int iHasHandle;
+} asOps[TRACE_NUM_OPS] = {
+   {"FT_init", 0, 0},
+   {"FT_destroy", 0, 0},
+   {"FT_toString", 0, 0},
+   {"FT_insertDir", 1, 0},
+   {"FT_containsDir", 1, 0},
+   {"FT_rmDir", 1, 0},
+   {"FT_insertFile", 1, 0},
+   {"FT_containsFile", 1, 0},
+   {"FT_rmFile", 1, 0},
+   {"FT_getFileContents", 1, 0},
+   {"FT_replaceFileContents", 1, 0},
+   {"FT_stat", 1, 0},
+   {"FT_openDir", 1, 1},
+   {"FT_closeDir", 0, 1},
+   {"FT_insertDirAt", 1, 1},
+   {"FT_insertFileAt", 1, 1},
+   {"FT_statAt", 1, 1},
+   {"FT_rmAt", 1, 1},
+   {"FT_listAt", 1, 1},
+   {"FT_freeze", 0, 0},
+   {"FT_thaw", 0, 0},
+   {"FT_indexNames", 0, 0},
+   {"FT_indexSizes", 0, 0},
+   {"FT_insertBatch", 0, 0},
+   {"FT_rmBatch", 0, 0},
+   {"FT_BatchEntry", 1, 0}
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A Trace consists of its file, whether it is being written, the
+   start time of the last record, and, when reading, a buffer for the
+   current record's path. */
+
+struct Trace
+{
+   /* The underlying file. */
+   FILE *psFile;
+
+   /* 1 (TRUE) if open for writing, 0 (FALSE) if for reading. */
+   int iWriting;
+
+   /* When writing, the absolute start time of the last record
+      written; when reading, the relative start time of the last
+      record read. */
+   unsigned long ulLastStart;
+
+   /* 1 (TRUE) once a record has been written. */
+   int iStarted;
+
+   /* The path buffer and its physical length. */
+   char *pcPath;
+   size_t uPathPhysLength;
+};
+
+/*--------------------------------------------------------------------*/
+
+const char *Trace_opName(int iOp)
+{
+   assert(iOp >= 0 && iOp < TRACE_NUM_OPS);
+   return asOps[iOp].pcName;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Trace_hasPath(int iOp)
+{
+   assert(iOp >= 0 && iOp < TRACE_NUM_OPS);
+   return asOps[iOp].iHasPath;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Trace_hasHandle(int iOp)
+{
+   assert(iOp >= 0 && iOp < TRACE_NUM_OPS);
+   return asOps[iOp].iHasHandle;
+}
+
+/*--------------------------------------------------------------------*/
+
+unsigned long Trace_now(void)
+{
+   struct timespec sTime;
+
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (unsigned long)sTime.tv_sec * 1000000000UL
+      + (unsigned long)sTime.tv_nsec;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new Trace object for psFile, or NULL (closing psFile) if
+   insufficient memory is available. */
+
+static Trace_T Trace_new(FILE *psFile, int iWriting)
+{
+   Trace_T oTrace;
+
+   assert(psFile != NULL);
+
+   oTrace = (struct Trace*)calloc(1, sizeof(struct Trace));
+   if (oTrace == NULL)
+   {
+      fclose(psFile);
+      return NULL;
+   }
+   oTrace->psFile = psFile;
+   oTrace->iWriting = iWriting;
+   return oTrace;
+}
+
+/*--------------------------------------------------------------------*/
+
+Trace_T Trace_create(const char *pcFilename)
+{
+   FILE *psFile;
+
+   assert(pcFilename != NULL);
+
+   psFile = fopen(pcFilename, "wb");
+   if (psFile == NULL)
+      return NULL;
+   if (fwrite(acMagic, sizeof(acMagic), 1, psFile) != 1)
+   {
+      fclose(psFile);
+      return NULL;
+   }
+   return Trace_new(psFile, 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+Trace_T Trace_open(const char *pcFilename)
+{
+   FILE *psFile;
+   char acHeader[sizeof(acMagic)];
+
+   assert(pcFilename != NULL);
+
+   psFile = fopen(pcFilename, "rb");
+   if (psFile == NULL)
+      return NULL;
+   if (fread(acHeader, sizeof(acHeader), 1, psFile) != 1
+       || memcmp(acHeader, acMagic, sizeof(acMagic)) != 0)
+   {
+      fclose(psFile);
+      return NULL;
+   }
+   return Trace_new(psFile, 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write ulValue to psFile as an unsigned LEB128 varint. */
+
+static void Trace_putVarint(FILE *psFile, unsigned long ulValue)
+{
+   while (ulValue >= 0x80)
+   {
+      putc((int)(ulValue & 0x7f) | 0x80, psFile);
+      ulValue >>= 7;
+   }
+   putc((int)ulValue, psFile);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read an unsigned LEB128 varint from psFile into *pulValue.  Return
+   1 (TRUE) if successful, or 0 (FALSE) at the end of the file or on
+   an overlong varint. */
+
+static int Trace_getVarint(FILE *psFile, unsigned long *pulValue)
+{
+   unsigned long ulValue = 0;
+   unsigned int uShift = 0;
+   int iByte;
+
+   do
+   {
+      iByte = getc(psFile);
+      if (iByte == EOF || uShift >= 8 * sizeof(unsigned long))
+         return 0;
+      ulValue |= (unsigned long)(iByte & 0x7f) << uShift;
+      uShift += 7;
+   } while (iByte & 0x80);
+
+   *pulValue = ulValue;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Trace_write(Trace_T oTrace, const struct TraceRecord *psRecord)
+{
+   unsigned long ulDelta;
+   size_t uPathLength;
+
+   assert(oTrace != NULL);
+   assert(oTrace->iWriting);
+   assert(psRecord != NULL);
+   assert(psRecord->iOp >= 0 && psRecord->iOp < TRACE_NUM_OPS);
+
+   ulDelta = oTrace->iStarted ?
+      psRecord->ulStart - oTrace->ulLastStart : 0;
+   oTrace->ulLastStart = psRecord->ulStart;
+   oTrace->iStarted = 1;
+
+   putc(psRecord->iOp, oTrace->psFile);
+   putc(psRecord->iFlags, oTrace->psFile);
+   Trace_putVarint(oTrace->psFile, (unsigned long)psRecord->iResult);
+   Trace_putVarint(oTrace->psFile, ulDelta);
+   Trace_putVarint(oTrace->psFile, psRecord->ulDuration);
+   Trace_putVarint(oTrace->psFile, psRecord->ulLength);
+   if (asOps[psRecord->iOp].iHasHandle)
+   {
+      Trace_putVarint(oTrace->psFile, psRecord->ulSlot);
+      Trace_putVarint(oTrace->psFile, psRecord->ulGeneration);
+   }
+   if (asOps[psRecord->iOp].iHasPath)
+   {
+      assert(psRecord->pcPath != NULL);
+      uPathLength = strlen(psRecord->pcPath);
+      Trace_putVarint(oTrace->psFile, (unsigned long)uPathLength);
+      fwrite(psRecord->pcPath, 1, uPathLength, oTrace->psFile);
+   }
+
+   return ! ferror(oTrace->psFile);
+}
+
+/*--------------------------------------------------------------------*/
+
+int Trace_read(Trace_T oTrace, struct TraceRecord *psRecord)
+{
+   int iOp;
+   int iFlags;
+   unsigned long ulResult;
+   unsigned long ulDelta;
+   unsigned long ulPathLength;
+   char *pcNewPath;
+
+   assert(oTrace != NULL);
+   assert(! oTrace->iWriting);
+   assert(psRecord != NULL);
+
+   iOp = getc(oTrace->psFile);
+   iFlags = getc(oTrace->psFile);
+   if (iOp == EOF || iFlags == EOF || iOp >= TRACE_NUM_OPS)
+      return 0;
+   psRecord->iOp = iOp;
+   psRecord->iFlags = iFlags;
+
+   if (! Trace_getVarint(oTrace->psFile, &ulResult)
+       || ! Trace_getVarint(oTrace->psFile, &ulDelta)
+       || ! Trace_getVarint(oTrace->psFile, &psRecord->ulDuration)
+       || ! Trace_getVarint(oTrace->psFile, &psRecord->ulLength))
+      return 0;
+   psRecord->iResult = (int)ulResult;
+   oTrace->ulLastStart += ulDelta;
+   psRecord->ulStart = oTrace->ulLastStart;
+
+   psRecord->ulSlot = 0;
+   psRecord->ulGeneration = 0;
+   if (asOps[iOp].iHasHandle)
+      if (! Trace_getVarint(oTrace->psFile, &psRecord->ulSlot)
+          || ! Trace_getVarint(oTrace->psFile, &psRecord->ulGeneration))
+         return 0;
+
+   psRecord->pcPath = NULL;
+   if (asOps[iOp].iHasPath)
+   {
+      if (! Trace_getVarint(oTrace->psFile, &ulPathLength))
+         return 0;
+      if (ulPathLength >= oTrace->uPathPhysLength)
+      {
+         pcNewPath = (char*)realloc(oTrace->pcPath, ulPathLength + 1);
+         if (pcNewPath == NULL)
+            return 0;
+         oTrace->pcPath = pcNewPath;
+         oTrace->uPathPhysLength = ulPathLength + 1;
+      }
+      if (fread(oTrace->pcPath, 1, ulPathLength, oTrace->psFile)
+          != ulPathLength)
+         return 0;
+      oTrace->pcPath[ulPathLength] = '\0';
+      psRecord->pcPath = oTrace->pcPath;
+   }
+
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Trace_close(Trace_T oTrace)
+{
+   int iSuccess;
+
+   assert(oTrace != NULL);
+
+   iSuccess = ! ferror(oTrace->psFile);
+   if (fclose(oTrace->psFile) != 0)
+      iSuccess = 0;
+   free(oTrace->pcPath);
+   free(oTrace);
+   return iSuccess;
+}
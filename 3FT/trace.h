@@ -0,0 +1,146 @@
+/*--------------------------------------------------------------------*/
+/* trace.h                                                            */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#ifndef TRACE_INCLUDED
+#define TRACE_INCLUDED
+
+#include <stddef.h>
+
+/* A Trace_T object is a binary file of records of calls to the FT
+   API, open either for writing (by FT_startTrace) or for reading (by
+   ft_replay).
+
+   The file starts with the 8 bytes "FTTRACE1". Each record is then an
+   operation byte, a flags byte, and a sequence of unsigned LEB128
+   varints: the result, the start time as nanoseconds since the
+   previous record's start, the duration in nanoseconds and the
+   length, followed, for the operations that take them, by a handle
+   (slot and generation varints) and a path (length varint and
+   bytes). A typical record takes about 10 bytes plus its path. */
+
+typedef struct Trace *Trace_T;
+
+/* The traced operations. */
+
+enum TraceOp {
+   TRACE_INIT, TRACE_DESTROY, TRACE_TO_STRING,
+   TRACE_INSERT_DIR, TRACE_CONTAINS_DIR, TRACE_RM_DIR,
+   TRACE_INSERT_FILE, TRACE_CONTAINS_FILE, TRACE_RM_FILE,
+   TRACE_GET_CONTENTS, TRACE_REPLACE_CONTENTS, TRACE_STAT,
+   TRACE_OPEN_DIR, TRACE_CLOSE_DIR, TRACE_INSERT_DIR_AT,
+   TRACE_INSERT_FILE_AT, TRACE_STAT_AT, TRACE_RM_AT, TRACE_LIST_AT,
+   TRACE_FREEZE, TRACE_THAW, TRACE_INDEX_NAMES, TRACE_INDEX_SIZES,
+   TRACE_INSERT_BATCH, TRACE_RM_BATCH, TRACE_BATCH_ENTRY,
+   TRACE_NUM_OPS
+};
+
+/* Flags of a record. */
+
+enum {
+   /* the call was the FT_*P variant, on a pre-parsed path */
+   TRACE_PARSED = 1,
+   /* the call passed non-NULL contents */
+   TRACE_HAS_CONTENTS = 2,
+   /* the call passed TRUE, for TRACE_INDEX_NAMES and
+      TRACE_INDEX_SIZES */
+   TRACE_ENABLE = 4,
+   /* the batch entry is a file */
+   TRACE_IS_FILE = 8
+};
+
+/* One traced call.  iResult is the status returned, or for functions
+   returning a boolean or a pointer, 1 for TRUE or non-NULL and 0
+   otherwise.  ulLength is the contents length for the operations
+   that take contents, the number of children visited for
+   TRACE_LIST_AT, the number of entries for TRACE_INSERT_BATCH and
+   TRACE_RM_BATCH, and 0 otherwise.  The handle is the one passed in,
+   or for TRACE_OPEN_DIR the one returned.  A batch record is followed
+   by one TRACE_BATCH_ENTRY record for each entry the batch looked at,
+   up to and including any that failed, each with its path, its
+   contents length and flags, and no time of its own. */
+
+struct TraceRecord
+{
+   int iOp;
+   int iFlags;
+   int iResult;
+   unsigned long ulStart;
+   unsigned long ulDuration;
+   unsigned long ulLength;
+   unsigned long ulSlot;
+   unsigned long ulGeneration;
+   const char *pcPath;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the name of operation iOp, as its FT function is named, or
+   for TRACE_BATCH_ENTRY, as the struct of a batch entry is. */
+
+const char *Trace_opName(int iOp);
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if operation iOp takes a path, else 0 (FALSE). */
+
+int Trace_hasPath(int iOp);
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if operation iOp takes or returns a handle, else 0
+   (FALSE). */
+
+int Trace_hasHandle(int iOp);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current time in nanoseconds. */
+
+unsigned long Trace_now(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Create the file named pcFilename, write the trace header to it, and
+   return a Trace_T object for writing it.  Return NULL if the file
+   cannot be created or insufficient memory is available. */
+
+Trace_T Trace_create(const char *pcFilename);
+
+/*--------------------------------------------------------------------*/
+
+/* Open the trace file named pcFilename and return a Trace_T object
+   for reading it.  Return NULL if the file cannot be opened, is not a
+   trace file, or insufficient memory is available. */
+
+Trace_T Trace_open(const char *pcFilename);
+
+/*--------------------------------------------------------------------*/
+
+/* Append *psRecord to oTrace, which must be open for writing.
+   psRecord->ulStart is an absolute time from Trace_now; it is stored
+   relative to the previous record.  Return 1 (TRUE) if successful, or
+   0 (FALSE) on a write error. */
+
+int Trace_write(Trace_T oTrace, const struct TraceRecord *psRecord);
+
+/*--------------------------------------------------------------------*/
+
+/* Read the next record of oTrace, which must be open for reading,
+   into *psRecord.  psRecord->ulStart is set to nanoseconds since the
+   first record's start, and psRecord->pcPath to a string owned by
+   oTrace that is valid until the next call, or NULL if the operation
+   takes no path.  Return 1 (TRUE) if a record was read, or 0 (FALSE)
+   at the end of the file or if it is malformed or truncated. */
+
+int Trace_read(Trace_T oTrace, struct TraceRecord *psRecord);
+
+/*--------------------------------------------------------------------*/
+
+/* Close oTrace, flushing it if open for writing, and free it.
+   Return 1 (TRUE) if successful, or 0 (FALSE) on a write error. */
+
+int Trace_close(Trace_T oTrace);
+
+#endif
@@ -0,0 +1,663 @@
+/*--------------------------------------------------------------------*/
+/* typedarray.h                                                       */
+/* Author: Abdullah Ramadan and Diane Yang                            */
+/*--------------------------------------------------------------------*/
+
+#ifndef TYPEDARRAY_INCLUDED
+#define TYPEDARRAY_INCLUDED
+
+#include <assert.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dynarray.h"
+#include "stats.h"
+
+/* The macros below generate DynArray variants specialized to one
+   element type, as static functions of the file that uses them.  A
+   DynArray stores const void* elements and reaches its comparison and
+   map functions through pointers, so none of them can be inlined;
+   here the element type and the functions applied to it are macro
+   arguments, so the compiler sees the array, the element and each
+   call directly.  The functions behave as their DynArray
+   counterparts, described in dynarray.h.  Each macro ends with a
+   harmless typedef so that its use may end with a semicolon. */
+
+/* The functions are static and a file uses only some of them; tell
+   the compiler not to warn about the rest. */
+
+#ifdef __GNUC__
+#define TYPEDARRAY_FUNCTION static __attribute__((unused))
+#else
+#define TYPEDARRAY_FUNCTION static
+#endif
+
+/* The minimum physical length of a typed array. */
+
+#define TYPEDARRAY_MIN_PHYS_LENGTH 2
+
+/* Sort partitions of at most this many elements are insertion
+   sorted. */
+
+#define TYPEDARRAY_INSERTION_SORT_LENGTH 16
+
+/*--------------------------------------------------------------------*/
+
+/* Return uPercent percent of u, rounded down, without overflow. */
+
+TYPEDARRAY_FUNCTION size_t TypedArray_percentOf(size_t u, size_t uPercent)
+{
+   return u / 100 * uPercent + u % 100 * uPercent / 100;
+}
+
+/* Return the physical length that an array of physical length
+   uPhysLength grows to under *psPolicy. */
+
+TYPEDARRAY_FUNCTION size_t TypedArray_grownLength(
+   const struct DynArray_Policy *psPolicy, size_t uPhysLength)
+{
+   size_t uGrowth;
+
+   assert(psPolicy != NULL);
+
+   uGrowth = TypedArray_percentOf(uPhysLength, psPolicy->uGrowthPercent);
+   if (psPolicy->uMaxGrowth != 0 && uGrowth > psPolicy->uMaxGrowth)
+      uGrowth = psPolicy->uMaxGrowth;
+   if (uGrowth == 0)
+      uGrowth = 1;
+   return uPhysLength + uGrowth;
+}
+
+/* Return the physical length that an array of length uLength and
+   physical length uPhysLength shrinks to under *psPolicy, or
+   uPhysLength if it does not shrink. */
+
+TYPEDARRAY_FUNCTION size_t TypedArray_shrunkLength(
+   const struct DynArray_Policy *psPolicy, size_t uLength,
+   size_t uPhysLength)
+{
+   size_t uNewLength;
+
+   assert(psPolicy != NULL);
+
+   if (psPolicy->uShrinkPercent == 0
+       || uLength >= TypedArray_percentOf(uPhysLength,
+                                          psPolicy->uShrinkPercent))
+      return uPhysLength;
+   uNewLength = 2 * uLength;
+   if (uNewLength < TYPEDARRAY_MIN_PHYS_LENGTH)
+      uNewLength = TYPEDARRAY_MIN_PHYS_LENGTH;
+   return uNewLength < uPhysLength ? uNewLength : uPhysLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* DEFINE_DYNARRAY(Name, Type) defines Name_T, a pointer to a struct
+   Name that is an array of Type whose length can expand dynamically,
+   and these functions on it:
+
+      Name_T Name_new(size_t uLength);
+      void   Name_free(Name_T oArray);
+      size_t Name_getLength(Name_T oArray);
+      size_t Name_getCapacity(Name_T oArray);
+      void   Name_setPolicy(Name_T oArray,
+                            const struct DynArray_Policy *psPolicy);
+      int    Name_reserve(Name_T oArray, size_t uCapacity);
+      void   Name_shrinkToFit(Name_T oArray);
+      Type   Name_get(Name_T oArray, size_t uIndex);
+      Type  *Name_slot(Name_T oArray, size_t uIndex);
+      Type   Name_set(Name_T oArray, size_t uIndex, Type tElement);
+      int    Name_add(Name_T oArray, Type tElement);
+      int    Name_addAt(Name_T oArray, size_t uIndex, Type tElement);
+      Type   Name_removeAt(Name_T oArray, size_t uIndex);
+      int    Name_addRangeAt(Name_T oArray, size_t uIndex,
+                             Type const *ptElements, size_t uCount);
+      void   Name_removeRange(Name_T oArray, size_t uIndex,
+                              size_t uCount);
+
+   A new array's elements are all bits zero.  Name_slot returns the
+   address of the uIndex'th element, which may be the length, for the
+   end of the elements; the elements from there on lie contiguously
+   at it until the array is next added to, reserved, shrunk or
+   freed. */
+
+#define DEFINE_DYNARRAY(Name, Type)                                     \
+                                                                        \
+typedef struct Name *Name##_T;                                          \
+                                                                        \
+struct Name                                                             \
+{                                                                       \
+   size_t uLength;                                                      \
+   size_t uPhysLength;                                                  \
+   Type *ptArray;                                                       \
+   const struct DynArray_Policy *psPolicy;                              \
+};                                                                      \
+                                                                        \
+TYPEDARRAY_FUNCTION int Name##_resize(Name##_T oArray, size_t uNewLength) \
+{                                                                       \
+   Type *ptNewArray;                                                    \
+                                                                        \
+   assert(oArray != NULL);                                              \
+   assert(uNewLength >= oArray->uLength);                               \
+   assert(uNewLength >= TYPEDARRAY_MIN_PHYS_LENGTH);                    \
+                                                                        \
+   ptNewArray = (Type*)realloc(oArray->ptArray,                         \
+                               sizeof(Type) * uNewLength);              \
+   if (ptNewArray == NULL)                                              \
+      return 0;                                                         \
+   if (uNewLength > oArray->uPhysLength)                                \
+      STATS_ADD(grows, 1);                                              \
+                                                                        \
+   oArray->uPhysLength = uNewLength;                                    \
+   oArray->ptArray = ptNewArray;                                        \
+   return 1;                                                            \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION int Name##_grow(Name##_T oArray, size_t uCount)     \
+{                                                                       \
+   size_t uNewLength;                                                   \
+                                                                        \
+   assert(oArray != NULL);                                              \
+   assert(uCount <= (size_t)-1 - oArray->uLength);                      \
+                                                                        \
+   if (uCount <= oArray->uPhysLength - oArray->uLength)                 \
+      return 1;                                                         \
+   uNewLength = TypedArray_grownLength(oArray->psPolicy,                \
+                                       oArray->uPhysLength);            \
+   if (uNewLength < oArray->uLength + uCount)                           \
+      uNewLength = oArray->uLength + uCount;                            \
+   return Name##_resize(oArray, uNewLength);                            \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION Name##_T Name##_new(size_t uLength)                 \
+{                                                                       \
+   Name##_T oArray;                                                     \
+                                                                        \
+   oArray = (struct Name*)malloc(sizeof(struct Name));                  \
+   if (oArray == NULL)                                                  \
+      return NULL;                                                      \
+   STATS_ADD(mallocs, 1);                                               \
+                                                                        \
+   oArray->uLength = uLength;                                           \
+   if (uLength > TYPEDARRAY_MIN_PHYS_LENGTH)                            \
+      oArray->uPhysLength = uLength;                                    \
+   else                                                                 \
+      oArray->uPhysLength = TYPEDARRAY_MIN_PHYS_LENGTH;                 \
+                                                                        \
+   oArray->psPolicy = &DynArray_defaultPolicy;                          \
+   oArray->ptArray = (Type*)calloc(oArray->uPhysLength, sizeof(Type));  \
+   if (oArray->ptArray == NULL)                                         \
+   {                                                                    \
+      free(oArray);                                                     \
+      STATS_ADD(frees, 1);                                              \
+      return NULL;                                                      \
+   }                                                                    \
+   STATS_ADD(mallocs, 1);                                               \
+                                                                        \
+   return oArray;                                                       \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION void Name##_free(Name##_T oArray)                   \
+{                                                                       \
+   assert(oArray != NULL);                                              \
+                                                                        \
+   free(oArray->ptArray);                                               \
+   free(oArray);                                                        \
+   STATS_ADD(frees, 2);                                                 \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION size_t Name##_getLength(Name##_T oArray)            \
+{                                                                       \
+   assert(oArray != NULL);                                              \
+                                                                        \
+   return oArray->uLength;                                              \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION size_t Name##_getCapacity(Name##_T oArray)          \
+{                                                                       \
+   assert(oArray != NULL);                                              \
+                                                                        \
+   return oArray->uPhysLength;                                          \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION void Name##_setPolicy(Name##_T oArray,              \
+                              const struct DynArray_Policy *psPolicy)   \
+{                                                                       \
+   assert(oArray != NULL);                                              \
+   assert(psPolicy == NULL || psPolicy->uShrinkPercent < 50);           \
+                                                                        \
+   oArray->psPolicy = psPolicy != NULL ? psPolicy :                     \
+      &DynArray_defaultPolicy;                                          \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION int Name##_reserve(Name##_T oArray, size_t uCapacity) \
+{                                                                       \
+   assert(oArray != NULL);                                              \
+                                                                        \
+   if (uCapacity <= oArray->uPhysLength)                                \
+      return 1;                                                         \
+   return Name##_resize(oArray, uCapacity);                             \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION void Name##_shrinkToFit(Name##_T oArray)            \
+{                                                                       \
+   size_t uNewLength;                                                   \
+                                                                        \
+   assert(oArray != NULL);                                              \
+                                                                        \
+   uNewLength = oArray->uLength;                                        \
+   if (uNewLength < TYPEDARRAY_MIN_PHYS_LENGTH)                         \
+      uNewLength = TYPEDARRAY_MIN_PHYS_LENGTH;                          \
+   if (uNewLength < oArray->uPhysLength)                                \
+      (void)Name##_resize(oArray, uNewLength);                          \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION Type Name##_get(Name##_T oArray, size_t uIndex)     \
+{                                                                       \
+   assert(oArray != NULL);                                              \
+   assert(uIndex < oArray->uLength);                                    \
+                                                                        \
+   return oArray->ptArray[uIndex];                                      \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION Type *Name##_slot(Name##_T oArray, size_t uIndex)   \
+{                                                                       \
+   assert(oArray != NULL);                                              \
+   assert(uIndex <= oArray->uLength);                                   \
+                                                                        \
+   return oArray->ptArray + uIndex;                                     \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION Type Name##_set(Name##_T oArray, size_t uIndex,     \
+                                    Type tElement)                      \
+{                                                                       \
+   Type tOldElement;                                                    \
+                                                                        \
+   assert(oArray != NULL);                                              \
+   assert(uIndex < oArray->uLength);                                    \
+                                                                        \
+   tOldElement = oArray->ptArray[uIndex];                               \
+   oArray->ptArray[uIndex] = tElement;                                  \
+   return tOldElement;                                                  \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION int Name##_add(Name##_T oArray, Type tElement)      \
+{                                                                       \
+   assert(oArray != NULL);                                              \
+                                                                        \
+   if (! Name##_grow(oArray, 1))                                        \
+      return 0;                                                         \
+                                                                        \
+   oArray->ptArray[oArray->uLength] = tElement;                         \
+   oArray->uLength++;                                                   \
+   return 1;                                                            \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION int Name##_addAt(Name##_T oArray, size_t uIndex,    \
+                                     Type tElement)                     \
+{                                                                       \
+   assert(oArray != NULL);                                              \
+   assert(uIndex <= oArray->uLength);                                   \
+                                                                        \
+   if (! Name##_grow(oArray, 1))                                        \
+      return 0;                                                         \
+                                                                        \
+   memmove(&oArray->ptArray[uIndex + 1], &oArray->ptArray[uIndex],      \
+           (oArray->uLength - uIndex) * sizeof(Type));                  \
+   STATS_ADD(shifts, oArray->uLength - uIndex);                         \
+                                                                        \
+   oArray->ptArray[uIndex] = tElement;                                  \
+   oArray->uLength++;                                                   \
+   return 1;                                                            \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION Type Name##_removeAt(Name##_T oArray, size_t uIndex) \
+{                                                                       \
+   Type tOldElement;                                                    \
+   size_t uNewLength;                                                   \
+                                                                        \
+   assert(oArray != NULL);                                              \
+   assert(uIndex < oArray->uLength);                                    \
+                                                                        \
+   tOldElement = oArray->ptArray[uIndex];                               \
+   oArray->uLength--;                                                   \
+   memmove(&oArray->ptArray[uIndex], &oArray->ptArray[uIndex + 1],      \
+           (oArray->uLength - uIndex) * sizeof(Type));                  \
+   STATS_ADD(shifts, oArray->uLength - uIndex);                         \
+                                                                        \
+   uNewLength = TypedArray_shrunkLength(oArray->psPolicy, oArray->uLength, \
+                                        oArray->uPhysLength);           \
+   if (uNewLength < oArray->uPhysLength)                                \
+      (void)Name##_resize(oArray, uNewLength);                          \
+   return tOldElement;                                                  \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION int Name##_addRangeAt(Name##_T oArray,             \
+                                          size_t uIndex,                \
+                                          Type const *ptElements,       \
+                                          size_t uCount)                \
+{                                                                       \
+   assert(oArray != NULL);                                              \
+   assert(uIndex <= oArray->uLength);                                   \
+   assert(ptElements != NULL || uCount == 0);                           \
+                                                                        \
+   if (! Name##_grow(oArray, uCount))                                   \
+      return 0;                                                         \
+                                                                        \
+   memmove(&oArray->ptArray[uIndex + uCount], &oArray->ptArray[uIndex], \
+           (oArray->uLength - uIndex) * sizeof(Type));                  \
+   STATS_ADD(shifts, oArray->uLength - uIndex);                         \
+   if (uCount > 0)                                                      \
+      memcpy(&oArray->ptArray[uIndex], ptElements, uCount * sizeof(Type)); \
+   oArray->uLength += uCount;                                           \
+   return 1;                                                            \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION void Name##_removeRange(Name##_T oArray,           \
+                                            size_t uIndex,              \
+                                            size_t uCount)              \
+{                                                                       \
+   size_t uNewLength;                                                   \
+                                                                        \
+   assert(oArray != NULL);                                              \
+   assert(uIndex <= oArray->uLength);                                   \
+   assert(uCount <= oArray->uLength - uIndex);                          \
+                                                                        \
+   memmove(&oArray->ptArray[uIndex], &oArray->ptArray[uIndex + uCount], \
+           (oArray->uLength - uIndex - uCount) * sizeof(Type));         \
+   STATS_ADD(shifts, oArray->uLength - uIndex - uCount);                \
+   oArray->uLength -= uCount;                                           \
+                                                                        \
+   uNewLength = TypedArray_shrunkLength(oArray->psPolicy, oArray->uLength, \
+                                        oArray->uPhysLength);           \
+   if (uNewLength < oArray->uPhysLength)                                \
+      (void)Name##_resize(oArray, uNewLength);                          \
+}                                                                       \
+                                                                        \
+typedef Name##_T Name##_dummy
+
+/*--------------------------------------------------------------------*/
+
+/* DEFINE_DYNARRAY_MAP(Name, Func, Type, Extra, apply) defines
+
+      void Func(Name_T oArray, Extra extra);
+
+   which calls apply(tElement, extra) for each element tElement of
+   oArray, in order, as DynArray_map would. */
+
+#define DEFINE_DYNARRAY_MAP(Name, Func, Type, Extra, apply)             \
+                                                                        \
+TYPEDARRAY_FUNCTION void Func(Name##_T oArray, Extra extra)             \
+{                                                                       \
+   size_t u;                                                            \
+                                                                        \
+   assert(oArray != NULL);                                              \
+                                                                        \
+   for (u = 0; u < oArray->uLength; u++)                                \
+      apply(oArray->ptArray[u], extra);                                 \
+}                                                                       \
+                                                                        \
+typedef Name##_T Func##_dummy
+
+/*--------------------------------------------------------------------*/
+
+/* DEFINE_DYNARRAY_SORT(Name, Func, Type, compare) defines
+
+      void Func(Name_T oArray);
+
+   which sorts oArray in the order determined by compare, with the
+   introsort of DynArray_sort.  compare(tElement1, tElement2) must
+   return <0, 0, or >0 depending upon whether tElement1 is less than,
+   equal to, or greater than tElement2. */
+
+#define DEFINE_DYNARRAY_SORT(Name, Func, Type, compare)                 \
+                                                                        \
+TYPEDARRAY_FUNCTION void Func##Insertion(Type *ptLo, Type *ptHi)        \
+{                                                                       \
+   Type *ptNext;                                                        \
+   Type *ptHole;                                                        \
+   Type tElement;                                                       \
+                                                                        \
+   for (ptNext = ptLo + 1; ptNext <= ptHi; ptNext++)                    \
+   {                                                                    \
+      tElement = *ptNext;                                               \
+      for (ptHole = ptNext;                                             \
+           ptHole > ptLo && compare(tElement, *(ptHole-1)) < 0;         \
+           ptHole--)                                                    \
+         *ptHole = *(ptHole-1);                                         \
+      *ptHole = tElement;                                               \
+   }                                                                    \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION void Func##Heapsort(Type *ptLo, Type *ptHi)         \
+{                                                                       \
+   size_t uLength = (size_t)(ptHi - ptLo) + 1;                          \
+   size_t uStart = uLength / 2;                                         \
+   size_t uRoot;                                                        \
+   size_t uChild;                                                       \
+   Type tTemp;                                                          \
+                                                                        \
+   while (uLength > 1)                                                  \
+   {                                                                    \
+      if (uStart > 0)                                                   \
+         uStart--;                                                      \
+      else                                                              \
+      {                                                                 \
+         uLength--;                                                     \
+         tTemp = ptLo[0]; ptLo[0] = ptLo[uLength]; ptLo[uLength] = tTemp; \
+      }                                                                 \
+                                                                        \
+      uRoot = uStart;                                                   \
+      while ((uChild = 2 * uRoot + 1) < uLength)                        \
+      {                                                                 \
+         if (uChild + 1 < uLength                                       \
+             && compare(ptLo[uChild], ptLo[uChild+1]) < 0)              \
+            uChild++;                                                   \
+         if (compare(ptLo[uRoot], ptLo[uChild]) >= 0)                   \
+            break;                                                      \
+         tTemp = ptLo[uRoot]; ptLo[uRoot] = ptLo[uChild];               \
+         ptLo[uChild] = tTemp;                                          \
+         uRoot = uChild;                                                \
+      }                                                                 \
+   }                                                                    \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION void Func##Help(Type *ptLo, Type *ptHi)             \
+{                                                                       \
+   /* The introsort of DynArray_introsort, on typed pointers. */        \
+   struct                                                               \
+   {                                                                    \
+      Type *ptLo;                                                       \
+      Type *ptHi;                                                       \
+      size_t uDepth;                                                    \
+   } asStack[sizeof(size_t) * CHAR_BIT];                                \
+   size_t uTop = 0;                                                     \
+   Type *ptRight;                                                       \
+   Type *ptLeft;                                                        \
+   Type *ptMid;                                                         \
+   Type tPivot;                                                         \
+   Type tTemp;                                                          \
+   size_t uDepth = 0;                                                   \
+   size_t u;                                                            \
+                                                                        \
+   assert(ptLo != NULL);                                                \
+   assert(ptHi != NULL);                                                \
+                                                                        \
+   for (u = (size_t)(ptHi - ptLo) + 1; u > 1; u /= 2)                   \
+      uDepth += 2;                                                      \
+                                                                        \
+   for (;;)                                                             \
+   {                                                                    \
+      while ((size_t)(ptHi - ptLo) >= TYPEDARRAY_INSERTION_SORT_LENGTH  \
+             && uDepth > 0)                                             \
+      {                                                                 \
+         uDepth--;                                                      \
+         ptMid = ptLo + ((ptHi - ptLo) / 2);                            \
+         if (compare(*ptMid, *ptLo) < 0)                                \
+         {                                                              \
+            tTemp = *ptMid; *ptMid = *ptLo; *ptLo = tTemp;              \
+         }                                                              \
+         if (compare(*ptHi, *ptMid) < 0)                                \
+         {                                                              \
+            tTemp = *ptHi; *ptHi = *ptMid; *ptMid = tTemp;              \
+            if (compare(*ptMid, *ptLo) < 0)                             \
+            {                                                           \
+               tTemp = *ptMid; *ptMid = *ptLo; *ptLo = tTemp;           \
+            }                                                           \
+         }                                                              \
+         tPivot = *ptMid;                                               \
+                                                                        \
+         ptRight = ptLo;                                                \
+         ptLeft = ptHi;                                                 \
+         while (ptRight <= ptLeft)                                      \
+         {                                                              \
+            while (compare(*ptRight, tPivot) < 0)                       \
+               ptRight++;                                               \
+            while (compare(tPivot, *ptLeft) < 0)                        \
+               ptLeft--;                                                \
+            if (ptRight <= ptLeft)                                      \
+            {                                                           \
+               tTemp = *ptRight; *ptRight = *ptLeft; *ptLeft = tTemp;   \
+               ptRight++;                                               \
+               ptLeft--;                                                \
+            }                                                           \
+         }                                                              \
+                                                                        \
+         if (ptLeft - ptLo > ptHi - ptRight)                            \
+         {                                                              \
+            asStack[uTop].ptLo = ptLo;                                  \
+            asStack[uTop].ptHi = ptLeft;                                \
+            ptLo = ptRight;                                             \
+         }                                                              \
+         else                                                           \
+         {                                                              \
+            asStack[uTop].ptLo = ptRight;                               \
+            asStack[uTop].ptHi = ptHi;                                  \
+            ptHi = ptLeft;                                              \
+         }                                                              \
+         asStack[uTop].uDepth = uDepth;                                 \
+         uTop++;                                                        \
+      }                                                                 \
+                                                                        \
+      if (ptLo < ptHi)                                                  \
+      {                                                                 \
+         if (uDepth == 0)                                               \
+            Func##Heapsort(ptLo, ptHi);                                 \
+         else                                                           \
+            Func##Insertion(ptLo, ptHi);                                \
+      }                                                                 \
+                                                                        \
+      if (uTop == 0)                                                    \
+         return;                                                        \
+      uTop--;                                                           \
+      ptLo = asStack[uTop].ptLo;                                        \
+      ptHi = asStack[uTop].ptHi;                                        \
+      uDepth = asStack[uTop].uDepth;                                    \
+   }                                                                    \
+}                                                                       \
+                                                                        \
+TYPEDARRAY_FUNCTION void Func(Name##_T oArray)                          \
+{                                                                       \
+   assert(oArray != NULL);                                              \
+                                                                        \
+   if (oArray->uLength < 2)                                             \
+      return;                                                           \
+   Func##Help(&oArray->ptArray[0], &oArray->ptArray[oArray->uLength-1]); \
+}                                                                       \
+                                                                        \
+typedef Name##_T Func##_dummy
+
+/*--------------------------------------------------------------------*/
+
+/* DEFINE_DYNARRAY_BSEARCH(Name, Func, Type, Key, compare) defines
+
+      int Func(Name_T oArray, Key tSought, size_t *puIndex);
+
+   which binary searches oArray for tSought as DynArray_bsearch would:
+   if it is found, then it assigns its index to *puIndex and returns
+   1, and otherwise it assigns the index where it would belong to
+   *puIndex and returns 0.  compare(tSought, tElement) must return <0,
+   0, or >0 depending upon whether tSought is less than, equal to, or
+   greater than tElement, and oArray must be sorted in that order.
+   Key may differ from Type, so that an array may be searched by a
+   key that is not itself an element. */
+
+#define DEFINE_DYNARRAY_BSEARCH(Name, Func, Type, Key, compare)         \
+                                                                        \
+TYPEDARRAY_FUNCTION int Func(Name##_T oArray, Key tSought,              \
+                             size_t *puIndex)                           \
+{                                                                       \
+   size_t uLo = 0;                                                      \
+   size_t uHi;                                                          \
+   size_t uMid;                                                         \
+   int iCompare;                                                        \
+                                                                        \
+   assert(oArray != NULL);                                              \
+   assert(puIndex != NULL);                                             \
+                                                                        \
+   uHi = oArray->uLength;                                               \
+   while (uLo < uHi)                                                    \
+   {                                                                    \
+      uMid = uLo + (uHi - uLo) / 2;                                     \
+      iCompare = compare(tSought, oArray->ptArray[uMid]);               \
+      if (iCompare == 0)                                                \
+      {                                                                 \
+         *puIndex = uMid;                                               \
+         return 1;                                                      \
+      }                                                                 \
+      if (iCompare < 0)                                                 \
+         uHi = uMid;                                                    \
+      else                                                              \
+         uLo = uMid + 1;                                                \
+   }                                                                    \
+   *puIndex = uLo;                                                      \
+   return 0;                                                            \
+}                                                                       \
+                                                                        \
+typedef Name##_T Func##_dummy
+
+/*--------------------------------------------------------------------*/
+
+/* DEFINE_DYNARRAY_MERGE(Name, Func, Type, compare) defines
+
+      int Func(Name_T oArray, Type const *ptElements, size_t uCount);
+
+   which adds the uCount sorted elements of ptElements to the sorted
+   oArray as DynArray_mergeSorted would, in the order determined by
+   compare(tElement1, tElement2). */
+
+#define DEFINE_DYNARRAY_MERGE(Name, Func, Type, compare)                \
+                                                                        \
+TYPEDARRAY_FUNCTION int Func(Name##_T oArray, Type const *ptElements,   \
+                             size_t uCount)                             \
+{                                                                       \
+   size_t uOld;                                                         \
+   size_t uNew;                                                         \
+   size_t uTo;                                                          \
+                                                                        \
+   assert(oArray != NULL);                                              \
+   assert(ptElements != NULL || uCount == 0);                           \
+                                                                        \
+   if (! Name##_grow(oArray, uCount))                                   \
+      return 0;                                                         \
+                                                                        \
+   uOld = oArray->uLength;                                              \
+   uNew = uCount;                                                       \
+   uTo = uOld + uCount;                                                 \
+   while (uNew > 0)                                                     \
+   {                                                                    \
+      if (uOld > 0 && compare(oArray->ptArray[uOld - 1],                \
+                              ptElements[uNew - 1]) > 0)                \
+         oArray->ptArray[--uTo] = oArray->ptArray[--uOld];              \
+      else                                                              \
+         oArray->ptArray[--uTo] = ptElements[--uNew];                   \
+   }                                                                    \
+   STATS_ADD(shifts, oArray->uLength - uOld);                           \
+   oArray->uLength += uCount;                                           \
+   return 1;                                                            \
+}                                                                       \
+                                                                        \
+typedef Name##_T Func##_dummy
+
+#endif